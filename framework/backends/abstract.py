@@ -30,14 +30,13 @@ from __future__ import (
 )
 import abc
 import contextlib
-import itertools
 import os
-import shutil
+import threading
 
 import six
 
 from framework import options
-from . import compression
+from . import compression, journal
 from framework.results import TestResult
 from framework.status import INCOMPLETE
 
@@ -156,34 +155,22 @@ class FileBackend(Backend):
     This class provides a few methods and setup required for a file based
     backend.
 
+    Test results are appended to a single journal in the tests directory (see
+    framework.backends.journal), read them back with _iter_tests().
+
     Arguments:
     dest -- a folder to store files in
 
-    Keyword Arguments:
-    file_start_count -- controls the counter for the test result files.
-                        Whatever this is set to will be the first name of the
-                        tests. It is important for resumes that this is not
-                        overlapping as the Inheriting classes assume they are
-                        not. Default: 0
-
     """
-    def __init__(self, dest, file_start_count=0, **kwargs):
+    def __init__(self, dest, **kwargs):
         self._dest = dest
-        self._counter = itertools.count(file_start_count)
         self._write_final = write_compressed
+        self.__journal = None
+        self.__legacy_imported = False
+        self.__lock = threading.Lock()
 
     __INCOMPLETE = TestResult(result=INCOMPLETE)
 
-    def __fsync(self, file_):
-        """ Sync the file to disk
-
-        If options.OPTIONS.sync is truthy this will sync self._file to disk
-
-        """
-        file_.flush()
-        if options.OPTIONS.sync:
-            os.fsync(file_.fileno())
-
     @abc.abstractmethod
     def _write(self, f, name, data):
         """Method that writes a TestResult into a result file."""
@@ -192,32 +179,110 @@ class FileBackend(Backend):
     def _file_extension(self):
         """The file extension of the backend."""
 
+    @property
+    def _journal_path(self):
+        return os.path.join(self._dest, 'tests',
+                            'journal.{}'.format(self._file_extension))
+
+    def _legacy_record(self, data):  # pylint: disable=unused-argument
+        """Return the (name, value) of a per-test file of an older piglit.
+
+        data is the content of the file, as bytes. Returns None if the file
+        can't be used, which is the default for backends that never wrote
+        such files.
+        """
+        return None
+
+    def __import_legacy_tests(self):
+        """Move the per-test files of an older piglit into the journal.
+
+        Runs started by older versions of piglit wrote a file per test into
+        the tests directory. When such a run is resumed those are appended to
+        the journal in the order they were written, before anything else, so
+        that the results of the resumed run supersede them. They're removed
+        once they are in the journal. Must be called with the lock held.
+        """
+        if self.__legacy_imported:
+            return
+        self.__legacy_imported = True
+
+        test_dir = os.path.dirname(self._journal_path)
+        suffix = '.' + self._file_extension
+        legacy = []
+        for file_ in os.listdir(test_dir):
+            if file_.endswith(suffix) and file_[:-len(suffix)].isdigit():
+                legacy.append((int(file_[:-len(suffix)]), file_))
+        if not legacy:
+            return
+
+        if self.__journal is None:
+            self.__journal = journal.Journal(
+                self._journal_path, sync=options.OPTIONS.sync)
+        for _, file_ in sorted(legacy):
+            with open(os.path.join(test_dir, file_), 'rb') as f:
+                record = self._legacy_record(f.read())
+            if record is not None:
+                self.__journal.append(*record)
+        self.__journal.commit()
+
+        for _, file_ in legacy:
+            os.unlink(os.path.join(test_dir, file_))
+
+    def __append(self, name, data):
+        """Serialize data with _write and append it to the journal."""
+        with self.__lock:
+            self.__import_legacy_tests()
+            if self.__journal is None:
+                self.__journal = journal.Journal(
+                    self._journal_path, sync=options.OPTIONS.sync)
+
+        f = six.StringIO()
+        self._write(f, name, data)
+        value = f.getvalue()
+        if isinstance(value, six.text_type):
+            value = value.encode('utf-8')
+        self.__journal.append(name, value)
+
+    def _close_journal(self):
+        """Close the journal, committing anything that is waiting."""
+        with self.__lock:
+            if self.__journal is not None:
+                self.__journal.close()
+                self.__journal = None
+
+    def _iter_tests(self):
+        """Yield the latest serialized record of each test, as bytes.
+
+        Only the position of each record is kept in memory, the records
+        themselves are read back one at a time.
+        """
+        with self.__lock:
+            self.__import_legacy_tests()
+        self._close_journal()
+        if not os.path.exists(self._journal_path):
+            return
+
+        offsets = journal.index(self._journal_path)
+        with open(self._journal_path, 'rb') as f:
+            for offset in six.itervalues(offsets):
+                yield journal.read_at(f, offset)
+
     @contextlib.contextmanager
     def write_test(self, name):
         """Write a test.
 
-        When this context manager is opened it will first write a placeholder
-        file with the status incomplete.
+        When this context manager is opened it will first append a record
+        with the status incomplete to the journal.
 
-        When it is called to write the finall result it will create a temporary
-        file, write to that file, then move that file over the original,
-        incomplete status file. This helps to make the operation atomic, as
-        long as the filesystem continues running and the result was valid in
-        the original file it will be valid at the end
+        When it is called to write the final result it appends a second
+        record, which supersedes the first. A record is either completely
+        written or ignored when the journal is read, so as long as the
+        filesystem continues running the journal stays valid.
 
         """
         def finish(val):
-            tfile = file_ + '.tmp'
-            with open(tfile, 'w') as f:
-                self._write(f, name, val)
-                self.__fsync(f)
-            shutil.move(tfile, file_)
-
-        file_ = os.path.join(self._dest, 'tests', '{}.{}'.format(
-            next(self._counter), self._file_extension))
-
-        with open(file_, 'w') as f:
-            self._write(f, name, self.__INCOMPLETE)
-            self.__fsync(f)
+            self.__append(name, val)
+
+        self.__append(name, self.__INCOMPLETE)
 
         yield finish
@@ -35,15 +35,25 @@ the PIGLIT_COMPRESSION environment variable, then the piglit.conf
 [core]:compression key, and finally the value of compression.DEFAULT). This is
 the best way to get a compressor.
 
+On python 3 the bz2, gz and xz compressors cut the text into blocks which are
+compressed in parallel, each into a complete stream of its own. All three
+formats allow a file to be a series of streams, which decompress as one, so
+the files are read by the usual streaming decompressors and tools. The level
+and the number of threads are taken from the piglit.conf [core]:compression
+level and [core]:compression threads keys. If the zstandard module is
+available, a zst mode using its multi-threaded compressor is provided too.
+
 """
 
 from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import bz2
+import collections
 import errno
 import functools
 import gzip
+import multiprocessing
 import os
 import subprocess
 import contextlib
@@ -58,7 +68,9 @@ __all__ = [
     'UnsupportedCompressor',
     'COMPRESSORS',
     'DECOMPRESSORS',
+    'get_level',
     'get_mode',
+    'get_threads',
 ]
 
 
@@ -178,24 +190,126 @@ else:
     # In the case of python 3 this all just works, no monkeying around with
     # imports and fallbacks. just import the right modules and go
 
-    import lzma  # pylint: disable=wrong-import-position,wrong-import-order
+    # pylint: disable=wrong-import-position,wrong-import-order
+    from concurrent.futures import ThreadPoolExecutor
+    import lzma
+    # pylint: enable=wrong-import-position,wrong-import-order
+
+    # The number of characters of text in each independently compressed block.
+    BLOCK_SIZE = 8 * 1024 * 1024
+
+    class _BlockWriter(object):
+        """A text file that is compressed in blocks, in parallel.
+
+        Once enough text is written it is cut off as a block and compressed by
+        a pool of threads, the compression modules release the GIL while they
+        work. The compressed blocks are written to the file in order, and only
+        a few blocks are kept waiting for it at a time.
+
+        """
+        def __init__(self, filename, compress, threads):
+            self.__file = open(filename, 'wb')
+            self.__compress = compress
+            self.__threads = threads
+            self.__pool = ThreadPoolExecutor(threads) if threads > 1 else None
+            self.__pending = collections.deque()
+            self.__buffer = []
+            self.__size = 0
+            self.__blocks = 0
+
+        def write(self, text):
+            self.__buffer.append(text)
+            self.__size += len(text)
+            if self.__size >= BLOCK_SIZE:
+                self.__submit()
+
+        def __submit(self):
+            block = ''.join(self.__buffer).encode('utf-8')
+            self.__buffer = []
+            self.__size = 0
+            self.__blocks += 1
+
+            if self.__pool is None:
+                self.__file.write(self.__compress(block))
+                return
+
+            self.__pending.append(self.__pool.submit(self.__compress, block))
+            while len(self.__pending) > 2 * self.__threads:
+                self.__file.write(self.__pending.popleft().result())
+
+        def close(self):
+            """Compress the rest of the text and close the file."""
+            try:
+                # Even an empty file has to be a valid stream.
+                if self.__buffer or not self.__blocks:
+                    self.__submit()
+                while self.__pending:
+                    self.__file.write(self.__pending.popleft().result())
+            finally:
+                if self.__pool is not None:
+                    self.__pool.shutdown()
+                self.__file.close()
+
+        def __enter__(self):
+            return self
+
+        def __exit__(self, type_, value, traceback):
+            self.close()
+
+    def _open_blocks(mode, filename):
+        """Open a _BlockWriter with the configured level and threads."""
+        level = get_level()
+        if mode == 'bz2':
+            compress = functools.partial(
+                bz2.compress, compresslevel=9 if level is None else level)
+        elif mode == 'gz':
+            compress = functools.partial(
+                gzip.compress, compresslevel=9 if level is None else level)
+        else:
+            compress = functools.partial(lzma.compress,
+                                         preset=6 if level is None else level)
+
+        return _BlockWriter(filename, compress, get_threads())
 
     COMPRESSION_SUFFIXES = ['.gz', '.bz2', '.xz']
 
     COMPRESSORS = {
-        'bz2': functools.partial(bz2.open, mode='wt'),
-        'gz': functools.partial(gzip.open, mode='wt'),
+        'bz2': functools.partial(_open_blocks, 'bz2'),
+        'gz': functools.partial(_open_blocks, 'gz'),
         'none': functools.partial(open, mode='w'),
-        'xz': functools.partial(lzma.open, mode='wt'),
+        'xz': functools.partial(_open_blocks, 'xz'),
     }
 
     DECOMPRESSORS = {
-        'bz2': functools.partial(bz2.open, mode='rt'),
-        'gz': functools.partial(gzip.open, mode='rt'),
+        'bz2': functools.partial(bz2.open, mode='rt', encoding='utf-8'),
+        'gz': functools.partial(gzip.open, mode='rt', encoding='utf-8'),
         'none': functools.partial(open, mode='r'),
-        'xz': functools.partial(lzma.open, mode='rt'),
+        'xz': functools.partial(lzma.open, mode='rt', encoding='utf-8'),
     }
 
+    # zstandard is optional, and only has open() since 0.15
+    try:
+        import zstandard  # pylint: disable=wrong-import-position
+    except ImportError:
+        pass
+    else:
+        if hasattr(zstandard, 'open'):
+            def _compress_zst(filename):
+                """Open a zstd file for writing with a multi-threaded
+                compressor.
+                """
+                level = get_level()
+                return zstandard.open(
+                    filename, mode='wt', encoding='utf-8',
+                    cctx=zstandard.ZstdCompressor(
+                        level=3 if level is None else level,
+                        threads=get_threads()))
+
+            COMPRESSORS['zst'] = _compress_zst
+            DECOMPRESSORS['zst'] = functools.partial(
+                zstandard.open, mode='rt', encoding='utf-8')
+            COMPRESSION_SUFFIXES += ['.zst']
+
 
 def get_mode():
     """Return the key value of the correct compressor to use.
@@ -220,3 +334,35 @@ def get_mode():
         raise UnsupportedCompressor(method)
 
     return method
+
+
+def get_level():
+    """Return the compression level from piglit.conf, or None.
+
+    None means to use the default of the compression mode.
+
+    """
+    level = PIGLIT_CONFIG.safe_get('core', 'compression level')
+    if level is None:
+        return None
+    try:
+        return int(level)
+    except ValueError:
+        raise exceptions.PiglitFatalError(
+            'Invalid compression level: {}'.format(level))
+
+
+def get_threads():
+    """Return the number of threads to compress with.
+
+    This is taken from piglit.conf, and defaults to the number of cpus.
+
+    """
+    threads = PIGLIT_CONFIG.safe_get('core', 'compression threads')
+    if threads is None:
+        return multiprocessing.cpu_count()
+    try:
+        return max(int(threads), 1)
+    except ValueError:
+        raise exceptions.PiglitFatalError(
+            'Invalid number of compression threads: {}'.format(threads))
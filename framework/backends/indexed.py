@@ -0,0 +1,316 @@
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""An indexed results backend, for summaries of large runs.
+
+The json backend stores a run as a single document, so a summary has to
+parse all of it, output and all, before it can look at a single status.
+This backend stores the same data in a results.pidx file laid out as:
+
+- a header of the magic string and the format version
+- one zlib compressed record per test, in the json backend's format
+- a zlib compressed json index, which holds the metadata and totals of the
+  run and a table with a column per field: the test names, the offset and
+  length of each record, and the status, subtest statuses, time and phase
+  timings of each test
+- a footer of the magic string and the offset and length of the index
+
+Loading a run only reads the index. The TestResults of a loaded run are made
+from the index when they are looked up, and only read their record the first
+time another attribute, like out or err, is used.
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import collections
+import os
+import shutil
+import struct
+import zlib
+
+try:
+    import simplejson as json
+except ImportError:
+    import json
+
+import six
+
+from framework import results, exceptions
+from .abstract import FileBackend
+from .register import Registry
+from . import json as json_
+
+__all__ = [
+    'REGISTRY',
+    'IndexedBackend',
+]
+
+# The version of the container, the records themselves are json results of
+# the current version.
+CURRENT_INDEXED_VERSION = 1
+
+_MAGIC = b'PIGLITIX'
+_HEADER = struct.Struct('>8sI')
+_FOOTER = struct.Struct('>8sQQ')
+
+_COLUMNS = ['names', 'offsets', 'lengths', 'results', 'subtests', 'start',
+            'end', 'phases']
+
+
+class IndexedBackend(FileBackend):
+    """Backend writing a results.pidx file.
+
+    While the run is going this works like the json backend, with metadata
+    in metadata.json and the tests in a journal, finalize() then writes them
+    into the indexed file.
+
+    """
+    _file_extension = 'pidx'
+
+    def initialize(self, metadata):
+        metadata['results_version'] = json_.CURRENT_JSON_VERSION
+
+        with open(os.path.join(self._dest, 'metadata.json'), 'w') as f:
+            json.dump(metadata, f, default=json_.piglit_encoder)
+
+        try:
+            os.mkdir(os.path.join(self._dest, 'tests'))
+        except OSError:
+            pass
+
+    def finalize(self, metadata=None):
+        with open(os.path.join(self._dest, 'metadata.json'), 'r') as f:
+            meta = json.load(f)
+        if metadata:
+            meta.update(metadata)
+
+        columns = collections.OrderedDict((c, []) for c in _COLUMNS)
+        run = results.TestrunResult()
+
+        with open(os.path.join(self._dest, 'results.pidx'), 'wb') as f:
+            f.write(_HEADER.pack(_MAGIC, CURRENT_INDEXED_VERSION))
+            offset = _HEADER.size
+
+            for test in self._iter_tests():
+                (name, data), = six.iteritems(
+                    json.loads(test.decode('utf-8')))
+                test = results.TestResult.from_dict(data)
+                record = zlib.compress(
+                    json.dumps(test, default=json_.piglit_encoder).encode(
+                        'utf-8'))
+                f.write(record)
+
+                columns['names'].append(name)
+                columns['offsets'].append(offset)
+                columns['lengths'].append(len(record))
+                columns['results'].append(six.text_type(test.result))
+                columns['subtests'].append(
+                    {k: six.text_type(v)
+                     for k, v in six.iteritems(test.subtests)} or None)
+                columns['start'].append(test.time.start)
+                columns['end'].append(test.time.end)
+                columns['phases'].append(test.phases or None)
+                offset += len(record)
+
+                run.tests[name] = _status_result(columns, -1)
+
+            run.calculate_group_totals()
+            meta['totals'] = run.totals
+
+            index = zlib.compress(json.dumps(
+                {'metadata': meta, 'columns': columns},
+                default=json_.piglit_encoder).encode('utf-8'))
+            f.write(index)
+            f.write(_FOOTER.pack(_MAGIC, offset, len(index)))
+
+        os.unlink(os.path.join(self._dest, 'metadata.json'))
+        shutil.rmtree(os.path.join(self._dest, 'tests'))
+
+    @staticmethod
+    def _write(f, name, data):
+        json.dump({name: data}, f, default=json_.piglit_encoder)
+
+
+def _status_result(columns, row):
+    """Make a TestResult with only the status and times of a row."""
+    result = results.TestResult(columns['results'][row])
+    if columns['subtests'][row]:
+        result.subtests = results.Subtests(columns['subtests'][row])
+    result.time = results.TimeAttribute(columns['start'][row],
+                                        columns['end'][row])
+    # Files written before the phases column was added don't have it.
+    if columns.get('phases') and columns['phases'][row]:
+        result.phases = columns['phases'][row]
+    return result
+
+
+class IndexedTestResult(results.TestResult):
+    """A TestResult whose record is read the first time it is needed.
+
+    The result, subtests, time and phases attributes are set from the index,
+    every other attribute is left unset until the record is read.
+
+    """
+    __slots__ = ['_container', '_row', '_key']
+
+    def __init__(self, container, row):  # pylint: disable=super-init-not-called
+        self._container = container
+        self._row = row
+        self._key = json.dumps([container.columns[c][row] if c in
+                                container.columns else None
+                                for c in _COLUMNS[1:]], sort_keys=True)
+
+        status = _status_result(container.columns, row)
+        self.result = status.result
+        self.subtests = status.subtests
+        self.time = status.time
+        self.phases = status.phases
+
+    def __getattr__(self, name):
+        # Only called when an attribute isn't set, which means the record
+        # hasn't been read yet. Copying and pickling look up attributes
+        # before any slot is set.
+        if name.startswith('__') or \
+                name in ['_container', '_row', '_key'] or self._row is None:
+            raise AttributeError(name)
+
+        full = results.TestResult.from_dict(self._container.read(self._row))
+        self._row = None
+        for slot in results.TestResult.__slots__:
+            if slot == '__result':
+                continue
+            try:
+                setattr(self, slot, getattr(full, slot))
+            except AttributeError:
+                pass
+        self.result = full.result
+
+        return getattr(self, name)
+
+    def change_key(self):
+        """A string that changes whenever the test's record does.
+
+        It is made from the row in the index: the offset and length of the
+        record and the status and times of the test, so comparing results
+        with it doesn't read their records.
+
+        """
+        return self._key
+
+
+class _Container(object):
+    """An open results.pidx file."""
+    def __init__(self, filename):
+        self.filename = filename
+        self.__file = None
+
+        try:
+            with open(filename, 'rb') as f:
+                magic, version = _HEADER.unpack(f.read(_HEADER.size))
+                f.seek(-_FOOTER.size, os.SEEK_END)
+                footer, offset, length = _FOOTER.unpack(f.read(_FOOTER.size))
+                f.seek(offset)
+                index = f.read(length)
+        except (IOError, OSError, struct.error) as e:
+            raise exceptions.PiglitFatalError(
+                'While loading indexed results file: "{}",\n'
+                'the following error occurred:\n{}'.format(
+                    filename, six.text_type(e)))
+
+        if magic != _MAGIC or footer != _MAGIC or len(index) != length:
+            raise exceptions.PiglitFatalError(
+                'Not a complete indexed results file: "{}"'.format(filename))
+        if version != CURRENT_INDEXED_VERSION:
+            raise exceptions.PiglitFatalError(
+                'Unsupported indexed results version "{}" in "{}"'.format(
+                    version, filename))
+
+        index = json.loads(zlib.decompress(index).decode('utf-8'))
+        self.metadata = index['metadata']
+        self.columns = index['columns']
+        self.rows = {n: i for i, n in enumerate(self.columns['names'])}
+
+    def read(self, row):
+        """Read the record of a row as a dict."""
+        if self.__file is None:
+            self.__file = open(self.filename, 'rb')
+        self.__file.seek(self.columns['offsets'][row])
+        record = self.__file.read(self.columns['lengths'][row])
+        return json.loads(zlib.decompress(record).decode('utf-8'))
+
+
+class IndexedTests(collections.Mapping):
+    """The tests of an indexed run, mapping names to IndexedTestResults.
+
+    The results are made when they are looked up and aren't kept, so only
+    the records of the tests that are actually used are read, and they can
+    be freed again.
+
+    """
+    def __init__(self, container):
+        self.__container = container
+
+    def __getitem__(self, name):
+        return IndexedTestResult(self.__container,
+                                 self.__container.rows[name])
+
+    def __iter__(self):
+        return iter(self.__container.columns['names'])
+
+    def __len__(self):
+        return len(self.__container.columns['names'])
+
+
+def load_results(filename, compression_):  # pylint: disable=unused-argument
+    """Load an indexed run, or resume a partial one.
+
+    The records compress themselves, so the compression mode isn't used.
+
+    """
+    if os.path.isdir(filename):
+        filepath = os.path.join(filename, 'results.pidx')
+        if not os.path.exists(filepath):
+            if os.path.exists(os.path.join(filename, 'metadata.json')):
+                return json_._resume(filename)
+            raise exceptions.PiglitFatalError(
+                'No results found in "{}"'.format(filename))
+    else:
+        filepath = filename
+
+    container = _Container(filepath)
+    meta = dict(container.metadata)
+    meta['tests'] = {}
+
+    testrun = results.TestrunResult.from_dict(meta)
+    testrun.tests = IndexedTests(container)
+    return testrun
+
+
+def set_meta(results_):
+    """Set indexed specific metadata on a TestrunResult."""
+    results_.results_version = json_.CURRENT_JSON_VERSION
+
+
+REGISTRY = Registry(
+    extensions=['.pidx'],
+    backend=IndexedBackend,
+    load=load_results,
+    meta=set_meta,
+)
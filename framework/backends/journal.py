@@ -0,0 +1,185 @@
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""An append-only journal of test results.
+
+File backends record every test twice while it runs: once as incomplete
+when it starts and once with the real result when it finishes. Rather than
+writing a file per record, the records are appended to a single journal.
+
+Each record is a big endian header of the key length, the value length, and
+the crc32 of both, followed by the utf-8 key and the value. A record that was
+only partially written when piglit (or the machine) died fails its length or
+crc check, and it and anything after it is ignored. When the same key is
+written more than once the last record wins.
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import collections
+import os
+import struct
+import threading
+import zlib
+
+__all__ = [
+    'Journal',
+    'index',
+    'read',
+    'read_at',
+]
+
+_HEADER = struct.Struct('>III')
+
+
+def _crc(key, value):
+    return zlib.crc32(value, zlib.crc32(key)) & 0xffffffff
+
+
+def _records(f):
+    """Yield (offset, key, value) for each valid record in the file f."""
+    offset = 0
+    while True:
+        header = f.read(_HEADER.size)
+        if len(header) != _HEADER.size:
+            return
+        klen, vlen, crc = _HEADER.unpack(header)
+        key = f.read(klen)
+        value = f.read(vlen)
+        if len(key) != klen or len(value) != vlen or _crc(key, value) != crc:
+            return
+        yield offset, key.decode('utf-8'), value
+        offset += _HEADER.size + klen + vlen
+
+
+def read(filename):
+    """Yield (key, value) for each valid record of the journal filename.
+
+    Values are bytes. Superseded records are returned too, in the order they
+    were written.
+    """
+    with open(filename, 'rb') as f:
+        for _, key, value in _records(f):
+            yield key, value
+
+
+def index(filename):
+    """Return an OrderedDict mapping each key to its latest record's offset.
+
+    Keys are ordered by when they were first written. Only the offsets are
+    kept, so indexing a journal doesn't hold its values in memory; read them
+    back one at a time with read_at().
+    """
+    offsets = collections.OrderedDict()
+    with open(filename, 'rb') as f:
+        for offset, key, _ in _records(f):
+            offsets[key] = offset
+    return offsets
+
+
+def read_at(f, offset):
+    """Return the value of the record at offset of the open journal f."""
+    f.seek(offset)
+    return next(_records(f))[2]
+
+
+class Journal(object):
+    """An open journal that records can be appended to from any thread.
+
+    Every record is flushed to the OS as soon as it is appended, so it
+    survives piglit crashing. If sync is True records are also fsync'd to
+    survive the machine crashing, but to avoid an fsync per record they are
+    committed in groups: once commit_records are waiting, or commit_interval
+    seconds after the oldest waiting record was appended, whichever comes
+    first. The time limit is enforced by a timer, so the record of a test
+    that hangs the machine still makes it to disk.
+
+    If the journal already exists, any partially written record at its end
+    is dropped before new records are appended.
+
+    Arguments:
+    filename -- the file to append to.
+
+    Keyword Arguments:
+    sync -- fsync records. Default: False
+    commit_records -- the most records waiting for an fsync. Default: 64
+    commit_interval -- the longest a record waits for an fsync, in seconds.
+                       Default: 0.1
+    """
+    def __init__(self, filename, sync=False, commit_records=64,
+                 commit_interval=0.1):
+        self.filename = filename
+        self.commits = 0
+        self.__sync = sync
+        self.__commit_records = commit_records
+        self.__commit_interval = commit_interval
+        self.__pending = 0
+        self.__timer = None
+        self.__lock = threading.Lock()
+
+        end = 0
+        if os.path.exists(filename):
+            with open(filename, 'rb') as f:
+                for _ in _records(f):
+                    end = f.tell()
+        self.__file = open(filename, 'ab')
+        self.__file.truncate(end)
+
+    def append(self, key, value):
+        """Append a record. value must be bytes."""
+        key = key.encode('utf-8')
+        record = _HEADER.pack(len(key), len(value), _crc(key, value)) + \
+            key + value
+
+        with self.__lock:
+            self.__file.write(record)
+            self.__file.flush()
+            if not self.__sync:
+                return
+
+            self.__pending += 1
+            if self.__pending >= self.__commit_records:
+                self.__commit()
+            elif self.__timer is None:
+                self.__timer = threading.Timer(self.__commit_interval,
+                                               self.commit)
+                self.__timer.daemon = True
+                self.__timer.start()
+
+    def __commit(self):
+        """fsync the waiting records. The lock must be held."""
+        if self.__timer is not None:
+            self.__timer.cancel()
+            self.__timer = None
+        if self.__pending and not self.__file.closed:
+            os.fsync(self.__file.fileno())
+            self.commits += 1
+        self.__pending = 0
+
+    def commit(self):
+        """fsync any records that are waiting."""
+        with self.__lock:
+            self.__commit()
+
+    def close(self):
+        """Commit any waiting records and close the journal."""
+        with self.__lock:
+            self.__commit()
+            self.__file.close()
@@ -45,7 +45,7 @@ except ImportError:
 from framework import status, results, exceptions, compat
 from .abstract import FileBackend, write_compressed
 from .register import Registry
-from . import compression
+from . import compression, journal
 
 __all__ = [
     'REGISTRY',
@@ -84,10 +84,11 @@ class JSONBackend(FileBackend):
     json module or the simplejson.
 
     This class is atomic, writes either completely fail or completley succeed.
-    To achieve this it writes individual files for each test and for the
-    metadata, and composes them at the end into a single file and removes the
-    intermediate files. When it tries to compose these files if it cannot read
-    a file it just ignores it, making the result atomic.
+    To achieve this it writes a file for the metadata and a journal record
+    for each test, and composes them at the end into a single file and
+    removes the intermediate files. When it tries to compose these files any
+    record that was not completely written is ignored, making the result
+    atomic.
 
     """
     _file_extension = 'json'
@@ -139,19 +140,8 @@ class JSONBackend(FileBackend):
             # Add the tests to the dictionary
             data['tests'] = collections.OrderedDict()
 
-            test_dir = os.path.join(self._dest, 'tests')
-            for test in os.listdir(test_dir):
-                test = os.path.join(test_dir, test)
-                if os.path.isfile(test):
-                    # Try to open the json snippets. If we fail to open a test
-                    # then throw the whole thing out. This gives us atomic
-                    # writes, the writing worked and is valid or it didn't
-                    # work.
-                    try:
-                        with open(test, 'r') as f:
-                            data['tests'].update(json.load(f))
-                    except ValueError:
-                        pass
+            for test in self._iter_tests():
+                data['tests'].update(json.loads(test.decode('utf-8')))
             assert data['tests']
 
             data = results.TestrunResult.from_dict(data)
@@ -178,19 +168,10 @@ class JSONBackend(FileBackend):
                     if metadata:
                         s.iterwrite(six.iteritems(metadata))
 
-                    test_dir = os.path.join(self._dest, 'tests')
                     with s.subobject('tests') as t:
-                        for test in os.listdir(test_dir):
-                            test = os.path.join(test_dir, test)
-                            if os.path.isfile(test):
-                                try:
-                                    with open(test, 'r') as f:
-                                        a = json.load(f)
-                                except ValueError:
-                                    continue
-
-                                t.iterwrite(six.iteritems(a))
-
+                        for test in self._iter_tests():
+                            t.iterwrite(six.iteritems(
+                                json.loads(test.decode('utf-8'))))
 
         # Delete the temporary files
         os.unlink(os.path.join(self._dest, 'metadata.json'))
@@ -200,6 +181,15 @@ class JSONBackend(FileBackend):
     def _write(f, name, data):
         json.dump({name: data}, f, default=piglit_encoder)
 
+    def _legacy_record(self, data):
+        # Each file holds {name: result}, like a journal record. Files that
+        # were only partially written are dropped, as they always were.
+        try:
+            (name, _), = six.iteritems(json.loads(data.decode('utf-8')))
+        except (ValueError, AttributeError):
+            return None
+        return name, data
+
 
 def load_results(filename, compression_):
     """ Loader function for TestrunResult class
@@ -281,9 +271,17 @@ def _resume(results_dir):
 
     meta['tests'] = {}
 
-    # Load all of the test names and added them to the test list
-    for file_ in os.listdir(os.path.join(results_dir, 'tests')):
-        with open(os.path.join(results_dir, 'tests', file_), 'r') as f:
+    # Load all of the test names and added them to the test list. Results
+    # written by older versions of piglit have a file per test rather than a
+    # journal. The indexed backend writes the same journal while it runs.
+    test_dir = os.path.join(results_dir, 'tests')
+    for file_ in os.listdir(test_dir):
+        if file_ in ['journal.json', 'journal.pidx']:
+            for _, value in journal.read(os.path.join(test_dir, file_)):
+                meta['tests'].update(json.loads(value.decode('utf-8')))
+            continue
+
+        with open(os.path.join(test_dir, file_), 'r') as f:
             try:
                 meta['tests'].update(json.load(f))
             except ValueError:
@@ -318,16 +318,9 @@ class JUnitBackend(FileBackend):
         root = etree.Element('testsuites')
         piglit = etree.Element('testsuite', name='piglit')
         root.append(piglit)
-        for each in os.listdir(os.path.join(self._dest, 'tests')):
-            with open(os.path.join(self._dest, 'tests', each), 'r') as f:
-                # parse returns an element tree, and that's not what we want,
-                # we want the first (and only) Element node
-                # If the element cannot be properly parsed then consider it a
-                # failed transaction and ignore it.
-                try:
-                    piglit.append(etree.parse(f).getroot())
-                except etree.ParseError:
-                    continue
+        for each in self._iter_tests():
+            # fromstring returns the Element node, which is what we want
+            piglit.append(etree.fromstring(each))
 
         # set the test count by counting the number of tests.
         # This must be unicode (py3 str)
@@ -21,9 +21,11 @@
 
 """ Module implementing classes for reading posix dmesg
 
-Currently this module only has the default DummyDmesg, and a LinuxDmesg.
-The method used on Linux requires that timetamps are enabled, and no other
-posix system has timestamps.
+Currently this module only has the default DummyDmesg, a LinuxDmesg and a
+KmsgDmesg. LinuxDmesg runs dmesg before and after each test and requires that
+timetamps are enabled, and no other posix system has timestamps. KmsgDmesg
+reads /dev/kmsg as messages arrive, and can be used while tests run
+concurrently.
 
 On OSX and *BSD one would likely want to implement a system that reads the
 sysloger, since timestamps can be added by the sysloger, and are not inserted
@@ -39,10 +41,15 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import abc
+import collections
+import errno
 import gzip
+import os
 import re
+import select
 import subprocess
 import sys
+import threading
 import warnings
 
 import six
@@ -52,6 +59,8 @@ from framework import exceptions
 __all__ = [
     'BaseDmesg',
     'DummyDmesg',
+    'KmsgDmesg',
+    'KmsgReader',
     'LinuxDmesg',
     'get_dmesg',
 ]
@@ -72,9 +81,12 @@ class BaseDmesg(object):
     This class is not thread safe, because it does not black between the start
     of the test and the reading of dmesg, which means that if two tests run at
     the same time, and test A creates an entri in dmesg, but test B finishes
-    first, test B will be marked as having the dmesg error.
+    first, test B will be marked as having the dmesg error. Subclasses that can
+    tell which messages belong to which test set thread_safe.
 
     """
+    thread_safe = False
+
     @abc.abstractmethod
     def __init__(self):
         # A list containing all messages since the last time dmesg was read.
@@ -113,6 +125,13 @@ class BaseDmesg(object):
         result -- A TestResult instance
 
         """
+        # Get a new snapshot of dmesg
+        self.update_dmesg()
+
+        return self._update_result(result, self._new_messages)
+
+    def _update_result(self, result, messages):
+        """Update a TestResult with the dmesg messages logged during it."""
         def replace(res):
             """ helper to replace statuses with the new dmesg status
 
@@ -126,15 +145,12 @@ class BaseDmesg(object):
                 "fail": "dmesg-fail"
             }.get(res, res)
 
-        # Get a new snapshot of dmesg
-        self.update_dmesg()
-
-        # if update_dmesg() found new entries replace the results of the test
-        # and subtests
-        if self._new_messages:
+        # if there are new entries replace the results of the test and
+        # subtests
+        if messages:
 
             if self.regex:
-                for line in self._new_messages:
+                for line in messages:
                     if self.regex.search(line):
                         break
                 else:
@@ -147,7 +163,7 @@ class BaseDmesg(object):
                 result.subtests[key] = replace(value)
 
             # Add the dmesg values to the result
-            result.dmesg = "\n".join(self._new_messages)
+            result.dmesg = "\n".join(messages)
 
         return result
 
@@ -227,6 +243,236 @@ class LinuxDmesg(BaseDmesg):
         return 'LinuxDmesg()'
 
 
+class KmsgReader(object):
+    """Read the kernel log from /dev/kmsg in a background thread.
+
+    Only messages logged after the reader is created are read. Each message
+    gets a position in the log, in the order the kernel logged them, and a
+    position returned by mark() is after every message logged before mark()
+    was called. A range of positions can then be turned into the messages
+    logged during it.
+
+    A message is kept until there are no marks before it, so a mark has to be
+    released when it isn't needed anymore. Reading in the background keeps
+    the kernel's ring buffer from overwriting messages during long tests.
+
+    """
+    KMSG = '/dev/kmsg'
+
+    def __init__(self, path=KMSG):
+        self._fd = os.open(path, os.O_RDONLY | os.O_NONBLOCK)
+        os.lseek(self._fd, 0, os.SEEK_END)
+
+        self._lock = threading.Lock()
+        # (level, line) of each message, the first is at position _first
+        self._messages = collections.deque()
+        self._first = 0
+        self._marks = collections.Counter()
+
+        thread = threading.Thread(target=self._run)
+        thread.daemon = True
+        thread.start()
+
+    @staticmethod
+    def parse(record):
+        """Turn a /dev/kmsg record into its level and a line like dmesg's.
+
+        A record looks like "6,1234,5678901,-;message\n", with the priority,
+        the sequence number, the timestamp in microseconds and flags, and may
+        be followed by continuation lines, which are dropped.
+
+        """
+        record = record.decode('utf-8', 'replace')
+        header, _, text = record.partition(';')
+        prio, _, rest = header.partition(',')
+        usecs = int(rest.split(',')[1])
+        return (int(prio) & 7,
+                '[{:5d}.{:06d}] {}'.format(usecs // 1000000, usecs % 1000000,
+                                           text.split('\n', 1)[0]))
+
+    def _drain(self):
+        """Read every message that is available. Must hold the lock."""
+        while True:
+            try:
+                record = os.read(self._fd, 8192)
+            except OSError as e:
+                if e.errno == errno.EAGAIN:
+                    break
+                elif e.errno == errno.EPIPE:
+                    # Messages were overwritten before they were read, the
+                    # next read returns the oldest one left.
+                    continue
+                raise
+            if not record:
+                break
+            self._messages.append(self.parse(record))
+
+        # Messages before every mark can't be asked for anymore
+        keep = min(self._marks) if self._marks else self.position
+        while self._first < keep:
+            self._messages.popleft()
+            self._first += 1
+
+    def _run(self):
+        while True:
+            select.select([self._fd], [], [])
+            with self._lock:
+                self._drain()
+
+    @property
+    def position(self):
+        """The position after the last message read."""
+        return self._first + len(self._messages)
+
+    def mark(self):
+        """Read the available messages and mark the position after them."""
+        with self._lock:
+            self._drain()
+            position = self.position
+            self._marks[position] += 1
+        return position
+
+    def release(self, position):
+        """Release a mark, the messages before it can then be dropped."""
+        with self._lock:
+            self._marks[position] -= 1
+            if not self._marks[position]:
+                del self._marks[position]
+
+    def messages(self, start, end):
+        """Get the (position, level, line) of the messages in [start, end).
+
+        start has to be a mark that isn't released yet.
+
+        """
+        with self._lock:
+            return [(start + i,) + self._messages[start - self._first + i]
+                    for i in six.moves.range(end - start)]
+
+
+_KMSG_READER = None
+_KMSG_READER_LOCK = threading.Lock()
+
+
+def get_kmsg_reader():
+    """Get the KmsgReader shared by every user of /dev/kmsg.
+
+    Raises OSError if /dev/kmsg can't be opened. Whether it can depends on
+    more than its permissions, kernel.dmesg_restrict for one, so trying is
+    the only way to find out.
+
+    """
+    global _KMSG_READER  # pylint: disable=global-statement
+    with _KMSG_READER_LOCK:
+        if _KMSG_READER is None:
+            _KMSG_READER = KmsgReader()
+        return _KMSG_READER
+
+
+class KmsgDmesg(BaseDmesg):
+    """ Read dmesg from /dev/kmsg, while tests run concurrently
+
+    Instead of comparing the whole ring buffer before and after each test,
+    this keeps a log of the messages with a KmsgReader, and marks where each
+    test starts and ends in it. A test gets the messages between its marks.
+
+    When tests run concurrently a message may have been logged by another
+    test that was running at the same time. Such messages are still reported,
+    since the test may have caused them, but they are marked as ambiguous.
+    Each test that overlaps such a message gets it.
+
+    """
+    thread_safe = True
+
+    # The levels from emerg to notice, like LinuxDmesg
+    LEVEL = 5
+
+    def __init__(self):  # pylint: disable=super-init-not-called
+        # Unlike the other implementations nothing has to be read initially,
+        # the reader only reads messages logged after it is created.
+        self._new_messages = []
+        self.regex = None
+
+        self._reader = get_kmsg_reader()
+        self._local = threading.local()
+        self._lock = threading.Lock()
+        # The start marks of the running tests, and the (start, end) marks
+        # of the finished ones that may still overlap a running test.
+        self._running = collections.Counter()
+        self._finished = []
+
+    def update_dmesg(self):
+        """ Mark the start of a test on this thread """
+        start = getattr(self._local, 'start', None)
+        if start is not None:
+            # The last test of this thread didn't finish, forget it.
+            self._reader.release(self._end(start)[0])
+            self._reader.release(start)
+
+        with self._lock:
+            self._local.start = self._reader.mark()
+            self._running[self._local.start] += 1
+
+    def _end(self, start):
+        """Mark the end of the test that started at start.
+
+        Returns the end mark, and the marks of the other tests that were
+        running at the same time. Both the start and end marks have to be
+        released by the caller, once it has the messages between them.
+
+        """
+        self._local.start = None
+
+        with self._lock:
+            end = self._reader.mark()
+            self._running[start] -= 1
+            if not self._running[start]:
+                del self._running[start]
+
+            others = [(s, None) for s in self._running] + [
+                (s, e) for s, e in self._finished if s < end and e > start]
+            self._finished.append((start, end))
+
+            # A test that ended before the first running test started can't
+            # overlap it, or any test that starts later.
+            first = min(self._running) if self._running else end
+            self._finished = [w for w in self._finished if w[1] > first]
+
+        return end, others
+
+    def update_result(self, result):
+        """ Update a TestResult with the messages logged during the test
+
+        Arguments:
+        result -- A TestResult instance
+
+        """
+        start = getattr(self._local, 'start', None)
+        if start is None:
+            return result
+
+        end, others = self._end(start)
+        try:
+            logged = self._reader.messages(start, end)
+        finally:
+            self._reader.release(start)
+            self._reader.release(end)
+
+        messages = []
+        for position, level, line in logged:
+            if level > self.LEVEL:
+                continue
+            if any(s <= position and (e is None or position < e)
+                   for s, e in others):
+                line = '(ambiguous) ' + line
+            messages.append(line)
+
+        return self._update_result(result, messages)
+
+    def __repr__(self):
+        return 'KmsgDmesg()'
+
+
 class DummyDmesg(BaseDmesg):
     """ An dummy class for dmesg on non unix-like systems
 
@@ -259,7 +505,12 @@ def get_dmesg(not_dummy=True):
     your system. However, if Dummy is True then it will always return a
     DummyDmesg instance.
 
+    On Linux /dev/kmsg is read if it can be opened, otherwise dmesg is run.
+
     """
     if sys.platform.startswith('linux') and not_dummy:
-        return LinuxDmesg()
+        try:
+            return KmsgDmesg()
+        except OSError:
+            return LinuxDmesg()
     return DummyDmesg()
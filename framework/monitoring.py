@@ -42,7 +42,7 @@ import re
 import six
 
 from framework.core import PIGLIT_CONFIG
-from framework.dmesg import LinuxDmesg
+from framework.dmesg import LinuxDmesg, get_kmsg_reader
 from framework import exceptions
 
 __all__ = [
@@ -301,15 +301,56 @@ if os.name == 'posix':
         This class is for monitoring on the system dmesg. It's inherited
         from LinuxDmesg for the dmesg processing methods.
 
+        When /dev/kmsg can be read the messages come from the same
+        KmsgReader as KmsgDmesg's instead, and --level is the only option of
+        dmesg that is supported.
+
         Work only on Linux operating system.
 
         """
+        LEVELS = ['emerg', 'alert', 'crit', 'err', 'warn', 'notice', 'info',
+                  'debug']
+
         def __init__(self, monitoring_source, regex):
             """Create a MonitoringLinuxDmesg instance"""
-            self.DMESG_COMMAND = ['dmesg']+monitoring_source.split()
             BaseMonitoring.__init__(self, monitoring_source, regex)
-            LinuxDmesg.__init__(self)
+            try:
+                self._reader = get_kmsg_reader()
+            except OSError:
+                self._reader = None
+
+            if self._reader is not None:
+                self._levels = self._get_levels(monitoring_source)
+                self._position = self._reader.mark()
+            else:
+                self.DMESG_COMMAND = ['dmesg']+monitoring_source.split()
+                LinuxDmesg.__init__(self)
+
+        @classmethod
+        def _get_levels(cls, options):
+            """Get the levels of the --level option of dmesg"""
+            options = options.split()
+            for i, option in enumerate(options):
+                if option.startswith('--level='):
+                    levels = option[len('--level='):]
+                elif option in ['--level', '-l'] and i + 1 < len(options):
+                    levels = options[i + 1]
+                else:
+                    continue
+                return {cls.LEVELS.index(l) for l in levels.split(',')
+                        if l in cls.LEVELS}
+            return set(range(len(cls.LEVELS)))
 
         def update_monitoring(self):
-            """Call update_dmesg"""
-            self.update_dmesg()
+            """Get the new messages of dmesg"""
+            if self._reader is None:
+                self.update_dmesg()
+                return
+
+            position = self._reader.mark()
+            self._new_messages = [
+                line for _, level, line in
+                self._reader.messages(self._position, position)
+                if level in self._levels]
+            self._reader.release(self._position)
+            self._position = position
@@ -33,12 +33,15 @@ from __future__ import (
 import collections
 import contextlib
 import copy
+import datetime
+import heapq
 import importlib
 import itertools
 import multiprocessing
 import multiprocessing.dummy
 import os
 import re
+import time
 
 import six
 
@@ -50,6 +53,7 @@ from framework.test.base import Test
 
 __all__ = [
     'RegexFilter',
+    'Schedule',
     'TestDict',
     'TestProfile',
     'load_test_profile',
@@ -361,7 +365,71 @@ def load_test_profile(filename):
             'Did you specify the right file?'.format(filename))
 
 
-def run(profiles, logger, backend, concurrency):
+class Schedule(object):
+    """Orders tests so that the ones expected to take longest start first.
+
+    When tests are handed to the pool in dictionary order a single long test
+    picked up at the end of a run keeps one thread busy while every other
+    thread sits idle. Starting the longest tests first (the LPT heuristic)
+    leaves only short tests for the tail of the run.
+
+    Tests that aren't in timings are assumed to take the median of the known
+    times, or DEFAULT_ESTIMATE seconds if no times are known at all.
+
+    Arguments:
+    timings -- a dict mapping test names to their wall time in seconds,
+               usually from a previous run's results.
+    """
+    DEFAULT_ESTIMATE = 1.0
+
+    def __init__(self, timings):
+        self.timings = timings
+        known = sorted(timings.values())
+        if known:
+            mid = len(known) // 2
+            if len(known) % 2:
+                self.fallback = known[mid]
+            else:
+                self.fallback = (known[mid - 1] + known[mid]) / 2
+        else:
+            self.fallback = self.DEFAULT_ESTIMATE
+
+    @classmethod
+    def from_results(cls, results):
+        """Create a Schedule from a TestrunResult instance."""
+        return cls({name: r.time.total
+                    for name, r in six.iteritems(results.tests)
+                    if r.time.end > r.time.start})
+
+    def estimate(self, name):
+        """Return the expected run time of the test called name."""
+        return self.timings.get(name, self.fallback)
+
+    def order(self, test_list):
+        """Return the (name, test) pairs of test_list, longest first.
+
+        The sort is stable, so tests with equal estimates keep their order.
+        """
+        return sorted(test_list, key=lambda x: self.estimate(x[0]),
+                      reverse=True)
+
+    def makespan(self, lanes):
+        """Return the predicted wall time of running lanes side by side.
+
+        Each lane is a (workers, names) tuple describing a pool and the tests
+        it will be given, in dispatch order. A pool hands each test to
+        whichever of its workers frees up first.
+        """
+        finish = 0.0
+        for workers, names in lanes:
+            heap = [0.0] * max(workers, 1)
+            for name in names:
+                heapq.heapreplace(heap, heap[0] + self.estimate(name))
+            finish = max(finish, max(heap))
+        return finish
+
+
+def run(profiles, logger, backend, concurrency, schedule=None):
     """Runs all tests using Thread pool.
 
     When called this method will flatten out self.tests into self.test_list,
@@ -372,12 +440,19 @@ def run(profiles, logger, backend, concurrency):
     tests concurrently, all serially, or first the thread safe tests then the
     serial tests.
 
+    If a Schedule is provided the tests of each profile are dispatched
+    longest first. The thread safe and serial tests are already run side by
+    side, so each pool gets its own ordered queue and the predicted length of
+    the run is the longer of the two. The predicted and actual wall time of
+    the run are printed at the end.
+
     Finally it will print a final summary of the tests.
 
     Arguments:
     profiles -- a list of Profile instances.
     logger   -- a log.LogManager instance.
     backend  -- a results.Backend derived instance.
+    schedule -- an optional Schedule instance.
     """
     chunksize = 1
 
@@ -387,6 +462,26 @@ def run(profiles, logger, backend, concurrency):
     profiles = [(p, list(p.itertests())) for p in profiles]
     log = LogManager(logger, sum(len(l) for _, l in profiles))
 
+    # Split each profile's tests into the lists that will be handed to each
+    # pool, so that a schedule can order them and predict the run time.
+    if concurrency == "all":
+        queues = [(l, []) for _, l in profiles]
+    elif concurrency == "none":
+        queues = [([], l) for _, l in profiles]
+    else:
+        assert concurrency == "some"
+        queues = [([x for x in l if x[1].run_concurrent],
+                   [x for x in l if not x[1].run_concurrent])
+                  for _, l in profiles]
+
+    if schedule is not None:
+        queues = [(schedule.order(m), schedule.order(s)) for m, s in queues]
+        predicted = schedule.makespan([
+            (multiprocessing.cpu_count(),
+             [x[0] for m, _ in queues for x in m]),
+            (1, [x[0] for _, s in queues for x in s]),
+        ])
+
     def test(name, test, profile, this_pool=None):
         """Function to call test.execute from map"""
         with backend.write_test(name) as w:
@@ -395,34 +490,18 @@ def run(profiles, logger, backend, concurrency):
         if profile.options['monitor'].abort_needed:
             this_pool.terminate()
 
-    def run_threads(pool, profile, test_list, filterby=None):
+    def run_threads(pool, profile, test_list):
         """ Open a pool, close it, and join it """
-        if filterby:
-            # Although filterby could be attached to TestProfile as a filter,
-            # it would have to be removed when run_threads exits, requiring
-            # more code, and adding side-effects
-            test_list = (x for x in test_list if filterby(x))
-
         pool.imap(lambda pair: test(pair[0], pair[1], profile, pool),
                   test_list, chunksize)
 
-    def run_profile(profile, test_list):
+    def run_profile(profile, concurrent, serial):
         """Run an individual profile."""
         profile.setup()
-        if concurrency == "all":
-            run_threads(multi, profile, test_list)
-        elif concurrency == "none":
-            run_threads(single, profile, test_list)
-        else:
-            assert concurrency == "some"
-            # Filter and return only thread safe tests to the threaded pool
-            run_threads(multi, profile, test_list,
-                        lambda x: x[1].run_concurrent)
-
-            # Filter and return the non thread safe tests to the single
-            # pool
-            run_threads(single, profile, test_list,
-                        lambda x: not x[1].run_concurrent)
+        if concurrent:
+            run_threads(multi, profile, concurrent)
+        if serial:
+            run_threads(single, profile, serial)
         profile.teardown()
 
     # Multiprocessing.dummy is a wrapper around Threading that provides a
@@ -432,9 +511,10 @@ def run(profiles, logger, backend, concurrency):
     single = multiprocessing.dummy.Pool(1)
     multi = multiprocessing.dummy.Pool()
 
+    start = time.time()
     try:
-        for p in profiles:
-            run_profile(*p)
+        for (p, _), (concurrent, serial) in zip(profiles, queues):
+            run_profile(p, concurrent, serial)
 
         for pool in [single, multi]:
             pool.close()
@@ -442,6 +522,11 @@ def run(profiles, logger, backend, concurrency):
     finally:
         log.get().summary()
 
+    if schedule is not None:
+        print('Predicted run time: {}, actual run time: {}'.format(
+            datetime.timedelta(seconds=int(predicted)),
+            datetime.timedelta(seconds=int(time.time() - start))))
+
     for p, _ in profiles:
         if p.options['monitor'].abort_needed:
             raise exceptions.PiglitAbort(p.options['monitor'].error_message)
@@ -0,0 +1,194 @@
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""A persistent index of parsed test files.
+
+Building a profile like all.py means parsing the requirements of thousands of
+shader_test and glslparser files, every time the profile is imported. The
+ProfileIndex keeps the result of parsing each file on disk along with the
+file's mtime and size, so that later imports only parse the files that
+changed. The directories are still walked and every file stat'ed on each
+import, which with building the rest of the profile is most of the time a
+warm import takes.
+
+Setting PIGLIT_NO_PROFILE_INDEX in the environment disables the index.
+
+"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import errno
+import hashlib
+import json
+import os
+import tempfile
+
+from framework.test import glsl_parser_test, shader_test
+
+__all__ = [
+    'ProfileIndex',
+]
+
+_DISABLED = bool(os.environ.get('PIGLIT_NO_PROFILE_INDEX', False))
+
+
+class ProfileIndex(object):
+    """A cache of parsed test files, keyed by their path.
+
+    Entries are validated against the file's mtime and size on every lookup.
+    Entries for files that were not looked up are dropped on write(), so the
+    index doesn't grow as tests are removed or renamed.
+
+    Arguments:
+    path -- where the index is stored. If None nothing is loaded or saved.
+
+    """
+    # Bump this whenever the data stored by a parser's to_json() changes.
+    VERSION = 1
+
+    def __init__(self, path):
+        self.path = path
+        self.hits = 0
+        self.misses = 0
+        self.__entries = {}
+        self.__seen = set()
+        self.__dirty = False
+
+        if path is None:
+            return
+
+        try:
+            with open(path, 'r') as f:
+                data = json.load(f)
+        except (IOError, OSError, ValueError):
+            return
+
+        if isinstance(data, dict) and data.get('version') == self.VERSION:
+            self.__entries = data.get('entries', {})
+
+    @classmethod
+    def for_dirs(cls, basedirs):
+        """Return the index for the tests found under basedirs.
+
+        Each set of directories gets its own file in the user's cache
+        directory, so separate piglit checkouts don't evict each other's
+        entries.
+        """
+        if _DISABLED:
+            return cls(None)
+
+        cache_home = os.environ.get('XDG_CACHE_HOME',
+                                    os.path.expandvars('$HOME/.cache'))
+        key = hashlib.sha1(
+            '\n'.join(basedirs).encode('utf-8')).hexdigest()[:16]
+        return cls(os.path.join(cache_home, 'piglit',
+                                'profile-index-{}.json'.format(key)))
+
+    def __lookup(self, filename, kind, parse):
+        """Return the cached data of filename, calling parse() on a miss."""
+        st = os.stat(filename)
+        self.__seen.add(filename)
+
+        entry = self.__entries.get(filename)
+        if (entry is not None and entry['kind'] == kind and
+                entry['mtime'] == st.st_mtime and
+                entry['size'] == st.st_size):
+            self.hits += 1
+            return entry['data']
+
+        self.misses += 1
+        data = parse()
+        self.__entries[filename] = {
+            'kind': kind,
+            'mtime': st.st_mtime,
+            'size': st.st_size,
+            'data': data,
+        }
+        self.__dirty = True
+        return data
+
+    def shader_test(self, filename):
+        """Return a parsed shader_test.Parser for filename."""
+        def parse():
+            parser = shader_test.Parser(filename)
+            parser.parse()
+            return parser.to_json()
+
+        return shader_test.Parser.from_dict(
+            filename, self.__lookup(filename, 'shader_test', parse))
+
+    def glsl_parser_test(self, filename):
+        """Return a glsl_parser_test.Parser for filename.
+
+        Raises GLSLParserNoConfigError if the file has no config block, just
+        like the Parser would. That outcome is cached too.
+        """
+        def parse():
+            try:
+                return glsl_parser_test.Parser(filename).to_json()
+            except glsl_parser_test.GLSLParserNoConfigError:
+                return None
+
+        config = self.__lookup(filename, 'glsl_parser_test', parse)
+        if config is None:
+            raise glsl_parser_test.GLSLParserNoConfigError(
+                'No [config] section found!')
+        return glsl_parser_test.Parser(filename, config)
+
+    def write(self):
+        """Save the index, if anything changed.
+
+        The index is only a cache, so failing to write it is not an error.
+        """
+        stale = set(self.__entries) - self.__seen
+        if self.path is None or not (self.__dirty or stale):
+            return
+
+        for each in stale:
+            del self.__entries[each]
+
+        dirname = os.path.dirname(self.path)
+        try:
+            os.makedirs(dirname)
+        except OSError as e:
+            if e.errno != errno.EEXIST:
+                return
+
+        # Write to a temporary file and rename it into place, so that a
+        # concurrent import never sees a partially written index.
+        try:
+            fd, tmp = tempfile.mkstemp(dir=dirname)
+        except (IOError, OSError):
+            return
+
+        try:
+            with os.fdopen(fd, 'w') as f:
+                json.dump({'version': self.VERSION,
+                           'entries': self.__entries}, f)
+            if os.name == 'nt' and os.path.exists(self.path):
+                os.remove(self.path)
+            os.rename(tmp, self.path)
+        except (IOError, OSError):
+            try:
+                os.remove(tmp)
+            except OSError:
+                pass
+            return
+
+        self.__dirty = False
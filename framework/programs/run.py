@@ -149,7 +149,8 @@ def _run_parser(input_):
     parser.add_argument("--dmesg",
                         action="store_true",
                         help="Capture a difference in dmesg before and "
-                             "after each test. Implies -1/--no-concurrency")
+                             "after each test. Implies -1/--no-concurrency "
+                             "unless /dev/kmsg can be read")
     parser.add_argument("--abort-on-monitored-error",
                         action="store_true",
                         dest="monitored",
@@ -207,6 +208,25 @@ def _run_parser(input_):
                              'isolation. This allows, but does not require, '
                              'tests to run multiple tests per process. '
                              'This value can also be set in piglit.conf.')
+    parser.add_argument('--shader-runner-workers',
+                        dest='shader_runner_workers',
+                        action='store',
+                        type=booltype,
+                        default=core.PIGLIT_CONFIG.safe_get(
+                            'core', 'shader runner workers', 'false'),
+                        metavar='<bool>',
+                        help='Run shader tests in long lived shader_runner '
+                             'processes, one per thread, that are fed test '
+                             'files one at a time. Each file is still '
+                             'reported as its own test. This value can also '
+                             'be set in piglit.conf.')
+    parser.add_argument('--schedule-from',
+                        dest='schedule_from',
+                        type=path.realpath,
+                        metavar='<Results Path>',
+                        help='Use the test times recorded in a previous '
+                             'run to start the longest tests first, and '
+                             'report the predicted and actual run time.')
     parser.add_argument("test_profile",
                         metavar="<Profile path(s)>",
                         nargs='+',
@@ -279,9 +299,11 @@ def run(input_):
     args = _run_parser(input_)
     _disable_windows_exception_messages()
 
-    # If dmesg is requested we must have serial run, this is because dmesg
-    # isn't reliable with threaded run
-    if args.dmesg or args.monitored:
+    # If dmesg is requested we must have serial run, unless it can tell which
+    # test logged what, because otherwise dmesg isn't reliable with threaded
+    # run
+    dmesg_ = dmesg.get_dmesg(args.dmesg) if args.dmesg else None
+    if (dmesg_ and not dmesg_.thread_safe) or args.monitored:
         args.concurrency = "none"
 
     # Pass arguments into Options
@@ -290,6 +312,7 @@ def run(input_):
     options.OPTIONS.sync = args.sync
     options.OPTIONS.deqp_mustpass = args.deqp_mustpass
     options.OPTIONS.process_isolation = args.process_isolation
+    options.OPTIONS.shader_runner_workers = args.shader_runner_workers
 
     # Set the platform to pass to waffle
     options.OPTIONS.env['PIGLIT_PLATFORM'] = args.platform
@@ -336,9 +359,9 @@ def run(input_):
         profiles[0].forced_test_list = forced_test_list
 
     # Set the dmesg type
-    if args.dmesg:
+    if dmesg_:
         for p in profiles:
-            p.options['dmesg'] = dmesg.get_dmesg(args.dmesg)
+            p.options['dmesg'] = dmesg_
 
     if args.monitored:
         for p in profiles:
@@ -351,9 +374,15 @@ def run(input_):
         if args.include_tests:
             p.filters.append(profile.RegexFilter(args.include_tests))
 
+    schedule = None
+    if args.schedule_from:
+        schedule = profile.Schedule.from_results(
+            backends.load(args.schedule_from))
+
     time_elapsed = TimeAttribute(start=time.time())
 
-    profile.run(profiles, args.log_level, backend, args.concurrency)
+    profile.run(profiles, args.log_level, backend, args.concurrency,
+                schedule)
 
     time_elapsed.end = time.time()
     backend.finalize({'time_elapsed': time_elapsed.to_json()})
@@ -387,6 +416,8 @@ def resume(input_):
     options.OPTIONS.sync = results.options['sync']
     options.OPTIONS.deqp_mustpass = results.options['deqp_mustpass']
     options.OPTIONS.proces_isolation = results.options['process_isolation']
+    options.OPTIONS.shader_runner_workers = results.options.get(
+        'shader_runner_workers', False)
 
     core.get_config(args.config_file)
 
@@ -395,10 +426,13 @@ def resume(input_):
     results.options['env'] = core.collect_system_info()
     results.options['name'] = results.name
 
-    # Resume only works with the JSON backend
-    backend = backends.get_backend('json')(
-        args.results_path,
-        file_start_count=len(results.tests) + 1)
+    # Resume only works with the JSON and indexed backends, which keep the
+    # same journal while they run
+    if os.path.exists(os.path.join(args.results_path, 'tests',
+                                   'journal.pidx')):
+        backend = backends.get_backend('indexed')(args.results_path)
+    else:
+        backend = backends.get_backend('json')(args.results_path)
     # Specifically do not initialize again, everything initialize does is done.
 
     # Don't re-run tests that have already completed, incomplete status tests
@@ -57,7 +57,9 @@ def html(input_):
     parser = argparse.ArgumentParser(parents=[parsers.CONFIG])
     parser.add_argument("-o", "--overwrite",
                         action="store_true",
-                        help="Overwrite existing directories")
+                        help="Overwrite existing directories. If the "
+                             "directory holds an earlier summary only the "
+                             "pages that changed are written")
     parser.add_argument("-l", "--list",
                         action="store",
                         help="Load a newline separated list of results. These "
@@ -96,8 +98,10 @@ def html(input_):
                 status.status_lookup(i) for i in args.exclude_details)
 
 
-    # if overwrite is requested delete the output directory
-    if path.exists(args.summaryDir) and args.overwrite:
+    # if overwrite is requested delete the output directory, unless it holds
+    # an earlier summary, then only the pages that changed are written
+    if path.exists(args.summaryDir) and args.overwrite and \
+            not path.exists(path.join(args.summaryDir, 'manifest.json')):
         shutil.rmtree(args.summaryDir)
 
     # If the requested directory doesn't exist, create it or throw an error
@@ -145,6 +149,13 @@ def console(input_):
                            const="incomplete",
                            dest='mode',
                            help="Only display tests that are incomplete.")
+    excGroup1.add_argument("-p", "--phases",
+                           action="store_const",
+                           const="phases",
+                           dest='mode',
+                           help="Only display the time spent in each phase "
+                                "of the tests, like compiling or drawing, "
+                                "summed over all tests")
     parser.add_argument("-l", "--list",
                         action="store",
                         help="Use test results from a list file")
@@ -33,6 +33,7 @@ import six
 from framework import status, exceptions, grouptools, compat
 
 __all__ = [
+    'ResultTree',
     'TestrunResult',
     'TestResult',
 ]
@@ -148,7 +149,7 @@ class TestResult(object):
     """An object represting the result of a single test."""
     __slots__ = ['returncode', '_err', '_out', 'time', 'command', 'traceback',
                  'environment', 'subtests', 'dmesg', '__result', 'images',
-                 'exception', 'pid']
+                 'exception', 'pid', 'phases']
     err = StringDescriptor('_err')
     out = StringDescriptor('_out')
 
@@ -163,6 +164,7 @@ class TestResult(object):
         self.traceback = None
         self.exception = None
         self.pid = []
+        self.phases = {}
         if result:
             self.result = result
         else:
@@ -206,6 +208,7 @@ class TestResult(object):
             'traceback': self.traceback,
             'dmesg': self.dmesg,
             'pid': self.pid,
+            'phases': self.phases,
         }
         return obj
 
@@ -225,7 +228,7 @@ class TestResult(object):
         inst = cls()
 
         for each in ['returncode', 'command', 'exception', 'environment',
-                     'traceback', 'dmesg', 'pid', 'result']:
+                     'traceback', 'dmesg', 'pid', 'phases', 'result']:
             if each in dict_:
                 setattr(inst, each, dict_[each])
 
@@ -290,6 +293,86 @@ class Totals(dict):
         return tots
 
 
+class _Node(object):
+    """A group or test in a ResultTree."""
+    __slots__ = ['children', 'status', 'subtests']
+
+    def __init__(self):
+        self.children = {}
+        self.status = None
+        self.subtests = None
+
+
+class ResultTree(object):
+    """A prefix tree of the tests of a run.
+
+    The tree is built once from the tests of a run, each test name is split
+    into its groups only while building it. The totals of every group are
+    then computed in a single pass over the tree, and statuses maps the name
+    of every test and subtest to its status, so looking one up doesn't need to
+    split the name again.
+
+    """
+    def __init__(self, tests):
+        self.__root = _Node()
+        self.statuses = {}
+        self.names = []
+
+        subtests = []
+        for name, result in six.iteritems(tests):
+            node = self.__root
+            for part in grouptools.split(name):
+                try:
+                    node = node.children[part]
+                except KeyError:
+                    node.children[part] = node = _Node()
+
+            # If there are subtests treat the test as if it is a group instead
+            # of a test.
+            status_ = result.result
+            self.statuses[name] = status_
+            if result.subtests:
+                node.subtests = [str(s)
+                                 for s in six.itervalues(result.subtests)]
+                for sub, sub_status in six.iteritems(result.subtests):
+                    subtests.append((grouptools.join(name, sub), sub_status))
+            else:
+                node.status = str(status_)
+                self.names.append(name)
+
+        # A test can have the name of a subtest, it takes precedence.
+        for name, status_ in subtests:
+            if name not in self.statuses:
+                self.names.append(name)
+                self.statuses[name] = status_
+
+    def totals(self):
+        """Calculate the number of passes, fails, etc of each group."""
+        totals = collections.defaultdict(Totals)
+
+        def walk(node, name):
+            """Calculate the totals of a group and the groups in it."""
+            group = Totals()
+            for part, child in six.iteritems(node.children):
+                if child.status is not None:
+                    group[child.status] += 1
+                if child.children or child.subtests:
+                    for res, count in six.iteritems(
+                            walk(child, grouptools.join(name, part))):
+                        group[res] += count
+            if node.subtests:
+                for res in node.subtests:
+                    group[res] += 1
+
+            totals[name] = group
+            return group
+
+        if self.__root.children:
+            totals['root'] = Totals(walk(self.__root, ''))
+
+        return totals
+
+
 class TestrunResult(object):
     """The result of a single piglit run."""
     def __init__(self):
@@ -303,6 +386,7 @@ class TestrunResult(object):
         self.time_elapsed = TimeAttribute()
         self.tests = collections.OrderedDict()
         self.totals = collections.defaultdict(Totals)
+        self.tree = None
 
     def get_result(self, key):
         """Get the result of a test or subtest.
@@ -315,6 +399,9 @@ class TestrunResult(object):
         key -- the key name of the test to return
 
         """
+        if self.tree is not None:
+            return self.tree.statuses[key]
+
         try:
             return self.tests[key].result
         except KeyError as e:
@@ -324,32 +411,25 @@ class TestrunResult(object):
             except KeyError:
                 raise e
 
+    def build_tree(self):
+        """Build the ResultTree of the tests, which get_result() then uses.
+
+        The tree isn't updated when the tests change, build_tree() or
+        calculate_group_totals() has to be called again after changing them.
+
+        """
+        self.tree = ResultTree(self.tests)
+        return self.tree
+
     def calculate_group_totals(self):
         """Calculate the number of pases, fails, etc at each level."""
-        for name, result in six.iteritems(self.tests):
-            # If there are subtests treat the test as if it is a group instead
-            # of a test.
-            if result.subtests:
-                for res in six.itervalues(result.subtests):
-                    res = str(res)
-                    temp = name
-
-                    self.totals[temp][res] += 1
-                    while temp:
-                        temp = grouptools.groupname(temp)
-                        self.totals[temp][res] += 1
-                    self.totals['root'][res] += 1
-            else:
-                res = str(result.result)
-                while name:
-                    name = grouptools.groupname(name)
-                    self.totals[name][res] += 1
-                self.totals['root'][res] += 1
+        self.totals = self.build_tree().totals()
 
     def to_json(self):
         if not self.totals:
             self.calculate_group_totals()
         rep = copy.copy(self.__dict__)
+        del rep['tree']
         rep['tests'] = {k: t.to_json() for k, t in six.iteritems(self.tests)}
         rep['__type__'] = 'TestrunResult'
         return rep
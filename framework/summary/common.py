@@ -35,7 +35,6 @@ from six.moves import zip
 # the module
 import framework.status as so
 from framework.core import lazy_property
-from framework import grouptools
 
 
 class Results(object):  # pylint: disable=too-few-public-methods
@@ -46,6 +45,9 @@ class Results(object):  # pylint: disable=too-few-public-methods
     """
     def __init__(self, results):
         self.results = results
+        for res in self.results:
+            if res.tree is None:
+                res.build_tree()
         self.names = Names(self)
         self.counts = Counts(self)
 
@@ -95,12 +97,7 @@ class Names(object):
         """A set of all tests in all runs."""
         all_ = set()
         for res in self.__results:
-            for key, value in six.iteritems(res.tests):
-                if not value.subtests:
-                    all_.add(key)
-                else:
-                    for subt in six.iterkeys(value.subtests):
-                        all_.add(grouptools.join(key, subt))
+            all_.update((res.tree or res.build_tree()).names)
         return all_
 
     @lazy_property
@@ -25,6 +25,7 @@
 from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
+import collections
 import textwrap
 
 import six
@@ -54,6 +55,10 @@ _SUMMARY_TEMPLATE = textwrap.dedent("""\
     regressions: {regressions}
           total: {total}""")
 
+# The phases native tests time, in the order they happen in a test.
+_PHASES = ['context', 'init', 'compile', 'link', 'draw', 'readback', 'probe',
+           'teardown']
+
 
 def _print_summary(results):
     """print a summary."""
@@ -89,6 +94,40 @@ def _print_summary(results):
             for x in results.results])))
 
 
+def _print_phases(results):
+    """Print the time spent in each phase, summed over the tests of each run.
+
+    Tests that didn't report phase timings, like tests of older runs, are left
+    out of the sums.
+
+    """
+    totals = []
+    for run in results.results:
+        phases = collections.defaultdict(float)
+        for test in six.itervalues(run.tests):
+            for name, seconds in six.iteritems(test.phases):
+                phases[name] += seconds
+        totals.append(phases)
+
+    names = [p for p in _PHASES if any(p in t for t in totals)]
+    names.extend(sorted(set(n for t in totals for n in t) - set(_PHASES)))
+
+    lens = [max(min(len(x.name), 20), 10) for x in results.results]
+    print_template = ' '.join(
+        (lambda x: '{: >' + '{0}.{0}'.format(x) + '}')(y) for y in lens)
+
+    print('phases (seconds):')
+    print('{: >11}: {}'.format(
+        'name', print_template.format(*[r.name for r in results.results])))
+    print('{: >11}  {}'.format(
+        '----', print_template.format(*['-'*l for l in lens])))
+    for name in names:
+        print('{: >11}: {}'.format(name, print_template.format(
+            *['{:.3f}'.format(t.get(name, 0.0)) for t in totals])))
+    print('{: >11}: {}'.format('total', print_template.format(
+        *['{:.3f}'.format(sum(six.itervalues(t))) for t in totals])))
+
+
 def _print_result(results, list_):
     """Takes a list of test names to print and prints the name and result."""
     for test in sorted(list_):
@@ -99,7 +138,7 @@ def _print_result(results, list_):
 
 def console(results, mode):
     """ Write summary information to the console """
-    assert mode in ['summary', 'diff', 'incomplete', 'all'], mode
+    assert mode in ['summary', 'diff', 'incomplete', 'phases', 'all'], mode
     results = Results([backends.load(r) for r in results])
 
     # Print the name of the test and the status from each test run
@@ -113,3 +152,5 @@ def console(results, mode):
         _print_result(results, results.names.all_incomplete)
     elif mode == 'summary':
         _print_summary(results)
+    elif mode == 'phases':
+        _print_phases(results)
@@ -27,18 +27,26 @@ from __future__ import (
 )
 import errno
 import getpass
+import hashlib
+import multiprocessing
 import os
 import shutil
 import sys
 import tempfile
 
+try:
+    import simplejson as json
+except ImportError:
+    import json
+
 import mako
 from mako.lookup import TemplateLookup
 import six
 
 # a local variable status exists, prevent accidental overloading by renaming
 # the module
-from framework import backends, exceptions, core
+from framework import backends, exceptions, core, results as results_
+from framework.backends.json import piglit_encoder
 
 from .common import Results, escape_filename, escape_pathname
 from .feature import FeatResults
@@ -76,25 +84,173 @@ def _copy_static_files(destination):
                 os.path.join(destination, "result.css"))
 
 
-def _make_testrun_info(results, destination, exclude=None):
+# The number of test pages handed to the worker processes at a time, so that
+# the serialized results of a large run aren't all queued at once.
+_BATCH_SIZE = 1024
+
+_MANIFEST = 'manifest.json'
+
+
+class _Pages(object):
+    """The pages written into a summary directory.
+
+    The manifest of the directory maps each page to a hash of its content. A
+    page whose hash is the same as in the manifest of the last summary written
+    into the directory, and that still exists, isn't written again. Test pages
+    are hashed by their result before rendering, so unchanged ones aren't even
+    rendered, the other pages are few and are hashed after rendering.
+
+    """
+    def __init__(self, destination):
+        self.destination = destination
+        self.written = 0
+        self.unchanged = 0
+        self.__new = {}
+
+        try:
+            with open(os.path.join(destination, _MANIFEST), 'r') as f:
+                self.__old = json.load(f)
+        except (IOError, OSError, ValueError):
+            self.__old = {}
+
+    def is_current(self, path, hash_):
+        """Add a page to the manifest, and return True if it is unchanged."""
+        name = os.path.relpath(path, self.destination)
+        self.__new[name] = hash_
+        if self.__old.get(name) == hash_ and os.path.exists(path):
+            self.unchanged += 1
+            return True
+        self.written += 1
+        return False
+
+    def write(self, path, content):
+        """Write a rendered page, unless it is unchanged."""
+        if not self.is_current(path, hashlib.sha1(content).hexdigest()):
+            with open(path, 'wb') as out:
+                out.write(content)
+
+    def finish(self):
+        """Remove the pages that aren't written anymore and save the manifest.
+        """
+        for name in six.iterkeys(self.__old):
+            if name not in self.__new:
+                try:
+                    os.unlink(os.path.join(self.destination, name))
+                except OSError:
+                    pass
+
+        with open(os.path.join(self.destination, _MANIFEST), 'w') as f:
+            json.dump(self.__new, f, indent=0, sort_keys=True)
+
+        print('Wrote {} pages, {} were unchanged'.format(
+            self.written, self.unchanged))
+
+
+def _template_hash(name):
+    """Hash the source of a template, so pages change when it does."""
+    with open(os.path.join(_TEMPLATE_DIR, name), 'rb') as f:
+        return hashlib.sha1(f.read()).hexdigest()
+
+
+def _change_key(result):
+    """A string that changes whenever a test result does.
+
+    Results of indexed runs make it from the index, others are serialized.
+
+    """
+    try:
+        return result.change_key()
+    except AttributeError:
+        return json.dumps(result, default=piglit_encoder, sort_keys=True)
+
+
+def _render_test_page(page):
+    """Render and write a test page, in a worker process."""
+    html_path, testname, value, css, index = page
+    value = results_.TestResult.from_dict(json.loads(value))
+
+    core.check_dir(os.path.dirname(html_path))
+    with open(html_path, 'wb') as out:
+        out.write(_TEMPLATES.get_template('test_result.mako').render(
+            testname=testname,
+            value=value,
+            css=css,
+            index=index))
+
+
+def _render_test_pages(pages):
+    """Render test pages over a pool of processes, one per cpu."""
+    # Compile the template before forking, rather than in every worker.
+    _TEMPLATES.get_template('test_result.mako')
+
+    batch = []
+    pool = None
+    try:
+        for page in pages:
+            batch.append(page)
+            if len(batch) == _BATCH_SIZE:
+                pool = pool or multiprocessing.Pool()
+                pool.map(_render_test_page, batch)
+                batch = []
+        if len(batch) > 1:
+            pool = pool or multiprocessing.Pool()
+            pool.map(_render_test_page, batch)
+        elif batch:
+            _render_test_page(batch[0])
+    finally:
+        if pool is not None:
+            pool.close()
+            pool.join()
+
+
+def _make_testrun_info(results, destination, pages, exclude=None):
     """Create the pages for each results file."""
     exclude = exclude or {}
     result_css = os.path.join(destination, "result.css")
     index = os.path.join(destination, "index.html")
+    template = _template_hash('test_result.mako')
+    names = set()
+
+    def test_pages(each, name):
+        """Yield the test pages of a run that have to be rendered.
+
+        The pages are hashed by a key of their result rather than the result
+        itself, so the records of indexed results are only read for the
+        pages that are rendered.
+
+        """
+        for key, value in six.iteritems(each.tests):
+            html_path = os.path.join(destination, name,
+                                     escape_filename(key + ".html"))
+            temp_path = os.path.dirname(html_path)
+
+            if value.result not in exclude:
+                css = os.path.relpath(result_css, temp_path)
+                index_ = os.path.relpath(index, temp_path)
+
+                hash_ = hashlib.sha1(template.encode('utf-8'))
+                for part in [key, _change_key(value), css, index_]:
+                    hash_.update(b'\0')
+                    hash_.update(part.encode('utf-8'))
+                if not pages.is_current(html_path, hash_.hexdigest()):
+                    yield (html_path, key,
+                           json.dumps(value, default=piglit_encoder),
+                           css, index_)
 
     for each in results.results:
         name = escape_pathname(each.name)
-        try:
-            core.check_dir(os.path.join(destination, name), True)
-        except exceptions.PiglitException:
+        if name in names:
             raise exceptions.PiglitFatalError(
                 'Two or more of your results have the same "name" '
                 'attribute. Try changing one or more of the "name" '
                 'values in your json files.\n'
                 'Duplicate value: {}'.format(name))
+        names.add(name)
+        core.check_dir(os.path.join(destination, name))
 
-        with open(os.path.join(destination, name, "index.html"), 'wb') as out:
-            out.write(_TEMPLATES.get_template('testrun_info.mako').render(
+        pages.write(
+            os.path.join(destination, name, "index.html"),
+            _TEMPLATES.get_template('testrun_info.mako').render(
                 name=each.name,
                 totals=each.totals['root'],
                 time=each.time_elapsed.delta,
@@ -105,61 +261,47 @@ def _make_testrun_info(results, destination, exclude=None):
                 lspci=each.lspci))
 
         # Then build the individual test results
-        for key, value in six.iteritems(each.tests):
-            html_path = os.path.join(destination, name,
-                                     escape_filename(key + ".html"))
-            temp_path = os.path.dirname(html_path)
-
-            if value.result not in exclude:
-                core.check_dir(temp_path)
+        _render_test_pages(test_pages(each, name))
 
-                with open(html_path, 'wb') as out:
-                    out.write(_TEMPLATES.get_template(
-                        'test_result.mako').render(
-                            testname=key,
-                            value=value,
-                            css=os.path.relpath(result_css, temp_path),
-                            index=os.path.relpath(index, temp_path)))
 
-
-def _make_comparison_pages(results, destination, exclude):
+def _make_comparison_pages(results, destination, pages, exclude):
     """Create the pages of comparisons."""
-    pages = frozenset(['changes', 'problems', 'skips', 'fixes',
+    names = frozenset(['changes', 'problems', 'skips', 'fixes',
                        'regressions', 'enabled', 'disabled'])
 
     # Index.html is a bit of a special case since there is index, all, and
     # alltests, where the other pages all use the same name. ie,
     # changes.html, changes, and page=changes.
-    with open(os.path.join(destination, "index.html"), 'wb') as out:
-        out.write(_TEMPLATES.get_template('index.mako').render(
+    pages.write(
+        os.path.join(destination, "index.html"),
+        _TEMPLATES.get_template('index.mako').render(
             results=results,
             page='all',
-            pages=pages,
+            pages=names,
             exclude=exclude))
 
     # Generate the rest of the pages
-    for page in pages:
-        with open(os.path.join(destination, page + '.html'), 'wb') as out:
-            # If there is information to display display it
-            if sum(getattr(results.counts, page)) > 0:
-                out.write(_TEMPLATES.get_template('index.mako').render(
-                    results=results,
-                    pages=pages,
-                    page=page,
-                    exclude=exclude))
-            # otherwise provide an empty page
-            else:
-                out.write(
-                    _TEMPLATES.get_template('empty_status.mako').render(
-                        page=page, pages=pages))
-
-
-def _make_feature_info(results, destination):
+    for page in names:
+        # If there is information to display display it
+        if sum(getattr(results.counts, page)) > 0:
+            content = _TEMPLATES.get_template('index.mako').render(
+                results=results,
+                pages=names,
+                page=page,
+                exclude=exclude)
+        # otherwise provide an empty page
+        else:
+            content = _TEMPLATES.get_template('empty_status.mako').render(
+                page=page, pages=names)
+        pages.write(os.path.join(destination, page + '.html'), content)
+
+
+def _make_feature_info(results, destination, pages):
     """Create the feature readiness page."""
 
-    with open(os.path.join(destination, "feature.html"), 'wb') as out:
-        out.write(_TEMPLATES.get_template('feature.mako').render(
-            results=results))
+    pages.write(
+        os.path.join(destination, "feature.html"),
+        _TEMPLATES.get_template('feature.mako').render(results=results))
 
 
 def html(results, destination, exclude):
@@ -171,12 +313,17 @@ def html(results, destination, exclude):
     The beauty of this approach is that mako is leveraged to do the
     heavy lifting, this method just passes it a bunch of dicts and lists
     of dicts, which mako turns into pretty HTML.
+
+    If destination holds an earlier summary, only the pages that changed
+    since are written.
     """
     results = Results([backends.load(i) for i in results])
+    pages = _Pages(destination)
 
     _copy_static_files(destination)
-    _make_testrun_info(results, destination, exclude)
-    _make_comparison_pages(results, destination, exclude)
+    _make_testrun_info(results, destination, pages, exclude)
+    _make_comparison_pages(results, destination, pages, exclude)
+    pages.finish()
 
 
 def feat(results, destination, feat_desc):
@@ -184,6 +331,9 @@ def feat(results, destination, feat_desc):
 
     feat_res = FeatResults([backends.load(i) for i in results], feat_desc)
 
+    pages = _Pages(destination)
+
     _copy_static_files(destination)
-    _make_testrun_info(feat_res, destination)
-    _make_feature_info(feat_res, destination)
+    _make_testrun_info(feat_res, destination, pages)
+    _make_feature_info(feat_res, destination, pages)
+    pages.finish()
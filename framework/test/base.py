@@ -35,6 +35,10 @@ import abc
 import copy
 import signal
 import warnings
+try:
+    import simplejson as json
+except ImportError:
+    import json
 
 import six
 from six.moves import range
@@ -272,8 +276,37 @@ class Test(object):
             self.result.returncode = None
             return
 
+        self._interpret_phases()
         self.interpret_result()
 
+    def _interpret_phases(self):
+        """Move the phase timings a test printed into result.phases.
+
+        Native tests print the time they spent in each phase of the run, like
+        compiling or drawing, to stderr in lines prefixed PIGLIT-PHASES:. A
+        test that was resumed or ran more than one process may print several
+        of them, these are summed.
+
+        """
+        if 'PIGLIT-PHASES:' not in self.result.err:
+            return
+
+        err = []
+        for line in self.result.err.split('\n'):
+            if line.startswith('PIGLIT-PHASES:'):
+                try:
+                    phases = json.loads(line[len('PIGLIT-PHASES:'):])
+                except ValueError:
+                    err.append(line)
+                    continue
+                for name, seconds in six.iteritems(phases):
+                    self.result.phases[name] = \
+                        self.result.phases.get(name, 0.0) + seconds
+            else:
+                err.append(line)
+
+        self.result.err = '\n'.join(err)
+
     def is_skip(self):
         """ Application specific check for skip
 
@@ -283,18 +316,8 @@ class Test(object):
         """
         pass
 
-    def _run_command(self, **kwargs):
-        """ Run the test command and get the result
-
-        This method sets environment options, then runs the executable. If the
-        executable isn't found it sets the result to skip.
-
-        """
-        # This allows the ReducedProcessMixin to work without having to whack
-        # self.command (which should be treated as immutable), but is
-        # considered private.
-        command = kwargs.pop('_command', self.command)
-
+    def _build_environment(self):
+        """Return the environment the test command should be run with."""
         # Setup the environment for the test. Environment variables are taken
         # from the following sources, listed in order of increasing precedence:
         #
@@ -318,6 +341,21 @@ class Test(object):
                                 six.iteritems(OPTIONS.env),
                                 six.iteritems(self.env))
         fullenv = {f(k): f(v) for k, v in _base}
+        return fullenv
+
+    def _run_command(self, **kwargs):
+        """ Run the test command and get the result
+
+        This method sets environment options, then runs the executable. If the
+        executable isn't found it sets the result to skip.
+
+        """
+        # This allows the ReducedProcessMixin to work without having to whack
+        # self.command (which should be treated as immutable), but is
+        # considered private.
+        command = kwargs.pop('_command', self.command)
+
+        fullenv = self._build_environment()
 
         try:
             proc = subprocess.Popen(command,
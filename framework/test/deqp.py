@@ -22,8 +22,14 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import abc
+import collections
+import io
 import os
+import re
+import shutil
 import subprocess
+import tempfile
+import threading
 try:
     from lxml import etree as et
 except ImportError:
@@ -34,11 +40,16 @@ from six.moves import range
 
 from framework import core, grouptools, exceptions
 from framework import options
+from framework import status
 from framework.profile import TestProfile
 from framework.test.base import Test, is_crash_returncode, TestRunError
 
 __all__ = [
     'DEQPBaseTest',
+    'DEQPBatchCase',
+    'DEQPBatchTest',
+    'DEQPProfile',
+    'QPAParser',
     'gen_caselist_txt',
     'get_option',
     'iter_deqp_test_cases',
@@ -69,6 +80,22 @@ _EXTRA_ARGS = get_option('PIGLIT_DEQP_EXTRA_ARGS',
                          ('deqp', 'extra_args'),
                          default='').split()
 
+_BATCH_SIZE = int(get_option('PIGLIT_DEQP_BATCH_SIZE',
+                             ('deqp', 'batch_size'),
+                             default='1000'))
+
+_RESULT_MAP = {
+    "Pass": "pass",
+    "Fail": "fail",
+    "QualityWarning": "warn",
+    "CompatibilityWarning": "warn",
+    "InternalError": "fail",
+    "Crash": "crash",
+    "Timeout": "timeout",
+    "NotSupported": "skip",
+    "ResourceError": "crash",
+}
+
 
 def select_source(bin_, filename, mustpass, extra_args):
     """Return either the mustpass list or the generated list."""
@@ -79,9 +106,45 @@ def select_source(bin_, filename, mustpass, extra_args):
             gen_caselist_txt(bin_, filename, extra_args))
 
 
-def make_profile(test_list, test_class):
-    """Create a TestProfile instance."""
-    profile = TestProfile()
+class DEQPProfile(TestProfile):
+    """A TestProfile whose cases may be run in batches.
+
+    Before the run each batch is told which of its cases are going to be run,
+    so that the cases filtered out, or already run when resuming, aren't run
+    with the others.
+
+    """
+    def setup(self):
+        super(DEQPProfile, self).setup()
+
+        # Tests compare equal by their commands, so the batches are keyed by
+        # their ids.
+        selected = collections.OrderedDict()
+        for _, test in self.itertests():
+            if isinstance(test, DEQPBatchCase):
+                selected.setdefault(id(test.batch), (test.batch, []))[1].append(
+                    test.case)
+        for batch, cases in six.itervalues(selected):
+            batch.select(cases)
+
+
+def make_profile(test_list, test_class, batch_class=None):
+    """Create a TestProfile instance.
+
+    If a batch_class is given and process isolation is disabled, the cases are
+    run in batches of batch_class instead, see gen_batches(). Each case is
+    still a test of its own, with the same name.
+
+    """
+    profile = DEQPProfile()
+    if batch_class is not None and not options.OPTIONS.process_isolation:
+        for cases in gen_batches(test_list, _BATCH_SIZE):
+            batch = batch_class(cases)
+            for testname in cases:
+                profile.test_list[testname.replace(
+                    '.', grouptools.SEPARATOR)] = DEQPBatchCase(batch, testname)
+        return profile
+
     for testname in test_list:
         # deqp uses '.' as the testgroup separator.
         piglit_name = testname.replace('.', grouptools.SEPARATOR)
@@ -90,6 +153,27 @@ def make_profile(test_list, test_class):
     return profile
 
 
+def gen_batches(test_list, size):
+    """Group the cases of each group into batches of at most size cases.
+
+    Yields the cases of each batch.
+
+    """
+    group = None
+    cases = []
+
+    for testname in test_list:
+        this = testname.rsplit('.', 1)[0]
+        if cases and (this != group or len(cases) == size):
+            yield cases
+            cases = []
+        group = this
+        cases.append(testname)
+
+    if cases:
+        yield cases
+
+
 def gen_mustpass_tests(mp_list):
     """Return a testlist from the mustpass list."""
     root = et.parse(mp_list).getroot()
@@ -153,15 +237,7 @@ def iter_deqp_test_cases(case_file):
 
 @six.add_metaclass(abc.ABCMeta)
 class DEQPBaseTest(Test):
-    __RESULT_MAP = {
-        "Pass": "pass",
-        "Fail": "fail",
-        "QualityWarning": "warn",
-        "InternalError": "fail",
-        "Crash": "crash",
-        "NotSupported": "skip",
-        "ResourceError": "crash",
-    }
+    __RESULT_MAP = _RESULT_MAP
 
     @abc.abstractproperty
     def deqp_bin(self):
@@ -226,3 +302,337 @@ class DEQPBaseTest(Test):
             return
 
         raise TestRunError('Failed to connect to X server 5 times', 'fail')
+
+
+class QPAParser(object):
+    """Parse a dEQP QPA log a piece at a time.
+
+    A QPA log has a section per case, from "#beginTestCaseResult <case>" to
+    "#endTestCaseResult", with an XML document in between whose Result element
+    has the status of the case. If dEQP stops a case, like when it times out,
+    the section ends with "#terminateTestCaseResult <reason>" instead, and if
+    dEQP crashes the section doesn't end at all.
+
+    Only the Result element of each case is kept, the rest of the XML, which
+    can have large images and shader sources, is not.
+
+    """
+    _RESULT = re.compile(r'<Result\s[^>]*StatusCode="(?P<code>[^"]*)"[^>]*>'
+                         r'(?P<text>[^<]*)')
+
+    def __init__(self):
+        self.current = None
+        self._code = None
+        self._text = None
+        self._partial = ''
+
+    def feed(self, data):
+        """Parse more of the log.
+
+        Returns the (case, status, description) of the cases that ended in
+        it. The description is the line dEQP prints for the case, like
+        "Fail (Image comparison failed)". The case that has begun but not
+        ended yet is in current.
+
+        """
+        lines = (self._partial + data).split('\n')
+        self._partial = lines.pop()
+
+        done = []
+        for line in lines:
+            if line.startswith('#beginTestCaseResult'):
+                self.current = line.split(None, 1)[1].strip()
+                self._code = None
+                self._text = None
+            elif self.current is None:
+                continue
+            elif line.startswith('#endTestCaseResult'):
+                done.append((self.current,
+                             _RESULT_MAP.get(self._code, 'fail'),
+                             '{} ({})'.format(self._code, self._text)))
+                self.current = None
+            elif line.startswith('#terminateTestCaseResult'):
+                reason = line[len('#terminateTestCaseResult'):].strip()
+                done.append((self.current, _RESULT_MAP.get(reason, 'crash'),
+                             reason))
+                self.current = None
+            else:
+                match = self._RESULT.search(line)
+                if match:
+                    self._code = match.group('code')
+                    self._text = match.group('text')
+
+        return done
+
+
+class _BatchSize(object):
+    """The number of cases to run in one process.
+
+    This is adapted to the rate cases crash at, so that on average a process
+    crashes every other time: when nothing crashes all of the cases of a
+    batch are run in one process, and when cases crash often they are run in
+    smaller processes, so that a crash, and any state it leaves behind, affects
+    fewer cases.
+
+    """
+    # The number of cases the crash rate is averaged over
+    _WINDOW = 1000
+
+    def __init__(self):
+        self._rate = 0.0
+        self._lock = threading.Lock()
+
+    def get(self, maximum):
+        """Get the number of cases to run, of a batch of maximum cases."""
+        with self._lock:
+            if self._rate == 0:
+                return maximum
+            return max(1, min(maximum, int(0.5 / self._rate)))
+
+    def update(self, cases, crashes):
+        """Add the number of cases a process ran and how many crashed."""
+        if cases == 0:
+            return
+        with self._lock:
+            weight = min(1.0, cases / self._WINDOW)
+            self._rate += (crashes / cases - self._rate) * weight
+
+
+@six.add_metaclass(abc.ABCMeta)
+class DEQPBatchTest(Test):
+    """Run a batch of dEQP cases in as few processes as possible.
+
+    This isn't a test of a profile itself, each case is a DEQPBatchCase which
+    gets its result from here. The first case that asks for its result
+    starts running the cases of the batch that were selected in a background
+    thread, beginning with that case.
+
+    The cases are passed to dEQP in a case list file, and the QPA log dEQP
+    writes is parsed while it runs, so each case gets its result as soon as
+    dEQP has finished it. If dEQP crashes or times out, the case it was
+    running gets that status along with the output of the process, and dEQP
+    is started again with the cases after it, like ReducedProcessMixin does.
+    How many cases are run in one process depends on how often cases of the
+    same binary crash, see _BatchSize.
+
+    Arguments:
+    case_names -- the dEQP names of the cases, which must be in one group.
+
+    """
+    __batch_sizes = {}
+    __batch_sizes_lock = threading.Lock()
+
+    # How often the QPA log is read while dEQP runs, in seconds
+    _POLL = 0.1
+
+    @abc.abstractproperty
+    def deqp_bin(self):
+        """The path to the exectuable."""
+
+    @abc.abstractproperty
+    def extra_args(self):
+        """Extra arguments to be passed to the each process."""
+        return _EXTRA_ARGS
+
+    def __init__(self, case_names):
+        super(DEQPBatchTest, self).__init__([self.deqp_bin])
+        self.cwd = os.path.dirname(self.deqp_bin)
+
+        self._cases = list(case_names)
+        self._selected = None
+        self._cond = threading.Condition()
+        self._running = False
+        # The (status, out, err, returncode) of the cases that ran and weren't
+        # asked for yet, and the names of every case that ran.
+        self._results = {}
+        self._done = set()
+
+    @Test.command.getter
+    def command(self):
+        """Return the command plus any extra arguments."""
+        command = super(DEQPBatchTest, self).command
+        return command + self.extra_args
+
+    @property
+    def _batch_size(self):
+        with self.__batch_sizes_lock:
+            return self.__batch_sizes.setdefault(self.deqp_bin, _BatchSize())
+
+    def select(self, case_names):
+        """Set the cases to run, by default all of them are run."""
+        with self._cond:
+            self._selected = set(case_names)
+
+    def get_result(self, case):
+        """Get the (status, out, err, returncode) of a case.
+
+        Waits until the case has run, running the batch if it isn't already.
+
+        """
+        with self._cond:
+            while case not in self._results:
+                if not self._running:
+                    self._start(case)
+                self._cond.wait()
+            return self._results.pop(case)
+
+    def _start(self, first):
+        """Start running first and the other pending cases. Must hold the
+        lock.
+        """
+        cases = [first] + [
+            c for c in self._cases if c != first and c not in self._done and
+            (self._selected is None or c in self._selected)]
+        self._running = True
+
+        thread = threading.Thread(target=self._run_batch, args=(cases,))
+        thread.daemon = True
+        thread.start()
+
+    def _publish(self, case, result, out='', err='', returncode=0):
+        """Hand the result of a case to the DEQPBatchCase waiting for it."""
+        with self._cond:
+            self._results[case] = (result, out, err, returncode)
+            self._done.add(case)
+            self._cond.notify_all()
+
+    def _follow(self, log, parser, stop):
+        """Parse the log as dEQP writes it, until stop is set."""
+        f = None
+        try:
+            while True:
+                # Checked before reading, so the last read sees everything
+                stopping = stop.is_set()
+                if f is None and os.path.exists(log):
+                    f = io.open(log, 'r', encoding='utf-8', errors='replace')
+                if f is not None:
+                    for data in iter(lambda: f.read(65536), ''):
+                        for case, result, line in parser.feed(data):
+                            self._publish(
+                                case, result,
+                                out="Test case '{}'..\n  {}\n".format(
+                                    case, line))
+                if stopping:
+                    return
+                stop.wait(self._POLL)
+        finally:
+            if f is not None:
+                f.close()
+
+    def _run_cases(self, cases, tempdir):
+        """Run cases in one process.
+
+        Returns whether the process stopped in the middle of a case.
+
+        """
+        caselist = os.path.join(tempdir, 'caselist.txt')
+        log = os.path.join(tempdir, 'log.qpa')
+        with io.open(caselist, 'w') as f:
+            f.write('\n'.join(cases) + '\n')
+        if os.path.exists(log):
+            os.unlink(log)
+
+        parser = QPAParser()
+        stop = threading.Event()
+        follower = threading.Thread(target=self._follow,
+                                    args=(log, parser, stop))
+        follower.start()
+        try:
+            super(DEQPBatchTest, self)._run_command(
+                _command=self.command + ['--deqp-caselist-file=' + caselist,
+                                         '--deqp-log-filename=' + log])
+            stopped = 'crash'
+        except TestRunError as e:
+            if e.status != 'timeout':
+                raise
+            stopped = 'timeout'
+            self.result.returncode = None
+        finally:
+            stop.set()
+            follower.join()
+
+        with self._cond:
+            progress = any(c in self._done for c in cases)
+
+        if parser.current is not None:
+            case = parser.current
+        elif not progress:
+            # dEQP didn't run any case. Charge it to the first one so that the
+            # next process starts with the next one, instead of trying it
+            # again.
+            case = cases[0]
+            if stopped == 'crash' and self.result.returncode == 0:
+                stopped = 'fail'
+        else:
+            return False
+
+        self._publish(case, stopped, self.result.out, self.result.err,
+                      self.result.returncode)
+        return True
+
+    def _run_batch(self, cases):
+        """Run processes until every case has run or stopped one."""
+        tempdir = tempfile.mkdtemp()
+        remaining = cases
+        try:
+            while remaining:
+                crashed = self._run_cases(
+                    remaining[:self._batch_size.get(len(remaining))],
+                    tempdir)
+
+                with self._cond:
+                    ran = len(remaining)
+                    remaining = [c for c in remaining if c not in self._done]
+                    ran -= len(remaining)
+                self._batch_size.update(ran, int(crashed))
+        except TestRunError as e:
+            for case in remaining:
+                if case not in self._done:
+                    self._publish(case, six.text_type(e.status),
+                                  out=six.text_type(e), returncode=None)
+        except Exception as e:  # pylint: disable=broad-except
+            # The cases are waiting for their results in other threads
+            for case in remaining:
+                if case not in self._done:
+                    self._publish(case, status.FAIL,
+                                  err='{}: {}'.format(type(e).__name__, e),
+                                  returncode=None)
+        finally:
+            shutil.rmtree(tempdir)
+            with self._cond:
+                self._running = False
+                self._cond.notify_all()
+
+    def interpret_result(self):
+        """The results are interpreted by each DEQPBatchCase."""
+
+
+class DEQPBatchCase(Test):
+    """A dEQP case that is run by a DEQPBatchTest with the other cases of its
+    batch.
+
+    Its command runs the case on its own, like DEQPBaseTest does.
+
+    Arguments:
+    batch -- the DEQPBatchTest the case is in.
+    case -- the dEQP name of the case.
+
+    """
+    def __init__(self, batch, case):
+        super(DEQPBatchCase, self).__init__([batch.deqp_bin])
+        self.cwd = batch.cwd
+        self.batch = batch
+        self.case = case
+
+    @Test.command.getter
+    def command(self):
+        """Return the command of the batch, for this case only."""
+        return self.batch.command + ['--deqp-case=' + self.case]
+
+    def _run_command(self, **kwargs):
+        (self.result.result, self.result.out, self.result.err,
+         self.result.returncode) = self.batch.get_result(self.case)
+
+    def interpret_result(self):
+        # The status came from the QPA log, or from the process stopping.
+        pass
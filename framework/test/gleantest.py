@@ -27,6 +27,11 @@ from __future__ import (
 )
 import os
 
+try:
+    import simplejson as json
+except ImportError:
+    import json
+
 from framework import options
 from .base import Test, TestIsSkip
 from .piglit_test import TEST_BIN_DIR
@@ -43,20 +48,35 @@ class GleanTest(Test):
     This class descendes from exectest.Test, and provides methods for running
     glean tests.
 
+    Keyword Arguments:
+    shard -- run only the named shard of the glean test, see
+             BaseTest::runShard() in tests/glean/tbase.h.
+
+    The shards that are run are reported as subtests.
+
     """
     GLOBAL_PARAMS = []
     _EXECUTABLE = os.path.join(TEST_BIN_DIR, "glean")
 
-    def __init__(self, name, **kwargs):
-        super(GleanTest, self).__init__(
-            [self._EXECUTABLE, "-o", "-v", "-v", "-v", "-t", "+" + name],
-            **kwargs)
+    def __init__(self, name, shard=None, **kwargs):
+        command = [self._EXECUTABLE, "-o", "-v", "-v", "-v", "-t", "+" + name]
+        if shard is not None:
+            command.extend(["--shard", shard])
+        super(GleanTest, self).__init__(command, **kwargs)
 
     @Test.command.getter
     def command(self):
         return super(GleanTest, self).command + self.GLOBAL_PARAMS
 
     def interpret_result(self):
+        out = []
+        for each in self.result.out.split('\n'):
+            if each.startswith('PIGLIT:'):
+                self.result.update(json.loads(each[8:]))
+            else:
+                out.append(each)
+        self.result.out = '\n'.join(out)
+
         if self.result.returncode != 0 or 'FAIL' in self.result.out:
             self.result.result = 'fail'
         else:
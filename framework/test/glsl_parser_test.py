@@ -30,13 +30,15 @@ import io
 import six
 
 from framework import exceptions
-from .base import TestIsSkip
-from .opengl import FastSkipMixin
+from framework import status
+from .base import ReducedProcessMixin, TestIsSkip
+from .opengl import FastSkipMixin, FastSkip
 from .piglit_test import PiglitBaseTest, TEST_BIN_DIR
 
 __all__ = [
     'GLSLParserTest',
     'GLSLParserNoConfigError',
+    'MultiGLSLParserTest',
 ]
 
 # In different configurations piglit may have one or both of these.
@@ -84,7 +86,7 @@ class Parser(object):
     _CONFIG_KEYS = frozenset(['expect_result', 'glsl_version',
                               'require_extensions', 'check_link'])
 
-    def __init__(self, filepath):
+    def __init__(self, filepath, config=None):
         # a set that stores a list of keys that have been found already
         self.__found_keys = set()
         self.gl_required = set()
@@ -92,9 +94,13 @@ class Parser(object):
         self.glsl_version = None
 
         try:
-            with io.open(filepath, mode='r', encoding='utf-8') as testfile:
-                testfile = testfile.read()
-                self.config = self.parse(testfile, filepath)
+            if config is not None:
+                # A config block parsed earlier, see to_json()
+                self.config = dict(config)
+            else:
+                with io.open(filepath, mode='r', encoding='utf-8') as testfile:
+                    testfile = testfile.read()
+                    self.config = self.parse(testfile, filepath)
             self.command = self.get_command(filepath)
         except GLSLParserInternalError as e:
             raise exceptions.PiglitFatalError(
@@ -129,6 +135,15 @@ class Parser(object):
             self.gl_required.add(ext)
             self.command.append(ext)
 
+    def to_json(self):
+        """Return the parsed config block as a json serializable dict.
+
+        Passing it back as config recreates this Parser without reading the
+        file. Everything derived from the environment (like which binary to
+        use) is recomputed at that point.
+        """
+        return dict(self.config)
+
     @staticmethod
     def pick_binary(version):
         """Pick the correct version of glslparsertest to use.
@@ -265,10 +280,11 @@ class GLSLParserTest(FastSkipMixin, PiglitBaseTest):
     Arguments:
     filepath -- the path to a glsl_parser_test which must end in .vert,
                 .tesc, .tese, .geom or .frag
+    parser -- an already constructed Parser for filepath, if one is at hand
     """
 
-    def __init__(self, filepath):
-        parsed = Parser(filepath)
+    def __init__(self, filepath, parser=None):
+        parsed = parser if parser is not None else Parser(filepath)
         super(GLSLParserTest, self).__init__(
             parsed.command,
             run_concurrent=True,
@@ -282,3 +298,110 @@ class GLSLParserTest(FastSkipMixin, PiglitBaseTest):
                              'but only an OpenGL ES binary has been built')
 
         super(GLSLParserTest, self).is_skip()
+
+
+class MultiGLSLParserTest(ReducedProcessMixin, PiglitBaseTest):
+    """A GLSLParserTest that tests more than one file in a single process.
+
+    glslparsertest creates one GL context for the GLSL version requested by
+    the first file, so all of the files must request the same version. Each
+    file is reported as a subtest named after the file, and if the process
+    crashes it is resumed with the next file.
+
+    Arguments:
+    filenames -- a list of absolute paths to glslparser test files
+    parsers -- an optional list of already constructed Parsers, one per file
+    """
+
+    def __init__(self, filenames, parsers=None):
+        assert filenames
+        assert parsers is None or len(parsers) == len(filenames)
+        prog = None
+        version = None
+        args = []
+        subtests = []
+        skips = []
+
+        for i, each in enumerate(filenames):
+            parser = parsers[i] if parsers is not None else Parser(each)
+            subtest = os.path.basename(each).lower()
+
+            if prog is None:
+                prog = parser.command[0]
+                version = parser.config['glsl_version']
+            elif parser.config['glsl_version'] != version:
+                raise exceptions.PiglitInternalError(
+                    'Different GLSL versions in the same command!\n'
+                    'All files must share one GL context.')
+
+            try:
+                FastSkip(gl_required=parser.gl_required,
+                         glsl_version=parser.glsl_version,
+                         glsl_es_version=parser.glsl_es_version).test()
+            except TestIsSkip:
+                skips.append(subtest)
+                continue
+            args.append(parser.command[1:])
+            subtests.append(subtest)
+
+        assert len(subtests) + len(skips) == len(filenames), \
+            'not all tests accounted for'
+
+        self._args = args
+        super(MultiGLSLParserTest, self).__init__(
+            [prog] + self._join(args),
+            subtests=subtests,
+            run_concurrent=True)
+
+        for name in skips:
+            self.result.subtests[name] = status.SKIP
+
+    @staticmethod
+    def _join(args):
+        """Return the arguments of each file, separated by '--'."""
+        command = []
+        for each in args:
+            if command:
+                command.append('--')
+            command.extend(each)
+        return command
+
+    @PiglitBaseTest.command.getter  # pylint: disable=no-member
+    def command(self):
+        """Add -report-subtests to the test command."""
+        command = super(MultiGLSLParserTest, self).command
+        return command[:1] + ['-report-subtests'] + command[1:]
+
+    def is_skip(self):
+        if os.path.basename(self.command[0]) == 'None':
+            raise TestIsSkip('Test is for desktop OpenGL, '
+                             'but only an OpenGL ES binary has been built')
+
+        super(MultiGLSLParserTest, self).is_skip()
+
+    def _is_subtest(self, line):
+        return line.startswith('PIGLIT TEST:')
+
+    def _resume(self, current):
+        return self.command[:2] + self._join(self._args[current:])
+
+    def _stop_status(self):
+        # If the lower level framework skips then return a status for that
+        # subtest as skip, and resume.
+        if self.result.out.endswith('PIGLIT: {"result": "skip" }\n'):
+            return status.SKIP
+        if self.result.returncode > 0:
+            return status.FAIL
+        return status.CRASH
+
+    def _is_cherry(self):
+        # If the GL framework or glslparsertest itself skips the whole batch
+        # (no context for the requested version, GL 2.0 not supported) the
+        # process exits 0 before any subtest is reported, so look for that
+        # message at the end of stdout as MultiShaderTest does.
+        return (
+            self.result.returncode == 0 and not
+            self.result.out.endswith(
+                'not supported on this implementation\n') and not
+            self.result.out.endswith(
+                'PIGLIT: {"result": "skip" }\n'))
@@ -26,20 +26,39 @@
 from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
+import atexit
+import errno
 import io
 import os
 import re
+import subprocess
+import threading
+import time
+
+import six
+from six.moves import queue
 
 from framework import exceptions
 from framework import status
-from .base import ReducedProcessMixin, TestIsSkip
+from framework.options import OPTIONS
+from .base import ReducedProcessMixin, TestIsSkip, TestRunError
 from .opengl import FastSkipMixin, FastSkip
 from .piglit_test import PiglitBaseTest
 
 __all__ = [
     'ShaderTest',
+    'ShaderWorkerTest',
 ]
 
+# The line shader_runner -worker prints on both stdout and stderr after the
+# result of each test script.
+_WORKER_DONE = 'PIGLIT WORKER: done'
+
+# Number of test scripts a worker runs before it is replaced by a fresh
+# process. Every GL context switch inside a worker recurses into main(), so
+# this keeps the stack (and any leaks) of a worker bounded.
+_WORKER_MAX_TESTS = 500
+
 
 class Parser(object):
     """An object responsible for parsing a shader_test file."""
@@ -114,6 +133,9 @@ class Parser(object):
             if line.startswith('['):
                 break
 
+        self._select_prog()
+
+    def _select_prog(self):
         # Select the correct binary to run the test, but be as conservative as
         # possible by always selecting the lowest version that meets the
         # criteria.
@@ -126,6 +148,35 @@ class Parser(object):
         else:
             self.prog = 'shader_runner'
 
+    def to_json(self):
+        """Return the parsed requirements as a json serializable dict."""
+        return {
+            'gl_required': sorted(self.gl_required),
+            'gl_version': self._gl_version,
+            'gles_version': self._gles_version,
+            'glsl_version': self._glsl_version,
+            'glsl_es_version': self._glsl_es_version,
+            'op': self.__op,
+            'sl_op': self.__sl_op,
+        }
+
+    @classmethod
+    def from_dict(cls, filename, dict_):
+        """Create a parsed Parser from the output of to_json().
+
+        This does not read filename.
+        """
+        parser = cls(filename)
+        parser.gl_required = set(dict_['gl_required'])
+        parser._gl_version = dict_['gl_version']
+        parser._gles_version = dict_['gles_version']
+        parser._glsl_version = dict_['glsl_version']
+        parser._glsl_es_version = dict_['glsl_es_version']
+        parser.__op = dict_['op']
+        parser.__sl_op = dict_['sl_op']
+        parser._select_prog()
+        return parser
+
     # FIXME: All of these properties are a work-around for the fact that the
     # FastSkipMixin assumes that operations are always > or >=
 
@@ -152,11 +203,16 @@ class ShaderTest(FastSkipMixin, PiglitBaseTest):
     This function parses a shader test to determine if it's a GL, GLES2 or
     GLES3 test, and then returns a PiglitTest setup properly.
 
+    Arguments:
+    filename -- the path to the shader_test file
+    parser -- an already parsed Parser for filename, if one is at hand
+
     """
 
-    def __init__(self, filename):
-        parser = Parser(filename)
-        parser.parse()
+    def __init__(self, filename, parser=None):
+        if parser is None:
+            parser = Parser(filename)
+            parser.parse()
 
         super(ShaderTest, self).__init__(
             [parser.prog, parser.filename],
@@ -182,10 +238,12 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
 
     Arguments:
     filenames -- a list of absolute paths to shader test files
+    parsers -- an optional list of already parsed Parsers, one per file
     """
 
-    def __init__(self, filenames):
+    def __init__(self, filenames, parsers=None):
         assert filenames
+        assert parsers is None or len(parsers) == len(filenames)
         prog = None
         files = []
         subtests = []
@@ -194,9 +252,12 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
         # Walk each subtest, and either add it to the list of tests to run, or
         # determine it is skip, and set the result of that test in the subtests
         # dictionary to skip without adding it ot the liest of tests to run
-        for each in filenames:
-            parser = Parser(each)
-            parser.parse()
+        for i, each in enumerate(filenames):
+            if parsers is not None:
+                parser = parsers[i]
+            else:
+                parser = Parser(each)
+                parser.parse()
             subtest = os.path.basename(os.path.splitext(each)[0]).lower()
 
             if prog is not None:
@@ -277,3 +338,221 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
                 'not supported on this implementation\n') and not
             self.result.out.endswith(
                 'PIGLIT: {"result": "skip" }\n'))
+
+
+def _pump(stream, lines):
+    """Move lines from stream into the lines queue until EOF.
+
+    None is queued once the stream is closed.
+    """
+    for line in iter(stream.readline, ''):
+        lines.put(line)
+    lines.put(None)
+
+
+class _WorkerTimeout(Exception):
+    """Raised by ShaderRunnerWorker when a test script runs too long."""
+
+
+class ShaderRunnerWorker(object):
+    """A long running "shader_runner -worker" process.
+
+    The process is started with the first test script on its command line and
+    is then handed one test script path per line on stdin. After each script
+    it prints a regular PIGLIT result line, followed by _WORKER_DONE on stderr
+    and stdout. If the worker dies (crash, or a test calling
+    piglit_report_result()) it is restarted with the next test script.
+
+    Arguments:
+    command -- the shader_runner binary followed by the arguments to pass to
+               it after the first test script.
+    env     -- the environment to start the process in.
+    """
+
+    def __init__(self, command, env=None):
+        self._command = command
+        self._env = env
+        self._proc = None
+        self._out = None
+        self._err = None
+        self._count = 0
+        self.last_pid = None
+
+    def _start(self, filename):
+        self._proc = subprocess.Popen(
+            [self._command[0], filename] + self._command[1:],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.PIPE,
+            env=self._env,
+            universal_newlines=True,
+            bufsize=1)
+        self._out = queue.Queue()
+        self._err = queue.Queue()
+        self._count = 0
+
+        for stream, lines in [(self._proc.stdout, self._out),
+                              (self._proc.stderr, self._err)]:
+            thread = threading.Thread(target=_pump, args=(stream, lines))
+            thread.daemon = True
+            thread.start()
+
+    @staticmethod
+    def _collect(lines, deadline):
+        """Read lines until the done marker or EOF.
+
+        Returns a tuple of the text read and True if the marker was seen.
+        """
+        text = []
+        while True:
+            try:
+                if deadline is None:
+                    line = lines.get()
+                else:
+                    line = lines.get(
+                        timeout=max(deadline - time.time(), 0))
+            except queue.Empty:
+                raise _WorkerTimeout()
+
+            if line is None:
+                return ''.join(text), False
+            elif line.rstrip('\n') == _WORKER_DONE:
+                return ''.join(text), True
+            text.append(line)
+
+    def run(self, filename, timeout=None):
+        """Run a single test script.
+
+        Returns a tuple of (stdout, stderr, returncode). The returncode is 0 if
+        the worker survived the test.
+
+        Raises _WorkerTimeout if the test didn't finish within timeout
+        seconds, the worker is killed in that case.
+        """
+        if self._proc is not None:
+            try:
+                self._proc.stdin.write(filename + '\n')
+                self._proc.stdin.flush()
+            except (IOError, OSError) as e:
+                if e.errno != errno.EPIPE:
+                    raise
+                self.close()
+
+        if self._proc is None:
+            self._start(filename)
+        self._count += 1
+        self.last_pid = self._proc.pid
+
+        deadline = time.time() + timeout if timeout else None
+        try:
+            out, done = self._collect(self._out, deadline)
+        except _WorkerTimeout:
+            self.kill()
+            raise
+
+        if done:
+            # stderr's marker is always written before stdout's
+            err, _ = self._collect(self._err, None)
+            returncode = 0
+            if self._count >= _WORKER_MAX_TESTS:
+                self.close()
+        else:
+            err, _ = self._collect(self._err, None)
+            returncode = self._proc.wait()
+            self._proc = None
+
+        return out, err, returncode
+
+    def close(self):
+        """Ask the worker to exit by closing its stdin, and reap it."""
+        if self._proc is None:
+            return
+        try:
+            self._proc.stdin.close()
+        except (IOError, OSError):
+            pass
+        self._proc.wait()
+        self._proc = None
+
+    def kill(self):
+        """Kill the worker immediately."""
+        if self._proc is None:
+            return
+        try:
+            self._proc.kill()
+        except OSError:
+            pass
+        self._proc.wait()
+        self._proc = None
+
+
+class _WorkerPool(object):
+    """Hands out one ShaderRunnerWorker per runner thread and binary.
+
+    Each thread of the profile's pool gets its own worker for each
+    shader_runner binary, so process startup is paid about once per core
+    instead of once per test or per directory.
+    """
+
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._workers = {}
+
+    def get(self, command, env):
+        key = (threading.current_thread().ident, command[0])
+        with self._lock:
+            worker = self._workers.get(key)
+            if worker is None:
+                worker = self._workers[key] = ShaderRunnerWorker(command, env)
+        return worker
+
+    def close(self):
+        with self._lock:
+            workers = list(six.itervalues(self._workers))
+            self._workers.clear()
+        for worker in workers:
+            worker.close()
+
+
+WORKERS = _WorkerPool()
+atexit.register(WORKERS.close)
+
+
+class ShaderWorkerTest(ShaderTest):
+    """A ShaderTest that runs in a persistent shader_runner worker.
+
+    Each test script is still reported as an individual test, but rather than
+    starting a new shader_runner process for it, the script is passed to the
+    worker process owned by the current runner thread.
+
+    Arguments:
+    filename -- the absolute path to a shader test file
+    """
+
+    def _run_command(self, **kwargs):
+        # valgrind wants a process per test
+        if OPTIONS.valgrind:
+            return super(ShaderWorkerTest, self)._run_command(**kwargs)
+
+        command = self.command
+        worker = WORKERS.get([command[0], '-auto', '-worker'],
+                             self._build_environment())
+
+        try:
+            out, err, returncode = worker.run(command[1], self.timeout)
+        except OSError as e:
+            if e.errno == errno.ENOENT:
+                raise TestRunError("Test executable not found.\n", 'skip')
+            raise
+        except _WorkerTimeout:
+            raise TestRunError(
+                'Test run time exceeded timeout value ({} seconds)\n'.format(
+                    self.timeout),
+                'timeout')
+        finally:
+            if worker.last_pid is not None:
+                self.result.pid.append(worker.last_pid)
+
+        self.result.out = out
+        self.result.err = err
+        self.result.returncode = returncode
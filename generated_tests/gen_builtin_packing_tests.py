@@ -1030,8 +1030,9 @@ class ShaderTest(object):
         dirname = os.path.dirname(self.filename)
         utils.safe_makedirs(dirname)
 
-        with open(self.filename, "w") as f:
-            f.write(self.__template.render_unicode(func=self.__func_info))
+        utils.write_if_changed(
+            self.filename,
+            self.__template.render_unicode(func=self.__func_info))
 
 
 def main():
@@ -514,8 +514,7 @@ class ShaderTest(object):
         filename = self.filename()
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(shader_test)
+        utils.write_if_changed(filename, shader_test)
 
 
 class VertexShaderTest(ShaderTest):
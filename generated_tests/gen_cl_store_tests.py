@@ -61,7 +61,7 @@ def print_config(f, type_name, addr_space):
 def begin_test(type_name, addr_space):
     fileName = os.path.join(dirName, 'store-' + type_name + '-' + addr_space + '.program_test')
     print(fileName)
-    f = open(fileName, 'w')
+    f = utils.open_if_changed(fileName)
     print_config(f, type_name, addr_space)
     return f
 
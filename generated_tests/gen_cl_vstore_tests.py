@@ -49,7 +49,7 @@ def ext_req(type_name):
 def begin_test(suffix, type_name, addr_space):
     fileName = os.path.join(dirName, 'vstore'+ suffix + '-' + type_name + '-' + addr_space + '.cl')
     print(fileName)
-    f = open(fileName, 'w')
+    f = utils.open_if_changed(fileName)
     f.write(textwrap.dedent(("""
     /*!
     [config]
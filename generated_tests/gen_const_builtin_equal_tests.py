@@ -84,9 +84,8 @@ def main():
 
         print(name)
 
-        with open(name, 'w') as f:
-            f.write(TEMPLATE.render_unicode(
-                func='equal', input=x[0:2], expected=x[2]))
+        utils.write_if_changed(name, TEMPLATE.render_unicode(
+            func='equal', input=x[0:2], expected=x[2]))
 
         # make notEqual tests
         name = os.path.join(
@@ -101,9 +100,8 @@ def main():
 
         print(name)
 
-        with open(name, 'w') as f:
-            f.write(TEMPLATE.render_unicode(
-                func='notEqual', input=x[0:2], expected=expected))
+        utils.write_if_changed(name, TEMPLATE.render_unicode(
+            func='notEqual', input=x[0:2], expected=expected))
 
 
 if __name__ == "__main__":
@@ -207,8 +207,7 @@ class ParserTest(object):
         filename = self.filename()
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(parser_test)
+        utils.write_if_changed(filename, parser_test)
 
 
 class VertexParserTest(ParserTest):
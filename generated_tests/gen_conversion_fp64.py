@@ -387,13 +387,12 @@ class RegularTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
-                test_file.write(TEMPLATES.get_template(
-                    'compiler.{}.mako'.format(self._stage)).render_unicode(
-                        ver=self._ver,
-                        from_type=from_type,
-                        to_type=to_type,
-                        converted_from=converted_from))
+            utils.write_if_changed(filename, TEMPLATES.get_template(
+                'compiler.{}.mako'.format(self._stage)).render_unicode(
+                    ver=self._ver,
+                    from_type=from_type,
+                    to_type=to_type,
+                    converted_from=converted_from))
 
     def _gen_exec_test(self, from_type, to_type,
                        uniform_from_type, uniform_to_type,
@@ -406,17 +405,16 @@ class RegularTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
-                test_file.write(TEMPLATES.get_template(
-                    'execution.{}.shader_test.mako'.format(self._stage)).render_unicode(
-                        ver=self._ver,
-                        amount=self._amount,
-                        from_type=from_type,
-                        to_type=to_type,
-                        converted_from=converted_from,
-                        uniform_from_type=uniform_from_type,
-                        uniform_to_type=uniform_to_type,
-                        conversions=conversions))
+            utils.write_if_changed(filename, TEMPLATES.get_template(
+                'execution.{}.shader_test.mako'.format(self._stage)).render_unicode(
+                    ver=self._ver,
+                    amount=self._amount,
+                    from_type=from_type,
+                    to_type=to_type,
+                    converted_from=converted_from,
+                    uniform_from_type=uniform_from_type,
+                    uniform_to_type=uniform_to_type,
+                    conversions=conversions))
 
     def _gen_to_double(self):
         converted_from = 'from'
@@ -532,18 +530,17 @@ class ZeroSignTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
-                test_file.write(TEMPLATES.get_template(
-                    'execution-zero-sign.{}.shader_test.mako'.format(
-                        self._stage)).render_unicode(
-                            ver=self._ver,
-                            amount=self._amount,
-                            from_type=from_type,
-                            to_type=to_type,
-                            converted_from=converted_from,
-                            uniform_from_type=uniform_from_type,
-                            uniform_to_type=uniform_to_type,
-                            conversions=conversions))
+            utils.write_if_changed(filename, TEMPLATES.get_template(
+                'execution-zero-sign.{}.shader_test.mako'.format(
+                    self._stage)).render_unicode(
+                        ver=self._ver,
+                        amount=self._amount,
+                        from_type=from_type,
+                        to_type=to_type,
+                        converted_from=converted_from,
+                        uniform_from_type=uniform_from_type,
+                        uniform_to_type=uniform_to_type,
+                        conversions=conversions))
 
     def _gen_to_double(self):
         if self._ver == '410':
@@ -153,11 +153,10 @@ def _gen_tests(ext, version, stage, path, extra_name, extra_extensions):
         name = os.path.join(path, '{}-{}.{}'.format(test, extra_name, stage))
 
         # Open in bytes mode to avoid weirdness in python 2/3 compatibility
-        with open(name, 'wb') as f:
-            f.write(template.render(
-                version=version,
-                extension=ext,
-                extra_extensions=extra_extensions))
+        utils.write_if_changed(name, template.render(
+            version=version,
+            extension=ext,
+            extra_extensions=extra_extensions))
         print(name)
 
 
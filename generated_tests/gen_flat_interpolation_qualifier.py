@@ -28,10 +28,9 @@ import argparse
 import os
 import itertools
 
-from templates import template_dir
 from modules import utils
 
-TEMPLATES = template_dir(os.path.basename(os.path.splitext(__file__)[0]))
+GENERATOR = os.path.basename(os.path.splitext(__file__)[0])
 
 INT_TYPES = ['int', 'ivec2', 'ivec3', 'ivec4']
 
@@ -58,7 +57,7 @@ def get_dir_name(ver):
 
 
 def generate(type_name, mode, interface_block, struct, array, ver, names_only):
-    """Generate GLSL parser tests."""
+    """Return the job generating a GLSL parser test, or None if names_only."""
 
     assert isinstance(type_name, str)
     assert isinstance(mode, str)
@@ -79,16 +78,15 @@ def generate(type_name, mode, interface_block, struct, array, ver, names_only):
 
     print(filename)
 
-    if not names_only:
-        with open(filename, 'w') as test_file:
-            test_file.write(TEMPLATES.get_template(
-                'template.frag.mako').render_unicode(
-                    ver=ver,
-                    mode=mode,
-                    type_name=type_name,
-                    interface_block=interface_block,
-                    struct=struct,
-                    array=array))
+    if names_only:
+        return None
+    return (filename, 'template.frag.mako',
+            {'ver': ver,
+             'mode': mode,
+             'type_name': type_name,
+             'interface_block': interface_block,
+             'struct': struct,
+             'array': array})
 
 
 def create_tests(type_names, glsl_vers, names_only):
@@ -162,8 +160,9 @@ def main():
         help="Don't output files, just generate a list of filenames to stdout")
     args = parser.parse_args()
 
-    for test_args in all_tests(args.names_only):
-        generate(*test_args)
+    jobs = [generate(*test_args) for test_args in all_tests(args.names_only)]
+    if not args.names_only:
+        utils.render_templates(GENERATOR, jobs)
 
 
 if __name__ == '__main__':
@@ -64,13 +64,12 @@ def generate_compilation_tests(type_name, shader, ver, names_only):
     print(filename)
 
     if not names_only:
-        with open(filename, 'w') as test_file:
-            test_file.write(TEMPLATES.get_template(
-                'template.{0}.mako'.format(shader)).render_unicode(
-                    glsl_version='{}.{}'.format(ver[0], ver[1:]),
-                    glsl_version_int=ver,
-                    type_name=type_name,
-                    extra_params=',0.0' if type_name in ['dvec2', 'dvec3'] else ''))
+        utils.write_if_changed(filename, TEMPLATES.get_template(
+            'template.{0}.mako'.format(shader)).render_unicode(
+                glsl_version='{}.{}'.format(ver[0], ver[1:]),
+                glsl_version_int=ver,
+                type_name=type_name,
+                extra_params=',0.0' if type_name in ['dvec2', 'dvec3'] else ''))
 
 
 def generate_execution_tests(type_name, ver, names_only):
@@ -87,12 +86,11 @@ def generate_execution_tests(type_name, ver, names_only):
     print(filename)
 
     if not names_only:
-        with open(filename, 'w') as test_file:
-            test_file.write(TEMPLATES.get_template(
-                'template.shader_test.mako').render_unicode(
-                    glsl_version='{}.{}'.format(ver[0], ver[1:]),
-                    glsl_version_int=ver,
-                    type_name=type_name))
+        utils.write_if_changed(filename, TEMPLATES.get_template(
+            'template.shader_test.mako').render_unicode(
+                glsl_version='{}.{}'.format(ver[0], ver[1:]),
+                glsl_version_int=ver,
+                type_name=type_name))
 
 
 def all_compilation_tests(names_only):
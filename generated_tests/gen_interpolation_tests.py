@@ -271,8 +271,7 @@ class Test(object):
         filename = self.filename()
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(TEMPLATE.render_unicode(args=self))
+        utils.write_if_changed(filename, TEMPLATE.render_unicode(args=self))
 
 
 def all_tests():
@@ -66,15 +66,14 @@ def generate(dirname, type_name, op, usage, shader_target):
             _NAMES[op], type_name, usage, shader_target))
 
     print(filename)
-    with open(filename, 'w') as f:
-        f.write(TEMPLATES.get_template(
-            '{0}.glsl_parser_test.mako'.format(usage)).render_unicode(
-                type_name=type_name,
-                mode=mode,
-                dest=dest,
-                components=components,
-                var_as_vec4=var_as_vec4,
-                op=op))
+    utils.write_if_changed(filename, TEMPLATES.get_template(
+        '{0}.glsl_parser_test.mako'.format(usage)).render_unicode(
+            type_name=type_name,
+            mode=mode,
+            dest=dest,
+            components=components,
+            var_as_vec4=var_as_vec4,
+            op=op))
 
 
 def all_tests():
@@ -39,8 +39,7 @@ def main():
                   'mat3x4', 'mat4', 'mat4x2', 'mat4x3', 'mat4x4']:
         name = os.path.join(dirname, 'outerProduct-{0}.vert'.format(type_))
         print(name)
-        with open(name, 'w+') as f:
-            f.write(TEMPLATE.render_unicode(type=type_))
+        utils.write_if_changed(name, TEMPLATE.render_unicode(type=type_))
 
 
 if __name__ == '__main__':
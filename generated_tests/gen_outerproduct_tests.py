@@ -66,10 +66,10 @@ def main():
                     vec='-ivec' if params.vec_type == 'ivec' else ''))
 
             print(name)
-            with open(name, 'w+') as f:
-                f.write(TEMPLATE.render_unicode(params=params,
-                                                type=type_,
-                                                shader=shader))
+            utils.write_if_changed(name,
+                                   TEMPLATE.render_unicode(params=params,
+                                                           type=type_,
+                                                           shader=shader))
 
 
 if __name__ == '__main__':
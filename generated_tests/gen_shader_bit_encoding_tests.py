@@ -163,19 +163,18 @@ def main():
                     elif in_modifier_func == 'neg_abs':
                         in_modifier_func = '-abs'
 
-                    with open(filename, 'w') as f:
-                        f.write(TEMPLATE.render_unicode(
-                            version=version,
-                            extensions=extensions,
-                            execution_stage=execution_stage,
-                            func=func,
-                            modifier_func=modifier_func,
-                            in_modifier_func=in_modifier_func,
-                            in_func=attrib['in_func'],
-                            out_func=attrib['out_func'],
-                            input_type=attrib['input'],
-                            output_type=attrib['output'],
-                            test_data=TEST_DATA))
+                    utils.write_if_changed(filename, TEMPLATE.render_unicode(
+                        version=version,
+                        extensions=extensions,
+                        execution_stage=execution_stage,
+                        func=func,
+                        modifier_func=modifier_func,
+                        in_modifier_func=in_modifier_func,
+                        in_func=attrib['in_func'],
+                        out_func=attrib['out_func'],
+                        input_type=attrib['input'],
+                        output_type=attrib['output'],
+                        test_data=TEST_DATA))
 
 
 if __name__ == '__main__':
@@ -66,8 +66,7 @@ def gen(src, tests):
     for t in tests:
         print(t['path'])
         utils.safe_makedirs(os.path.dirname(t['path']))
-        with open(t['path'], 'w') as f:
-            f.write(template.render(**t))
+        utils.write_if_changed(t['path'], template.render(**t))
 
 
 def gen_execution(src, tests):
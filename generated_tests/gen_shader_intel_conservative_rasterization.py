@@ -93,8 +93,8 @@ def gen(name, src, tests):
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
 
-        with open(filename, 'w') as f:
-            f.write(template.render(header=gen_header, **t))
+        utils.write_if_changed(filename,
+                               template.render(header=gen_header, **t))
 
 
 shader_stages = [
@@ -59,6 +59,7 @@ import six
 from six.moves import range
 
 from templates import template_file
+from modules import utils
 
 
 
@@ -248,17 +249,18 @@ def main():
                 num_elements = signature.rettype.num_cols * signature.rettype.num_rows
                 invocation = signature.template.format( *['arg{0}'.format(i)
                                                         for i in range(len(signature.argtypes))])
-                with open(output_filename, 'w') as f:
-                    f.write(template.render_unicode( signature=signature,
-                                                     is_complex_tolerance=_is_sequence(tolerance),
-                                                     complex_tol_type=signature.rettype,
-                                                     test_vectors=refined_test_vectors,
-                                                     invocation=invocation,
-                                                     num_elements=num_elements,
-                                                     indexers=indexers,
-                                                     shader_runner_type=shader_runner_type,
-                                                     shader_runner_format=shader_runner_format,
-                                                     column_major_values=column_major_values ))
+                utils.write_if_changed(
+                    output_filename,
+                    template.render_unicode(signature=signature,
+                                            is_complex_tolerance=_is_sequence(tolerance),
+                                            complex_tol_type=signature.rettype,
+                                            test_vectors=refined_test_vectors,
+                                            invocation=invocation,
+                                            num_elements=num_elements,
+                                            indexers=indexers,
+                                            shader_runner_type=shader_runner_type,
+                                            shader_runner_format=shader_runner_format,
+                                            column_major_values=column_major_values))
 
 if __name__ == "__main__":
     main()
@@ -48,6 +48,8 @@ import textwrap
 
 from six.moves import range
 
+from modules import utils
+
 
 class Test(object):
     def __init__(self, type_name, array, patch_in, name):
@@ -310,8 +312,7 @@ class Test(object):
         dirname = os.path.dirname(filename)
         if not os.path.exists(dirname):
             os.makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(test)
+        utils.write_if_changed(filename, test)
 
 
 def all_tests():
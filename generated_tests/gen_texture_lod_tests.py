@@ -86,9 +86,8 @@ def main():
                 dimensions=params.dimensions,
                 coord=params.coord))
         print(name)
-        with open(name, 'w+') as f:
-            f.write(TEMPLATES.get_template(
-                'frag_lod.glsl_parser_test.mako').render_unicode(param=params))
+        utils.write_if_changed(name, TEMPLATES.get_template(
+            'frag_lod.glsl_parser_test.mako').render_unicode(param=params))
 
     for params in GRAD_TESTS:
         # Generate fragment shader test
@@ -101,8 +100,9 @@ def main():
 
         for stage in ['frag', 'vert']:
             print('{0}.{1}'.format(name, stage))
-            with open('{0}.{1}'.format(name, stage), 'w+') as f:
-                f.write(TEMPLATES.get_template(
+            utils.write_if_changed(
+                '{0}.{1}'.format(name, stage),
+                TEMPLATES.get_template(
                     'tex_grad.{0}.mako'.format(stage)).render_unicode(
                         param=params,
                         extensions=get_extensions(params.mode)))
@@ -108,14 +108,13 @@ def main():
                                                      file_extension))
                 print(filename)
 
-                with open(filename, "w") as f:
-                    f.write(TEMPLATE.render_unicode(
-                        version=requirement['version'],
-                        extensions=requirements,
-                        execution_stage=execution_stage,
-                        sampler_type=sampler_type,
-                        coord_type=coord_type,
-                        lod=lod))
+                utils.write_if_changed(filename, TEMPLATE.render_unicode(
+                    version=requirement['version'],
+                    extensions=requirements,
+                    execution_stage=execution_stage,
+                    sampler_type=sampler_type,
+                    coord_type=coord_type,
+                    lod=lod))
 
 
 if __name__ == '__main__':
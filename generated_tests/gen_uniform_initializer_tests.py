@@ -123,11 +123,12 @@ def generate_tests(type_list, base_name, major, minor):
                 test_vectors.append((type_, name, value))
                 api_vectors.append((api_type, name, alt_numbers))
 
-            with open(test_file_name, "w") as f:
-                f.write(template.render_unicode(type_list=test_vectors,
-                                                api_types=api_vectors,
-                                                major=major,
-                                                minor=minor))
+            utils.write_if_changed(
+                test_file_name,
+                template.render_unicode(type_list=test_vectors,
+                                        api_types=api_vectors,
+                                        major=major,
+                                        minor=minor))
 
 
 def generate_array_tests(type_list, base_name, major, minor):
@@ -169,10 +170,11 @@ def generate_array_tests(type_list, base_name, major, minor):
             '{0}-{1}-array.shader_test'.format(target, base_name))
         print(test_file_name)
 
-        with open(test_file_name, "w") as f:
-            f.write(template.render_unicode(type_list=vecs,
-                                            major=major,
-                                            minor=minor))
+        utils.write_if_changed(
+            test_file_name,
+            template.render_unicode(type_list=vecs,
+                                    major=major,
+                                    minor=minor))
 
 
 def main():
@@ -26,12 +26,9 @@ import itertools
 
 from six.moves import range
 
-from templates import template_dir
-from modules.utils import lazy_property, safe_makedirs
+from modules.utils import lazy_property, render_templates
 
-TEMPLATES = template_dir(os.path.basename(os.path.splitext(__file__)[0]))
-FS_TEMPLATE = TEMPLATES.get_template('fs.shader_test.mako')
-VS_TEMPLATE = TEMPLATES.get_template('vs.shader_test.mako')
+GENERATOR = os.path.basename(os.path.splitext(__file__)[0])
 DIRNAME = os.path.join('spec', 'glsl-{}', 'execution', 'variable-indexing')
 
 
@@ -146,21 +143,17 @@ class TestParams(object):
 
 
 def make_fs(name, params):
-    """Generate a fragment shader test."""
-    dirname = DIRNAME.format(params.formated_version)
-    safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
-        f.write(FS_TEMPLATE.render_unicode(params=params))
+    """Return the job generating a fragment shader test."""
     print(name)
+    return (os.path.join(DIRNAME.format(params.formated_version), name),
+            'fs.shader_test.mako', {'params': params})
 
 
 def make_vs(name, params):
-    """Generate a vertex shader test."""
-    dirname = DIRNAME.format(params.formated_version)
-    safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
-        f.write(VS_TEMPLATE.render_unicode(params=params))
+    """Return the job generating a vertex shader test."""
     print(name)
+    return (os.path.join(DIRNAME.format(params.formated_version), name),
+            'vs.shader_test.mako', {'params': params})
 
 
 def main():
@@ -173,6 +166,7 @@ def main():
     stages = ['fs', 'vs']
     iter_ = itertools.product(stages, modes, array_dims, matrix_dims,
                               glsl_versions, cols)
+    jobs = []
     for stage, mode, array_dim, matrix_dim, glsl_version, col in iter_:
         if stage == 'vs':
             func = make_vs
@@ -184,7 +178,7 @@ def main():
                 arr = 'array-'
                 idx_text = 'index-'
 
-                func(
+                jobs.append(func(
                     '{stage}-{mode}-{arr}mat{matrix_dim}-{col}{row}rd.shader_test'.format(
                         stage=stage,
                         mode=mode,
@@ -193,12 +187,12 @@ def main():
                         col='col-' if col == 'col' else '',
                         row='row-' if expect == 'float' else ''),
                     TestParams(matrix_dim, array_dim, mode, 1, col, expect,
-                               glsl_version))
+                               glsl_version)))
             else:
                 arr = ''
                 idx_text = ''
 
-            func(
+            jobs.append(func(
                 '{stage}-{mode}-{arr}mat{matrix_dim}-{idx_text}{col}{row}rd.shader_test'.format(
                     stage=stage,
                     mode=mode,
@@ -208,7 +202,9 @@ def main():
                     col='col-' if col == 'col' else '',
                     row='row-' if expect == 'float' else ''),
                 TestParams(matrix_dim, array_dim, mode, 'index', col, expect,
-                           glsl_version))
+                           glsl_version)))
+
+    render_templates(GENERATOR, jobs)
 
 
 if __name__ == '__main__':
@@ -37,11 +37,8 @@ import os
 from six.moves import range  # pylint: disable=redefined-builtin
 
 from modules import utils, glsl
-from templates import template_dir
 
-_TEMPLATES = template_dir(os.path.basename(os.path.splitext(__file__)[0]))
-_VS_TEMPLATE = _TEMPLATES.get_template('vs.shader_test.mako')
-_FS_TEMPLATE = _TEMPLATES.get_template('fs.shader_test.mako')
+_GENERATOR = os.path.basename(os.path.splitext(__file__)[0])
 _DIRNAME = os.path.join('spec', 'glsl-{}', 'execution', 'variable-indexing')
 
 
@@ -219,21 +216,17 @@ class ParamsFactory(object):  # pylint: disable=too-few-public-methods
 
 
 def make_vs(name, params):
-    """Create a vertex shader test."""
-    dirname = _DIRNAME.format(params.version)
-    utils.safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
-        f.write(_VS_TEMPLATE.render_unicode(params=params))
+    """Return the job creating a vertex shader test."""
     print(name)
+    return (os.path.join(_DIRNAME.format(params.version), name),
+            'vs.shader_test.mako', {'params': params})
 
 
 def make_fs(name, params):
-    """Create a fragment shader test."""
-    dirname = _DIRNAME.format(params.version)
-    utils.safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
-        f.write(_FS_TEMPLATE.render_unicode(params=params))
+    """Return the job creating a fragment shader test."""
     print(name)
+    return (os.path.join(_DIRNAME.format(params.version), name),
+            'fs.shader_test.mako', {'params': params})
 
 
 def main():
@@ -254,6 +247,7 @@ def main():
     # Note that idx, col, row, and arr will need to have a '-' added to the end
     # of the value if it is not empty
     name = '{stage}-{mode}-{arr}mat{matrix_dim}-{idx}{col}{row}wr.shader_test'
+    jobs = []
 
     for v, a, d, m, c, s in iter_:
         for t in ['float', 'vec{}'.format(d)]:
@@ -268,7 +262,7 @@ def main():
             if a != 0:
                 arr = 'array-'
 
-                func(
+                jobs.append(func(
                     name.format(stage=s,
                                 mode=m,
                                 matrix_dim=d,
@@ -276,11 +270,11 @@ def main():
                                 idx='',
                                 col='col-' if c == 'col' else '',
                                 row='row-' if t == 'float' else ''),
-                    factory.get(m, a, d, 1, c, t, v))
+                    factory.get(m, a, d, 1, c, t, v)))
             else:
                 arr = ''
 
-            func(
+            jobs.append(func(
                 name.format(stage=s,
                             mode=m,
                             matrix_dim=d,
@@ -288,7 +282,9 @@ def main():
                             idx='index-' if a != 0 else '',
                             col='col-' if c == 'col' else '',
                             row='row-' if t == 'float' else ''),
-                factory.get(m, a, d, 'index', c, t, v))
+                factory.get(m, a, d, 'index', c, t, v)))
+
+    utils.render_templates(_GENERATOR, jobs)
 
 
 if __name__ == '__main__':
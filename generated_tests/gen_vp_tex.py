@@ -53,8 +53,8 @@ def main():
         for target in targets_1:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
-                f.write(template.render_unicode(target=target, inst=inst))
+            utils.write_if_changed(
+                fname, template.render_unicode(target=target, inst=inst))
             print(fname)
             i += 1
 
@@ -62,8 +62,8 @@ def main():
         for target in targets_1:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
-                f.write(template.render_unicode(target=target, inst=inst))
+            utils.write_if_changed(
+                fname, template.render_unicode(target=target, inst=inst))
             print(fname)
             i += 1
 
@@ -71,15 +71,15 @@ def main():
         for target in ["CUBE", "RECT"]:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
-                f.write(template.render_unicode(target=target, inst=inst))
+            utils.write_if_changed(
+                fname, template.render_unicode(target=target, inst=inst))
             print(fname)
             i += 1
 
         template = TEMPLATES.get_template('nvvp3.mako')
         fname = os.path.join(dirname, "{}-{:0>2d}.txt".format(inst.lower(), i))
-        with open(fname, 'w') as f:
-            f.write(template.render_unicode(target="SHADOWRECT", inst=inst))
+        utils.write_if_changed(
+            fname, template.render_unicode(target="SHADOWRECT", inst=inst))
         print(fname)
         i += 1
 
@@ -87,8 +87,8 @@ def main():
         for target in ["SHADOW1D", "SHADOW2D", "SHADOWRECT"]:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
-                f.write(template.render_unicode(target=target, inst=inst))
+            utils.write_if_changed(
+                fname, template.render_unicode(target=target, inst=inst))
             print(fname)
             i += 1
 
@@ -462,16 +462,15 @@ class RegularTestTuple(TestTuple):
         filename += '.shader_test'
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
-                test_file.write(TEMPLATES.get_template(
-                    'regular.shader_test.mako').render_unicode(
-                        ver=self._ver,
-                        in_types=self._in_types,
-                        gl_types=self._gl_types,
-                        position_order=self._position_order,
-                        arrays=self._arrays,
-                        num_vs_in=self._num_vs_in,
-                        gl_types_values=GL_TYPES_VALUES))
+            utils.write_if_changed(filename, TEMPLATES.get_template(
+                'regular.shader_test.mako').render_unicode(
+                    ver=self._ver,
+                    in_types=self._in_types,
+                    gl_types=self._gl_types,
+                    position_order=self._position_order,
+                    arrays=self._arrays,
+                    num_vs_in=self._num_vs_in,
+                    gl_types_values=GL_TYPES_VALUES))
 
         print(filename)
 
@@ -517,13 +516,12 @@ class ColumnsTestTuple(TestTuple):
         filename += '.shader_test'
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
-                test_file.write(TEMPLATES.get_template(
-                    'columns.shader_test.mako').render_unicode(
-                        ver=self._ver,
-                        mat=self._mat,
-                        columns=self._columns,
-                        dvalues=GL_TYPES_VALUES['double']))
+            utils.write_if_changed(filename, TEMPLATES.get_template(
+                'columns.shader_test.mako').render_unicode(
+                    ver=self._ver,
+                    mat=self._mat,
+                    columns=self._columns,
+                    dvalues=GL_TYPES_VALUES['double']))
 
         print(filename)
 
@@ -3,6 +3,8 @@ import os
 
 import six
 
+from modules import utils
+
 __all__ = ['gen', 'DATA_SIZES', 'MAX_VALUES', 'MAX', 'MIN', 'BMIN', 'BMAX',
            'SMIN', 'SMAX', 'UMIN', 'UMAX', 'TYPE', 'T', 'U', 'B']
 
@@ -436,7 +438,7 @@ def gen(types, minVersions, functions, testDefs, dirName):
 
             fileName = os.path.join(dirName, fileName)
 
-            with open(fileName, 'w') as f:
+            with utils.open_if_changed(fileName) as f:
                 print(fileName)
                 # Write the file header
                 f.write('/*!\n' +
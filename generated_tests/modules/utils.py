@@ -24,6 +24,8 @@ from __future__ import print_function, absolute_import
 import os
 import errno
 import functools
+import hashlib
+import multiprocessing
 
 
 def safe_makedirs(dirs):
@@ -65,3 +67,105 @@ class lazy_property(object):
         value = self.__func(obj)
         setattr(obj, self.__func.__name__, value)
         return value
+
+
+def write_if_changed(filename, content):
+    """Write content to a file, unless the file already has that content.
+
+    A file whose content hashes the same is left alone, so it keeps its mtime
+    and anything depending on it isn't invalidated. The directory of the file
+    is created if needed. Text content is written as utf-8.
+
+    Returns True if the file was written.
+
+    """
+    if not isinstance(content, bytes):
+        content = content.encode('utf-8')
+
+    try:
+        with open(filename, 'rb') as f:
+            if (hashlib.sha1(f.read()).digest() ==
+                    hashlib.sha1(content).digest()):
+                return False
+    except (IOError, OSError):
+        safe_makedirs(os.path.dirname(filename) or '.')
+
+    with open(filename, 'wb') as f:
+        f.write(content)
+    return True
+
+
+class open_if_changed(object):  # pylint: disable=invalid-name
+    """A file to write a generated test into, with write_if_changed().
+
+    It can be used in place of a file opened for writing, by generators that
+    write their tests piece by piece. What is written is kept and only goes
+    to the file when it's closed, which is done on leaving a with block
+    without an exception.
+
+    """
+    def __init__(self, filename):
+        self.filename = filename
+        self.__parts = []
+
+    def write(self, content):
+        self.__parts.append(content)
+
+    def close(self):
+        """Write the file if its content changed, see write_if_changed()."""
+        return write_if_changed(self.filename, ''.join(self.__parts))
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        if exc_type is None:
+            self.close()
+
+
+_LOOKUPS = {}
+
+
+def _render_template(job):
+    """Render one template of render_templates() and write it."""
+    generator, filename, template, kwargs = job
+
+    # The templates module is found next to the generators, like they do.
+    if generator not in _LOOKUPS:
+        from templates import template_dir
+        _LOOKUPS[generator] = template_dir(generator)
+
+    return write_if_changed(
+        filename,
+        _LOOKUPS[generator].get_template(template).render_unicode(**kwargs))
+
+
+def render_templates(generator, jobs, processes=None):
+    """Render templates into files over a pool of processes.
+
+    Each job is a (filename, template, kwargs) tuple, the template is looked
+    up in the templates of the generator, like template_dir() does, and
+    rendered with the kwargs, which have to be picklable. Only the files whose
+    content changed are written, see write_if_changed().
+
+    Returns the number of files written and the number left unchanged.
+
+    Arguments:
+    generator -- the name of the generator, which corresponds to the subdir of
+                 the templates folder.
+    jobs -- an iterable of (filename, template, kwargs) tuples.
+
+    Keyword Arguments:
+    processes -- the number of processes, by default one per cpu.
+
+    """
+    jobs = [(generator, f, t, k) for f, t, k in jobs]
+
+    pool = multiprocessing.Pool(processes)
+    try:
+        written = sum(pool.map(_render_template, jobs, chunksize=16))
+    finally:
+        pool.close()
+        pool.join()
+
+    return written, len(jobs) - written
@@ -15,15 +15,19 @@ from six.moves import range
 from framework import grouptools
 from framework import options
 from framework.profile import TestProfile
+from framework.profile_index import ProfileIndex
 from framework.driver_classifier import DriverClassifier
 from framework.test import (PiglitGLTest, GleanTest, PiglitBaseTest,
-                            GLSLParserTest, GLSLParserNoConfigError)
-from framework.test.shader_test import ShaderTest, MultiShaderTest
+                            GLSLParserTest, GLSLParserNoConfigError,
+                            MultiGLSLParserTest)
+from framework.test.shader_test import (ShaderTest, MultiShaderTest,
+                                        ShaderWorkerTest)
 from .py_modules.constants import TESTS_DIR, GENERATED_TESTS_DIR
 
 __all__ = ['profile']
 
 PROCESS_ISOLATION = options.OPTIONS.process_isolation
+SHADER_RUNNER_WORKERS = options.OPTIONS.shader_runner_workers
 
 # Disable bad hanging indent errors in pylint
 # There is a bug in pylint which causes the profile.test_list.group_manager to
@@ -209,6 +213,11 @@ def power_set(s):
 profile = TestProfile()  # pylint: disable=invalid-name
 
 shader_tests = collections.defaultdict(list)
+glslparser_tests = collections.defaultdict(list)
+
+# The parsed requirements of shader_test and glslparser files are cached
+# between imports, so only new or modified files need to be parsed.
+index = ProfileIndex.for_dirs([TESTS_DIR, GENERATED_TESTS_DIR])
 
 # Find and add all shader tests.
 for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
@@ -217,19 +226,33 @@ for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
             testname, ext = os.path.splitext(filename)
             groupname = grouptools.from_path(os.path.relpath(dirpath, basedir))
             if ext == '.shader_test':
-                if PROCESS_ISOLATION:
-                    test = ShaderTest(os.path.join(dirpath, filename))
+                path = os.path.join(dirpath, filename)
+                if SHADER_RUNNER_WORKERS:
+                    test = ShaderWorkerTest(path,
+                                            parser=index.shader_test(path))
+                elif PROCESS_ISOLATION:
+                    test = ShaderTest(path, parser=index.shader_test(path))
                 else:
-                    shader_tests[groupname].append(os.path.join(dirpath, filename))
+                    shader_tests[groupname].append(path)
                     continue
             elif ext in ['.vert', '.tesc', '.tese', '.geom', '.frag', '.comp']:
+                path = os.path.join(dirpath, filename)
                 try:
-                    test = GLSLParserTest(os.path.join(dirpath, filename))
+                    parser = index.glsl_parser_test(path)
                 except GLSLParserNoConfigError:
                     # In the event that there is no config assume that it is a
                     # legacy test, and continue
                     continue
 
+                if not PROCESS_ISOLATION:
+                    # Files are batched by the GLSL version they request,
+                    # since that decides which GL context is created.
+                    glslparser_tests[
+                        (groupname, parser.config['glsl_version'])].append(
+                            (path, parser))
+                    continue
+                test = GLSLParserTest(path, parser=parser)
+
                 # For glslparser tests you can have multiple tests with the
                 # same name, but a different stage, so keep the extension.
                 testname = filename
@@ -250,9 +273,28 @@ for group, files in six.iteritems(shader_tests):
     if len(files) == 1:
         group = grouptools.join(
             group, os.path.basename(os.path.splitext(files[0])[0]))
-        profile.test_list[group] = ShaderTest(files[0])
+        profile.test_list[group] = ShaderTest(
+            files[0], parser=index.shader_test(files[0]))
     else:
-        profile.test_list[group] = MultiShaderTest(files)
+        profile.test_list[group] = MultiShaderTest(
+            files, parsers=[index.shader_test(f) for f in files])
+
+for (group, version), files in six.iteritems(glslparser_tests):
+    # If there is only one file for a version use a normal GLSLParserTest.
+    # Otherwise use a MultiGLSLParserTest named after the version.
+    if len(files) == 1:
+        path, parser = files[0]
+        group = grouptools.join(group, os.path.basename(path))
+        test = GLSLParserTest(path, parser=parser)
+    else:
+        group = grouptools.join(
+            group, 'glslparser-{}'.format(version.replace(' ', '-')))
+        test = MultiGLSLParserTest([f for f, _ in files],
+                                   parsers=[p for _, p in files])
+    assert group not in profile.test_list, 'duplicate group: {}'.format(group)
+    profile.test_list[group] = test
+
+index.write()
 
 # Collect and add all asmparsertests
 for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
@@ -299,22 +341,51 @@ with profile.test_list.group_manager(GleanTest, 'glean') as g:
     g('depthStencil')
     g('fbo')
     g('getString')
-    g('pixelFormats')
     g('pointAtten')
     g('pointSprite')
     # exactRGBA is not included intentionally, because it's too strict and
     # the equivalent functionality is covered by other tests
     g('shaderAPI')
-    g('texCombine')
     g('texCube')
     g('texEnv')
     g('texgen')
-    g('texCombine4')
     g('texture_srgb')
     g('texUnits')
     g('vertArrayBGRA')
     g('vertattrib')
 
+# These glean tests are split into shards, which are run as separate tests
+glean_shards = [
+    ('pixelFormats', ['{0}-{1}'.format(mode, format_) for mode, format_ in
+                      itertools.product(
+                          ['GL_REPLACE', 'GL_COMBINE_ARB'],
+                          ['GL_RGBA', 'GL_BGRA', 'GL_RGB', 'GL_BGR', 'GL_RED',
+                           'GL_GREEN', 'GL_BLUE', 'GL_ALPHA', 'GL_LUMINANCE',
+                           'GL_LUMINANCE_ALPHA', 'GL_ABGR_EXT', 'GL_RG'])]),
+    ('texCombine', ['GL_REPLACE',
+                    'GL_ADD',
+                    'GL_ADD_SIGNED_EXT',
+                    'GL_MODULATE',
+                    'GL_INTERPOLATE_EXT',
+                    'GL_DOT3_RGB_EXT',
+                    'GL_DOT3_RGBA_EXT',
+                    'GL_MODULATE_ADD_ATI',
+                    'GL_MODULATE_SIGNED_ADD_ATI',
+                    'GL_MODULATE_SUBTRACT_ATI',
+                    'multitexture',
+                    'crossbar']),
+    ('texCombine4', ['iterations-0-49',
+                     'iterations-50-99',
+                     'iterations-100-149',
+                     'iterations-150-199']),
+]
+
+for prefix, shards in glean_shards:
+    for shard in shards:
+        profile.test_list[grouptools.join(
+            'glean', '{0}-{1}'.format(prefix, shard))] = GleanTest(
+                prefix, shard=shard, run_concurrent=True)
+
 glean_glsl_tests = ['Primary plus secondary color',
                     'Global vars and initializers',
                     'Global vars and initializers (2)',
@@ -30,171 +30,44 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <math.h>
-#include <regex.h>
+#include <ctype.h>
 #include <libgen.h>
 
 #include "piglit-framework-cl-program.h"
 
-/* Regexes */
-
-/*
- * IMPORTANT:
- *     Watch on subexpressions when modifying regexes, because some of them are
- *     used to retrieve the strings matching them!
- */
+/* Grammar */
 
 /*
+ * The configuration is lexed by hand in a single pass, one line at a time.
+ * Anything after a # is a comment, and a key-value whose line ends with a \
+ * is continued on the next line.
+ *
  * Section (section can include whitespace):
  *   <whitespace>[<whitespace>section<whitespace>]<whitespace>
- */
-#define REGEX_SECTION "^[[:space:]]*\\[[[:space:]]*([[:alnum:]_]+[[:alnum:][:space:]_]*[[:alnum:]_]+|[[:alnum:]_]+)[[:space:]]*\\][[:space:]]*$" /* section */
-/*
  * Key-value (value can have whitespace):
  *   <whitespace>key<whitespace>:<whitespace>value<whitespace>
+ *
+ * Values are words separated by whitespace. The words below are lists of
+ * alternative spellings separated by |.
  */
-#define REGEX_KEY_VALUE "^[[:space:]]*([[:alnum:]_]+)[[:space:]]*" /* key */ \
-                         ":" \
-                         "[[:space:]]*([^[:space:]#]+[^#]*[^[:space:]#]+|[^[:space:]#]+)[[:space:]]*$" /* value */
+#define WORDS_NULL    "NULL|null"
+#define WORDS_TRUE    "1|true"
+#define WORDS_FALSE   "0|false"
+#define WORDS_NAN     "nan|NAN|NaN"
+#define WORDS_INF     "infinity|INFINITY|Infinity|inf|INF|Inf"
+#define WORDS_RANDOM  "RANDOM|random"
+#define WORDS_REPEAT  "REPEAT|repeat"
+
 /*
- * Ignored:
- *   <whitespace>
+ * Numbers:
+ *   int:   [+-]digits or [+-]0xhexdigits
+ *   uint:  [+]digits or [+]0xhexdigits
+ *   float: [+-]digits[.digits][e][+-][digits], [+-]0xhexfloat, [+-]nan or
+ *          [+-]inf
+ *
+ * Types are char, uchar, short, ushort, int, uint, long, ulong, half, float
+ * and double, optionally followed by a vector size of 2, 3, 4, 8 or 16.
  */
-#define REGEX_IGNORE "^[[:space:]]*$"
-
-/* Values */
-#define REGEX_ARRAY_DELIMITER        "[[:space:]]+"
-#define REGEX_DEFINE_ARRAY(element)  "((" element REGEX_ARRAY_DELIMITER ")*" element ")"
-#define REGEX_NAN          "(nan|NAN|NaN)"
-#define REGEX_PNAN         "([+]?" REGEX_NAN ")"
-#define REGEX_NNAN         "([-]" REGEX_NAN ")"
-#define REGEX_INF          "(infinity|INFINITY|Infinity|inf|INF|Inf)"
-#define REGEX_PINF         "([+]?" REGEX_INF ")"
-#define REGEX_NINF         "([-]" REGEX_INF ")"
-#define REGEX_NULL         "(NULL|null)"
-#define REGEX_BOOL         "(0|1|false|true)"
-#define REGEX_BOOL_TRUE    "(1|true)"
-#define REGEX_BOOL_FALSE   "(0|false)"
-#define REGEX_INT          "(([+-]?[[:digit:]]+)|([+-]?0[Xx][[:digit:]abcdefABCDEF]+))"
-#define REGEX_UINT         "(([+]?[[:digit:]]+)|([+]?0[Xx][[:digit:]abcdefABCDEF]+))"
-#define REGEX_FLOAT_HEX    "([+-]?0[Xx][[:digit:]abcdefABCDEF.]+[[:digit:]pP+-]*)"
-#define REGEX_FLOAT        "(([+-]?[[:digit:]]+(\\.[[:digit:]]+)?e*[+-]*[[:digit:]]*)|"      \
-                             REGEX_FLOAT_HEX "|" REGEX_PNAN "|" REGEX_NNAN "|" REGEX_PINF "|" \
-                             REGEX_NINF ")"
-#define REGEX_BOOL_ARRAY   REGEX_DEFINE_ARRAY(REGEX_BOOL)
-#define REGEX_INT_ARRAY    REGEX_DEFINE_ARRAY(REGEX_INT)
-#define REGEX_UINT_ARRAY   REGEX_DEFINE_ARRAY(REGEX_UINT)
-#define REGEX_FLOAT_ARRAY  REGEX_DEFINE_ARRAY(REGEX_FLOAT)
-#define REGEX_VALUE        "(" REGEX_NULL "|" REGEX_BOOL "|" REGEX_INT "|" \
-                               REGEX_UINT "|" REGEX_FLOAT ")"
-#define REGEX_ARRAY        "(" REGEX_NULL "|" REGEX_BOOL_ARRAY "|"      \
-                               REGEX_INT_ARRAY "|" REGEX_UINT_ARRAY "|" \
-                               REGEX_FLOAT_ARRAY ")"
-#define REGEX_ARRAY_VALUE  "(" REGEX_BOOL "|" REGEX_INT "|" REGEX_UINT "|" \
-                               REGEX_FLOAT ")"
-#define REGEX_RANDOM       "(RANDOM|random)"
-#define REGEX_REPEAT       "(REPEAT|repeat)[[:space:]]+" \
-                           REGEX_DEFINE_ARRAY(REGEX_ARRAY_VALUE)
-
-/* Types */
-#define REGEX_DEFINE_TYPE(type)  type"|"type"2|"type"3|"type"4|"type"8|"type"16"
-#define REGEX_TYPE_CHAR       REGEX_DEFINE_TYPE("char")
-#define REGEX_TYPE_UCHAR      REGEX_DEFINE_TYPE("uchar")
-#define REGEX_TYPE_SHORT      REGEX_DEFINE_TYPE("short")
-#define REGEX_TYPE_USHORT     REGEX_DEFINE_TYPE("ushort")
-#define REGEX_TYPE_INT        REGEX_DEFINE_TYPE("int")
-#define REGEX_TYPE_UINT       REGEX_DEFINE_TYPE("uint")
-#define REGEX_TYPE_LONG       REGEX_DEFINE_TYPE("long")
-#define REGEX_TYPE_ULONG      REGEX_DEFINE_TYPE("ulong")
-// half is defined as unsigned short and C can't read/write its value.
-// Also half is only used as a storage format unless device supports
-// cl_khr_fp16
-// TODO: probably we could use libmpdec to handle this
-//       http://www.bytereef.org/mpdecimal/index.html
-//#define REGEX_TYPE_HALF       "buffer half[1]"
-#define REGEX_TYPE_HALF       REGEX_DEFINE_TYPE("half")
-#define REGEX_TYPE_FLOAT      REGEX_DEFINE_TYPE("float")
-#define REGEX_TYPE_DOUBLE      REGEX_DEFINE_TYPE("double")
-#define REGEX_TYPE  REGEX_TYPE_CHAR "|" REGEX_TYPE_UCHAR "|" \
-                    REGEX_TYPE_SHORT "|" REGEX_TYPE_USHORT "|" \
-                    REGEX_TYPE_INT "|" REGEX_TYPE_UINT "|" \
-                    REGEX_TYPE_LONG "|" REGEX_TYPE_ULONG "|" \
-                    REGEX_TYPE_HALF "|" REGEX_TYPE_FLOAT "|" REGEX_TYPE_DOUBLE
-
-/* Image types */
-/* TODO: add OpenCL 1.2+ types */
-#define REGEX_IMGT_2D        "2D|2d"
-#define REGEX_IMGT_3D        "3D|3d"
-#define REGEX_IMAGE_TYPE     REGEX_IMGT_2D "|" REGEX_IMGT_3D
-
-/* Image formats */
-/* TODO: add OpenCL 2.0 formats */
-#define REGEX_CHO_R          "R|r"
-#define REGEX_CHO_RX         "RX|Rx|rx"
-#define REGEX_CHO_A          "A|a"
-#define REGEX_CHO_INTENSITY  "INTENSITY|intensity"
-#define REGEX_CHO_LUMINANCE  "LUMINANCE|luminance"
-#define REGEX_CHO_RG         "RG|rg"
-#define REGEX_CHO_RGX        "RGX|RGx|rgx"
-#define REGEX_CHO_RA         "RA|ra"
-#define REGEX_CHO_RGB        "RGB|rgb"
-#define REGEX_CHO_RGBX       "RGBX|rgbx"
-#define REGEX_CHO_RGBA       "RGBA|rgba"
-#define REGEX_CHO_ARGB       "ARGB|argb"
-#define REGEX_CHO_BGRA       "BGRA|bgra"
-#define REGEX_CHANNEL_ORDER  REGEX_CHO_R "|" REGEX_CHO_RX "|" REGEX_CHO_A "|" \
-                             REGEX_CHO_INTENSITY "|" REGEX_CHO_LUMINANCE "|" \
-                             REGEX_CHO_RG "|" REGEX_CHO_RGX "|" \
-                             REGEX_CHO_RA "|" REGEX_CHO_RGB "|" \
-                             REGEX_CHO_RGBX "|" REGEX_CHO_RGBA "|" \
-                             REGEX_CHO_ARGB "|" REGEX_CHO_BGRA
-
-#define REGEX_CHT_SNORM_INT8         "SNORM_INT8|snorm_int8"
-#define REGEX_CHT_SNORM_INT16        "SNORM_INT16|snorm_int16"
-#define REGEX_CHT_UNORM_INT8         "UNORM_INT8|unorm_int8"
-#define REGEX_CHT_UNORM_INT16        "UNORM_INT16|unorm_int16"
-#define REGEX_CHT_UNORM_SHORT_565    "UNORM_SHORT_565|unorm_short_565"
-#define REGEX_CHT_UNORM_SHORT_555    "UNORM_SHORT_555|unorm_short_555"
-#define REGEX_CHT_UNORM_INT_101010   "UNORM_INT_101010|unorm_int_101010"
-#define REGEX_CHT_SIGNED_INT8        "SIGNED_INT8|signed_int8"
-#define REGEX_CHT_SIGNED_INT16       "SIGNED_INT16|signed_int16"
-#define REGEX_CHT_SIGNED_INT32       "SIGNED_INT32|signed_int32"
-#define REGEX_CHT_UNSIGNED_INT8      "UNSIGNED_INT8|unsigned_int8"
-#define REGEX_CHT_UNSIGNED_INT16     "UNSIGNED_INT16|unsigned_int16"
-#define REGEX_CHT_UNSIGNED_INT32     "UNSIGNED_INT32|unsigned_int32"
-#define REGEX_CHT_HALF_FLOAT         "HALF_FLOAT|half_float"
-#define REGEX_CHT_FLOAT              "FLOAT|float"
-#define REGEX_CHANNEL_DATA_TYPE  REGEX_CHT_SNORM_INT8 "|" \
-                                 REGEX_CHT_SNORM_INT16 "|" \
-                                 REGEX_CHT_UNORM_INT8 "|" \
-                                 REGEX_CHT_UNORM_INT16 "|" \
-                                 REGEX_CHT_UNORM_SHORT_565 "|" \
-                                 REGEX_CHT_UNORM_SHORT_555 "|" \
-                                 REGEX_CHT_UNORM_INT_101010 "|" \
-                                 REGEX_CHT_SIGNED_INT8 "|" \
-                                 REGEX_CHT_SIGNED_INT16 "|" \
-                                 REGEX_CHT_SIGNED_INT32 "|" \
-                                 REGEX_CHT_UNSIGNED_INT8 "|" \
-                                 REGEX_CHT_UNSIGNED_INT16 "|" \
-                                 REGEX_CHT_UNSIGNED_INT32 "|" \
-                                 REGEX_CHT_HALF_FLOAT "|" \
-                                 REGEX_CHT_FLOAT
-
-/* Sampler */
-#define REGEX_SAMP_ADDR_NONE               "NONE|none"
-#define REGEX_SAMP_ADDR_CLAMP_TO_EDGE      "CLAMP_TO_EDGE|clamp_to_edge"
-#define REGEX_SAMP_ADDR_CLAMP              "CLAMP|clamp"
-#define REGEX_SAMP_ADDR_REPEAT             "REPEAT|repeat"
-#define REGEX_SAMP_ADDR_MIRRORED_REPEAT    "MIRRORED_REPEAT|mirrored_repeat"
-#define REGEX_SAMPLER_ADDRESSING_MODE  REGEX_SAMP_ADDR_NONE "|"\
-                                       REGEX_SAMP_ADDR_CLAMP_TO_EDGE "|" \
-                                       REGEX_SAMP_ADDR_CLAMP "|" \
-                                       REGEX_SAMP_ADDR_REPEAT "|" \
-                                       REGEX_SAMP_ADDR_MIRRORED_REPEAT
-
-#define REGEX_SAMP_FILT_NEAREST  "NEAREST|nearest"
-#define REGEX_SAMP_FILT_LINEAR   "LINEAR|linear"
-#define REGEX_SAMPLER_FILTER_MODE  REGEX_SAMP_FILT_NEAREST "|" \
-                                   REGEX_SAMP_FILT_LINEAR
 
 /*
  * Value argument:
@@ -216,46 +89,6 @@
  *                    addressing_mode<whitespace>(none|clamp_to_edge|repeat|mirrored_repeat)<whitespace>
  *                    filter_mode<whitespace>(nearest|linear)<whitespace>
  */
-#define REGEX_DEFINE_ARG(type, value)  "([[:digit:]]+)[[:space:]]+" type \
-                                       "[[:space:]]+(" value ")"
-#define REGEX_ARG_TOLERANCE            "tolerance[[:space:]]+(" REGEX_VALUE ")"
-#define REGEX_ARG_TOLERANCE_ULP        REGEX_ARG_TOLERANCE "[[:space:]]+ulp"
-#define REGEX_ARG_IMAGE_TYPE                "image_type[[:space:]]+(" REGEX_IMAGE_TYPE ")"
-#define REGEX_ARG_IMAGE_WIDTH               "image_width[[:space:]]+(" REGEX_UINT ")"
-#define REGEX_ARG_IMAGE_HEIGHT              "image_height[[:space:]]+(" REGEX_UINT ")"
-#define REGEX_ARG_IMAGE_CHANNEL_ORDER       "image_channel_order[[:space:]]+(" REGEX_CHANNEL_ORDER ")"
-#define REGEX_ARG_IMAGE_CHANNEL_DATA_TYPE   "image_channel_data_type[[:space:]]+(" REGEX_CHANNEL_DATA_TYPE ")"
-#define REGEX_ARG_SAMPLER_NORMALIZED_COORDS "normalized_coords[[:space:]]+" REGEX_BOOL
-#define REGEX_ARG_SAMPLER_ADDERSSING_MODE   "addressing_mode[[:space:]]+(" REGEX_SAMPLER_ADDRESSING_MODE ")"
-#define REGEX_ARG_SAMPLER_FILTER_MODE       "filter_mode[[:space:]]+(" REGEX_SAMPLER_FILTER_MODE ")"
-#define REGEX_ARG_VALUE   REGEX_DEFINE_ARG( "(" REGEX_TYPE ")", REGEX_ARRAY )
-#define REGEX_ARG_BUFFER  REGEX_DEFINE_ARG( "buffer[[:space:]]+(" REGEX_TYPE ")\\[([[:digit:]]+)\\]", \
-                                            REGEX_ARRAY "|" REGEX_RANDOM "|" REGEX_REPEAT )           \
-                          "([[:space:]]+" "("REGEX_ARG_TOLERANCE "|" REGEX_ARG_TOLERANCE_ULP")" ")?"
-#define REGEX_ARG_IMAGE   REGEX_DEFINE_ARG( "image[[:space:]]+(" REGEX_TYPE ")",             \
-                                            REGEX_ARRAY "|" REGEX_RANDOM "|" REGEX_REPEAT )  \
-                          "[[:space:]]+"REGEX_ARG_IMAGE_TYPE                                 \
-                          "[[:space:]]+"REGEX_ARG_IMAGE_WIDTH                                \
-                          "[[:space:]]+"REGEX_ARG_IMAGE_HEIGHT                               \
-                          "[[:space:]]+"REGEX_ARG_IMAGE_CHANNEL_ORDER                        \
-                          "[[:space:]]+"REGEX_ARG_IMAGE_CHANNEL_DATA_TYPE                    \
-                          "([[:space:]]+" "("REGEX_ARG_TOLERANCE "|" REGEX_ARG_TOLERANCE_ULP")" ")?"
-#define REGEX_ARG_SAMPLER "([[:digit:]]+)[[:space:]]+sampler"                 \
-                          "[[:space:]]+"REGEX_ARG_SAMPLER_NORMALIZED_COORDS \
-                          "[[:space:]]+"REGEX_ARG_SAMPLER_ADDERSSING_MODE   \
-                          "[[:space:]]+"REGEX_ARG_SAMPLER_FILTER_MODE
-#define REGEX_ARG         "(" REGEX_ARG_VALUE "|" REGEX_ARG_BUFFER "|" \
-                              REGEX_ARG_IMAGE "|" REGEX_ARG_SAMPLER ")"
-
-/* Match whole line */
-#define REGEX_FULL_MATCH(content) "^"content"$"
-
-/* Comment config */
-#define REGEX_COMMENT_CONFIG "/\\*!(.*)!\\*/"
-
-/* Other */
-#define REGEX_LINE       "^([^#]*)(#.*)?$"
-#define REGEX_MULTILINE  "^([^#]*)\\\\[[:space:]]*$"
 
 /* Config function */
 void init(const int argc,
@@ -591,302 +424,467 @@ exit_report_result(enum piglit_result result)
 	piglit_report_result(result);
 }
 
-/* Regex functions */
+/* Lexer */
+
+/* Line of the configuration being parsed, for error messages */
+unsigned int config_line = 0;
 
+NORETURN void
+config_error(const char* fmt, ...)
+{
+	va_list args;
+
+	fprintf(stderr, "Invalid configuration at line %u, ", config_line);
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+
+	exit_report_result(PIGLIT_WARN);
+}
+
+/* A word of a value, not NUL-terminated */
+struct word {
+	const char* str;
+	size_t length;
+};
+
+/* Get the next word of *src and advance *src past it */
 bool
-regex_get_matches(const char* src,
-                  const char* pattern,
-                  regmatch_t* pmatch,
-                  size_t size,
-                  int cflags)
+next_word(const char** src, struct word* word)
 {
-	int errcode;
-	regex_t r;
+	const char* pch = *src;
 
-	/* Build regex */
-	errcode = regcomp(&r, pattern, REG_EXTENDED | cflags);
-	if(errcode) {
-		fprintf(stderr, "Invalid regular expression: '%s'\n", pattern);
+	while(isspace((unsigned char)*pch)) {
+		pch++;
+	}
+	if(*pch == '\0') {
+		*src = pch;
 		return false;
 	}
 
-	/* Match regex and if pmatch != NULL && size > 0 return matched */
-	if(pmatch == NULL || size == 0) {
-		errcode = regexec(&r, src, 0, NULL, 0);
-	} else {
-		errcode = regexec(&r, src, size, pmatch, 0);
+	word->str = pch;
+	while(*pch != '\0' && !isspace((unsigned char)*pch)) {
+		pch++;
 	}
+	word->length = pch - word->str;
 
-	regfree(&r);
+	*src = pch;
+	return true;
+}
+
+/* Check if the word is one of the |-separated words */
+bool
+word_is(struct word word, const char* words)
+{
+	for(;;) {
+		size_t length = strcspn(words, "|");
 
-	return errcode == 0;
+		if(length == word.length && !strncmp(words, word.str, length)) {
+			return true;
+		}
+		if(words[length] == '\0') {
+			return false;
+		}
+		words += length + 1;
+	}
 }
 
+/* Check if src consists of the single word, ignoring whitespace */
 bool
-regex_get_match_str(char** dst,
-                    const char* src,
-                    regmatch_t* pmatch,
-                    unsigned int index)
+is_single_word(const char* src, const char* words)
 {
-	size_t size = pmatch[index].rm_eo - pmatch[index].rm_so;
+	struct word word;
 
-	if(size > 0) {
-		*dst = malloc((size+1) * sizeof(char));
-		strncpy(*dst, src+pmatch[index].rm_so, size);
-		(*dst)[size] = '\0';
+	return    next_word(&src, &word)
+	       && word_is(word, words)
+	       && !next_word(&src, &word);
+}
 
-		return true;
-	}
+/* Copy the word to a NUL-terminated string */
+char*
+word_str(struct word word)
+{
+	char* str = malloc(word.length + 1);
 
-	return false;
+	memcpy(str, word.str, word.length);
+	str[word.length] = '\0';
+
+	return str;
 }
 
+struct keyword {
+	const char* words;
+	int value;
+};
+
 bool
-regex_get_str(char** dst,
-              const char* src,
-              const char* pattern,
-              unsigned int index,
-              int cflags)
+get_keyword(struct word word,
+            const struct keyword* keywords,
+            size_t num_keywords,
+            int* value)
 {
-	regmatch_t *pmatch = calloc(index+1, sizeof(*pmatch));
-	bool ret = false;
+	size_t i;
 
-	if(regex_get_matches(src, pattern, pmatch, index+1, cflags)) {
-		ret = regex_get_match_str(dst, src, pmatch, index);
+	for(i = 0; i < num_keywords; i++) {
+		if(word_is(word, keywords[i].words)) {
+			*value = keywords[i].value;
+			return true;
+		}
 	}
 
-	free(pmatch);
-	return ret;
+	return false;
+}
+
+static const struct {
+	const char* name;
+	enum cl_type cl_type;
+	size_t size;
+} types[] = {
+	{ "char",   TYPE_CHAR,   sizeof(cl_char)   },
+	{ "uchar",  TYPE_UCHAR,  sizeof(cl_uchar)  },
+	{ "short",  TYPE_SHORT,  sizeof(cl_short)  },
+	{ "ushort", TYPE_USHORT, sizeof(cl_ushort) },
+	{ "int",    TYPE_INT,    sizeof(cl_int)    },
+	{ "uint",   TYPE_UINT,   sizeof(cl_uint)   },
+	{ "long",   TYPE_LONG,   sizeof(cl_long)   },
+	{ "ulong",  TYPE_ULONG,  sizeof(cl_ulong)  },
+	// half is defined as unsigned short and C can't read/write its value.
+	// Also half is only used as a storage format unless device supports
+	// cl_khr_fp16
+	// TODO: probably we could use libmpdec to handle this
+	//       http://www.bytereef.org/mpdecimal/index.html
+	{ "half",   TYPE_HALF,   sizeof(cl_half)   },
+	{ "float",  TYPE_FLOAT,  sizeof(cl_float)  },
+	{ "double", TYPE_DOUBLE, sizeof(cl_double) },
+};
+
+/* TODO: add OpenCL 1.2+ types */
+static const struct keyword image_types[] = {
+	{ "2D|2d", CL_MEM_OBJECT_IMAGE2D },
+	{ "3D|3d", CL_MEM_OBJECT_IMAGE3D },
+};
+
+/* TODO: add OpenCL 2.0 formats */
+static const struct keyword channel_orders[] = {
+	{ "R|r",                 CL_R },
+	{ "RX|Rx|rx",            CL_Rx },
+	{ "A|a",                 CL_A },
+	{ "INTENSITY|intensity", CL_INTENSITY },
+	{ "LUMINANCE|luminance", CL_LUMINANCE },
+	{ "RG|rg",               CL_RG },
+	{ "RGX|RGx|rgx",         CL_RGx },
+	{ "RA|ra",               CL_RA },
+	{ "RGB|rgb",             CL_RGB },
+	{ "RGBX|rgbx",           CL_RGBx },
+	{ "RGBA|rgba",           CL_RGBA },
+	{ "ARGB|argb",           CL_ARGB },
+	{ "BGRA|bgra",           CL_BGRA },
+};
+
+static const struct keyword channel_data_types[] = {
+	{ "SNORM_INT8|snorm_int8",             CL_SNORM_INT8 },
+	{ "SNORM_INT16|snorm_int16",           CL_SNORM_INT16 },
+	{ "UNORM_INT8|unorm_int8",             CL_UNORM_INT8 },
+	{ "UNORM_INT16|unorm_int16",           CL_UNORM_INT16 },
+	{ "UNORM_SHORT_565|unorm_short_565",   CL_UNORM_SHORT_565 },
+	{ "UNORM_SHORT_555|unorm_short_555",   CL_UNORM_SHORT_555 },
+	{ "UNORM_INT_101010|unorm_int_101010", CL_UNORM_INT_101010 },
+	{ "SIGNED_INT8|signed_int8",           CL_SIGNED_INT8 },
+	{ "SIGNED_INT16|signed_int16",         CL_SIGNED_INT16 },
+	{ "SIGNED_INT32|signed_int32",         CL_SIGNED_INT32 },
+	{ "UNSIGNED_INT8|unsigned_int8",       CL_UNSIGNED_INT8 },
+	{ "UNSIGNED_INT16|unsigned_int16",     CL_UNSIGNED_INT16 },
+	{ "UNSIGNED_INT32|unsigned_int32",     CL_UNSIGNED_INT32 },
+	{ "HALF_FLOAT|half_float",             CL_HALF_FLOAT },
+	{ "FLOAT|float",                       CL_FLOAT },
+};
+
+static const struct keyword addressing_modes[] = {
+	{ "NONE|none",                       CL_ADDRESS_NONE },
+	{ "CLAMP_TO_EDGE|clamp_to_edge",     CL_ADDRESS_CLAMP_TO_EDGE },
+	{ "CLAMP|clamp",                     CL_ADDRESS_CLAMP },
+	{ "REPEAT|repeat",                   CL_ADDRESS_REPEAT },
+	{ "MIRRORED_REPEAT|mirrored_repeat", CL_ADDRESS_MIRRORED_REPEAT },
+};
+
+static const struct keyword filter_modes[] = {
+	{ "NEAREST|nearest", CL_FILTER_NEAREST },
+	{ "LINEAR|linear",   CL_FILTER_LINEAR },
+};
+
+/* Values */
+
+bool
+is_digits(const char* pch, const char* end, bool hex)
+{
+	if(pch == end) {
+		return false;
+	}
+	for(; pch < end; pch++) {
+		if(hex ? !isxdigit((unsigned char)*pch)
+		       : !isdigit((unsigned char)*pch)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool
-regex_match(const char* src, const char* pattern)
+is_integer(struct word word, bool is_signed)
 {
-	return regex_get_matches(src, pattern, NULL, 0, REG_NEWLINE);
+	const char* pch = word.str;
+	const char* end = word.str + word.length;
+
+	if(pch < end && (*pch == '+' || (is_signed && *pch == '-'))) {
+		pch++;
+	}
+	if(end - pch > 2 && pch[0] == '0' && (pch[1] == 'x' || pch[1] == 'X')) {
+		return is_digits(pch + 2, end, true);
+	}
+	return is_digits(pch, end, false);
 }
 
 bool
-regex_section(const char* src, char** section)
+word_to_bool(struct word word, bool* value)
 {
-	regmatch_t pmatch[2];
+	if(word_is(word, WORDS_TRUE)) {
+		*value = true;
+	} else if(word_is(word, WORDS_FALSE)) {
+		*value = false;
+	} else {
+		return false;
+	}
+	return true;
+}
 
-	if(regex_get_matches(src, REGEX_SECTION, pmatch, 2, REG_NEWLINE)) {
-		return regex_get_match_str(section, src, pmatch, 1);
+bool
+word_to_int(struct word word, int64_t* value)
+{
+	if(is_integer(word, false)) {
+		*value = strtoull(word.str, NULL, 0);
+	} else if(is_integer(word, true)) {
+		*value = strtoll(word.str, NULL, 0);
+	} else {
+		return false;
 	}
+	return true;
+}
 
+bool
+word_to_uint(struct word word, uint64_t* value)
+{
+	if(is_integer(word, false)) {
+		*value = strtoull(word.str, NULL, 0);
+		return true;
+	}
 	return false;
 }
 
 bool
-regex_key_value(const char* src, char** key, char** value)
+word_to_float(struct word word, double* value)
 {
-	regmatch_t pmatch[3];
+	const char* pch = word.str;
+	const char* end = word.str + word.length;
+	bool negative = false;
+	struct word rest;
+
+	if(pch < end && (*pch == '+' || *pch == '-')) {
+		negative = *pch == '-';
+		pch++;
+	}
 
-	if(regex_get_matches(src, REGEX_KEY_VALUE, pmatch, 3, REG_NEWLINE)) {
-		*key = NULL;
-		*value = NULL;
-		if(   regex_get_match_str(key, src, pmatch, 1)
-		   && regex_get_match_str(value, src, pmatch, 2)) {
-			return true;
+	if(end - pch > 2 && pch[0] == '0' && (pch[1] == 'x' || pch[1] == 'X')) {
+		/* Hexadecimal float, leave the details to strtod */
+		const char* digits;
+
+		pch += 2;
+		digits = pch;
+		while(pch < end && (isxdigit((unsigned char)*pch) || *pch == '.')) {
+			pch++;
+		}
+		if(pch == digits) {
+			return false;
+		}
+		while(pch < end && (isdigit((unsigned char)*pch) || *pch == 'p' ||
+		                    *pch == 'P' || *pch == '+' || *pch == '-')) {
+			pch++;
+		}
+		if(pch != end) {
+			return false;
+		}
+	} else if(pch < end && isdigit((unsigned char)*pch)) {
+		while(pch < end && isdigit((unsigned char)*pch)) {
+			pch++;
+		}
+		if(pch < end && *pch == '.') {
+			pch++;
+			if(pch == end || !isdigit((unsigned char)*pch)) {
+				return false;
+			}
+			while(pch < end && isdigit((unsigned char)*pch)) {
+				pch++;
+			}
+		}
+		while(pch < end && *pch == 'e') {
+			pch++;
+		}
+		while(pch < end && (*pch == '+' || *pch == '-')) {
+			pch++;
+		}
+		while(pch < end && isdigit((unsigned char)*pch)) {
+			pch++;
+		}
+		if(pch != end) {
+			return false;
+		}
+	} else {
+		rest.str = pch;
+		rest.length = end - pch;
+		if(word_is(rest, WORDS_NAN)) {
+			*value = negative ? -NAN : NAN;
+		} else if(word_is(rest, WORDS_INF)) {
+			*value = negative ? -INFINITY : INFINITY;
 		} else {
-			free(*key);
-			free(*value);
+			return false;
 		}
+		return true;
 	}
 
-	return false;
+	*value = strtod(word.str, NULL);
+	return true;
 }
 
 bool
 get_bool(const char* src)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_BOOL_TRUE))) {
-		return true;
-	} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_BOOL_FALSE))) {
-		return false;
-	} else {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert to bool: %s\n",
-		        src);
-		exit_report_result(PIGLIT_WARN);
-		return false;
+	struct word word = { src, strlen(src) };
+	bool value;
+
+	if(!word_to_bool(word, &value)) {
+		config_error("could not convert to bool: %s", src);
 	}
+	return value;
 }
 
 int64_t
 get_int(const char* src)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_UINT))) {
-		return strtoull(src, NULL, 0);
-	} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_INT))) {
-		return strtoll(src, NULL, 0);
-	} else {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert to long: %s\n",
-		        src);
-		exit_report_result(PIGLIT_WARN);
-		return -1;
+	struct word word = { src, strlen(src) };
+	int64_t value;
+
+	if(!word_to_int(word, &value)) {
+		config_error("could not convert to long: %s", src);
 	}
+	return value;
 }
 
 uint64_t
 get_uint(const char* src)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_UINT))) {
-		return strtoull(src, NULL, 0);
-	} else {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert to ulong: %s\n",
-		        src);
-		exit_report_result(PIGLIT_WARN);
-		return 0;
+	struct word word = { src, strlen(src) };
+	uint64_t value;
+
+	if(!word_to_uint(word, &value)) {
+		config_error("could not convert to ulong: %s", src);
 	}
+	return value;
 }
 
 double
 get_float(const char* src)
 {
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_FLOAT))) {
-		if(regex_match(src, REGEX_FULL_MATCH(REGEX_PNAN))) {
-			return NAN;
-		} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_NNAN))) {
-			return -NAN;
-		} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_PINF))) {
-			return INFINITY;
-		} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_NINF))) {
-			return -INFINITY;
-		} else {
-			return strtod(src, NULL);
-		}
-	} else {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert to double: %s\n",
-		        src);
-		exit_report_result(PIGLIT_WARN);
-		return 0;
+	struct word word = { src, strlen(src) };
+	double value;
+
+	if(!word_to_float(word, &value)) {
+		config_error("could not convert to double: %s", src);
 	}
+	return value;
 }
 
 size_t
 get_array_length(const char* src)
 {
 	size_t size = 0;
+	struct word word;
 
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_ARRAY))) {
-		regmatch_t pmatch[1];
-
-		while(regex_get_matches(src,
-		                        REGEX_ARRAY_VALUE REGEX_ARRAY_DELIMITER,
-		                        pmatch,
-		                        1,
-		                        REG_NEWLINE)) {
-			src += pmatch[0].rm_eo;
-			size++;
-		}
-		if(regex_match(src, REGEX_ARRAY_VALUE)) {
-			size++;
-		}
-	} else {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert to an array: %s\n",
-		        src);
-		exit_report_result(PIGLIT_WARN);
+	while(next_word(&src, &word)) {
+		size++;
 	}
 
 	return size;
 }
 
+enum array_type {
+	ARRAY_BOOL,
+	ARRAY_INT,
+	ARRAY_UINT,
+	ARRAY_FLOAT,
+};
+
 size_t
-get_array(const char* src, void** array, size_t size, char* array_pattern)
+get_array(const char* src, void** array, size_t size, enum array_type array_type)
 {
-	bool regex_matched;
-	size_t i = 0;
+	static const char* const type_names[] = {
+		[ARRAY_BOOL] = "bool",
+		[ARRAY_INT] = "long",
+		[ARRAY_UINT] = "ulong",
+		[ARRAY_FLOAT] = "double",
+	};
+	static const size_t element_sizes[] = {
+		[ARRAY_BOOL] = sizeof(bool),
+		[ARRAY_INT] = sizeof(int64_t),
+		[ARRAY_UINT] = sizeof(uint64_t),
+		[ARRAY_FLOAT] = sizeof(double),
+	};
+	const char* type = type_names[array_type];
+	const char* pch = src;
+	size_t i;
 	size_t actual_size;
-	char* type;
-	char* value;
-	char* value_pattern;
-	regmatch_t pmatch[2];
-
-	actual_size = get_array_length(src);
-
-	if(!strcmp(array_pattern, REGEX_BOOL_ARRAY)) {
-		type = "bool";
-		value_pattern = REGEX_BOOL REGEX_ARRAY_DELIMITER;
-		*(bool**)array = malloc(actual_size * sizeof(bool));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_BOOL_ARRAY));
-	} else if(!strcmp(array_pattern, REGEX_INT_ARRAY)) {
-		type = "long";
-		value_pattern = REGEX_INT REGEX_ARRAY_DELIMITER;
-		*(int64_t**)array = malloc(actual_size * sizeof(int64_t));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_INT_ARRAY));
-	} else if(!strcmp(array_pattern, REGEX_UINT_ARRAY)) {
-		type = "ulong";
-		value_pattern = REGEX_UINT REGEX_ARRAY_DELIMITER;
-		*(uint64_t**)array = malloc(actual_size * sizeof(uint64_t));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_UINT_ARRAY));
-	} else if(!strcmp(array_pattern, REGEX_FLOAT_ARRAY)) {
-		type = "double";
-		value_pattern = REGEX_FLOAT REGEX_ARRAY_DELIMITER;
-		*(double**)array = malloc(actual_size * sizeof(double));
-		regex_matched = regex_match(src, REGEX_FULL_MATCH(REGEX_FLOAT_ARRAY));
-	} else {
-		fprintf(stderr,
-		        "Internal error, invalid array pattern: %s\n",
-		        array_pattern);
-		exit_report_result(PIGLIT_WARN);
-	}
+	bool is_null = is_single_word(src, WORDS_NULL);
+	struct word word;
+
+	actual_size = is_null ? 0 : get_array_length(src);
 
 	if(size > 0 && actual_size != size) {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert %s[%zu] to %s[%zu]: %s\n",
-		        type, actual_size, type, size, src);
-		exit_report_result(PIGLIT_WARN);
+		config_error("could not convert %s[%zu] to %s[%zu]: %s",
+		             type, actual_size, type, size, src);
 	}
 
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_NULL))) {
-		free(*array);
+	if(is_null) {
 		*array = NULL;
 		return 0;
 	}
 
-	if(!regex_matched) {
-		fprintf(stderr,
-		        "Invalid configuration, could not convert to %s array: %s\n",
-		        type, src);
-		exit_report_result(PIGLIT_WARN);
+	if(actual_size == 0) {
+		config_error("could not convert to an array: %s", src);
 	}
 
-	while(regex_get_matches(src, value_pattern, pmatch, 2, 0)) {
-		if(regex_get_match_str(&value, src, pmatch, 1)) {
-			if(!strcmp(array_pattern, REGEX_BOOL_ARRAY)) {
-				(*(bool**)array)[i] = get_bool(value);
-			} else if(!strcmp(array_pattern, REGEX_INT_ARRAY)) {
-				(*(int64_t**)array)[i] = get_int(value);
-			} else if(!strcmp(array_pattern, REGEX_UINT_ARRAY)) {
-				(*(uint64_t**)array)[i] = get_uint(value);
-			} else if(!strcmp(array_pattern, REGEX_FLOAT_ARRAY)) {
-				(*(double**)array)[i] = get_float(value);
-			}
-			free(value);
-		} else {
-			fprintf(stderr,
-			        "Invalid configuration, could not read %s on index %zu: %s\n",
-			        type, i, src);
-			exit_report_result(PIGLIT_WARN);
-		}
+	*array = malloc(actual_size * element_sizes[array_type]);
 
-		src += pmatch[0].rm_eo;
-		i++;
-	}
+	for(i = 0; next_word(&pch, &word); i++) {
+		bool converted = false;
+
+		switch(array_type) {
+		case ARRAY_BOOL:
+			converted = word_to_bool(word, &(*(bool**)array)[i]);
+			break;
+		case ARRAY_INT:
+			converted = word_to_int(word, &(*(int64_t**)array)[i]);
+			break;
+		case ARRAY_UINT:
+			converted = word_to_uint(word, &(*(uint64_t**)array)[i]);
+			break;
+		case ARRAY_FLOAT:
+			converted = word_to_float(word, &(*(double**)array)[i]);
+			break;
+		}
 
-	if(!strcmp(array_pattern, REGEX_BOOL_ARRAY)) {
-		(*(bool**)array)[i] = get_bool(src);
-	} else if(!strcmp(array_pattern, REGEX_INT_ARRAY)) {
-		(*(int64_t**)array)[i] = get_int(src);
-	} else if(!strcmp(array_pattern, REGEX_UINT_ARRAY)) {
-		(*(uint64_t**)array)[i] = get_uint(src);
-	} else if(!strcmp(array_pattern, REGEX_FLOAT_ARRAY)) {
-		(*(double**)array)[i] = get_float(src);
+		if(!converted) {
+			config_error("could not read %s on index %zu: %s",
+			             type, i, src);
+		}
 	}
 
 	return actual_size;
@@ -895,25 +893,25 @@ get_array(const char* src, void** array, size_t size, char* array_pattern)
 size_t
 get_bool_array(const char* src, bool** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_BOOL_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_BOOL);
 }
 
 size_t
 get_int_array(const char* src, int64_t** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_INT_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_INT);
 }
 
 size_t
 get_uint_array(const char* src, uint64_t** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_UINT_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_UINT);
 }
 
 size_t
 get_float_array(const char* src, double** array, size_t size)
 {
-	return get_array(src, (void**)array, size, REGEX_FLOAT_ARRAY);
+	return get_array(src, (void**)array, size, ARRAY_FLOAT);
 }
 
 /* Help */
@@ -951,27 +949,223 @@ print_usage_and_warn(const int argc, const char** argv, const char* fmt, ...)
 
 /* Parse configuration */
 
+/*
+ * Get the section name of a line if it is a section, like " [ test ] ".
+ * The name is written to the start of line and NUL-terminated.
+ */
+bool
+get_section(char* line, char** section)
+{
+	char* start = line;
+	char* end = line + strlen(line);
+	char* pch;
+
+	while(isspace((unsigned char)*start)) {
+		start++;
+	}
+	while(end > start && isspace((unsigned char)end[-1])) {
+		end--;
+	}
+	if(end - start < 3 || *start != '[' || end[-1] != ']') {
+		return false;
+	}
+
+	start++;
+	end--;
+	while(start < end && isspace((unsigned char)*start)) {
+		start++;
+	}
+	while(end > start && isspace((unsigned char)end[-1])) {
+		end--;
+	}
+	if(start == end ||
+	   !(isalnum((unsigned char)*start) || *start == '_') ||
+	   !(isalnum((unsigned char)end[-1]) || end[-1] == '_')) {
+		return false;
+	}
+	for(pch = start; pch < end; pch++) {
+		if(!isalnum((unsigned char)*pch) && *pch != '_' &&
+		   !isspace((unsigned char)*pch)) {
+			return false;
+		}
+	}
+
+	memmove(line, start, end - start);
+	line[end - start] = '\0';
+	*section = line;
+
+	return true;
+}
+
+/*
+ * Split a line like " key : value " to its key and value. If it is one, the
+ * line is modified to NUL-terminate them.
+ */
+bool
+get_key_value(char* line, char** key, char** value)
+{
+	char* pch = line;
+	char* key_end;
+	char* value_end;
+
+	while(isspace((unsigned char)*pch)) {
+		pch++;
+	}
+	*key = pch;
+	while(isalnum((unsigned char)*pch) || *pch == '_') {
+		pch++;
+	}
+	if(pch == *key) {
+		return false;
+	}
+	key_end = pch;
+	while(isspace((unsigned char)*pch)) {
+		pch++;
+	}
+	if(*pch != ':') {
+		return false;
+	}
+	pch++;
+
+	while(isspace((unsigned char)*pch)) {
+		pch++;
+	}
+	*value = pch;
+	value_end = pch + strlen(pch);
+	while(value_end > pch && isspace((unsigned char)value_end[-1])) {
+		value_end--;
+	}
+	if(value_end == pch) {
+		return false;
+	}
+
+	*key_end = '\0';
+	*value_end = '\0';
+
+	return true;
+}
+
+/*
+ * Get the length of the next line of src without its comment, and advance
+ * src to the line after it.
+ */
 size_t
-get_section_content(const char* src, char** content)
+next_line(const char** src, unsigned int* line_number)
 {
-	size_t size = 0;
-	size_t section_name_length = strcspn(src, "\n\0");
-	regmatch_t pmatch[2];
+	const char* line = *src;
+	size_t length = strcspn(line, "#\n");
 
-	if(src[section_name_length] != '\0') {
-		src += section_name_length+1;
-	} else {
-		src += section_name_length;
+	*src += strcspn(line, "\n");
+	if(**src == '\n') {
+		(*src)++;
 	}
+	(*line_number)++;
+
+	return length;
+}
 
-	if(regex_get_matches(src, REGEX_SECTION, pmatch, 2, REG_NEWLINE)) { // found next section
-		size = pmatch[1].rm_so-1;
-	} else { // no next section
-		size = strlen(src);
+/*
+ * Get the length of a line without the \ at its end, or 0 if it doesn't end
+ * with a \.
+ */
+size_t
+continued_length(const char* line, size_t length)
+{
+	while(length > 0 && isspace((unsigned char)line[length-1])) {
+		length--;
+	}
+	if(length > 0 && line[length-1] == '\\') {
+		return length;
 	}
+	return 0;
+}
 
+/*
+ * Get the next line of the configuration without its comment, joined with
+ * the lines it continues to if it is a key-value ending with a \.
+ */
+char*
+get_config_line(const char** src, unsigned int* line_number)
+{
+	const char* start = *src;
+	size_t length = next_line(src, line_number);
+	size_t continued = continued_length(start, length);
+	char* line = malloc(length + 1);
+	char* key;
+	char* value;
+
+	memcpy(line, start, length);
+	line[length] = '\0';
+
+	if(continued == 0 || !get_key_value(line, &key, &value)) {
+		return line;
+	}
+
+	/* Multiline key-value, get_key_value() modified the line so copy it again */
+	length = continued - 1;
+	memcpy(line, start, length);
+	while(**src != '\0') {
+		size_t next_length;
+
+		start = *src;
+		next_length = next_line(src, line_number);
+		if(next_length == 0) {
+			break;
+		}
+
+		continued = continued_length(start, next_length);
+		if(continued > 0) {
+			next_length = continued - 1;
+		}
+
+		line = realloc(line, length + next_length + 1);
+		memcpy(line + length, start, next_length);
+		length += next_length;
+
+		if(continued == 0) {
+			break;
+		}
+	}
+	line[length] = '\0';
+
+	return line;
+}
+
+size_t
+get_section_content(const char* src, char** content, unsigned int* line_number)
+{
+	const char* pch = src;
+	size_t size;
+
+	/* Content ends at the next section */
+	while(*pch != '\0') {
+		size_t line_length = strcspn(pch, "\n");
+
+		if(pch[strspn(pch, " \t\r\f\v")] == '[') {
+			char* line = malloc(line_length + 1);
+			char* section;
+			bool is_section;
+
+			memcpy(line, pch, line_length);
+			line[line_length] = '\0';
+			is_section = get_section(line, &section);
+			free(line);
+
+			if(is_section) {
+				break;
+			}
+		}
+
+		pch += line_length;
+		if(*pch == '\n') {
+			pch++;
+		}
+		(*line_number)++;
+	}
+
+	size = pch - src;
 	*content = malloc((size+1) * sizeof(char));
-	strncpy(*content, src, size);
+	memcpy(*content, src, size);
 	(*content)[size] = '\0';
 
 	return size;
@@ -1034,34 +1228,32 @@ get_test_arg_value(struct test_arg* test_arg, const char* value, size_t length)
 void
 get_test_arg_tolerance(struct test_arg* test_arg, const char* tolerance_str)
 {
-	regmatch_t pmatch[2];
-	char* value_str = NULL;
-
-        if(regex_get_matches(tolerance_str,
-	                     REGEX_ARG_TOLERANCE_ULP,
-	                     pmatch,
-	                     2,
-	                     REG_NEWLINE)) {
-		regex_get_match_str(&value_str, tolerance_str, pmatch, 1);
+	const char* pch = tolerance_str;
+	struct word word;
+	struct word ulp;
+	char* value_str;
+	bool has_ulp;
+
+	if(!next_word(&pch, &word)) {
+		config_error("could not parse tolerance: %s", tolerance_str);
+	}
+	has_ulp = next_word(&pch, &ulp);
+	if(has_ulp && (!word_is(ulp, "ulp") || next_word(&pch, &ulp))) {
+		config_error("could not parse tolerance: %s", tolerance_str);
+	}
+
+	value_str = word_str(word);
+	if(has_ulp) {
 		switch(test_arg->cl_type) {
 		case TYPE_HALF:
 		case TYPE_FLOAT:
 		case TYPE_DOUBLE:
 			test_arg->ulp = get_uint(value_str);
-			return;
+			break;
 		default:
-			fprintf(stderr, "ulp not value for integer types\n");
-			exit_report_result(PIGLIT_WARN);
-                }
-	}
-
-	if(regex_get_matches(tolerance_str,
-	                     REGEX_ARG_TOLERANCE,
-	                     pmatch,
-	                     2,
-	                     REG_NEWLINE)) {
-		regex_get_match_str(&value_str, tolerance_str, pmatch, 1);
-
+			config_error("ulp not value for integer types");
+		}
+	} else {
 		switch(test_arg->cl_type) {
 		case TYPE_CHAR:
 		case TYPE_SHORT:
@@ -1083,221 +1275,226 @@ get_test_arg_tolerance(struct test_arg* test_arg, const char* tolerance_str)
 			break;
 			}
 		}
+	}
+	free(value_str);
+}
+
+/*
+ * Set cl_type, cl_size, cl_mem_size and size (partially for buffers) of a
+ * type like int or float4.
+ */
+bool
+get_test_arg_type(struct test_arg* test_arg, struct word word)
+{
+	struct word name = word;
+	struct word vector = { NULL, 0 };
+	unsigned i;
+
+	for(i = 0; i < word.length; i++) {
+		if(isdigit((unsigned char)word.str[i])) {
+			name.length = i;
+			vector.str = word.str + i;
+			vector.length = word.length - i;
+			break;
+		}
+	}
+
+	if(vector.length == 0) {
+		test_arg->cl_size = 1;
+	} else if(word_is(vector, "2|3|4|8|16")) {
+		test_arg->cl_size = strtoul(vector.str, NULL, 10);
+	} else {
+		return false;
+	}
+	test_arg->cl_mem_size = test_arg->cl_size != 3 ? test_arg->cl_size : 4; // test if we have type3
+
+	for(i = 0; i < ARRAY_SIZE(types); i++) {
+		if(word_is(name, types[i].name)) {
+			test_arg->cl_type = types[i].cl_type;
+			test_arg->size = types[i].size * test_arg->cl_mem_size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Get the words of *src up to the word stop, or up to the end if stop is
+ * NULL, and advance *src past them.
+ */
+char*
+get_words_until(const char** src, const char* stop)
+{
+	const char* pch = *src;
+	const char* start = NULL;
+	const char* end = NULL;
+	struct word word;
+
+	while(next_word(&pch, &word) && (stop == NULL || !word_is(word, stop))) {
+		if(start == NULL) {
+			start = word.str;
+		}
+		end = word.str + word.length;
+		*src = pch;
+	}
+
+	if(start == NULL) {
+		return NULL;
+	}
+	word.str = start;
+	word.length = end - start;
+	return word_str(word);
+}
+
+/* Get the value of a key-value property like image_width 4 */
+struct word
+get_test_arg_property(const char** src, const char* key, const char* arg)
+{
+	struct word word;
+
+	if(!next_word(src, &word) || !word_is(word, key) ||
+	   !next_word(src, &word)) {
+		config_error("test argument is missing %s: %s", key, arg);
+	}
+
+	return word;
+}
+
+/* Get the value of a buffer or image, which is NULL, random, repeat or an array */
+void
+get_test_arg_data(struct test_arg* test_arg,
+                  const char* value,
+                  size_t length,
+                  bool arg_in,
+                  const char* src)
+{
+	const char* pch = value;
+	struct word word;
 
-		free(value_str);
+	next_word(&pch, &word);
+	if(is_single_word(value, WORDS_NULL)) {
+		test_arg->value = NULL;
+		if(!arg_in) {
+			config_error("out argument buffer value can not be NULL: %s",
+			             src);
+		}
+	} else if(is_single_word(value, WORDS_RANDOM)) {
+		test_arg->value = malloc(test_arg->size);
+		if(!arg_in) {
+			config_error("out argument buffer can not be random: %s",
+			             src);
+		}
+	} else if(word_is(word, WORDS_REPEAT)) {
+		get_test_arg_value(test_arg, pch, get_array_length(pch));
 	} else {
-		fprintf(stderr,
-		        "Invalid configuration, could not parse tolerance: %s\n",
-		        tolerance_str);
-		exit_report_result(PIGLIT_WARN);
+		get_test_arg_value(test_arg, value, length);
 	}
 }
 
 void
 get_test_arg(const char* src, struct test* test, bool arg_in)
 {
-	regmatch_t pmatch[5];
-	char* index_str = NULL;
-	char* type = NULL;
+	const char* pch = src;
+	struct word word;
 	char* value = NULL;
 	struct test_arg test_arg = create_test_arg();
-	bool has_type = true;
-
-	/* Get matches */
-	if(regex_get_matches(src, REGEX_FULL_MATCH(REGEX_ARG_VALUE),
-	                     pmatch, 5, REG_NEWLINE)) { // value
-		// do nothing
-	} else if(regex_get_matches(src, REGEX_FULL_MATCH(REGEX_ARG_BUFFER),
-	                            pmatch, 5, REG_NEWLINE)) { // buffer
-		// do nothing
-	} else if(regex_get_matches(src, REGEX_FULL_MATCH(REGEX_ARG_IMAGE),
-	                            pmatch, 5, REG_NEWLINE)) { // image
-		// do nothing
-	} else if(regex_get_matches(src, REGEX_FULL_MATCH(REGEX_ARG_SAMPLER),
-	                            pmatch, 5, REG_NEWLINE)) { // sampler
-		has_type = false;
-	} else {
-		fprintf(stderr,
-		        "Invalid configuration, invalid test argument: %s\n",
-		        src);
-		exit_report_result(PIGLIT_WARN);
-	}
+	int keyword;
 
 	/* Get index */
-	regex_get_match_str(&index_str, src, pmatch, 1);
-	test_arg.index = get_int(index_str);
-	free(index_str);
-
-	if(has_type) {
-		/* Set type, cl_size, cl_mem_size and size (partially for buffers) */
-		regex_get_match_str(&type, src, pmatch, 2);
-		if(regex_match(type, "[[:digit:]]+")) {
-			char* type_size_str;
-			regex_get_str(&type_size_str, type, "[[:digit:]]+", 0, REG_NEWLINE);
-			test_arg.cl_size = get_int(type_size_str);
-			test_arg.cl_mem_size = test_arg.cl_size != 3 ? test_arg.cl_size : 4; // test if we have type3
-			free(type_size_str);
-		} else {
-			test_arg.cl_size = 1;
-			test_arg.cl_mem_size = 1;
-		}
-
-#define IF(regex_type, enum_type, main_type)                       \
-		if(regex_match(type, REGEX_FULL_MATCH(regex_type))) {          \
-			test_arg.cl_type = enum_type;                              \
-			test_arg.size = sizeof(main_type) * test_arg.cl_mem_size;  \
-		}
-#define ELSEIF(regex_type, enum_type, main_type) \
-		else IF(regex_type, enum_type, main_type)
-
-		IF    (REGEX_TYPE_CHAR,   TYPE_CHAR,   cl_char)
-		ELSEIF(REGEX_TYPE_UCHAR,  TYPE_UCHAR,  cl_uchar)
-		ELSEIF(REGEX_TYPE_SHORT,  TYPE_SHORT,  cl_short)
-		ELSEIF(REGEX_TYPE_USHORT, TYPE_USHORT, cl_ushort)
-		ELSEIF(REGEX_TYPE_INT,    TYPE_INT,    cl_int)
-		ELSEIF(REGEX_TYPE_UINT,   TYPE_UINT,   cl_uint)
-		ELSEIF(REGEX_TYPE_LONG,   TYPE_LONG,   cl_long)
-		ELSEIF(REGEX_TYPE_ULONG,  TYPE_ULONG,  cl_ulong)
-		ELSEIF(REGEX_TYPE_HALF,   TYPE_HALF,   cl_half)
-		ELSEIF(REGEX_TYPE_FLOAT,  TYPE_FLOAT,  cl_float)
-		ELSEIF(REGEX_TYPE_DOUBLE,  TYPE_DOUBLE,  cl_double)
-
-#undef IF
-#undef ELSEIF
+	if(!next_word(&pch, &word) ||
+	   !is_digits(word.str, word.str + word.length, false)) {
+		config_error("invalid test argument: %s", src);
+	}
+	test_arg.index = strtoul(word.str, NULL, 0);
 
-		free(type);
+	if(!next_word(&pch, &word)) {
+		config_error("invalid test argument: %s", src);
 	}
 
 	/* Get arg type, size and value */
-	if(regex_match(src, REGEX_FULL_MATCH(REGEX_ARG_VALUE))) { // value
-		/* Values are only allowed for in arguments */
-		if(!arg_in) {
-			fprintf(stderr,
-			        "Invalid configuration, only arg_in values are allowed: %s\n",
-			        src);
-			exit_report_result(PIGLIT_WARN);
-		}
-
-		/* Set arg type */
-		test_arg.type = TEST_ARG_VALUE;
-
-		/* Set length */
-		test_arg.length = 1;
-
-		/* Get value */
-		regex_get_match_str(&value, src, pmatch, 3);
-		if(regex_match(value, REGEX_FULL_MATCH(REGEX_NULL))) {
-			test_arg.value = NULL;
-		} else {
-			get_test_arg_value(&test_arg, value, test_arg.cl_size);
-		}
-		free(value);
-	} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_ARG_BUFFER))) { // buffer
-		char* array_length_str = NULL;
-		const char* tolerance_str = NULL;
+	if(word_is(word, "buffer")) { // buffer
+		const char* bracket;
 
 		/* Set arg type */
 		test_arg.type = TEST_ARG_BUFFER;
 
-		/* Set length */
-		regex_get_match_str(&array_length_str, src, pmatch, 3);
-		test_arg.length = get_int(array_length_str);
-		free(array_length_str);
+		/* Set type and length */
+		if(!next_word(&pch, &word) ||
+		   (bracket = memchr(word.str, '[', word.length)) == NULL ||
+		   word.str[word.length-1] != ']' ||
+		   !is_digits(bracket + 1, word.str + word.length - 1, false)) {
+			config_error("invalid test argument: %s", src);
+		}
+		test_arg.length = strtoul(bracket + 1, NULL, 0);
+		word.length = bracket - word.str;
+		if(!get_test_arg_type(&test_arg, word)) {
+			config_error("invalid test argument: %s", src);
+		}
 
 		/* Set size */
 		test_arg.size = test_arg.size * test_arg.length;
 
+		value = get_words_until(&pch, "tolerance");
+		if(value == NULL) {
+			config_error("invalid test argument: %s", src);
+		}
+
 		/* Set tolerance */
-		tolerance_str = src+pmatch[4].rm_eo;
-		if(regex_match(tolerance_str, REGEX_ARG_TOLERANCE)) {
+		if(next_word(&pch, &word)) {
 			if(arg_in) {
-				fprintf(stderr,
-				        "Invalid configuration, in argument buffer can't have tolerance: %s\n",
-				        src);
-				exit_report_result(PIGLIT_WARN);
+				config_error("in argument buffer can't have tolerance: %s",
+				             src);
 			}
-			get_test_arg_tolerance(&test_arg, tolerance_str);
+			get_test_arg_tolerance(&test_arg, pch);
 		}
 
 		/* Get value */
-		regex_get_match_str(&value, src, pmatch, 4);
-		if(regex_match(value, REGEX_FULL_MATCH(REGEX_NULL))) {
-			test_arg.value = NULL;
-			if(!arg_in) {
-				fprintf(stderr,
-				        "Invalid configuration, out argument buffer value can not be NULL: %s\n",
-				        src);
-				exit_report_result(PIGLIT_WARN);
-			}
-		} else {
-			if(regex_match(value, REGEX_FULL_MATCH(REGEX_RANDOM))) {
-				test_arg.value = malloc(test_arg.size);
-				if(!arg_in) {
-					fprintf(stderr,
-					        "Invalid configuration, out argument buffer can not be random: %s\n",
-					        src);
-					exit_report_result(PIGLIT_WARN);
-				}
-			} else if(regex_match(value, REGEX_FULL_MATCH(REGEX_REPEAT))) {
-				regmatch_t rmatch[3];
-				char* repeat_value_str;
-
-				regex_get_matches(value, REGEX_REPEAT, rmatch, 3, 0);
-				regex_get_match_str(&repeat_value_str, value, rmatch, 2);
-
-				get_test_arg_value(&test_arg,
-				                   repeat_value_str,
-				                   get_array_length(repeat_value_str));
-
-				free(repeat_value_str);
-			} else if(regex_match(value, REGEX_ARRAY)) {
-				get_test_arg_value(&test_arg,
-				                   value,
-				                   test_arg.length * test_arg.cl_size);
-			}
-		}
+		get_test_arg_data(&test_arg, value,
+		                  test_arg.length * test_arg.cl_size, arg_in, src);
 		free(value);
-	} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_ARG_IMAGE))) { // image
-		char* str = NULL;
-		const char* properties_str = src + pmatch[3].rm_eo;
-		const char* tolerance_str = NULL;
+	} else if(word_is(word, "image")) { // image
 		size_t image_elems = 0;
-		cl_channel_order cho;
-		cl_channel_type cht;
-		regmatch_t pmatch_prop[2];
+		uint64_t image_size;
 
 		/* Set arg type */
 		test_arg.type = TEST_ARG_IMAGE;
 
+		if(!next_word(&pch, &word) || !get_test_arg_type(&test_arg, word)) {
+			config_error("invalid test argument: %s", src);
+		}
+
+		value = get_words_until(&pch, "image_type");
+		if(value == NULL) {
+			config_error("invalid test argument: %s", src);
+		}
+
 		/* Image type */
-		regex_get_matches(properties_str, REGEX_ARG_IMAGE_TYPE,
-		                  pmatch_prop, 2, REG_NEWLINE);
-		regex_get_match_str(&str, properties_str, pmatch_prop, 1);
-		properties_str += pmatch_prop[1].rm_eo;
-		if(regex_match(str, REGEX_FULL_MATCH("("REGEX_IMGT_2D")"))) {
-			test_arg.image_desc.image_type = CL_MEM_OBJECT_IMAGE2D;
-		} else {
+		word = get_test_arg_property(&pch, "image_type", src);
+		if(!get_keyword(word, image_types, ARRAY_SIZE(image_types),
+		                &keyword) ||
+		   keyword != CL_MEM_OBJECT_IMAGE2D) {
 			/* TODO: Implement other image types */
-			fprintf(stderr, "Image type not supported: %s\n", str);
-			exit_report_result(PIGLIT_WARN);
+			config_error("image type not supported: %.*s",
+			             (int)word.length, word.str);
 		}
-		free(str);
+		test_arg.image_desc.image_type = keyword;
 
 		/* Image width */
-		regex_get_matches(properties_str, REGEX_ARG_IMAGE_WIDTH,
-		                  pmatch_prop, 2, REG_NEWLINE);
-		regex_get_match_str(&str, properties_str, pmatch_prop, 1);
-		properties_str += pmatch_prop[1].rm_eo;
-		test_arg.image_desc.image_width = get_int(str);
-		free(str);
+		word = get_test_arg_property(&pch, "image_width", src);
+		if(!word_to_uint(word, &image_size)) {
+			config_error("could not convert to ulong: %.*s",
+			             (int)word.length, word.str);
+		}
+		test_arg.image_desc.image_width = image_size;
 
 		/* Image height */
-		regex_get_matches(properties_str, REGEX_ARG_IMAGE_HEIGHT,
-		                  pmatch_prop, 2, REG_NEWLINE);
-		regex_get_match_str(&str, properties_str, pmatch_prop, 1);
-		properties_str += pmatch_prop[1].rm_eo;
-		test_arg.image_desc.image_height = get_int(str);
-		free(str);
+		word = get_test_arg_property(&pch, "image_height", src);
+		if(!word_to_uint(word, &image_size)) {
+			config_error("could not convert to ulong: %.*s",
+			             (int)word.length, word.str);
+		}
+		test_arg.image_desc.image_height = image_size;
 
 		/* Image descriptor defaults */
 		test_arg.image_desc.image_depth = 1;
@@ -1309,84 +1506,22 @@ get_test_arg(const char* src, struct test* test, bool arg_in)
 		test_arg.image_desc.buffer = NULL;
 
 		/* Image channel order */
-		regex_get_matches(properties_str, REGEX_ARG_IMAGE_CHANNEL_ORDER,
-		                  pmatch_prop, 2, REG_NEWLINE);
-		regex_get_match_str(&str, properties_str, pmatch_prop, 1);
-		properties_str += pmatch_prop[1].rm_eo;
-		if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_R")"))) {
-			cho = CL_R;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_RX")"))) {
-			cho = CL_Rx;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_A")"))) {
-			cho = CL_A;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_INTENSITY")"))) {
-			cho = CL_INTENSITY;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_LUMINANCE")"))) {
-			cho = CL_LUMINANCE;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_RG")"))) {
-			cho = CL_RG;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_RGX")"))) {
-			cho = CL_RGx;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_RA")"))) {
-			cho = CL_RA;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_RGB")"))) {
-			cho = CL_RGB;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_RGBX")"))) {
-			cho = CL_RGBx;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_RGBA")"))) {
-			cho = CL_RGBA;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_ARGB")"))) {
-			cho = CL_ARGB;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHO_BGRA")"))) {
-			cho = CL_BGRA;
-		} else {
-			fprintf(stderr, "Image channel order not supported: %s\n", str);
-			exit_report_result(PIGLIT_WARN);
+		word = get_test_arg_property(&pch, "image_channel_order", src);
+		if(!get_keyword(word, channel_orders, ARRAY_SIZE(channel_orders),
+		                &keyword)) {
+			config_error("image channel order not supported: %.*s",
+			             (int)word.length, word.str);
 		}
-		free(str);
-		test_arg.image_format.image_channel_order = cho;
+		test_arg.image_format.image_channel_order = keyword;
 
 		/* Image channel data type */
-		regex_get_matches(properties_str, REGEX_ARG_IMAGE_CHANNEL_DATA_TYPE,
-		                  pmatch_prop, 2, REG_NEWLINE);
-		regex_get_match_str(&str, properties_str, pmatch_prop, 1);
-		properties_str += pmatch_prop[1].rm_eo;
-		if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_SNORM_INT8")"))) {
-			cht = CL_SNORM_INT8;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_SNORM_INT16")"))) {
-			cht = CL_SNORM_INT16;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNORM_INT8")"))) {
-			cht = CL_UNORM_INT8;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNORM_INT16")"))) {
-			cht = CL_UNORM_INT16;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNORM_SHORT_565")"))) {
-			cht = CL_UNORM_SHORT_565;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNORM_SHORT_555")"))) {
-			cht = CL_UNORM_SHORT_555;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNORM_INT_101010")"))) {
-			cht = CL_UNORM_INT_101010;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_SIGNED_INT8")"))) {
-			cht = CL_SIGNED_INT8;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_SIGNED_INT16")"))) {
-			cht = CL_SIGNED_INT16;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_SIGNED_INT32")"))) {
-			cht = CL_SIGNED_INT32;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNSIGNED_INT8")"))) {
-			cht = CL_UNSIGNED_INT8;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNSIGNED_INT16")"))) {
-			cht = CL_UNSIGNED_INT16;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_UNSIGNED_INT32")"))) {
-			cht = CL_UNSIGNED_INT32;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_HALF_FLOAT")"))) {
-			cht = CL_HALF_FLOAT;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_CHT_FLOAT")"))) {
-			cht = CL_FLOAT;
-		} else {
-			fprintf(stderr, "Image channel data type not supported: %s\n", str);
-			exit_report_result(PIGLIT_WARN);
+		word = get_test_arg_property(&pch, "image_channel_data_type", src);
+		if(!get_keyword(word, channel_data_types,
+		                ARRAY_SIZE(channel_data_types), &keyword)) {
+			config_error("image channel data type not supported: %.*s",
+			             (int)word.length, word.str);
 		}
-		free(str);
-		test_arg.image_format.image_channel_data_type = cht;
+		test_arg.image_format.image_channel_data_type = keyword;
 
 		/* Set size */
 		image_elems = test_arg.image_desc.image_width *
@@ -1397,64 +1532,27 @@ get_test_arg(const char* src, struct test* test, bool arg_in)
 		test_arg.size *= image_elems;
 
 		/* Set tolerance */
-		tolerance_str = properties_str;
-		if(regex_match(tolerance_str, REGEX_ARG_TOLERANCE)) {
+		if(next_word(&pch, &word)) {
+			if(!word_is(word, "tolerance")) {
+				config_error("invalid test argument: %s", src);
+			}
 			if(arg_in) {
-				fprintf(stderr,
-				        "Invalid configuration, in argument buffer can't have tolerance: %s\n",
-				        src);
-				exit_report_result(PIGLIT_WARN);
+				config_error("in argument buffer can't have tolerance: %s",
+				             src);
 			}
-			get_test_arg_tolerance(&test_arg, tolerance_str);
+			get_test_arg_tolerance(&test_arg, pch);
 		}
 
 		/* Get value */
-		regex_get_match_str(&value, src, pmatch, 3);
-		if(regex_match(value, REGEX_FULL_MATCH(REGEX_NULL))) {
-			test_arg.value = NULL;
-			if(!arg_in) {
-				fprintf(stderr,
-				        "Invalid configuration, out argument buffer value can not be NULL: %s\n",
-				        src);
-				exit_report_result(PIGLIT_WARN);
-			}
-		} else {
-			if(regex_match(value, REGEX_FULL_MATCH(REGEX_RANDOM))) {
-				test_arg.value = malloc(test_arg.size);
-				if(!arg_in) {
-					fprintf(stderr,
-					        "Invalid configuration, out argument buffer can not be random: %s\n",
-					        src);
-					exit_report_result(PIGLIT_WARN);
-				}
-			} else if(regex_match(value, REGEX_FULL_MATCH(REGEX_REPEAT))) {
-				regmatch_t rmatch[3];
-				char* repeat_value_str;
-
-				regex_get_matches(value, REGEX_REPEAT, rmatch, 3, 0);
-				regex_get_match_str(&repeat_value_str, value, rmatch, 2);
-
-				get_test_arg_value(&test_arg,
-				                   repeat_value_str,
-				                   get_array_length(repeat_value_str));
-
-				free(repeat_value_str);
-			} else if(regex_match(value, REGEX_ARRAY)) {
-				get_test_arg_value(&test_arg, value,
-				                   image_elems * test_arg.cl_size);
-			}
-		}
+		get_test_arg_data(&test_arg, value,
+		                  image_elems * test_arg.cl_size, arg_in, src);
 		free(value);
-
-	} else if(regex_match(src, REGEX_FULL_MATCH(REGEX_ARG_SAMPLER))) { // sampler
-		char* str = NULL;
+	} else if(word_is(word, "sampler")) { // sampler
+		bool normalized_coords;
 
 		/* Samplers are only allowed for in arguments */
 		if(!arg_in) {
-			fprintf(stderr,
-			        "Invalid configuration, only arg_in samplers are allowed: %s\n",
-			        src);
-			exit_report_result(PIGLIT_WARN);
+			config_error("only arg_in samplers are allowed: %s", src);
 		}
 
 		test_arg.size = sizeof(cl_sampler);
@@ -1463,54 +1561,71 @@ get_test_arg(const char* src, struct test* test, bool arg_in)
 		test_arg.type = TEST_ARG_SAMPLER;
 
 		/* Normalized coords */
-		regex_get_match_str(&str, src, pmatch, 2);
-		test_arg.sampler_normalized_coords = get_bool(str);
-		free(str);
+		word = get_test_arg_property(&pch, "normalized_coords", src);
+		if(!word_to_bool(word, &normalized_coords)) {
+			config_error("could not convert to bool: %.*s",
+			             (int)word.length, word.str);
+		}
+		test_arg.sampler_normalized_coords = normalized_coords;
 
 		/* Addressing mode */
-		regex_get_match_str(&str, src, pmatch, 3);
-		if(regex_match(str, REGEX_FULL_MATCH("("REGEX_SAMP_ADDR_NONE")"))) {
-			test_arg.sampler_addressing_mode = CL_ADDRESS_NONE;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_SAMP_ADDR_CLAMP_TO_EDGE")"))) {
-			test_arg.sampler_addressing_mode = CL_ADDRESS_CLAMP_TO_EDGE;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_SAMP_ADDR_CLAMP")"))) {
-			test_arg.sampler_addressing_mode = CL_ADDRESS_CLAMP;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_SAMP_ADDR_REPEAT))) {
-			test_arg.sampler_addressing_mode = CL_ADDRESS_REPEAT;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_SAMP_ADDR_MIRRORED_REPEAT))) {
-			test_arg.sampler_addressing_mode = CL_ADDRESS_MIRRORED_REPEAT;
-		} else {
-			fprintf(stderr, "Sampler addressing mode not supported: %s\n", str);
-			exit_report_result(PIGLIT_WARN);
+		word = get_test_arg_property(&pch, "addressing_mode", src);
+		if(!get_keyword(word, addressing_modes,
+		                ARRAY_SIZE(addressing_modes), &keyword)) {
+			config_error("sampler addressing mode not supported: %.*s",
+			             (int)word.length, word.str);
 		}
-		free(str);
+		test_arg.sampler_addressing_mode = keyword;
 
 		/* Filter mode */
-		regex_get_match_str(&str, src, pmatch, 4);
-		if(regex_match(str, REGEX_FULL_MATCH("("REGEX_SAMP_FILT_NEAREST")"))) {
-			test_arg.sampler_filter_mode = CL_FILTER_NEAREST;
-		} else if(regex_match(str, REGEX_FULL_MATCH("("REGEX_SAMP_FILT_LINEAR")"))) {
-			test_arg.sampler_filter_mode = CL_FILTER_LINEAR;
+		word = get_test_arg_property(&pch, "filter_mode", src);
+		if(!get_keyword(word, filter_modes, ARRAY_SIZE(filter_modes),
+		                &keyword)) {
+			config_error("sampler filter mode not supported: %.*s",
+			             (int)word.length, word.str);
+		}
+		test_arg.sampler_filter_mode = keyword;
+
+		if(next_word(&pch, &word)) {
+			config_error("invalid test argument: %s", src);
+		}
+	} else { // value
+		/* Values are only allowed for in arguments */
+		if(!arg_in) {
+			config_error("only arg_in values are allowed: %s", src);
+		}
+
+		/* Set arg type */
+		test_arg.type = TEST_ARG_VALUE;
+
+		/* Set type */
+		if(!get_test_arg_type(&test_arg, word)) {
+			config_error("invalid test argument: %s", src);
+		}
+
+		/* Set length */
+		test_arg.length = 1;
+
+		/* Get value */
+		value = get_words_until(&pch, NULL);
+		if(value == NULL) {
+			config_error("invalid test argument: %s", src);
+		}
+		if(is_single_word(value, WORDS_NULL)) {
+			test_arg.value = NULL;
 		} else {
-			fprintf(stderr, "Sampler filter mode not supported: %s\n", str);
-			exit_report_result(PIGLIT_WARN);
+			get_test_arg_value(&test_arg, value, test_arg.cl_size);
 		}
-		free(str);
+		free(value);
 	}
 
 	if(arg_in) {
 		if(!add_test_arg_in(test, test_arg)) {
-			fprintf(stderr,
-			        "Invalid configuration, could not add in argument: %s\n",
-			        src);
-			exit_report_result(PIGLIT_WARN);
+			config_error("could not add in argument: %s", src);
 		}
 	} else {
 		if(!add_test_arg_out(test, test_arg)) {
-			fprintf(stderr,
-			        "Invalid configuration, could not add out argument: %s\n",
-			        src);
-			exit_report_result(PIGLIT_WARN);
+			config_error("could not add out argument: %s", src);
 		}
 	}
 }
@@ -1521,28 +1636,15 @@ get_test_arg(const char* src, struct test* test, bool arg_in)
 static char*
 parse_name(const char *input)
 {
-	char *name = add_dynamic_str_copy(input);
-	int error;
-	regex_t regex;
-	regmatch_t pmatch[1];
-
-
-	if ((error = regcomp(&regex, "\\([/%]\\)",0))) {
-		char errbuf[100];
-		regerror(error, &regex, errbuf, 100);
-		fprintf(stderr, "Failed to compile regex for parse_name():%s\n", errbuf);
-		return NULL;
-	}
+	const char *bad_char = strpbrk(input, "/%");
 
-	if (!regexec(&regex, input, 1, pmatch, 0)) {
-		char bad_char = *(input + pmatch[0].rm_so);
+	if (bad_char) {
 		fprintf(stderr,	"Illegal character in test name '%s': %c\n",
-							input, bad_char);
+							input, *bad_char);
 		return NULL;
 	}
 
-	regfree(&regex);
-	return name;
+	return add_dynamic_str_copy(input);
 }
 
 void
@@ -1550,7 +1652,7 @@ parse_config(const char* config_str,
              struct piglit_cl_program_test_config* config)
 {
 	const char* pch;
-	size_t length = strlen(config_str);
+	unsigned int line_number = 0;
 
 	char* line = NULL;
 	char* section = NULL;
@@ -1570,165 +1672,93 @@ parse_config(const char* config_str,
 
 	/* parse config string by each line */
 	pch = config_str;
-	while(pch < (config_str+length)) {
-		regmatch_t pmatch[2];
-		size_t line_length;
-
-		/* Get line */
-		regex_get_matches(pch, REGEX_LINE, pmatch, 2, REG_NEWLINE);
-		line_length = pmatch[0].rm_eo - pmatch[0].rm_so;
-		if(!regex_get_match_str(&line, pch, pmatch, 1)) {
-			/* Line is empty */
-			pch += line_length + 1;
-			continue;
-		}
-
-		/* Get more lines if it is a multiline */
-		if(   regex_match(line, REGEX_KEY_VALUE)
-		   && regex_match(line, REGEX_MULTILINE)) {
-			char* multiline = malloc(sizeof(char));
-			multiline[0] = '\0';
-
-			free(line); line = NULL;
-
-			while((pch <= (config_str+length))) {
-				regmatch_t mmatch[2];
-				char* old_multiline = multiline;
-				char* new_multiline;
-
-				/* Get line */
-				regex_get_matches(pch, REGEX_LINE, pmatch, 2, REG_NEWLINE);
-				line_length = pmatch[0].rm_eo - pmatch[0].rm_so;
-				if(!regex_get_match_str(&line, pch, pmatch, 1)) {
-					/* Line is empty */
-					break;
-				}
-
-				if(regex_match(line, REGEX_MULTILINE)) { // not last line
-					regex_get_matches(line, REGEX_MULTILINE,
-					                  mmatch, 2, REG_NEWLINE);
-					if(!regex_get_match_str(&new_multiline, pch, mmatch, 1)) {
-						/* Multiline is empty */
-						pch += line_length + 1;
-						continue;
-					}
-
-					multiline = malloc(strlen(old_multiline) + strlen(new_multiline) + 1);
-					strncpy(multiline, old_multiline, strlen(old_multiline));
-					strcpy(multiline+strlen(old_multiline), new_multiline);
-
-					pch += line_length+1;
-
-					free(line); free(old_multiline); free(new_multiline);
-				} else { // last line
-					multiline = malloc(strlen(old_multiline) + strlen(line) + 1);
-					strncpy(multiline, old_multiline, strlen(old_multiline));
-					strcpy(multiline+strlen(old_multiline), line);
-
-					free(line); free(old_multiline);
-					break;
-				}
-			}
-
-			line = multiline;
-		}
+	while(*pch != '\0') {
+		/* Get line, with multilines joined */
+		config_line = line_number + 1;
+		line = get_config_line(&pch, &line_number);
 
 		/* parse line */
-		if(regex_section(line, &section)) { // SECTION
-			if(regex_match(section, "^config$")) { // config
+		if(get_section(line, &section)) { // SECTION
+			if(!strcmp(section, "config")) { // config
 				if(config_found) {
-					fprintf(stderr, "Invalid configuration, [config] section can be defined only once\n");
-					free(section); section = NULL;
-					exit_report_result(PIGLIT_WARN);
+					config_error("[config] section can be defined only once");
 				}
 				if(test_found) {
-					fprintf(stderr, "Invalid configuration, [config] section must be declared before any [test] section\n");
-					free(section); section = NULL;
-					exit_report_result(PIGLIT_WARN);
+					config_error("[config] section must be declared before any [test] section");
 				}
 				config_found = true;
 				state = SECTION_CONFIG;
-			} else if(regex_match(section, "^test$")) { // test
+			} else if(!strcmp(section, "test")) { // test
 				if(!config_found) {
-					fprintf(stderr, "Invalid configuration, [config] section must be declared before any [test] section\n");
-					free(section); section = NULL;
-					exit_report_result(PIGLIT_WARN);
+					config_error("[config] section must be declared before any [test] section");
 				}
 				if(config->expect_build_fail) {
-					fprintf(stderr, "Invalid configuration, no tests can be defined when expect_build_fail is true\n");
-					free(section); section = NULL;
-					exit_report_result(PIGLIT_WARN);
+					config_error("no tests can be defined when expect_build_fail is true");
 				}
 				test_found = true;
 				add_test(create_test());
 				test = &tests[num_tests-1];
 				state = SECTION_TEST;
-			} else if(regex_match(section, "^program source$")) { // program source
-				pch += get_section_content(pch, &config->program_source);
+			} else if(!strcmp(section, "program source")) { // program source
+				pch += get_section_content(pch, &config->program_source,
+				                           &line_number);
 				add_dynamic_str(config->program_source);
 				state = SECTION_NONE;
-			} else if(regex_match(section, "^program binary$")) { // program binary
-				pch += get_section_content(pch, (char**)&config->program_binary);
+			} else if(!strcmp(section, "program binary")) { // program binary
+				pch += get_section_content(pch,
+				                           (char**)&config->program_binary,
+				                           &line_number);
 				add_dynamic_str((char*)config->program_binary);
 				state = SECTION_NONE;
 			} else {
-				fprintf(stderr,
-				        "Invalid configuration, configuration has an invalid section: [%s]\n",
-				        section);
-				free(section); section = NULL;
-				exit_report_result(PIGLIT_WARN);
+				config_error("configuration has an invalid section: [%s]",
+				             section);
 			}
-
-			free(section); section = NULL;
-		} else if(regex_key_value(line, &key, &value)) { // KEY : VALUE
+		} else if(get_key_value(line, &key, &value)) { // KEY : VALUE
 			switch(state) {
 			case SECTION_NONE:
-				fprintf(stderr,
-				        "Invalid configuration, this key-value does not belong to any section: %s\n",
-				        line);
-				free(key); key = NULL;
-				free(value); value = NULL;
-				exit_report_result(PIGLIT_WARN);
+				config_error("key '%s' does not belong to any section",
+				             key);
 				break;
 			case SECTION_CONFIG:
-				if(regex_match(key, "^name$")) {
+				if(!strcmp(key, "name")) {
 					config->name = parse_name(value);
 					if (!config->name) {
 						exit_report_result(PIGLIT_FAIL);
 					}
-				} else if(regex_match(key, "^clc_version_min$")) {
+				} else if(!strcmp(key, "clc_version_min")) {
 					config->clc_version_min = get_int(value);
-				} else if(regex_match(key, "clc_version_max$")) {
+				} else if(!strcmp(key, "clc_version_max")) {
 					config->clc_version_max = get_int(value);
-				} else if(regex_match(key, "^platform_regex$")) {
+				} else if(!strcmp(key, "platform_regex")) {
 					config->platform_regex = add_dynamic_str_copy(value);
-				} else if(regex_match(key, "^device_regex$")) {
+				} else if(!strcmp(key, "device_regex")) {
 					config->platform_regex = add_dynamic_str_copy(value);
-				} else if(regex_match(key, "^require_platform_extensions$")) {
+				} else if(!strcmp(key, "require_platform_extensions")) {
 					config->require_platform_extensions =
 						add_dynamic_str_copy(value);
-				} else if(regex_match(key, "^require_device_extensions$")) {
+				} else if(!strcmp(key, "require_device_extensions")) {
 					config->require_device_extensions =
 						add_dynamic_str_copy(value);
-				} else if(regex_match(key, "^program_source_file$")) {
+				} else if(!strcmp(key, "program_source_file")) {
 					config->program_source_file = add_dynamic_str_copy(value);
-				} else if(regex_match(key, "^program_binary_file$")) {
+				} else if(!strcmp(key, "program_binary_file")) {
 					config->program_binary_file = add_dynamic_str_copy(value);
-				} else if(regex_match(key, "^build_options$")) {
+				} else if(!strcmp(key, "build_options")) {
 					config->build_options = add_dynamic_str_copy(value);
-				} else if(regex_match(key, "^kernel_name$")) {
-					if(!regex_match(value, REGEX_NULL)) {
+				} else if(!strcmp(key, "kernel_name")) {
+					if(!is_single_word(value, WORDS_NULL)) {
 						config->kernel_name = add_dynamic_str_copy(value);
 					} else {
 						config->kernel_name = NULL;
 					}
-				} else if(regex_match(key, "^expect_build_fail$")) {
+				} else if(!strcmp(key, "expect_build_fail")) {
 					config->expect_build_fail = get_bool(value);
-				} else if(regex_match(key, "^expect_test_fail$")) {
+				} else if(!strcmp(key, "expect_test_fail")) {
 					expect_test_fail = get_bool(value);
-				} else if(regex_match(key, "^dimensions$")) {
+				} else if(!strcmp(key, "dimensions")) {
 					work_dimensions = get_uint(value);
-				} else if(regex_match(key, "^global_size$")) {
+				} else if(!strcmp(key, "global_size")) {
 					int i;
 					uint64_t* int_global_work_size;
 					get_uint_array(value, &int_global_work_size, 3);
@@ -1736,8 +1766,8 @@ parse_config(const char* config_str,
 						global_work_size[i] = int_global_work_size[i];
 					}
 					free(int_global_work_size);
-				} else if(regex_match(key, "^local_size$")) {
-					if(!regex_match(value, REGEX_FULL_MATCH(REGEX_NULL))) {
+				} else if(!strcmp(key, "local_size")) {
+					if(!is_single_word(value, WORDS_NULL)) {
 						int i;
 						uint64_t* int_local_work_size;
 						get_uint_array(value, &int_local_work_size, 3);
@@ -1749,8 +1779,8 @@ parse_config(const char* config_str,
 					} else {
 						local_work_size_null = true;
 					}
-				} else if(regex_match(key, "^global_offset$")) {
-					if(!regex_match(value, REGEX_FULL_MATCH(REGEX_NULL))) {
+				} else if(!strcmp(key, "global_offset")) {
+					if(!is_single_word(value, WORDS_NULL)) {
 						int i;
 						uint64_t* int_global_offset;
 						get_uint_array(value, &int_global_offset, 3);
@@ -1763,27 +1793,23 @@ parse_config(const char* config_str,
 						global_offset_null = true;
 					}
 				} else {
-					fprintf(stderr,
-					        "Invalid configuration, key '%s' does not belong to a [config] section: %s\n",
-					        key, line);
-					free(key); key = NULL;
-					free(value); value = NULL;
-					exit_report_result(PIGLIT_WARN);
+					config_error("key '%s' does not belong to a [config] section",
+					             key);
 				}
 				break;
 			case SECTION_TEST:
-				if(regex_match(key, "^name$")) {
+				if(!strcmp(key, "name")) {
 					test->name = parse_name(value);
 					if (!test->name) {
 						exit_report_result(PIGLIT_FAIL);
 					}
-				} else if(regex_match(key, "^kernel_name$")) {
+				} else if(!strcmp(key, "kernel_name")) {
 					test->kernel_name = add_dynamic_str_copy(value); // test can't have kernel_name == NULL like config section
-				} else if(regex_match(key, "^expect_test_fail$")) {
+				} else if(!strcmp(key, "expect_test_fail")) {
 					test->expect_test_fail = get_bool(value);
-				} else if(regex_match(key, "^dimensions$")) {
+				} else if(!strcmp(key, "dimensions")) {
 					test->work_dimensions = get_uint(value);
-				} else if(regex_match(key, "^global_size$")) {
+				} else if(!strcmp(key, "global_size")) {
 					int i;
 					uint64_t* int_global_work_size;
 					get_uint_array(value, &int_global_work_size, 3);
@@ -1791,8 +1817,8 @@ parse_config(const char* config_str,
 						test->global_work_size[i] = int_global_work_size[i];
 					}
 					free(int_global_work_size);
-				} else if(regex_match(key, "^local_size$")) {
-					if(!regex_match(value, REGEX_FULL_MATCH(REGEX_NULL))) {
+				} else if(!strcmp(key, "local_size")) {
+					if(!is_single_word(value, WORDS_NULL)) {
 						int i;
 						uint64_t* int_local_work_size;
 						get_uint_array(value, &int_local_work_size, 3);
@@ -1804,8 +1830,8 @@ parse_config(const char* config_str,
 					} else {
 						test->local_work_size_null = true;
 					}
-				} else if(regex_match(key, "^global_offset$")) {
-					if(!regex_match(value, REGEX_FULL_MATCH(REGEX_NULL))) {
+				} else if(!strcmp(key, "global_offset")) {
+					if(!is_single_word(value, WORDS_NULL)) {
 						int i;
 						uint64_t* int_global_offset;
 						get_uint_array(value, &int_global_offset, 3);
@@ -1817,33 +1843,21 @@ parse_config(const char* config_str,
 					} else {
 						test->global_offset_null = true;
 					}
-				} else if(regex_match(key, "^arg_in$")) {
+				} else if(!strcmp(key, "arg_in")) {
 					get_test_arg(value, test, true);
-				} else if(regex_match(key, "^arg_out$")) {
+				} else if(!strcmp(key, "arg_out")) {
 					get_test_arg(value, test, false);
 				} else {
-					fprintf(stderr,
-					        "Invalid configuration, key '%s' does not belong to a [test] section: %s\n",
-					        key, line);
-					free(key); key = NULL;
-					free(value); value = NULL;
-					exit_report_result(PIGLIT_WARN);
+					config_error("key '%s' does not belong to a [test] section",
+					             key);
 				}
 				break;
 			}
-			
-			free(key); key = NULL;
-			free(value); value = NULL;
-		} else if(!regex_match(line, REGEX_IGNORE)){ // not WHITESPACE or COMMENT
-			fprintf(stderr,
-			        "Invalid configuration, configuration could not be parsed: %s\n",
-			        line);
-			exit_report_result(PIGLIT_WARN);
+		} else if(line[strspn(line, " \t\r\f\v")] != '\0') { // not WHITESPACE or COMMENT
+			config_error("configuration could not be parsed: %s", line);
 		}
 
-		/* Go to next line */
 		free(line); line = NULL;
-		pch += line_length+1;
 	}
 
 	if(!config_found) {
@@ -1857,20 +1871,41 @@ parse_config(const char* config_str,
 char*
 get_comment_config_str(const char* src)
 {
-	char* config_str = NULL;
-	regmatch_t pmatch[2];
+	const char* start = strstr(src, "/*!");
+	const char* end = NULL;
+	const char* pch;
+	struct word config_str;
 
-	if(regex_get_matches(src, REGEX_COMMENT_CONFIG, pmatch, 2, 0)) {
-		if(regex_get_match_str(&config_str, src, pmatch, 1)) {
-			return config_str;
-		}
+	if(start == NULL) {
+		return NULL;
+	}
+	start += strlen("/*!");
+
+	/* The config ends at the last end marker */
+	for(pch = strstr(start, "!*/"); pch != NULL; pch = strstr(pch + 1, "!*/")) {
+		end = pch;
+	}
+	if(end == NULL || end == start) {
+		return NULL;
 	}
 
-	return NULL;
+	config_str.str = start;
+	config_str.length = end - start;
+	return word_str(config_str);
 }
 
 /* Init */
 
+bool
+has_extension(const char* filename, const char* extension)
+{
+	size_t length = strlen(filename);
+	size_t extension_length = strlen(extension);
+
+	return    length >= extension_length
+	       && !strcmp(filename + length - extension_length, extension);
+}
+
 void
 init(const int argc,
      const char** argv,
@@ -1903,7 +1938,9 @@ init(const int argc,
 			print_usage_and_warn(argc, argv, "No main argument.");
 		}
 	}
-	if(!regex_match(main_argument, "\\.(cl|program_test|bin)$")) {
+	if(   !has_extension(main_argument, ".cl")
+	   && !has_extension(main_argument, ".program_test")
+	   && !has_extension(main_argument, ".bin")) {
 		print_usage_and_warn(argc, argv, "Invalid main argument.");
 	}
 	temp_file = fopen(main_argument, "r");
@@ -1914,7 +1951,7 @@ init(const int argc,
 	// valid config argument
 	if(config_arg_present) {
 		config_file = piglit_cl_get_arg_value(argc, argv, "config");
-		if(!regex_match(config_file, "\\.program_test$")) {
+		if(!has_extension(config_file, ".program_test")) {
 			print_usage_and_warn(argc, argv, "Invalid config argument.");
 		}
 		temp_file = fopen(config_file, "r");
@@ -1924,19 +1961,19 @@ init(const int argc,
 		fclose(temp_file);
 	}
 	// no config argument if using .program_test
-	if(regex_match(main_argument, "\\.program_test$") && config_arg_present) {
+	if(has_extension(main_argument, ".program_test") && config_arg_present) {
 		print_usage_and_warn(argc,
 		                     argv,
 		                     "Cannot use config argument if main argument is already a config file.");
 	}
 
 	/* Get main_argument type and config string */
-	if(regex_match(main_argument, "\\.program_test$")) {
+	if(has_extension(main_argument, ".program_test")) {
 		main_argument_type = ARG_CONFIG;
 
 		config_file = main_argument;
 		config_str = piglit_load_text_file(config_file, &config_str_size);
-	} else if(regex_match(main_argument, "\\.cl$")) {
+	} else if(has_extension(main_argument, ".cl")) {
 		main_argument_type = ARG_SOURCE;
 
 		if(config_arg_present) {
@@ -1951,7 +1988,7 @@ init(const int argc,
 			
 			free(source_str);
 		}
-	} else if(regex_match(main_argument, "\\.bin$")) {
+	} else if(has_extension(main_argument, ".bin")) {
 		main_argument_type = ARG_BINARY;
 
 		config_file = piglit_cl_get_arg_value(argc, argv, "config");
@@ -2025,6 +2062,9 @@ init(const int argc,
 
 	/* Run test per device */
 	config->run_per_device = true;
+
+	/* Only the kernels are run, so cached program binaries will do */
+	piglit_cl_use_program_cache(true);
 }
 
 /* Memory object functions */
@@ -2153,25 +2193,70 @@ check_test_arg_value(struct test_arg test_arg,
 }
 
 /* Run the kernel test */
-enum piglit_result
-test_kernel(const struct piglit_cl_program_test_config* config,
-            const struct piglit_cl_program_test_env* env,
-            struct test test)
+
+/*
+ * A kernel test whose commands have been enqueued. Its memory objects and the
+ * values read back from them stay alive until the command queue is finished
+ * and the results are checked.
+ */
+struct test_run {
+	enum piglit_result result;
+	cl_kernel kernel; // NULL if nothing was enqueued
+
+	struct mem_arg* mem_args;
+	unsigned int num_mem_args;
+
+	cl_sampler* sampler_args;
+	unsigned int num_sampler_args;
+
+	void** read_values; // one per out argument, NULL if it can't be read
+	unsigned int num_read_values;
+};
+
+void
+release_test_run(struct test_run* run)
 {
-	enum piglit_result result = PIGLIT_PASS;
+	unsigned i;
 
+	if(run->kernel != NULL) {
+		clReleaseKernel(run->kernel);
+		run->kernel = NULL;
+	}
+	free_mem_args(&run->mem_args, &run->num_mem_args);
+	free_sampler_args(&run->sampler_args, &run->num_sampler_args);
+
+	for(i = 0; i < run->num_read_values; i++) {
+		free(run->read_values[i]);
+	}
+	free(run->read_values); run->read_values = NULL;
+	run->num_read_values = 0;
+}
+
+/*
+ * Enqueue writing the in arguments, the kernel and reading the out arguments
+ * of a test without waiting for them. Return PIGLIT_PASS if the commands were
+ * enqueued to run, otherwise the result of the test.
+ */
+enum piglit_result
+enqueue_test_kernel(const struct piglit_cl_program_test_config* config,
+                    const struct piglit_cl_program_test_env* env,
+                    struct test test,
+                    struct test_run* run)
+{
 	// all
 	unsigned j;
 	char* kernel_name;
 	cl_kernel kernel;
 
-	// setting/validating arguments
+	// setting/reading arguments
 	struct mem_arg* mem_args = NULL;
 	unsigned int  num_mem_args = 0;
 
 	cl_sampler *sampler_args = NULL;
 	unsigned int num_sampler_args = 0;
 
+	void** read_values;
+
 	/* Check if this device supports the local work size. */
 	if (!piglit_cl_framework_check_local_work_size(env->device_id,
 						test.local_work_size)) {
@@ -2225,11 +2310,11 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 				                                            CL_MEM_READ_WRITE,
 				                                            test_arg.size);
 				if(   mem_arg.mem != NULL
-				   && piglit_cl_write_buffer(env->context->command_queues[0],
-				                             mem_arg.mem,
-				                             0,
-				                             test_arg.size,
-				                             test_arg.value)
+				   && piglit_cl_enqueue_write_buffer(env->context->command_queues[0],
+				                                     mem_arg.mem,
+				                                     0,
+				                                     test_arg.size,
+				                                     test_arg.value)
 				   && piglit_cl_set_kernel_arg(kernel,
 				                               mem_arg.index,
 				                               sizeof(cl_mem),
@@ -2268,9 +2353,9 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			                                     &test_arg.image_format,
 			                                     &test_arg.image_desc);
 			if(   mem_arg.mem != NULL
-			   && piglit_cl_write_whole_image(env->context->command_queues[0],
-			                                  mem_arg.mem,
-			                                  test_arg.value)
+			   && piglit_cl_enqueue_write_whole_image(env->context->command_queues[0],
+			                                          mem_arg.mem,
+			                                          test_arg.value)
 			   && piglit_cl_set_kernel_arg(kernel,
 			                               mem_arg.index,
 			                               sizeof(cl_mem),
@@ -2448,7 +2533,7 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 	/* Execute kernel */
 	printf("Running the kernel...\n");
 
-	if(!piglit_cl_execute_ND_range_kernel(env->context->command_queues[0],
+	if(!piglit_cl_enqueue_ND_range_kernel(env->context->command_queues[0],
 	                                      kernel,
 	                                      test.work_dimensions,
 	                                      test.global_offset_null ? NULL : test.global_offset,
@@ -2461,120 +2546,137 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 		return PIGLIT_FAIL;
 	}
 
-	/* Check results */
-	printf("Validating results...\n");
+	/* Read results */
+	read_values = calloc(test.num_args_out, sizeof(void*));
 
 	for(j = 0; j < test.num_args_out; j++) {
 		unsigned k;
-		bool arg_valid = false;
+		bool arg_read = false;
 		struct test_arg test_arg = test.args_out[j];
+		struct mem_arg mem_arg;
 
-		switch(test_arg.type) {
-		case TEST_ARG_VALUE:
-			// Not accepted by parser
-			break;
-		case TEST_ARG_BUFFER: {
-			struct mem_arg mem_arg;
-
-			/* Find the right buffer */
-			for(k = 0; k < num_mem_args; k++) {
-				if(mem_args[k].index == test_arg.index) {
-					mem_arg = mem_args[k];
-				}
-			}
-
-			if(test_arg.value != NULL) {
-				void* read_value = malloc(test_arg.size);
-
-				if(piglit_cl_read_buffer(env->context->command_queues[0],
-					                     mem_arg.mem,
-					                     0,
-					                     test_arg.size,
-					                     read_value)) {
-					arg_valid = true;
-					if(check_test_arg_value(test_arg, read_value)) {
-						printf(" Argument %u: PASS%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (not expected)");
-						if(test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					} else {
-						printf(" Argument %u: FAIL%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (expected)");
-						if(!test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					}
-				}
-
-				free(read_value);
-			}
-
-			break;
+		if(test_arg.value == NULL) {
+			continue;
 		}
-		case TEST_ARG_IMAGE: {
-			struct mem_arg mem_arg;
 
-			/* Find the right buffer */
-			for(k = 0; k < num_mem_args; k++) {
-				if(mem_args[k].index == test_arg.index) {
-					mem_arg = mem_args[k];
-				}
+		/* Find the right buffer */
+		for(k = 0; k < num_mem_args; k++) {
+			if(mem_args[k].index == test_arg.index) {
+				mem_arg = mem_args[k];
 			}
+		}
 
-			if(test_arg.value != NULL) {
-				void* read_value = malloc(test_arg.size);
-
-				if(piglit_cl_read_whole_image(env->context->command_queues[0],
-					                          mem_arg.mem,
-					                          read_value)) {
-					arg_valid = true;
-					if(check_test_arg_value(test_arg, read_value)) {
-						printf(" Argument %u: PASS%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (not expected)");
-						if(test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					} else {
-						printf(" Argument %u: FAIL%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (expected)");
-						if(!test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					}
-				}
-
-				free(read_value);
-			}
+		read_values[j] = malloc(test_arg.size);
 
+		switch(test_arg.type) {
+		case TEST_ARG_BUFFER:
+			arg_read = piglit_cl_enqueue_read_buffer(env->context->command_queues[0],
+			                                         mem_arg.mem,
+			                                         0,
+			                                         test_arg.size,
+			                                         read_values[j]);
 			break;
-		}
+		case TEST_ARG_IMAGE:
+			arg_read = piglit_cl_enqueue_read_whole_image(env->context->command_queues[0],
+			                                              mem_arg.mem,
+			                                              read_values[j]);
+			break;
+		case TEST_ARG_VALUE:
 		case TEST_ARG_SAMPLER:
 			// Not accepted by parser
 			break;
 		}
 
-		if(!arg_valid) {
+		if(!arg_read) {
+			free(read_values[j]);
+			read_values[j] = NULL;
+		}
+	}
+
+	run->kernel = kernel;
+	run->mem_args = mem_args;
+	run->num_mem_args = num_mem_args;
+	run->sampler_args = sampler_args;
+	run->num_sampler_args = num_sampler_args;
+	run->read_values = read_values;
+	run->num_read_values = test.num_args_out;
+	return PIGLIT_PASS;
+}
+
+/* Check the values read by a test once the command queue is finished */
+enum piglit_result
+check_test_kernel(struct test test, const struct test_run* run)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	unsigned j;
+
+	printf("Validating results...\n");
+
+	for(j = 0; j < test.num_args_out; j++) {
+		struct test_arg test_arg = test.args_out[j];
+
+		if(run->read_values[j] == NULL) {
 			printf("Failed to validate kernel argument with index %u\n",
 			       test_arg.index);
-			clReleaseKernel(kernel);
-			free_mem_args(&mem_args, &num_mem_args);
-			free_sampler_args(&sampler_args, &num_sampler_args);
 			return PIGLIT_FAIL;
 		}
+
+		if(check_test_arg_value(test_arg, run->read_values[j])) {
+			printf(" Argument %u: PASS%s\n",
+			                     test_arg.index,
+			                     !test.expect_test_fail ? "" : " (not expected)");
+			if(test.expect_test_fail) {
+				piglit_merge_result(&result, PIGLIT_FAIL);
+			}
+		} else {
+			printf(" Argument %u: FAIL%s\n",
+			                     test_arg.index,
+			                     !test.expect_test_fail ? "" : " (expected)");
+			if(!test.expect_test_fail) {
+				piglit_merge_result(&result, PIGLIT_FAIL);
+			}
+		}
 	}
 
-	/* Clean memory used by test */
-	clReleaseKernel(kernel);
-	free_mem_args(&mem_args, &num_mem_args);
-	free_sampler_args(&sampler_args, &num_sampler_args);
 	return result;
 }
 
+/*
+ * Wait for the commands of the enqueued runs to complete, then check and
+ * release them.
+ */
+void
+finish_test_runs(const struct piglit_cl_program_test_env* env,
+                 struct test_run* runs,
+                 const struct test* run_tests,
+                 unsigned int num_runs)
+{
+	unsigned i;
+	cl_int errNo;
+	bool finished;
+
+	errNo = clFinish(env->context->command_queues[0]);
+	finished = piglit_cl_check_error(errNo, CL_SUCCESS);
+	if(!finished) {
+		printf("Could not wait for the kernels to finish: %s\n",
+		       piglit_cl_get_error_name(errNo));
+	}
+
+	for(i = 0; i < num_runs; i++) {
+		if(runs[i].kernel == NULL) {
+			continue;
+		}
+
+		if(num_runs > 1) {
+			printf("> Checking kernel test: %s\n",
+			       run_tests[i].name != NULL ? run_tests[i].name : "");
+		}
+		runs[i].result = finished ? check_test_kernel(run_tests[i], &runs[i])
+		                          : PIGLIT_FAIL;
+		release_test_run(&runs[i]);
+	}
+}
+
 /* Run test */
 
 enum piglit_result
@@ -2586,6 +2688,8 @@ piglit_cl_test(const int argc,
 	enum piglit_result result = PIGLIT_SKIP;
 
 	unsigned i;
+	struct test_run* runs;
+	bool pipeline = getenv("PIGLIT_CL_NO_PIPELINE") == NULL;
 
 	/* Print building status */
 	if(!config->expect_build_fail) {
@@ -2602,19 +2706,38 @@ piglit_cl_test(const int argc,
 		result = PIGLIT_PASS;
 	}
 
-	/* Run the tests */
+	/*
+	 * Run the tests. The tests are independent and the command queue is
+	 * in-order, so all of them are enqueued before waiting once for the
+	 * queue to finish, unless PIGLIT_CL_NO_PIPELINE is set.
+	 */
+	runs = calloc(num_tests, sizeof(struct test_run));
+
 	for(i = 0; i< num_tests; i++) {
-		enum piglit_result test_result;
 		char* test_name = tests[i].name != NULL ? tests[i].name : "";
 
 		printf("> Running kernel test: %s\n", test_name);
 
-		test_result = test_kernel(config, env, tests[i]);
-		piglit_merge_result(&result, test_result);
+		runs[i].result = enqueue_test_kernel(config, env, tests[i], &runs[i]);
+
+		if(!pipeline) {
+			finish_test_runs(env, &runs[i], &tests[i], 1);
+			piglit_merge_result(&result, runs[i].result);
+			piglit_report_subtest_result(runs[i].result, "%s", tests[i].name);
+		}
+	}
+
+	if(pipeline) {
+		finish_test_runs(env, runs, tests, num_tests);
 
-		piglit_report_subtest_result(test_result, "%s", tests[i].name);
+		for(i = 0; i < num_tests; i++) {
+			piglit_merge_result(&result, runs[i].result);
+			piglit_report_subtest_result(runs[i].result, "%s", tests[i].name);
+		}
 	}
 
+	free(runs);
+
 	/* Print result */
 	if(num_tests > 0) {
 		switch(result) {
@@ -53,7 +53,16 @@ class DEQPGLES2Test(deqp.DEQPBaseTest):
 
 
 
+class DEQPGLES2BatchTest(deqp.DEQPBatchTest):
+    deqp_bin = _DEQP_GLES2_BIN
+
+    @property
+    def extra_args(self):
+        return super(DEQPGLES2BatchTest, self).extra_args + \
+            [x for x in _EXTRA_ARGS if not x.startswith('--deqp-case')]
+
+
 profile = deqp.make_profile(  # pylint: disable=invalid-name
     deqp.select_source(_DEQP_GLES2_BIN, 'dEQP-GLES2-cases.txt', _DEQP_MUSTPASS,
                        _EXTRA_ARGS),
-    DEQPGLES2Test)
+    DEQPGLES2Test, DEQPGLES2BatchTest)
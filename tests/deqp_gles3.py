@@ -92,7 +92,16 @@ class DEQPGLES3Test(deqp.DEQPBaseTest):
         super(DEQPGLES3Test, self).__init__(*args, **kwargs)
 
 
+class DEQPGLES3BatchTest(deqp.DEQPBatchTest):
+    deqp_bin = _DEQP_GLES3_BIN
+
+    @property
+    def extra_args(self):
+        return super(DEQPGLES3BatchTest, self).extra_args + \
+            [x for x in _EXTRA_ARGS if not x.startswith('--deqp-case')]
+
+
 profile = deqp.make_profile(  # pylint: disable=invalid-name
     deqp.select_source(_DEQP_GLES3_BIN, 'dEQP-GLES3-cases.txt', _DEQP_MUSTPASS,
                        _EXTRA_ARGS),
-    DEQPGLES3Test)
+    DEQPGLES3Test, DEQPGLES3BatchTest)
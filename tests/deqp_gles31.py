@@ -52,7 +52,16 @@ class DEQPGLES31Test(deqp.DEQPBaseTest):
             [x for x in _EXTRA_ARGS if not x.startswith('--deqp-case')]
 
 
+class DEQPGLES31BatchTest(deqp.DEQPBatchTest):
+    deqp_bin = _DEQP_GLES31_BIN
+
+    @property
+    def extra_args(self):
+        return super(DEQPGLES31BatchTest, self).extra_args + \
+            [x for x in _EXTRA_ARGS if not x.startswith('--deqp-case')]
+
+
 profile = deqp.make_profile(  # pylint: disable=invalid-name
     deqp.select_source(_DEQP_GLES31_BIN, 'dEQP-GLES31-cases.txt',
                        _DEQP_MUSTPASS, _EXTRA_ARGS),
-    DEQPGLES31Test)
+    DEQPGLES31Test, DEQPGLES31BatchTest)
@@ -82,6 +82,9 @@ main(int argc, char* argv[]) {
 			o.overwrite = true;
 		} else if (!strcmp(argv[i], "--quick")) {
 			o.quick = true;
+		} else if (!strcmp(argv[i], "--shard")) {
+			++i;
+			o.shard = mandatoryArg(argc, argv, i);
 		} else if (!strcmp(argv[i], "--visuals")) {
 			visFilter = true;
 			++i;
@@ -271,6 +274,7 @@ usage(char* command) {
 "                                  # pixel formats) to test\n"
 "       (-t|--tests) {(+|-)test}   # choose tests to include (+) or exclude (-)\n"
 "       --quick                    # run fewer tests to reduce test time\n"
+"       --shard name               # run only the named shard of the tests\n"
 "       --listtests                # list test names and exit\n"
 "       --help                     # display usage information\n"
 #if defined(__X11__)
@@ -75,6 +75,10 @@ class Options {
 
 	bool quick;		// run fewer/quicker tests when possible
 
+	string shard;		// Name of the only shard of the tests to
+				// run, or empty to run all of them.  See
+				// BaseTest::runShard().
+
 #if defined(__X11__)
 	string dpyName;		// Name of the X11 display providing the
 				// OpenGL implementation to be tested.
@@ -77,6 +77,12 @@ variables which you might want to use when constructing a test:
 	running the current test.  This makes the results of
 	"prerequisite" tests available.
 
+A test that walks a large matrix of cases can split it into named
+shards, so that they can be run by separate processes.  runOne() asks
+runShard() whether to run each shard, which is true for every shard
+unless --shard selected one, and reports the result of each shard it
+ran with logShard(), as a piglit subtest.
+
 To use BaseTest, declare a new class derived from BaseTest,
 parameterized by your result class.  Then override the runOne()
 and logOne() member functions.  runOne() runs a test and generates a
@@ -207,6 +213,7 @@ public:
 		fWidth      = 258;
 		fHeight     = 258;
 		testOne     = false;
+		shardFound  = false;
 	}
 	BaseTest(const char* aName, const char* aFilter, Test** thePrereqs,
 		 const char* aDescription):
@@ -217,6 +224,7 @@ public:
 		fWidth      = 258;
 		fHeight     = 258;
 		testOne     = false;
+		shardFound  = false;
 	}
 	BaseTest(const char* aName, const char* aFilter,
 		 const char* anExtensionList,
@@ -227,6 +235,7 @@ public:
 		fWidth      = 258;
 		fHeight     = 258;
 		testOne     = false;
+		shardFound  = false;
 	}
 
 	virtual ~BaseTest() {
@@ -241,6 +250,7 @@ public:
 	int                 fWidth;	 // Drawing surface width.
 	int                 fHeight;     // Drawing surface height.
 	bool                testOne;     // Test only one config?
+	bool                shardFound;  // Did runOne() find the shard?
 	vector<ResultType*> results;     // Test results.
 
 	virtual void runOne(ResultType& r, Window& w) = 0;
@@ -268,6 +278,23 @@ public:
 				 << '\n';
 	}
 
+	// Whether runOne() should run the shard with the given name.
+	virtual bool runShard(const string& shardName) {
+		if (env->options.shard.empty())
+			return true;
+		if (env->options.shard != shardName)
+			return false;
+		shardFound = true;
+		return true;
+	}
+
+	// Report the result of a shard, "pass", "fail" or "skip", as a
+	// piglit subtest.
+	virtual void logShard(const string& shardName, const char* result) {
+		env->log << "PIGLIT: {\"subtest\": {\"" << shardName
+			 << "\" : \"" << result << "\"}}\n";
+	}
+
 	// This method allows a test to indicate that it's not applicable.
 	// For example, the GL version is too low.
 	virtual bool isApplicable() const {
@@ -351,6 +378,11 @@ public:
 		catch (RenderingContext::Error) {
 			env->log << "Could not create a rendering context\n";
 		}
+
+		if (!env->options.shard.empty() && !results.empty() &&
+		    !shardFound)
+			env->log << name << ":  FAIL no shard named '"
+				 << env->options.shard << "'\n";
 		env->log << '\n';
 
 		hasRun = true;	// Note that we've completed the run
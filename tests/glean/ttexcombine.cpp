@@ -1537,7 +1537,6 @@ TexCombineTest::RunCrossbarTest(glmachine &machine, BasicResult &r, Window& w) {
 // runOne:  Run a single test case
 ///////////////////////////////////////////////////////////////////////////////
 
-// XXX should we run a number of individual tests instead?
 void
 TexCombineTest::runOne(BasicResult& r, Window& w) {
 	// Grab pointers to the extension functions.  It's safe to use
@@ -1601,7 +1600,6 @@ TexCombineTest::runOne(BasicResult& r, Window& w) {
 	glViewport(0, 0, 2, 2);
 
 	ResetMachine(Machine);
-	Machine.NumTexUnits = 1;
 
 	// If quick mode, run fewer tests
 	if (env->options.quick)
@@ -1609,39 +1607,68 @@ TexCombineTest::runOne(BasicResult& r, Window& w) {
 	else
 		testStride = 1;
 
-	// Do single texture unit tests first.
-	bool passed = RunSingleTextureTest(Machine, ReplaceParams, r, w);
-	if (passed)
-		passed = RunSingleTextureTest(Machine, AddParams, r, w);
-	if (passed)
-		passed = RunSingleTextureTest(Machine, AddSignedParams, r, w);
-	if (passed)
-		passed = RunSingleTextureTest(Machine, ModulateParams, r, w);
-	if (passed)
-		passed = RunSingleTextureTest(Machine, InterpolateParams, r, w);
-	if (passed && haveDot3)
-		passed = RunSingleTextureTest(Machine, Dot3RGBParams, r, w);
-	if (passed && haveDot3)
-		passed = RunSingleTextureTest(Machine, Dot3RGBAParams, r, w);
-	if (passed && haveCombine3)
-		passed = RunSingleTextureTest(Machine, ModulateAddParams, r, w);
-	if (passed && haveCombine3)
-		passed = RunSingleTextureTest(Machine, ModulateSignedAddParams, r, w);
-	if (passed && haveCombine3)
-		passed = RunSingleTextureTest(Machine, ModulateSubtractParams, r, w);
+	// Each of the single texture unit tests, the multi-texture tests
+	// and the crossbar tests is a shard.  They're independent, so a
+	// failure doesn't stop the shards after it.
+	const struct {
+		const char *name;
+		const test_param *params;
+		bool available;
+	} singleTextureShards[] = {
+		{ "GL_REPLACE", ReplaceParams, true },
+		{ "GL_ADD", AddParams, true },
+		{ "GL_ADD_SIGNED_EXT", AddSignedParams, true },
+		{ "GL_MODULATE", ModulateParams, true },
+		{ "GL_INTERPOLATE_EXT", InterpolateParams, true },
+		{ "GL_DOT3_RGB_EXT", Dot3RGBParams, haveDot3 },
+		{ "GL_DOT3_RGBA_EXT", Dot3RGBAParams, haveDot3 },
+		{ "GL_MODULATE_ADD_ATI", ModulateAddParams, haveCombine3 },
+		{ "GL_MODULATE_SIGNED_ADD_ATI", ModulateSignedAddParams,
+		  haveCombine3 },
+		{ "GL_MODULATE_SUBTRACT_ATI", ModulateSubtractParams,
+		  haveCombine3 },
+	};
+	bool passed = true;
+
+	for (unsigned i = 0; i < sizeof(singleTextureShards) /
+		     sizeof(singleTextureShards[0]); i++) {
+		if (!runShard(singleTextureShards[i].name))
+			continue;
+		if (!singleTextureShards[i].available) {
+			logShard(singleTextureShards[i].name, "skip");
+			continue;
+		}
+		Machine.NumTexUnits = 1;
+		const bool ok = RunSingleTextureTest(Machine,
+			singleTextureShards[i].params, r, w);
+		logShard(singleTextureShards[i].name, ok ? "pass" : "fail");
+		passed = passed && ok;
+	}
 
 	// Now do some multi-texture tests
-	if (passed) {
+	if (runShard("multitexture")) {
 		glGetIntegerv(GL_MAX_TEXTURE_UNITS_ARB,
 			(GLint *) &Machine.NumTexUnits);
 		if (Machine.NumTexUnits > 1) {
-			passed = RunMultiTextureTest(Machine, r, w);
+			const bool ok = RunMultiTextureTest(Machine, r, w);
+			logShard("multitexture", ok ? "pass" : "fail");
+			passed = passed && ok;
+		}
+		else {
+			logShard("multitexture", "skip");
 		}
 	}
 
 	// Do crossbar tests
-	if (passed && haveCrossbar) {
-		passed = RunCrossbarTest(Machine, r, w);
+	if (runShard("crossbar")) {
+		if (haveCrossbar) {
+			const bool ok = RunCrossbarTest(Machine, r, w);
+			logShard("crossbar", ok ? "pass" : "fail");
+			passed = passed && ok;
+		}
+		else {
+			logShard("crossbar", "skip");
+		}
 	}
 
 	r.pass = passed;
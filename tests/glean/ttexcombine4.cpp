@@ -328,42 +328,65 @@ TexCombine4Test::runOne(TexCombine4Result &r, Window &w)
 
 	const float err = 0.05;  // xxx compute something better
 
-	for (int i = 0; i < NUM_TESTS; i++) {
-		combine_state state;
-		GLfloat expected[4], actual[4];
-
-		//env->log << "\t iteration " << i << "\n";
-
-		generate_state(state);
-
-		evaluate_state(state, expected);
-
-		if (!render_state(state, actual)) {
-			r.pass = false;
-			return;
+	bool passed = true;
+
+	// The tests are split into shards of consecutive iterations, like
+	// "iterations-0-49".  The states of the iterations that aren't run
+	// are still generated, so that every shard tests the same states
+	// whether or not the shards before it ran.
+	for (int shard = 0; shard < NUM_SHARDS; shard++) {
+		const int first = shard * NUM_TESTS / NUM_SHARDS;
+		const int last = (shard + 1) * NUM_TESTS / NUM_SHARDS;
+		char shardName[100];
+		sprintf(shardName, "iterations-%d-%d", first, last - 1);
+
+		const bool runThisShard = runShard(shardName);
+		bool shardPassed = true;
+
+		for (int i = first; i < last; i++) {
+			combine_state state;
+			GLfloat expected[4], actual[4];
+
+			//env->log << "\t iteration " << i << "\n";
+
+			generate_state(state);
+
+			if (!runThisShard || !shardPassed)
+				continue;
+
+			evaluate_state(state, expected);
+
+			if (!render_state(state, actual)) {
+				shardPassed = false;
+				continue;
+			}
+
+			if (fabs(expected[0] - actual[0]) > err ||
+			    fabs(expected[1] - actual[1]) > err ||
+			    fabs(expected[2] - actual[2]) > err) {
+				char str[100];
+				env->log << name << ": Error: GL_NV_texure_env_combine4 failed\n";
+				report_state(state);
+				env->log << "\tResults:\n";
+				sprintf(str, "%.3f, %.3f, %.3f, %.3f",
+					expected[0], expected[1],
+					expected[2], expected[3]);
+				env->log << "\t\tExpected color: " << str << "\n";
+				sprintf(str, "%.3f, %.3f, %.3f, %.3f",
+					actual[0], actual[1],
+					actual[2], actual[3]);
+				env->log << "\t\tRendered color: " << str << "\n";
+				shardPassed = false;
+			}
 		}
 
-		if (fabs(expected[0] - actual[0]) > err ||
-		    fabs(expected[1] - actual[1]) > err ||
-		    fabs(expected[2] - actual[2]) > err) {
-			char str[100];
-			env->log << name << ": Error: GL_NV_texure_env_combine4 failed\n";
-			report_state(state);
-			env->log << "\tResults:\n";
-			sprintf(str, "%.3f, %.3f, %.3f, %.3f",
-				expected[0], expected[1],
-				expected[2], expected[3]);
-			env->log << "\t\tExpected color: " << str << "\n";
-			sprintf(str, "%.3f, %.3f, %.3f, %.3f",
-				actual[0], actual[1],
-				actual[2], actual[3]);
-			env->log << "\t\tRendered color: " << str << "\n";
-			r.pass = false;
-			return;
+		if (runThisShard) {
+			logShard(shardName, shardPassed ? "pass" : "fail");
+			passed = passed && shardPassed;
 		}
 	}
 
-	r.pass = true;
+	r.pass = passed;
 }
 
 
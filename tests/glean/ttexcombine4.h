@@ -40,6 +40,7 @@ namespace GLEAN {
 #define NUM_POINTS 1000
 #define WINDOW_SIZE 100
 #define NUM_TESTS 200
+#define NUM_SHARDS 4  // of NUM_TESTS / NUM_SHARDS tests each
 
 
 class TexCombine4Result: public BaseResult
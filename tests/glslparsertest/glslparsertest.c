@@ -29,6 +29,11 @@
  *
  * Tests that compiling (but not linking or drawing with) a given
  * shader either succeeds or fails as expected.
+ *
+ * With -report-subtests any number of shaders can be tested in a single
+ * run, each reported as a subtest named after the file.  The arguments of
+ * each shader are separated by "--", and all of them must request the same
+ * GLSL version, since they share one GL context.
  */
 
 #include <errno.h>
@@ -41,7 +46,7 @@ static int process_options(int argc, char **argv);
 PIGLIT_GL_TEST_CONFIG_BEGIN
 
 	argc = process_options(argc, argv);
-	if (argc > 3) {
+	if (argc > 3 && strcmp(argv[3], "--") != 0) {
 		const unsigned int int_version
 			= parse_glsl_version_number(argv[3]);
 		switch (int_version) {
@@ -95,6 +100,10 @@ static int gl_version_times_10 = 0;
 static int check_link = 0;
 static unsigned requested_version = 110;
 static bool test_requires_geometry_shader4 = false;
+static bool report_subtests = false;
+
+/** Whether --check-link was given, for each shader's arguments. */
+static bool *check_link_args;
 
 static GLint
 get_shader_compile_status(GLuint shader)
@@ -233,7 +242,7 @@ attach_complementary_shader(GLuint shader_prog, GLenum type)
 		attach_dummy_shader(shader_prog, GL_FRAGMENT_SHADER);
 }
 
-static void
+static bool
 require_feature(int gl_ver, const char *gl_ext, int es_ver, const char *es_ext)
 {
 	const int required_ver = piglit_is_gles() ? es_ver : gl_ver;
@@ -243,11 +252,13 @@ require_feature(int gl_ver, const char *gl_ext, int es_ver, const char *es_ext)
 	    !piglit_is_extension_supported(required_ext)) {
 		printf("Test requires version %g or %s\n",
 		       required_ver / 10.0, required_ext);
-		piglit_report_result(PIGLIT_SKIP);
+		return false;
 	}
+
+	return true;
 }
 
-static void
+static enum piglit_result
 test(void)
 {
 	GLint prog;
@@ -276,26 +287,24 @@ test(void)
 		type = GL_NONE;
 		fprintf(stderr, "Couldn't determine type of program %s\n",
 			filename);
-		piglit_report_result(PIGLIT_FAIL);
+		return PIGLIT_FAIL;
 	}
 
-	piglit_require_vertex_shader();
-	piglit_require_fragment_shader();
-
-	if (type == GL_TESS_CONTROL_SHADER || type == GL_TESS_EVALUATION_SHADER) {
-		require_feature(40, "GL_ARB_tessellation_shader",
-				32, "GL_OES_tessellation_shader");
-	}
+	if ((type == GL_TESS_CONTROL_SHADER ||
+	     type == GL_TESS_EVALUATION_SHADER) &&
+	    !require_feature(40, "GL_ARB_tessellation_shader",
+			     32, "GL_OES_tessellation_shader"))
+		return PIGLIT_SKIP;
 
-	if (type == GL_COMPUTE_SHADER) {
-		require_feature(43, "GL_ARB_compute_shader", 31, NULL);
-	}
+	if (type == GL_COMPUTE_SHADER &&
+	    !require_feature(43, "GL_ARB_compute_shader", 31, NULL))
+		return PIGLIT_SKIP;
 
 	prog_string = piglit_load_text_file(filename, NULL);
 	if (prog_string == NULL) {
 		fprintf(stderr, "Couldn't open program %s: %s\n",
 			filename, strerror(errno));
-		exit(1);
+		return PIGLIT_FAIL;
 	}
 
 	prog = glCreateShader(type);
@@ -383,13 +392,15 @@ test(void)
 		free(info);
 	free(prog_string);
 	glDeleteShader(prog);
-	piglit_report_result (pass ? PIGLIT_PASS : PIGLIT_FAIL);
+	return pass ? PIGLIT_PASS : PIGLIT_FAIL;
 }
 
 static void usage(char *name)
 {
 	printf("%s {options} <filename.frag|filename.vert> <pass|fail> "
 	       "{requested GLSL version} {list of required GL extensions}\n", name);
+	printf("%s -report-subtests <arguments of the first shader> "
+	       "[-- <arguments of the next shader>]...\n", name);
 	printf("\nSupported options:\n");
 	printf("  --check-link: also detect link failures\n");
 	exit(1);
@@ -398,16 +409,28 @@ static void usage(char *name)
 /**
  * Process any options and remove them from the argv array.  Return
  * the new argc.
+ *
+ * --check-link applies to the shader whose arguments it appears in, the
+ * "--" separating the arguments of each shader are retained.
  */
 static int
 process_options(int argc, char **argv)
 {
 	int i = 1;
 	int new_argc = 1;
+	int shader = 0;
+
+	check_link_args = calloc(argc, sizeof(bool));
+
 	while (i < argc) {
-		if (argv[i][0] == '-') {
+		if (strcmp(argv[i], "--") == 0) {
+			shader++;
+			argv[new_argc++] = argv[i++];
+		} else if (argv[i][0] == '-') {
 			if (strcmp(argv[i], "--check-link") == 0)
-				check_link = 1;
+				check_link_args[shader] = true;
+			else if (strcmp(argv[i], "-report-subtests") == 0)
+				report_subtests = true;
 			else
 				usage(argv[0]);
 			/* do not retain the option; we've processed it */
@@ -461,23 +484,28 @@ parse_glsl_version_string(const char *str)
 }
 
 
-static void
+static enum piglit_result
 check_version(unsigned glsl_version)
 {
+	const char *compat_ext = NULL;
+
 	if (!piglit_is_gles()) {
-		if (requested_version == 100) {
-			piglit_require_extension("GL_ARB_ES2_compatibility");
-			return;
-		} else if (requested_version == 300) {
-			piglit_require_extension("GL_ARB_ES3_compatibility");
-			return;
-		} else if (requested_version == 310) {
-			piglit_require_extension("GL_ARB_ES3_1_compatibility");
-			return;
-		} else if (requested_version == 320) {
-			piglit_require_extension("GL_ARB_ES3_2_compatibility");
-			return;
+		if (requested_version == 100)
+			compat_ext = "GL_ARB_ES2_compatibility";
+		else if (requested_version == 300)
+			compat_ext = "GL_ARB_ES3_compatibility";
+		else if (requested_version == 310)
+			compat_ext = "GL_ARB_ES3_1_compatibility";
+		else if (requested_version == 320)
+			compat_ext = "GL_ARB_ES3_2_compatibility";
+	}
+
+	if (compat_ext != NULL) {
+		if (!piglit_is_extension_supported(compat_ext)) {
+			printf("Test requires %s\n", compat_ext);
+			return PIGLIT_SKIP;
 		}
+		return PIGLIT_PASS;
 	}
 
 	if (glsl_version < requested_version) {
@@ -485,8 +513,60 @@ check_version(unsigned glsl_version)
 			"GLSL version is %u.%u, but requested version %u.%u is required\n",
 			glsl_version / 100, glsl_version % 100,
 			requested_version / 100, requested_version % 100);
-		piglit_report_result(PIGLIT_SKIP);
+		return PIGLIT_SKIP;
 	}
+
+	return PIGLIT_PASS;
+}
+
+
+/**
+ * Test a single shader, given its arguments (without the program name).
+ */
+static enum piglit_result
+run_test_file(int argc, char **argv, bool check_link_arg,
+	      unsigned glsl_version)
+{
+	enum piglit_result result;
+	int i;
+
+	if (argc < 2 || strlen(argv[0]) < 5)
+		usage("glslparsertest");
+	filename = argv[0];
+
+	if (strcmp(argv[1], "pass") == 0)
+		expected_pass = 1;
+	else if (strcmp(argv[1], "fail") == 0)
+		expected_pass = 0;
+	else
+		usage("glslparsertest");
+
+	requested_version = 110;
+	if (argc > 2)
+		requested_version = parse_glsl_version_number(argv[2]);
+
+	check_link = check_link_arg;
+	test_requires_geometry_shader4 = false;
+
+	result = check_version(glsl_version);
+	if (result != PIGLIT_PASS)
+		return result;
+
+	for (i = 3; i < argc; i++) {
+		if (argv[i][0] == '!') {
+			if (piglit_is_extension_supported(argv[i] + 1))
+				return PIGLIT_SKIP;
+		} else {
+			if (!piglit_is_extension_supported(argv[i])) {
+				printf("Test requires %s\n", argv[i]);
+				return PIGLIT_SKIP;
+			}
+			if (strstr(argv[i], "geometry_shader4") != NULL)
+				test_requires_geometry_shader4 = true;
+		}
+	}
+
+	return test();
 }
 
 
@@ -495,25 +575,15 @@ piglit_init(int argc, char**argv)
 {
 	const char *glsl_version_string;
 	unsigned glsl_version = 0;
+	unsigned context_version;
+	enum piglit_result result = PIGLIT_SKIP;
+	int start = 1;
+	int shader = 0;
 	int i;
 
 	if (argc < 3)
 		usage(argv[0]);
 
-	if (strlen(argv[1]) < 5)
-		usage(argv[0]);
-	filename = argv[1];
-
-	if (strcmp(argv[2], "pass") == 0)
-		expected_pass = 1;
-	else if (strcmp(argv[2], "fail") == 0)
-		expected_pass = 0;
-	else
-		usage(argv[0]);
-
-	if (argc > 3)
-		requested_version = parse_glsl_version_number(argv[3]);
-
 	gl_version_times_10 = piglit_get_gl_version();
 
 	if (gl_version_times_10 < 20
@@ -522,25 +592,64 @@ piglit_init(int argc, char**argv)
 		piglit_report_result(PIGLIT_SKIP);
 	}
 
+	piglit_require_vertex_shader();
+	piglit_require_fragment_shader();
+
 	glsl_version_string = (char *)
 		glGetString(GL_SHADING_LANGUAGE_VERSION);
 
 	if (glsl_version_string != NULL)
 		glsl_version = parse_glsl_version_string(glsl_version_string);
 
-	check_version(glsl_version);
+	if (!report_subtests)
+		piglit_report_result(run_test_file(argc - 1, argv + 1,
+						   check_link_args[0],
+						   glsl_version));
 
-	for (i = 4; i < argc; i++) {
-		if (argv[i][0] == '!') {
-			piglit_require_not_extension(argv[i] + 1);
+	/* The GL context was created for the GLSL version of the first
+	 * shader, see PIGLIT_GL_TEST_CONFIG_BEGIN.
+	 */
+	context_version = argc > 3 && strcmp(argv[3], "--") != 0 ?
+		parse_glsl_version_number(argv[3]) : 110;
+
+	for (i = 1; i <= argc; i++) {
+		enum piglit_result subtest;
+		const char *name;
+
+		if (i < argc && strcmp(argv[i], "--") != 0)
+			continue;
+
+		if (i == start)
+			usage(argv[0]);
+
+		/* Print the name before testing, so that if the test
+		 * crashes the run can be resumed with the next shader.
+		 */
+		name = strrchr(argv[start], PIGLIT_PATH_SEP);
+		name = name ? name + 1 : argv[start];
+		printf("PIGLIT TEST: %i - %s\n", shader, name);
+		fprintf(stderr, "PIGLIT TEST: %i - %s\n", shader, name);
+
+		if (i - start > 2 &&
+		    parse_glsl_version_number(argv[start + 2]) !=
+		    context_version) {
+			printf("%s requires a different GLSL version than the "
+			       "first shader\n", name);
+			subtest = PIGLIT_FAIL;
 		} else {
-			piglit_require_extension(argv[i]);
-			if (strstr(argv[i], "geometry_shader4") != NULL)
-				test_requires_geometry_shader4 = true;
+			subtest = run_test_file(i - start, argv + start,
+						check_link_args[shader],
+						glsl_version);
 		}
+
+		piglit_report_subtest_result(subtest, "%s", name);
+		piglit_merge_result(&result, subtest);
+
+		start = i + 1;
+		shader++;
 	}
 
-	test();
+	piglit_report_result(result);
 }
 
 enum piglit_result
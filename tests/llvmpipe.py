@@ -25,7 +25,9 @@ def remove(key):
 
 # These take too long or too much memory
 remove(join('glean', 'pointAtten'))
-remove(join('glean', 'texCombine'))
+for key in list(profile.test_list.keys()):
+    if key.startswith(join('glean', 'texcombine-')):
+        remove(key)
 remove(join('spec', '!OpenGL 1.0', 'gl-1.0-blend-func'))
 remove(join('spec', '!OpenGL 1.1', 'streaming-texture-leak'))
 remove(join('spec', '!OpenGL 1.1', 'max-texture-size'))
@@ -125,6 +125,7 @@ static char *shader_string;
 static GLint shader_string_size;
 static const char *vertex_data_start = NULL;
 static const char *vertex_data_end = NULL;
+static bool vertex_data_binary_present = false;
 static GLuint prog;
 static GLuint sso_vertex_prog;
 static GLuint sso_tess_control_prog;
@@ -138,6 +139,24 @@ static bool vbo_present = false;
 static bool link_ok = false;
 static bool prog_in_use = false;
 static bool sso_in_use = false;
+
+/**
+ * Program binary cache, enabled by pointing PIGLIT_SHADER_CACHE_DIR at an
+ * existing directory.  While it is enabled, compile_glsl() only records the
+ * stage sources in cached_shaders[] and link_and_use_shaders() either
+ * restores the linked program with glProgramBinary() or compiles and links
+ * the recorded stages and stores the result.
+ */
+static const char *shader_cache_dir = NULL;
+static unsigned shader_cache_hits = 0;
+static unsigned shader_cache_misses = 0;
+static struct {
+	GLenum target;
+	char version_string[100];
+	const char *source;
+	GLint source_size;
+} cached_shaders[256];
+static unsigned num_cached_shaders = 0;
 static GLchar *prog_err_info = NULL;
 static GLuint vao = 0;
 static GLuint draw_fbo, read_fbo;
@@ -145,6 +164,8 @@ static GLint render_width, render_height;
 static GLint read_width, read_height;
 
 static bool report_subtests = false;
+static bool worker_mode = false;
+static float default_piglit_tolerance[4];
 
 static struct texture_binding {
 	GLuint obj;
@@ -202,6 +223,7 @@ enum states {
 	fragment_program,
 	compute_shader,
 	vertex_data,
+	vertex_data_binary,
 	test,
 };
 
@@ -377,11 +399,143 @@ target_to_short_name(GLenum target)
 }
 
 
+/**
+ * Whether linked GLSL programs should go through the program binary cache.
+ *
+ * Separable programs are linked stage by stage as they are parsed, so they
+ * always bypass the cache.
+ */
+static bool
+shader_cache_enabled(void)
+{
+	GLint num_formats = 0;
+
+	if (shader_cache_dir == NULL || sso_in_use)
+		return false;
+
+	if (gl_version.es) {
+		if (gl_version.num < 30)
+			return false;
+	} else {
+		if (gl_version.num < 41 &&
+		    !piglit_is_extension_supported("GL_ARB_get_program_binary"))
+			return false;
+	}
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	return num_formats > 0;
+}
+
+/**
+ * Compute the cache key of the program made of cached_shaders[].
+ *
+ * Besides the stage sources, the key covers the driver identification
+ * strings and all of the state process_shader() applies before linking.
+ */
+static uint64_t
+shader_cache_key(void)
+{
+	static const GLenum strings[] = {
+		GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION
+	};
+	const GLint link_state[] = {
+		geometry_layout_input_type,
+		geometry_layout_output_type,
+		geometry_layout_vertices_out,
+		PIGLIT_ATTRIB_POS,
+		PIGLIT_ATTRIB_TEX,
+	};
+	uint64_t key = PIGLIT_HASH_INIT;
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(strings); i++)
+		key = piglit_hash_string(key,
+					 (const char *) glGetString(strings[i]));
+
+	key = piglit_hash_update(key, link_state, sizeof(link_state));
+
+	for (i = 0; i < num_cached_shaders; i++) {
+		key = piglit_hash_update(key, &cached_shaders[i].target,
+					 sizeof(cached_shaders[i].target));
+		key = piglit_hash_string(key, cached_shaders[i].version_string);
+		key = piglit_hash_update(key, &cached_shaders[i].source_size,
+					 sizeof(cached_shaders[i].source_size));
+		key = piglit_hash_update(key, cached_shaders[i].source,
+					 cached_shaders[i].source_size);
+	}
+
+	return key;
+}
+
+/**
+ * Try to restore \p program from the cache entry \p key.
+ *
+ * Entries start with the binary format enum, followed by the program
+ * binary itself.
+ */
+static bool
+shader_cache_load(GLuint program, uint64_t key)
+{
+	size_t size;
+	char *data = piglit_cache_load(shader_cache_dir, key, &size);
+	GLenum format;
+	GLint ok = 0;
+
+	if (data == NULL)
+		return false;
+
+	if (size > sizeof(format)) {
+		memcpy(&format, data, sizeof(format));
+		piglit_phase_begin(PIGLIT_PHASE_LINK);
+		glProgramBinary(program, format, data + sizeof(format),
+				size - sizeof(format));
+		glGetProgramiv(program, GL_LINK_STATUS, &ok);
+		piglit_phase_end(PIGLIT_PHASE_LINK);
+	}
+
+	free(data);
+
+	/* A stale or rejected binary must not leave an error behind for
+	 * the test to trip over.
+	 */
+	if (!ok) {
+		while (glGetError() != GL_NO_ERROR)
+			;
+	}
+
+	return ok;
+}
+
+static void
+shader_cache_store(GLuint program, uint64_t key)
+{
+	GLint length = 0;
+	GLenum format;
+	char *data;
+
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	data = malloc(sizeof(format) + length);
+	glGetProgramBinary(program, length, &length, &format,
+			   data + sizeof(format));
+	if (glGetError() == GL_NO_ERROR) {
+		memcpy(data, &format, sizeof(format));
+		piglit_cache_store(shader_cache_dir, key, data,
+				   sizeof(format) + length);
+	}
+	free(data);
+}
+
+static enum piglit_result
+compile_glsl_source(GLenum target, const char *version_string,
+		    const char *source, GLint source_size);
+
 static enum piglit_result
 compile_glsl(GLenum target)
 {
-	GLuint shader = glCreateShader(target);
-	GLint ok;
+	char version_string[100];
 
 	switch (target) {
 	case GL_VERTEX_SHADER:
@@ -423,21 +577,52 @@ compile_glsl(GLenum target)
 		return PIGLIT_FAIL;
 	}
 
+	/* Add a #version directive based on the GLSL requirement. */
+	version_string[0] = '\0';
 	if (!strstr(shader_string, "#version ")) {
-		char *shader_strings[2];
-		char version_string[100];
-		GLint shader_string_sizes[2];
-
-		/* Add a #version directive based on the GLSL requirement. */
 		sprintf(version_string, "#version %d", glsl_req_version.num);
 		if (glsl_req_version.es && glsl_req_version.num != 100) {
 			strcat(version_string, " es");
 		}
 		strcat(version_string, "\n");
+	}
+
+	if (shader_cache_enabled() &&
+	    num_cached_shaders < ARRAY_SIZE(cached_shaders)) {
+		cached_shaders[num_cached_shaders].target = target;
+		strcpy(cached_shaders[num_cached_shaders].version_string,
+		       version_string);
+		cached_shaders[num_cached_shaders].source = shader_string;
+		cached_shaders[num_cached_shaders].source_size =
+			shader_string_size;
+		num_cached_shaders++;
+		return PIGLIT_PASS;
+	}
+
+	return compile_glsl_source(target, version_string, shader_string,
+				   shader_string_size);
+}
+
+/**
+ * Compile a single shader stage and add it to the list of shaders to be
+ * attached to the program.  \p version_string is prepended to the source
+ * unless it is empty.
+ */
+static enum piglit_result
+compile_glsl_source(GLenum target, const char *version_string,
+		    const char *source, GLint source_size)
+{
+	GLuint shader = glCreateShader(target);
+	GLint ok;
+
+	if (version_string[0] != '\0') {
+		const char *shader_strings[2];
+		GLint shader_string_sizes[2];
+
 		shader_strings[0] = version_string;
 		shader_string_sizes[0] = strlen(version_string);
-		shader_strings[1] = shader_string;
-		shader_string_sizes[1] = shader_string_size;
+		shader_strings[1] = source;
+		shader_string_sizes[1] = source_size;
 
 		glShaderSource(shader, 2,
 				    (const GLchar **) shader_strings,
@@ -445,13 +630,14 @@ compile_glsl(GLenum target)
 
 	} else {
 		glShaderSource(shader, 1,
-				    (const GLchar **) &shader_string,
-				    &shader_string_size);
+				    (const GLchar **) &source,
+				    &source_size);
 	}
 
+	piglit_phase_begin(PIGLIT_PHASE_COMPILE);
 	glCompileShader(shader);
-
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	piglit_phase_end(PIGLIT_PHASE_COMPILE);
 
 	if (!ok) {
 		GLchar *info;
@@ -534,9 +720,10 @@ link_sso(GLenum target)
 {
 	GLint ok;
 
+	piglit_phase_begin(PIGLIT_PHASE_LINK);
 	glLinkProgram(prog);
-
 	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+	piglit_phase_end(PIGLIT_PHASE_LINK);
 	if (ok) {
 		link_ok = true;
 	} else {
@@ -941,6 +1128,7 @@ leave_state(enum states state, const char *line)
 		return compile_glsl(GL_COMPUTE_SHADER);
 
 	case vertex_data:
+	case vertex_data_binary:
 		vertex_data_end = line;
 		break;
 
@@ -1002,10 +1190,52 @@ static enum piglit_result
 link_and_use_shaders(void)
 {
 	enum piglit_result result;
+	uint64_t cache_key = 0;
+	bool cache_miss = false;
 	unsigned i;
 	GLenum err;
 	GLint ok;
 
+	if (num_cached_shaders != 0) {
+		cache_key = shader_cache_key();
+		prog = glCreateProgram();
+
+		if (shader_cache_load(prog, cache_key)) {
+			shader_cache_hits++;
+			printf("Shader cache hit (%u hits, %u misses)\n",
+			       shader_cache_hits, shader_cache_misses);
+			num_cached_shaders = 0;
+			link_ok = true;
+			glUseProgram(prog);
+			result = PIGLIT_PASS;
+			goto check_in_use;
+		}
+
+		shader_cache_misses++;
+		printf("Shader cache miss (%u hits, %u misses)\n",
+		       shader_cache_hits, shader_cache_misses);
+
+		/* Fall back to compiling the recorded stages. */
+		for (i = 0; i < num_cached_shaders; i++) {
+			result = compile_glsl_source(cached_shaders[i].target,
+						     cached_shaders[i].version_string,
+						     cached_shaders[i].source,
+						     cached_shaders[i].source_size);
+			if (result != PIGLIT_PASS)
+				break;
+		}
+		num_cached_shaders = 0;
+		if (result != PIGLIT_PASS) {
+			glDeleteProgram(prog);
+			prog = 0;
+			goto cleanup;
+		}
+
+		glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+				    GL_TRUE);
+		cache_miss = true;
+	}
+
 	if ((num_vertex_shaders == 0)
 	    && (num_fragment_shaders == 0)
 	    && (num_tess_ctrl_shaders == 0)
@@ -1014,7 +1244,7 @@ link_and_use_shaders(void)
 	    && (num_compute_shaders == 0))
 		return PIGLIT_PASS;
 
-	if (!sso_in_use)
+	if (!sso_in_use && !cache_miss)
 		prog = glCreateProgram();
 
 	result = process_shader(GL_VERTEX_SHADER, num_vertex_shaders, vertex_shaders);
@@ -1036,13 +1266,15 @@ link_and_use_shaders(void)
 	if (result != PIGLIT_PASS)
 		goto cleanup;
 
-	if (!sso_in_use)
-		glLinkProgram(prog);
-
 	if (!sso_in_use) {
+		piglit_phase_begin(PIGLIT_PHASE_LINK);
+		glLinkProgram(prog);
 		glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+		piglit_phase_end(PIGLIT_PHASE_LINK);
 		if (ok) {
 			link_ok = true;
+			if (cache_miss)
+				shader_cache_store(prog, cache_key);
 		} else {
 			GLint size;
 
@@ -1058,6 +1290,7 @@ link_and_use_shaders(void)
 		glUseProgram(prog);
 	}
 
+check_in_use:
 	err = glGetError();
 	if (!err) {
 		prog_in_use = true;
@@ -1165,6 +1398,11 @@ process_test_script(const char *script_name)
 			} else if (parse_str(line, "[vertex data]", NULL)) {
 				state = vertex_data;
 				vertex_data_start = NULL;
+				vertex_data_binary_present = false;
+			} else if (parse_str(line, "[vertex data binary]", NULL)) {
+				state = vertex_data_binary;
+				vertex_data_start = NULL;
+				vertex_data_binary_present = true;
 			} else if (parse_str(line, "[test]", NULL)) {
 				test_start = strchrnul(line, '\n');
 				test_start_line_num = line_num + 1;
@@ -1206,6 +1444,7 @@ process_test_script(const char *script_name)
 				break;
 
 			case vertex_data:
+			case vertex_data_binary:
 				if (vertex_data_start == NULL)
 					vertex_data_start = line;
 				break;
@@ -2801,11 +3040,516 @@ probe_ssbo_uint(GLint ssbo_index, GLint ssbo_offset, const char *op, uint32_t va
 	return true;
 }
 
+/**
+ * Opcodes of the commands understood in the [test] section.
+ *
+ * The section is lexed once per test script by lex_test_section(), so
+ * that piglit_display() doesn't have to match every line against the
+ * whole command grammar each time it is run.
+ */
+enum test_opcode {
+	OP_SKIP,
+	OP_UNKNOWN,
+	OP_ACTIVE_SHADER_PROGRAM,
+	OP_ATOMIC_COUNTER_BUFFER,
+	OP_ATOMIC_COUNTERS,
+	OP_ATOMIC_COUNTER,
+	OP_CLEAR_COLOR,
+	OP_CLEAR_DEPTH,
+	OP_CLEAR,
+	OP_CLIP_PLANE,
+	OP_COMPUTE,
+	OP_COMPUTE_GROUP_SIZE,
+	OP_DRAW_RECT_TEX,
+	OP_DRAW_RECT_ORTHO_PATCH,
+	OP_DRAW_RECT_ORTHO,
+	OP_DRAW_RECT_PATCH,
+	OP_DRAW_RECT,
+	OP_DRAW_INSTANCED_RECT,
+	OP_DRAW_ARRAYS,
+	OP_DISABLE,
+	OP_ENABLE,
+	OP_DEPTHFUNC,
+	OP_FB,
+	OP_BLIT,
+	OP_FRUSTUM,
+	OP_HINT,
+	OP_IMAGE_TEXTURE,
+	OP_MEMORY_BARRIER,
+	OP_BLEND_BARRIER,
+	OP_ORTHO_PARAMS,
+	OP_ORTHO,
+	OP_PROBE_RGBA,
+	OP_PROBE_DEPTH,
+	OP_PROBE_ATOMIC_COUNTER,
+	OP_PROBE_SSBO_UINT,
+	OP_RELATIVE_PROBE_RGBA,
+	OP_PROBE_RGB,
+	OP_RELATIVE_PROBE_RGB,
+	OP_PROBE_RECT_RGBA,
+	OP_RELATIVE_PROBE_RECT_RGB,
+	OP_RELATIVE_PROBE_RECT_RGBA_INT,
+	OP_PROBE_ALL_RGBA,
+	OP_PROBE_WARN_ALL_RGBA,
+	OP_PROBE_ALL_RGB,
+	OP_TOLERANCE,
+	OP_SHADE_MODEL_SMOOTH,
+	OP_SHADE_MODEL_FLAT,
+	OP_SSBO,
+	OP_SSBO_SUBDATA_FLOAT,
+	OP_TEXTURE_RGBW,
+	OP_TEXTURE_INTEGER,
+	OP_TEXTURE_MIPTREE,
+	OP_TEXTURE_CHECKERBOARD,
+	OP_TEXTURE_QUADS,
+	OP_TEXTURE_JUNK_2D_ARRAY,
+	OP_TEXTURE_STORAGE,
+	OP_TEXTURE_RGBW_2D_ARRAY,
+	OP_TEXTURE_RGBW_1D_ARRAY,
+	OP_TEXTURE_SHADOW_2D,
+	OP_TEXTURE_SHADOW_RECT,
+	OP_TEXTURE_SHADOW_1D,
+	OP_TEXTURE_SHADOW_1D_ARRAY,
+	OP_TEXTURE_SHADOW_2D_ARRAY,
+	OP_TEXCOORD,
+	OP_TEXPARAMETER,
+	OP_UNIFORM,
+	OP_SUBUNIFORM,
+	OP_PARAMETER,
+	OP_PATCH_PARAMETER,
+	OP_PROVOKING_VERTEX,
+	OP_LINK_ERROR,
+	OP_LINK_SUCCESS,
+	OP_UBO_ARRAY_INDEX,
+	OP_ACTIVE_UNIFORM,
+	OP_VERIFY_PROGRAM_INTERFACE_QUERY,
+};
+
+/**
+ * One pre-parsed line of the [test] section.
+ *
+ * Fixed-format commands have their operands stored in \c i, \c u, \c f,
+ * \c d and \c s.  Commands with a richer sub-grammar (uniforms, fb
+ * bindings, texture storage, ...) keep the text following the command
+ * keyword in \c rest and finish parsing it when executed.
+ */
+struct test_command {
+	enum test_opcode op;
+	unsigned line_num;
+	const char *line;
+	const char *rest;
+	int i[6];
+	unsigned u[2];
+	float f[16];
+	double d[4];
+	char s[32];
+};
+
+static char *test_text = NULL;
+static struct test_command *test_commands = NULL;
+static unsigned num_test_commands = 0;
+
+static void
+free_test_commands(void)
+{
+	free(test_commands);
+	free(test_text);
+	test_commands = NULL;
+	test_text = NULL;
+	num_test_commands = 0;
+}
+
+/**
+ * Match a single [test] line against the command grammar.
+ *
+ * The order of the tests below matters, since several commands are
+ * prefixes of others (e.g. "draw rect" and "draw rect tex").
+ */
+static void
+lex_test_command(const char *line, struct test_command *cmd)
+{
+	int *i = cmd->i;
+	float *c = cmd->f;
+	double *d = cmd->d;
+	char *s = cmd->s;
+	const char *rest = NULL;
+
+	cmd->op = OP_UNKNOWN;
+
+	if (line[0] == '\0' || line[0] == '\n' || line[0] == '#') {
+		cmd->op = OP_SKIP;
+	} else if (sscanf(line, "active shader program %31s", s) == 1) {
+		cmd->op = OP_ACTIVE_SHADER_PROGRAM;
+	} else if (sscanf(line, "atomic counter buffer %u %u",
+			  &i[0], &i[1]) == 2) {
+		cmd->op = OP_ATOMIC_COUNTER_BUFFER;
+	} else if (sscanf(line, "atomic counters %d", &i[0]) == 1) {
+		cmd->op = OP_ATOMIC_COUNTERS;
+	} else if (sscanf(line, "atomic counter %u %u %u",
+			  &i[0], &i[1], &i[2]) == 3) {
+		cmd->op = OP_ATOMIC_COUNTER;
+	} else if (parse_str(line, "clear color ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_CLEAR_COLOR;
+	} else if (parse_str(line, "clear depth ", &rest)) {
+		parse_floats(rest, c, 1, NULL);
+		cmd->op = OP_CLEAR_DEPTH;
+	} else if (parse_str(line, "clear", NULL)) {
+		cmd->op = OP_CLEAR;
+	} else if (sscanf(line,
+			  "clip plane %d %lf %lf %lf %lf",
+			  &i[0], &d[0], &d[1], &d[2], &d[3]) == 5) {
+		cmd->op = OP_CLIP_PLANE;
+	} else if (sscanf(line,
+			  "compute %d %d %d",
+			  &i[0], &i[1], &i[2]) == 3) {
+		cmd->op = OP_COMPUTE;
+	} else if (sscanf(line,
+			  "compute group size %d %d %d %d %d %d",
+			  &i[0], &i[1], &i[2], &i[3], &i[4], &i[5]) == 6) {
+		cmd->op = OP_COMPUTE_GROUP_SIZE;
+	} else if (parse_str(line, "draw rect tex ", &rest)) {
+		parse_floats(rest, c, 8, NULL);
+		cmd->op = OP_DRAW_RECT_TEX;
+	} else if (parse_str(line, "draw rect ortho patch ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT_ORTHO_PATCH;
+	} else if (parse_str(line, "draw rect ortho ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT_ORTHO;
+	} else if (parse_str(line, "draw rect patch ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT_PATCH;
+	} else if (parse_str(line, "draw rect ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_DRAW_RECT;
+	} else if (parse_str(line, "draw instanced rect ", &rest)) {
+		sscanf(rest, "%d %f %f %f %f",
+		       &i[0], c + 0, c + 1, c + 2, c + 3);
+		cmd->op = OP_DRAW_INSTANCED_RECT;
+	} else if (sscanf(line, "draw arrays %31s %d %d",
+			  s, &i[0], &i[1]) == 3) {
+		cmd->op = OP_DRAW_ARRAYS;
+	} else if (parse_str(line, "disable ", &rest)) {
+		cmd->op = OP_DISABLE;
+	} else if (parse_str(line, "enable ", &rest)) {
+		cmd->op = OP_ENABLE;
+	} else if (sscanf(line, "depthfunc %31s", s) == 1) {
+		cmd->op = OP_DEPTHFUNC;
+	} else if (parse_str(line, "fb ", &rest)) {
+		cmd->op = OP_FB;
+	} else if (parse_str(line, "blit ", &rest)) {
+		cmd->op = OP_BLIT;
+	} else if (parse_str(line, "frustum", &rest)) {
+		parse_floats(rest, c, 6, NULL);
+		cmd->op = OP_FRUSTUM;
+	} else if (parse_str(line, "hint", &rest)) {
+		cmd->op = OP_HINT;
+	} else if (sscanf(line,
+			  "image texture %d %31s",
+			  &i[0], s) == 2) {
+		cmd->op = OP_IMAGE_TEXTURE;
+	} else if (sscanf(line, "memory barrier %31s", s) == 1) {
+		cmd->op = OP_MEMORY_BARRIER;
+	} else if (parse_str(line, "blend barrier", NULL)) {
+		cmd->op = OP_BLEND_BARRIER;
+	} else if (sscanf(line, "ortho %f %f %f %f",
+			  c + 0, c + 1, c + 2, c + 3) == 4) {
+		cmd->op = OP_ORTHO_PARAMS;
+	} else if (parse_str(line, "ortho", NULL)) {
+		cmd->op = OP_ORTHO;
+	} else if (parse_str(line, "probe rgba ", &rest)) {
+		parse_floats(rest, c, 6, NULL);
+		cmd->op = OP_PROBE_RGBA;
+	} else if (parse_str(line, "probe depth ", &rest)) {
+		parse_floats(rest, c, 3, NULL);
+		cmd->op = OP_PROBE_DEPTH;
+	} else if (sscanf(line,
+			  "probe atomic counter %u %31s %u",
+			  &cmd->u[0], s, &cmd->u[1]) == 3) {
+		cmd->op = OP_PROBE_ATOMIC_COUNTER;
+	} else if (sscanf(line, "probe ssbo uint %d %d %31s 0x%x",
+			  &i[0], &i[1], s, &i[2]) == 4) {
+		cmd->op = OP_PROBE_SSBO_UINT;
+	} else if (sscanf(line, "probe ssbo uint %d %d %31s %d",
+			  &i[0], &i[1], s, &i[2]) == 4) {
+		cmd->op = OP_PROBE_SSBO_UINT;
+	} else if (sscanf(line,
+			  "relative probe rgba ( %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  c + 0, c + 1,
+			  c + 2, c + 3, c + 4, c + 5) == 6) {
+		cmd->op = OP_RELATIVE_PROBE_RGBA;
+	} else if (parse_str(line, "probe rgb ", &rest)) {
+		parse_floats(rest, c, 5, NULL);
+		cmd->op = OP_PROBE_RGB;
+	} else if (sscanf(line,
+			  "relative probe rgb ( %f , %f ) "
+			  "( %f , %f , %f )",
+			  c + 0, c + 1,
+			  c + 2, c + 3, c + 4) == 5) {
+		cmd->op = OP_RELATIVE_PROBE_RGB;
+	} else if (sscanf(line, "probe rect rgba "
+			  "( %d , %d , %d , %d ) "
+			  "( %f , %f , %f , %f )",
+			  &i[0], &i[1], &i[2], &i[3],
+			  c + 0, c + 1, c + 2, c + 3) == 8) {
+		cmd->op = OP_PROBE_RECT_RGBA;
+	} else if (sscanf(line, "relative probe rect rgb "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f )",
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6) == 7) {
+		cmd->op = OP_RELATIVE_PROBE_RECT_RGB;
+	} else if (sscanf(line, "relative probe rect rgba int "
+			  "( %f , %f , %f , %f ) "
+			  "( %d , %d , %d , %d )",
+			  c + 0, c + 1, c + 2, c + 3,
+			  &i[0], &i[1], &i[2], &i[3]) == 8) {
+		cmd->op = OP_RELATIVE_PROBE_RECT_RGBA_INT;
+	} else if (parse_str(line, "probe all rgba ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_PROBE_ALL_RGBA;
+	} else if (parse_str(line, "probe warn all rgba ", &rest)) {
+		parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_PROBE_WARN_ALL_RGBA;
+	} else if (parse_str(line, "probe all rgb", &rest)) {
+		parse_floats(rest, c, 3, NULL);
+		cmd->op = OP_PROBE_ALL_RGB;
+	} else if (parse_str(line, "tolerance", &rest)) {
+		i[0] = parse_floats(rest, c, 4, NULL);
+		cmd->op = OP_TOLERANCE;
+	} else if (parse_str(line, "shade model smooth", NULL)) {
+		cmd->op = OP_SHADE_MODEL_SMOOTH;
+	} else if (parse_str(line, "shade model flat", NULL)) {
+		cmd->op = OP_SHADE_MODEL_FLAT;
+	} else if (sscanf(line, "ssbo %d %d", &i[0], &i[1]) == 2) {
+		cmd->op = OP_SSBO;
+	} else if (sscanf(line, "ssbo %d subdata float %d %f",
+			  &i[0], &i[1], &c[0]) == 3) {
+		cmd->op = OP_SSBO_SUBDATA_FLOAT;
+	} else if (sscanf(line, "texture rgbw %d ( %d", &i[0], &i[1]) == 2) {
+		i[3] = sscanf(line,
+			      "texture rgbw %d ( %d , %d ) %31s",
+			      &i[0], &i[1], &i[2], s);
+		cmd->op = OP_TEXTURE_RGBW;
+	} else if (parse_str(line, "texture integer ", &rest)) {
+		i[5] = sscanf(rest, "%d ( %d , %d ) ( %d, %d ) %31s",
+			      &i[0], &i[1], &i[2], &i[3], &i[4], s);
+		cmd->op = OP_TEXTURE_INTEGER;
+	} else if (sscanf(line, "texture miptree %d", &i[0]) == 1) {
+		cmd->op = OP_TEXTURE_MIPTREE;
+	} else if (sscanf(line,
+			  "texture checkerboard %d %d ( %d , %d ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  &i[0], &i[1], &i[2], &i[3],
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6, c + 7) == 12) {
+		cmd->op = OP_TEXTURE_CHECKERBOARD;
+	} else if (sscanf(line,
+			  "texture quads %d %d ( %d , %d ) ( %d , %d ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f ) "
+			  "( %f , %f , %f , %f )",
+			  &i[0], &i[1], &i[2], &i[3], &i[4], &i[5],
+			  c + 0, c + 1, c + 2, c + 3,
+			  c + 4, c + 5, c + 6, c + 7,
+			  c + 8, c + 9, c + 10, c + 11,
+			  c + 12, c + 13, c + 14, c + 15) == 22) {
+		cmd->op = OP_TEXTURE_QUADS;
+	} else if (sscanf(line,
+			  "texture junk 2DArray %d ( %d , %d , %d )",
+			  &i[0], &i[1], &i[2], &i[3]) == 4) {
+		cmd->op = OP_TEXTURE_JUNK_2D_ARRAY;
+	} else if (parse_str(line, "texture storage ", &rest)) {
+		cmd->op = OP_TEXTURE_STORAGE;
+	} else if (sscanf(line,
+			  "texture rgbw 2DArray %d ( %d , %d , %d )",
+			  &i[0], &i[1], &i[2], &i[3]) == 4) {
+		cmd->op = OP_TEXTURE_RGBW_2D_ARRAY;
+	} else if (sscanf(line,
+			  "texture rgbw 1DArray %d ( %d , %d )",
+			  &i[0], &i[1], &i[2]) == 3) {
+		cmd->op = OP_TEXTURE_RGBW_1D_ARRAY;
+	} else if (sscanf(line,
+			  "texture shadow2D %d ( %d , %d )",
+			  &i[0], &i[1], &i[2]) == 3) {
+		cmd->op = OP_TEXTURE_SHADOW_2D;
+	} else if (sscanf(line,
+			  "texture shadowRect %d ( %d , %d )",
+			  &i[0], &i[1], &i[2]) == 3) {
+		cmd->op = OP_TEXTURE_SHADOW_RECT;
+	} else if (sscanf(line,
+			  "texture shadow1D %d ( %d )",
+			  &i[0], &i[1]) == 2) {
+		cmd->op = OP_TEXTURE_SHADOW_1D;
+	} else if (sscanf(line,
+			  "texture shadow1DArray %d ( %d , %d )",
+			  &i[0], &i[1], &i[2]) == 3) {
+		cmd->op = OP_TEXTURE_SHADOW_1D_ARRAY;
+	} else if (sscanf(line,
+			  "texture shadow2DArray %d ( %d , %d , %d )",
+			  &i[0], &i[1], &i[2], &i[3]) == 4) {
+		cmd->op = OP_TEXTURE_SHADOW_2D_ARRAY;
+	} else if (sscanf(line, "texcoord %d ( %f , %f , %f , %f )",
+			  &i[0], c + 0, c + 1, c + 2, c + 3) == 5) {
+		cmd->op = OP_TEXCOORD;
+	} else if (parse_str(line, "texparameter ", &rest)) {
+		cmd->op = OP_TEXPARAMETER;
+	} else if (parse_str(line, "uniform ", &rest)) {
+		cmd->op = OP_UNIFORM;
+	} else if (parse_str(line, "subuniform ", &rest)) {
+		cmd->op = OP_SUBUNIFORM;
+	} else if (parse_str(line, "parameter ", &rest)) {
+		cmd->op = OP_PARAMETER;
+	} else if (parse_str(line, "patch parameter ", &rest)) {
+		cmd->op = OP_PATCH_PARAMETER;
+	} else if (parse_str(line, "provoking vertex ", &rest)) {
+		cmd->op = OP_PROVOKING_VERTEX;
+	} else if (parse_str(line, "link error", &rest)) {
+		cmd->op = OP_LINK_ERROR;
+	} else if (parse_str(line, "link success", &rest)) {
+		cmd->op = OP_LINK_SUCCESS;
+	} else if (parse_str(line, "ubo array index ", &rest)) {
+		parse_ints(rest, &i[0], 1, NULL);
+		cmd->op = OP_UBO_ARRAY_INDEX;
+	} else if (parse_str(line, "active uniform ", &rest)) {
+		cmd->op = OP_ACTIVE_UNIFORM;
+	} else if (parse_str(line, "verify program_interface_query ", &rest)) {
+		cmd->op = OP_VERIFY_PROGRAM_INTERFACE_QUERY;
+	}
+
+	cmd->rest = rest;
+}
+
+/**
+ * Split the [test] section into lines and lex each of them into
+ * test_commands.  The text is copied once so that every command line
+ * is null terminated without a per-line allocation.
+ */
+static void
+lex_test_section(void)
+{
+	const char *end = test_start + strlen(test_start);
+	unsigned line_num = test_start_line_num;
+	unsigned max_commands = 1;
+	const char *p;
+	char *line;
+
+	free_test_commands();
+
+	for (p = test_start; p < end; p++) {
+		if (*p == '\n')
+			max_commands++;
+	}
+
+	test_text = strndup(test_start, end - test_start);
+	test_commands = calloc(max_commands, sizeof(*test_commands));
+	if (test_text == NULL || test_commands == NULL) {
+		fprintf(stderr, "%s: out of memory\n", __func__);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	line = test_text;
+	while (line[0] != '\0') {
+		struct test_command *cmd = &test_commands[num_test_commands];
+		char *next_line = strchrnul(line, '\n');
+		const char *text;
+		const bool last_line = next_line[0] == '\0';
+
+		*next_line = '\0';
+		parse_whitespace(line, &text);
+
+		cmd->line = text;
+		cmd->line_num = line_num;
+		lex_test_command(text, cmd);
+		if (cmd->op != OP_SKIP)
+			num_test_commands++;
+
+		if (last_line)
+			break;
+
+		line = next_line + 1;
+		line_num++;
+	}
+}
+
+/**
+ * Whether running \p op leaves the read framebuffer untouched, so probes
+ * before and after it may share one readback.  Everything else
+ * invalidates the probe readback cache.
+ */
+static bool
+op_preserves_framebuffer(enum test_opcode op)
+{
+	switch (op) {
+	case OP_SKIP:
+	case OP_TOLERANCE:
+	case OP_PROBE_RGBA:
+	case OP_PROBE_DEPTH:
+	case OP_RELATIVE_PROBE_RGBA:
+	case OP_PROBE_RGB:
+	case OP_RELATIVE_PROBE_RGB:
+	case OP_PROBE_RECT_RGBA:
+	case OP_RELATIVE_PROBE_RECT_RGB:
+	case OP_RELATIVE_PROBE_RECT_RGBA_INT:
+	case OP_PROBE_ALL_RGBA:
+	case OP_PROBE_WARN_ALL_RGBA:
+	case OP_PROBE_ALL_RGB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * The phase \p op is timed as, if it draws or probes.  Everything else is
+ * timed as part of the phase piglit_display() runs in.
+ */
+static bool
+op_phase(enum test_opcode op, enum piglit_phase *phase)
+{
+	switch (op) {
+	case OP_CLEAR:
+	case OP_COMPUTE:
+	case OP_COMPUTE_GROUP_SIZE:
+	case OP_DRAW_RECT_TEX:
+	case OP_DRAW_RECT_ORTHO_PATCH:
+	case OP_DRAW_RECT_ORTHO:
+	case OP_DRAW_RECT_PATCH:
+	case OP_DRAW_RECT:
+	case OP_DRAW_INSTANCED_RECT:
+	case OP_DRAW_ARRAYS:
+	case OP_BLIT:
+		*phase = PIGLIT_PHASE_DRAW;
+		return true;
+	case OP_PROBE_RGBA:
+	case OP_PROBE_DEPTH:
+	case OP_PROBE_ATOMIC_COUNTER:
+	case OP_PROBE_SSBO_UINT:
+	case OP_RELATIVE_PROBE_RGBA:
+	case OP_PROBE_RGB:
+	case OP_RELATIVE_PROBE_RGB:
+	case OP_PROBE_RECT_RGBA:
+	case OP_RELATIVE_PROBE_RECT_RGB:
+	case OP_RELATIVE_PROBE_RECT_RGBA_INT:
+	case OP_PROBE_ALL_RGBA:
+	case OP_PROBE_WARN_ALL_RGBA:
+	case OP_PROBE_ALL_RGB:
+		*phase = PIGLIT_PHASE_PROBE;
+		return true;
+	default:
+		return false;
+	}
+}
+
 enum piglit_result
 piglit_display(void)
 {
-	const char *line, *next_line, *rest;
-	unsigned line_num;
+	const char *line, *rest;
+	unsigned cmd_idx;
 	enum piglit_result full_result = PIGLIT_PASS;
 	GLbitfield clear_bits = 0;
 	bool link_error_expected = false;
@@ -2814,30 +3558,31 @@ piglit_display(void)
 	if (test_start == NULL)
 		return PIGLIT_PASS;
 
-	next_line = test_start;
-	line_num = test_start_line_num;
-	while (next_line[0] != '\0') {
-		float c[32];
-		double d[4];
-		int x, y, z, w, h, l, tex, level;
-		unsigned ux, uy;
-		char s[32];
-		enum piglit_result result = PIGLIT_PASS;
+	piglit_probe_cache_enable(true);
 
-		parse_whitespace(next_line, &line);
+	for (cmd_idx = 0; cmd_idx < num_test_commands; cmd_idx++) {
+		struct test_command *cmd = &test_commands[cmd_idx];
+		const int *i = cmd->i;
+		float *c = cmd->f;
+		int x, y, z, w, h, l, tex;
+		enum piglit_result result = PIGLIT_PASS;
+		enum piglit_phase phase;
+		bool timed = op_phase(cmd->op, &phase);
 
-		next_line = strchrnul(next_line, '\n');
+		line = cmd->line;
+		rest = cmd->rest;
 
-		/* Duplicate the line to make it null terminated */
-		line = strndup(line, next_line - line);
+		if (!op_preserves_framebuffer(cmd->op))
+			piglit_probe_cache_invalidate();
 
-		/* If strchrnul found a newline, then skip it */
-		if (next_line[0] != '\0')
-			next_line++;
+		if (timed)
+			piglit_phase_begin(phase);
 
-		if (line[0] == '\0') {
-		} else if (sscanf(line, "active shader program %s", s) == 1) {
-			switch (get_shader_from_string(s, &x)) {
+		switch (cmd->op) {
+		case OP_SKIP:
+			break;
+		case OP_ACTIVE_SHADER_PROGRAM:
+			switch (get_shader_from_string(cmd->s, &x)) {
 			case GL_VERTEX_SHADER:
 				glActiveShaderProgram(pipeline, sso_vertex_prog);
 			break;
@@ -2857,103 +3602,105 @@ piglit_display(void)
 				glActiveShaderProgram(pipeline, sso_compute_prog);
 			break;
 			}
-		} else if (sscanf(line, "atomic counter buffer %u %u", &x, &y) == 2) {
-			GLuint *atomics_buf = calloc(y, sizeof(GLuint));
-			glGenBuffers(1, &atomics_bos[x]);
-			glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, x, atomics_bos[x]);
+			break;
+		case OP_ATOMIC_COUNTER_BUFFER: {
+			GLuint *atomics_buf = calloc(i[1], sizeof(GLuint));
+			glGenBuffers(1, &atomics_bos[i[0]]);
+			glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, i[0],
+					 atomics_bos[i[0]]);
 			glBufferData(GL_ATOMIC_COUNTER_BUFFER,
-				     sizeof(GLuint) * y, atomics_buf,
+				     sizeof(GLuint) * i[1], atomics_buf,
 				     GL_STATIC_DRAW);
 			free(atomics_buf);
-		} else if (sscanf(line, "atomic counters %d", &x) == 1) {
-			GLuint *atomics_buf = calloc(x, sizeof(GLuint));
+			break;
+		}
+		case OP_ATOMIC_COUNTERS: {
+			GLuint *atomics_buf = calloc(i[0], sizeof(GLuint));
 			glGenBuffers(1, &atomics_bos[0]);
 			glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, atomics_bos[0]);
 			glBufferData(GL_ATOMIC_COUNTER_BUFFER,
-				     sizeof(GLuint) * x,
+				     sizeof(GLuint) * i[0],
 				     atomics_buf, GL_STATIC_DRAW);
 			free(atomics_buf);
-		} else if (sscanf(line, "atomic counter %u %u %u", &x, &y, &z) == 3) {
-			glNamedBufferSubData(atomics_bos[x],
-					     sizeof(GLuint) * y, sizeof(GLuint),
-					     &z);
-		} else if (parse_str(line, "clear color ", &rest)) {
-			parse_floats(rest, c, 4, NULL);
+			break;
+		}
+		case OP_ATOMIC_COUNTER:
+			glNamedBufferSubData(atomics_bos[i[0]],
+					     sizeof(GLuint) * i[1], sizeof(GLuint),
+					     &i[2]);
+			break;
+		case OP_CLEAR_COLOR:
 			glClearColor(c[0], c[1], c[2], c[3]);
 			clear_bits |= GL_COLOR_BUFFER_BIT;
-		} else if (parse_str(line, "clear depth ", &rest)) {
-			parse_floats(rest, c, 1, NULL);
+			break;
+		case OP_CLEAR_DEPTH:
 			glClearDepth(c[0]);
 			clear_bits |= GL_DEPTH_BUFFER_BIT;
-		} else if (parse_str(line, "clear", NULL)) {
+			break;
+		case OP_CLEAR:
 			glClear(clear_bits);
-		} else if (sscanf(line,
-				  "clip plane %d %lf %lf %lf %lf",
-				  &x, &d[0], &d[1], &d[2], &d[3]) == 5) {
-			if (x < 0 || x >= gl_max_clip_planes) {
-				printf("clip plane id %d out of range\n", x);
+			break;
+		case OP_CLIP_PLANE:
+			if (i[0] < 0 || i[0] >= gl_max_clip_planes) {
+				printf("clip plane id %d out of range\n", i[0]);
 				piglit_report_result(PIGLIT_FAIL);
 			}
-			glClipPlane(GL_CLIP_PLANE0 + x, d);
-		} else if (sscanf(line,
-				  "compute %d %d %d",
-				  &x, &y, &z) == 3) {
+			glClipPlane(GL_CLIP_PLANE0 + i[0], cmd->d);
+			break;
+		case OP_COMPUTE:
 			result = program_must_be_in_use();
 			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-			glDispatchCompute(x, y, z);
+			glDispatchCompute(i[0], i[1], i[2]);
 			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-		} else if (sscanf(line,
-				  "compute group size %d %d %d %d %d %d",
-				  &x, &y, &z, &w, &h, &l) == 6) {
+			break;
+		case OP_COMPUTE_GROUP_SIZE:
 			result = program_must_be_in_use();
 			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-			glDispatchComputeGroupSizeARB(x, y, z, w, h, l);
+			glDispatchComputeGroupSizeARB(i[0], i[1], i[2],
+						      i[3], i[4], i[5]);
 			glMemoryBarrier(GL_ALL_BARRIER_BITS);
-		} else if (parse_str(line, "draw rect tex ", &rest)) {
+			break;
+		case OP_DRAW_RECT_TEX:
 			result = program_must_be_in_use();
 			program_subroutine_uniforms();
-			parse_floats(rest, c, 8, NULL);
 			piglit_draw_rect_tex(c[0], c[1], c[2], c[3],
 					     c[4], c[5], c[6], c[7]);
-		} else if (parse_str(line, "draw rect ortho patch ", &rest)) {
+			break;
+		case OP_DRAW_RECT_ORTHO_PATCH:
 			result = program_must_be_in_use();
 			program_subroutine_uniforms();
-			parse_floats(rest, c, 4, NULL);
 
 			piglit_draw_rect_custom(-1.0 + 2.0 * (c[0] / piglit_width),
 						-1.0 + 2.0 * (c[1] / piglit_height),
 						2.0 * (c[2] / piglit_width),
 						2.0 * (c[3] / piglit_height), true);
-		} else if (parse_str(line, "draw rect ortho ", &rest)) {
+			break;
+		case OP_DRAW_RECT_ORTHO:
 			result = program_must_be_in_use();
 			program_subroutine_uniforms();
-			parse_floats(rest, c, 4, NULL);
 
 			piglit_draw_rect(-1.0 + 2.0 * (c[0] / piglit_width),
 					 -1.0 + 2.0 * (c[1] / piglit_height),
 					 2.0 * (c[2] / piglit_width),
 					 2.0 * (c[3] / piglit_height));
-		} else if (parse_str(line, "draw rect patch ", &rest)) {
+			break;
+		case OP_DRAW_RECT_PATCH:
 			result = program_must_be_in_use();
-			parse_floats(rest, c, 4, NULL);
 			piglit_draw_rect_custom(c[0], c[1], c[2], c[3], true);
-		} else if (parse_str(line, "draw rect ", &rest)) {
+			break;
+		case OP_DRAW_RECT:
 			result = program_must_be_in_use();
 			program_subroutine_uniforms();
-			parse_floats(rest, c, 4, NULL);
 			piglit_draw_rect(c[0], c[1], c[2], c[3]);
-		} else if (parse_str(line, "draw instanced rect ", &rest)) {
-			int primcount;
-
+			break;
+		case OP_DRAW_INSTANCED_RECT:
 			result = program_must_be_in_use();
-			sscanf(rest, "%d %f %f %f %f",
-			       &primcount,
-			       c + 0, c + 1, c + 2, c + 3);
-			draw_instanced_rect(primcount, c[0], c[1], c[2], c[3]);
-		} else if (sscanf(line, "draw arrays %31s %d %d", s, &x, &y) == 3) {
-			GLenum mode = decode_drawing_mode(s);
-			int first = x;
-			size_t count = (size_t) y;
+			draw_instanced_rect(i[0], c[0], c[1], c[2], c[3]);
+			break;
+		case OP_DRAW_ARRAYS: {
+			GLenum mode = decode_drawing_mode(cmd->s);
+			int first = i[0];
+			size_t count = (size_t) i[1];
 			result = program_must_be_in_use();
 			if (first < 0) {
 				printf("draw arrays 'first' must be >= 0\n");
@@ -2975,13 +3722,18 @@ piglit_display(void)
 			}
 			bind_vao_if_supported();
 			glDrawArrays(mode, first, count);
-		} else if (parse_str(line, "disable ", &rest)) {
+			break;
+		}
+		case OP_DISABLE:
 			do_enable_disable(rest, false);
-		} else if (parse_str(line, "enable ", &rest)) {
+			break;
+		case OP_ENABLE:
 			do_enable_disable(rest, true);
-		} else if (sscanf(line, "depthfunc %31s", s) == 1) {
-			glDepthFunc(piglit_get_gl_enum_from_name(s));
-		} else if (parse_str(line, "fb ", &rest)) {
+			break;
+		case OP_DEPTHFUNC:
+			glDepthFunc(piglit_get_gl_enum_from_name(cmd->s));
+			break;
+		case OP_FB: {
 			const GLenum target =
 				parse_str(rest, "draw ", &rest) ? GL_DRAW_FRAMEBUFFER :
 				parse_str(rest, "read ", &rest) ? GL_READ_FRAMEBUFFER :
@@ -3186,8 +3938,9 @@ piglit_display(void)
 
 				read_fbo = fbo;
 			}
-
-		} else if (parse_str(line, "blit ", &rest)) {
+			break;
+		}
+		case OP_BLIT: {
 			static const struct string_to_enum buffers[] = {
 				{ "color", GL_COLOR_BUFFER_BIT },
 				{ "depth", GL_DEPTH_BUFFER_BIT },
@@ -3214,61 +3967,59 @@ piglit_display(void)
 				fprintf(stderr, "glBlitFramebuffer error\n");
 				piglit_report_result(PIGLIT_FAIL);
 			}
-
-		} else if (parse_str(line, "frustum", &rest)) {
-			parse_floats(rest, c, 6, NULL);
+			break;
+		}
+		case OP_FRUSTUM:
 			piglit_frustum_projection(false, c[0], c[1], c[2],
 						  c[3], c[4], c[5]);
-		} else if (parse_str(line, "hint", &rest)) {
+			break;
+		case OP_HINT:
 			do_hint(rest);
-		} else if (sscanf(line,
-				  "image texture %d %31s",
-				  &tex, s) == 2) {
-			const GLenum img_fmt = piglit_get_gl_enum_from_name(s);
+			break;
+		case OP_IMAGE_TEXTURE: {
+			const GLenum img_fmt = piglit_get_gl_enum_from_name(cmd->s);
+			tex = i[0];
 			glBindImageTexture(tex, get_texture_binding(tex)->obj, 0,
 					   GL_FALSE, 0, GL_READ_WRITE, img_fmt);
-		} else if (sscanf(line, "memory barrier %s", s) == 1) {
-			glMemoryBarrier(piglit_get_gl_memory_barrier_enum_from_name(s));
-		} else if (parse_str(line, "blend barrier", NULL)) {
+			break;
+		}
+		case OP_MEMORY_BARRIER:
+			glMemoryBarrier(piglit_get_gl_memory_barrier_enum_from_name(cmd->s));
+			break;
+		case OP_BLEND_BARRIER:
 			glBlendBarrier();
-		} else if (sscanf(line, "ortho %f %f %f %f",
-				  c + 0, c + 1, c + 2, c + 3) == 4) {
+			break;
+		case OP_ORTHO_PARAMS:
 			piglit_gen_ortho_projection(c[0], c[1], c[2], c[3],
 						    -1, 1, GL_FALSE);
-		} else if (parse_str(line, "ortho", NULL)) {
+			break;
+		case OP_ORTHO:
 			piglit_ortho_projection(render_width, render_height,
 						GL_FALSE);
-		} else if (parse_str(line, "probe rgba ", &rest)) {
-			parse_floats(rest, c, 6, NULL);
+			break;
+		case OP_PROBE_RGBA:
 			if (!piglit_probe_pixel_rgba((int) c[0], (int) c[1],
 						    & c[2])) {
 				result = PIGLIT_FAIL;
 			}
-		} else if (parse_str(line, "probe depth ", &rest)) {
-			parse_floats(rest, c, 3, NULL);
+			break;
+		case OP_PROBE_DEPTH:
 			if (!piglit_probe_pixel_depth((int) c[0], (int) c[1],
 						      c[2])) {
 				result = PIGLIT_FAIL;
 			}
-		} else if (sscanf(line,
-				  "probe atomic counter %u %s %u",
-				  &ux, s, &uy) == 3) {
-			if (!probe_atomic_counter(0, ux, s, uy)) {
+			break;
+		case OP_PROBE_ATOMIC_COUNTER:
+			if (!probe_atomic_counter(0, cmd->u[0], cmd->s,
+						  cmd->u[1])) {
 				piglit_report_result(PIGLIT_FAIL);
 			}
-		} else if (sscanf(line, "probe ssbo uint %d %d %s 0x%x",
-				  &x, &y, s, &z) == 4) {
-			if (!probe_ssbo_uint(x, y, s, z))
-				result = PIGLIT_FAIL;
-		} else if (sscanf(line, "probe ssbo uint %d %d %s %d",
-				  &x, &y, s, &z) == 4) {
-			if (!probe_ssbo_uint(x, y, s, z))
+			break;
+		case OP_PROBE_SSBO_UINT:
+			if (!probe_ssbo_uint(i[0], i[1], cmd->s, i[2]))
 				result = PIGLIT_FAIL;
-		} else if (sscanf(line,
-				  "relative probe rgba ( %f , %f ) "
-				  "( %f , %f , %f , %f )",
-				  c + 0, c + 1,
-				  c + 2, c + 3, c + 4, c + 5) == 6) {
+			break;
+		case OP_RELATIVE_PROBE_RGBA:
 			x = c[0] * read_width;
 			y = c[1] * read_height;
 			if (x >= read_width)
@@ -3279,17 +4030,14 @@ piglit_display(void)
 			if (!piglit_probe_pixel_rgba(x, y, &c[2])) {
 				result = PIGLIT_FAIL;
 			}
-		} else if (parse_str(line, "probe rgb ", &rest)) {
-			parse_floats(rest, c, 5, NULL);
+			break;
+		case OP_PROBE_RGB:
 			if (!piglit_probe_pixel_rgb((int) c[0], (int) c[1],
 						    & c[2])) {
 				result = PIGLIT_FAIL;
 			}
-		} else if (sscanf(line,
-				  "relative probe rgb ( %f , %f ) "
-				  "( %f , %f , %f )",
-				  c + 0, c + 1,
-				  c + 2, c + 3, c + 4) == 5) {
+			break;
+		case OP_RELATIVE_PROBE_RGB:
 			x = c[0] * read_width;
 			y = c[1] * read_height;
 			if (x >= read_width)
@@ -3300,19 +4048,13 @@ piglit_display(void)
 			if (!piglit_probe_pixel_rgb(x, y, &c[2])) {
 				result = PIGLIT_FAIL;
 			}
-		} else if (sscanf(line, "probe rect rgba "
-				  "( %d , %d , %d , %d ) "
-				  "( %f , %f , %f , %f )",
-				  &x, &y, &w, &h,
-				  c + 0, c + 1, c + 2, c + 3) == 8) {
-			if (!piglit_probe_rect_rgba(x, y, w, h, c)) {
+			break;
+		case OP_PROBE_RECT_RGBA:
+			if (!piglit_probe_rect_rgba(i[0], i[1], i[2], i[3], c)) {
 				result = PIGLIT_FAIL;
 			}
-		} else if (sscanf(line, "relative probe rect rgb "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f )",
-				  c + 0, c + 1, c + 2, c + 3,
-				  c + 4, c + 5, c + 6) == 7) {
+			break;
+		case OP_RELATIVE_PROBE_RECT_RGB:
 			x = c[0] * read_width;
 			y = c[1] * read_height;
 			w = c[2] * read_width;
@@ -3321,60 +4063,62 @@ piglit_display(void)
 			if (!piglit_probe_rect_rgb(x, y, w, h, &c[4])) {
 				result = PIGLIT_FAIL;
 			}
-
-		} else if (sscanf(line, "relative probe rect rgba int "
-				  "( %f , %f , %f , %f ) "
-				  "( %d , %d , %d , %d )",
-				  c + 0, c + 1, c + 2, c + 3,
-				  &x, &y, &z, &w) == 8) {
-			const int expected[] = { x, y, z, w };
+			break;
+		case OP_RELATIVE_PROBE_RECT_RGBA_INT:
 			if (!piglit_probe_rect_rgba_int(c[0] * read_width,
 							c[1] * read_height,
 							c[2] * read_width,
 							c[3] * read_height,
-							expected))
+							i))
 				result = PIGLIT_FAIL;
-
-		} else if (parse_str(line, "probe all rgba ", &rest)) {
-			parse_floats(rest, c, 4, NULL);
+			break;
+		case OP_PROBE_ALL_RGBA:
 			if (result != PIGLIT_FAIL &&
 			    !piglit_probe_rect_rgba(0, 0, read_width,
 						    read_height, c))
 				result = PIGLIT_FAIL;
-		} else if (parse_str(line, "probe warn all rgba ", &rest)) {
-			parse_floats(rest, c, 4, NULL);
+			break;
+		case OP_PROBE_WARN_ALL_RGBA:
 			if (result == PIGLIT_PASS &&
 			    !piglit_probe_rect_rgba(0, 0, read_width,
 						    read_height, c))
 				result = PIGLIT_WARN;
-		} else if (parse_str(line, "probe all rgb", &rest)) {
-			parse_floats(rest, c, 3, NULL);
+			break;
+		case OP_PROBE_ALL_RGB:
 			if (result != PIGLIT_FAIL &&
 			    !piglit_probe_rect_rgb(0, 0, read_width,
 						   read_height, c))
 				result = PIGLIT_FAIL;
-		} else if (parse_str(line, "tolerance", &rest)) {
-			parse_floats(rest, piglit_tolerance, 4, NULL);
-		} else if (parse_str(line, "shade model smooth", NULL)) {
+			break;
+		case OP_TOLERANCE:
+			memcpy(piglit_tolerance, c, i[0] * sizeof(float));
+			break;
+		case OP_SHADE_MODEL_SMOOTH:
 			glShadeModel(GL_SMOOTH);
-		} else if (parse_str(line, "shade model flat", NULL)) {
+			break;
+		case OP_SHADE_MODEL_FLAT:
 			glShadeModel(GL_FLAT);
-		} else if (sscanf(line, "ssbo %d %d", &x, &y) == 2) {
-			GLuint *ssbo_init = calloc(y, 1);
-			glGenBuffers(1, &ssbo[x]);
-			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, x, ssbo[x]);
-			glBufferData(GL_SHADER_STORAGE_BUFFER, y,
+			break;
+		case OP_SSBO: {
+			GLuint *ssbo_init = calloc(i[1], 1);
+			glGenBuffers(1, &ssbo[i[0]]);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i[0], ssbo[i[0]]);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, i[1],
 				     ssbo_init, GL_DYNAMIC_DRAW);
 			free(ssbo_init);
-		} else if (sscanf(line, "ssbo %d subdata float %d %f", &x, &y, &c[0]) == 3) {
-			glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo[x]);
-			glBufferSubData(GL_SHADER_STORAGE_BUFFER, y, 4, &c[0]);
-		} else if (sscanf(line, "texture rgbw %d ( %d", &tex, &w) == 2) {
+			break;
+		}
+		case OP_SSBO_SUBDATA_FLOAT:
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo[i[0]]);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, i[1], 4, &c[0]);
+			break;
+		case OP_TEXTURE_RGBW: {
 			GLenum int_fmt = GL_RGBA;
-			int num_scanned =
-				sscanf(line,
-				       "texture rgbw %d ( %d , %d ) %31s",
-				       &tex, &w, &h, s);
+			const int num_scanned = i[3];
+
+			tex = i[0];
+			w = i[1];
+			h = i[2];
 			if (num_scanned < 3) {
 				fprintf(stderr,
 					"invalid texture rgbw command!\n");
@@ -3382,7 +4126,7 @@ piglit_display(void)
 			}
 
 			if (num_scanned >= 4) {
-				int_fmt = piglit_get_gl_enum_from_name(s);
+				int_fmt = piglit_get_gl_enum_from_name(cmd->s);
 			}
 
 			glActiveTexture(GL_TEXTURE0 + tex);
@@ -3395,27 +4139,30 @@ piglit_display(void)
 			if (!piglit_is_core_profile &&
 			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
 				glEnable(GL_TEXTURE_2D);
-
-		} else if (parse_str(line, "texture integer ", &rest)) {
+			break;
+		}
+		case OP_TEXTURE_INTEGER: {
 			GLenum int_fmt;
-			int b, a;
-			int num_scanned =
-				sscanf(rest, "%d ( %d , %d ) ( %d, %d ) %31s",
-				       &tex, &w, &h, &b, &a, s);
-			if (num_scanned < 6) {
+
+			tex = i[0];
+			w = i[1];
+			h = i[2];
+			if (i[5] < 6) {
 				fprintf(stderr,
 					"invalid texture integer command!\n");
 				piglit_report_result(PIGLIT_FAIL);
 			}
 
-			int_fmt = piglit_get_gl_enum_from_name(s);
+			int_fmt = piglit_get_gl_enum_from_name(cmd->s);
 
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle =
-				piglit_integer_texture(int_fmt, w, h, b, a);
+				piglit_integer_texture(int_fmt, w, h, i[3], i[4]);
 			set_texture_binding(tex, handle, w, h, 1);
-
-		} else if (sscanf(line, "texture miptree %d", &tex) == 1) {
+			break;
+		}
+		case OP_TEXTURE_MIPTREE: {
+			tex = i[0];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_miptree_texture();
 			set_texture_binding(tex, handle, 8, 8, 1);
@@ -3423,52 +4170,53 @@ piglit_display(void)
 			if (!piglit_is_core_profile &&
 			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
 				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture checkerboard %d %d ( %d , %d ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f )",
-				  &tex, &level, &w, &h,
-				  c + 0, c + 1, c + 2, c + 3,
-				  c + 4, c + 5, c + 6, c + 7) == 12) {
+			break;
+		}
+		case OP_TEXTURE_CHECKERBOARD: {
+			tex = i[0];
+			w = i[2];
+			h = i[3];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_checkerboard_texture(
-				0, level, w, h, w / 2, h / 2, c + 0, c + 4);
+				0, i[1], w, h, w / 2, h / 2, c + 0, c + 4);
 			set_texture_binding(tex, handle, w, h, 1);
 
 			if (!piglit_is_core_profile &&
 			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
 				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture quads %d %d ( %d , %d ) ( %d , %d ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f ) "
-				  "( %f , %f , %f , %f )",
-				  &tex, &level, &w, &h, &x, &y,
-				  c + 0, c + 1, c + 2, c + 3,
-				  c + 4, c + 5, c + 6, c + 7,
-				  c + 8, c + 9, c + 10, c + 11,
-				  c + 12, c + 13, c + 14, c + 15) == 22) {
+			break;
+		}
+		case OP_TEXTURE_QUADS: {
+			tex = i[0];
+			w = i[2];
+			h = i[3];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_quads_texture(
-				0, level, w, h, x, y, c + 0, c + 4, c + 8, c + 12);
+				0, i[1], w, h, i[4], i[5],
+				c + 0, c + 4, c + 8, c + 12);
 			set_texture_binding(tex, handle, w, h, 1);
 
 			if (!piglit_is_core_profile &&
 			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
 				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture junk 2DArray %d ( %d , %d , %d )",
-				  &tex, &w, &h, &l) == 4) {
+			break;
+		}
+		case OP_TEXTURE_JUNK_2D_ARRAY: {
 			GLuint texobj;
+
+			tex = i[0];
+			w = i[1];
+			h = i[2];
+			l = i[3];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			glGenTextures(1, &texobj);
 			glBindTexture(GL_TEXTURE_2D_ARRAY, texobj);
 			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA,
 				     w, h, l, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
 			set_texture_binding(tex, texobj, w, h, l);
-
-		} else if (parse_str(line, "texture storage ", &rest)) {
+			break;
+		}
+		case OP_TEXTURE_STORAGE: {
 			GLenum target, format;
 			GLuint tex_obj;
 			int d = h = w = 1;
@@ -3502,27 +4250,34 @@ piglit_display(void)
 				set_texture_binding(tex, tex_obj, w, 1, h);
 			else
 				set_texture_binding(tex, tex_obj, w, h, d);
-
-		} else if (sscanf(line,
-				  "texture rgbw 2DArray %d ( %d , %d , %d )",
-				  &tex, &w, &h, &l) == 4) {
+			break;
+		}
+		case OP_TEXTURE_RGBW_2D_ARRAY: {
+			tex = i[0];
+			w = i[1];
+			h = i[2];
+			l = i[3];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_array_texture(
 				GL_TEXTURE_2D_ARRAY, GL_RGBA, w, h, l, GL_FALSE);
 			set_texture_binding(tex, handle, w, h, l);
-
-		} else if (sscanf(line,
-				  "texture rgbw 1DArray %d ( %d , %d )",
-				  &tex, &w, &l) == 3) {
+			break;
+		}
+		case OP_TEXTURE_RGBW_1D_ARRAY: {
+			tex = i[0];
+			w = i[1];
+			l = i[2];
 			glActiveTexture(GL_TEXTURE0 + tex);
-                        h = 1;
+			h = 1;
 			const GLuint handle = piglit_array_texture(
 				GL_TEXTURE_1D_ARRAY, GL_RGBA, w, h, l, GL_FALSE);
 			set_texture_binding(tex, handle, w, 1, l);
-
-		} else if (sscanf(line,
-				  "texture shadow2D %d ( %d , %d )",
-				  &tex, &w, &h) == 3) {
+			break;
+		}
+		case OP_TEXTURE_SHADOW_2D: {
+			tex = i[0];
+			w = i[1];
+			h = i[2];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_depth_texture(
 				GL_TEXTURE_2D, GL_DEPTH_COMPONENT,
@@ -3538,9 +4293,12 @@ piglit_display(void)
 			if (!piglit_is_core_profile &&
 			    !(piglit_is_gles() && piglit_get_gl_version() >= 20))
 				glEnable(GL_TEXTURE_2D);
-		} else if (sscanf(line,
-				  "texture shadowRect %d ( %d , %d )",
-				  &tex, &w, &h) == 3) {
+			break;
+		}
+		case OP_TEXTURE_SHADOW_RECT: {
+			tex = i[0];
+			w = i[1];
+			h = i[2];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_depth_texture(
 				GL_TEXTURE_RECTANGLE, GL_DEPTH_COMPONENT,
@@ -3552,9 +4310,11 @@ piglit_display(void)
 					GL_TEXTURE_COMPARE_FUNC,
 					GL_GREATER);
 			set_texture_binding(tex, handle, w, h, 1);
-		} else if (sscanf(line,
-				  "texture shadow1D %d ( %d )",
-				  &tex, &w) == 2) {
+			break;
+		}
+		case OP_TEXTURE_SHADOW_1D: {
+			tex = i[0];
+			w = i[1];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_depth_texture(
 				GL_TEXTURE_1D, GL_DEPTH_COMPONENT,
@@ -3566,9 +4326,12 @@ piglit_display(void)
 					GL_TEXTURE_COMPARE_FUNC,
 					GL_GREATER);
 			set_texture_binding(tex, handle, w, 1, 1);
-		} else if (sscanf(line,
-				  "texture shadow1DArray %d ( %d , %d )",
-				  &tex, &w, &l) == 3) {
+			break;
+		}
+		case OP_TEXTURE_SHADOW_1D_ARRAY: {
+			tex = i[0];
+			w = i[1];
+			l = i[2];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_depth_texture(
 				GL_TEXTURE_1D_ARRAY, GL_DEPTH_COMPONENT,
@@ -3580,9 +4343,13 @@ piglit_display(void)
 					GL_TEXTURE_COMPARE_FUNC,
 					GL_GREATER);
 			set_texture_binding(tex, handle, w, 1, l);
-		} else if (sscanf(line,
-				  "texture shadow2DArray %d ( %d , %d , %d )",
-				  &tex, &w, &h, &l) == 4) {
+			break;
+		}
+		case OP_TEXTURE_SHADOW_2D_ARRAY: {
+			tex = i[0];
+			w = i[1];
+			h = i[2];
+			l = i[3];
 			glActiveTexture(GL_TEXTURE0 + tex);
 			const GLuint handle = piglit_depth_texture(
 				GL_TEXTURE_2D_ARRAY, GL_DEPTH_COMPONENT,
@@ -3594,25 +4361,33 @@ piglit_display(void)
 					GL_TEXTURE_COMPARE_FUNC,
 					GL_GREATER);
 			set_texture_binding(tex, handle, w, h, l);
-		} else if (sscanf(line, "texcoord %d ( %f , %f , %f , %f )",
-		                  &x, c + 0, c + 1, c + 2, c + 3) == 5) {
-			glMultiTexCoord4fv(GL_TEXTURE0 + x, c);
-		} else if (parse_str(line, "texparameter ", &rest)) {
+			break;
+		}
+		case OP_TEXCOORD:
+			glMultiTexCoord4fv(GL_TEXTURE0 + i[0], c);
+			break;
+		case OP_TEXPARAMETER:
 			handle_texparameter(rest);
-		} else if (parse_str(line, "uniform ", &rest)) {
+			break;
+		case OP_UNIFORM:
 			result = program_must_be_in_use();
 			set_uniform(rest, ubo_array_index);
-		} else if (parse_str(line, "subuniform ", &rest)) {
+			break;
+		case OP_SUBUNIFORM:
 			result = program_must_be_in_use();
 			check_shader_subroutine_support();
 			set_subroutine_uniform(rest);
-		} else if (parse_str(line, "parameter ", &rest)) {
+			break;
+		case OP_PARAMETER:
 			set_parameter(rest);
-		} else if (parse_str(line, "patch parameter ", &rest)) {
+			break;
+		case OP_PATCH_PARAMETER:
 			set_patch_parameter(rest);
-		} else if (parse_str(line, "provoking vertex ", &rest)) {
+			break;
+		case OP_PROVOKING_VERTEX:
 			set_provoking_vertex(rest);
-		} else if (parse_str(line, "link error", &rest)) {
+			break;
+		case OP_LINK_ERROR:
 			link_error_expected = true;
 			if (link_ok) {
 				printf("shader link error expected, but it was successful!\n");
@@ -3620,34 +4395,43 @@ piglit_display(void)
 			} else {
 				fprintf(stderr, "Failed to link:\n%s\n", prog_err_info);
 			}
-		} else if (parse_str(line, "link success", &rest)) {
+			break;
+		case OP_LINK_SUCCESS:
 			result = program_must_be_in_use();
-		} else if (parse_str(line, "ubo array index ", &rest)) {
-			parse_ints(rest, &ubo_array_index, 1, NULL);
-		} else if (parse_str(line, "active uniform ", &rest)) {
+			break;
+		case OP_UBO_ARRAY_INDEX:
+			ubo_array_index = i[0];
+			break;
+		case OP_ACTIVE_UNIFORM:
 			active_uniform(rest);
-		} else if (parse_str(line, "verify program_interface_query ", &rest)) {
+			break;
+		case OP_VERIFY_PROGRAM_INTERFACE_QUERY:
 			active_program_interface(rest);
-		} else if ((line[0] != '\n') && (line[0] != '\0')
-			   && (line[0] != '#')) {
+			break;
+		case OP_UNKNOWN:
 			printf("unknown command \"%s\"\n", line);
 			piglit_report_result(PIGLIT_FAIL);
+			break;
 		}
 
-		free((void*) line);
+		if (timed)
+			piglit_phase_end(phase);
 
 		if (result != PIGLIT_PASS) {
-			printf("Test failure on line %u\n", line_num);
+			printf("Test failure on line %u\n", cmd->line_num);
 			full_result = result;
 		}
-
-		line_num++;
 	}
 
 	if (!link_ok && !link_error_expected) {
 		full_result = program_must_be_in_use();
 	}
 
+	if (piglit_probe_cache_readbacks_saved())
+		printf("Probe readbacks saved: %u\n",
+		       piglit_probe_cache_readbacks_saved());
+	piglit_probe_cache_enable(false);
+
 	piglit_present_results();
 
 	if (piglit_automatic) {
@@ -3683,6 +4467,9 @@ init_test(const char *file)
 	if (result != PIGLIT_PASS)
 		return result;
 
+	if (test_start != NULL)
+		lex_test_section();
+
 	result = link_and_use_shaders();
 	if (result != PIGLIT_PASS)
 		return result;
@@ -3697,8 +4484,15 @@ init_test(const char *file)
 
 		bind_vao_if_supported();
 
-		num_vbo_rows = setup_vbo_from_text(prog, vertex_data_start,
-						   vertex_data_end);
+		if (vertex_data_binary_present)
+			num_vbo_rows = setup_vbo_from_binary(prog,
+							     vertex_data_start,
+							     vertex_data_end,
+							     file);
+		else
+			num_vbo_rows = setup_vbo_from_text(prog,
+							   vertex_data_start,
+							   vertex_data_end);
 		vbo_present = true;
 	}
 	setup_ubos();
@@ -3720,11 +4514,13 @@ recreate_gl_context(char *exec_arg, int param_argc, char **param_argv)
 	memcpy(&argv[1], param_argv, param_argc * sizeof(char*));
 	argv[argc-3] = "-auto";
 	argv[argc-2] = "-fbo";
-	argv[argc-1] = "-report-subtests";
+	argv[argc-1] = worker_mode ? "-worker" : "-report-subtests";
 
+	piglit_phase_begin(PIGLIT_PHASE_TEARDOWN);
 	if (gl_fw->destroy)
 		gl_fw->destroy(gl_fw);
 	gl_fw = NULL;
+	piglit_phase_end(PIGLIT_PHASE_TEARDOWN);
 
 	exit(main(argc, argv));
 }
@@ -3762,6 +4558,201 @@ validate_current_gl_context(const char *filename)
 	return true;
 }
 
+/**
+ * Reset the state left behind by the previous test and run the test
+ * script \p filename in the current GL context.  The name the test's
+ * result should be reported under is returned in \p testname.
+ */
+static enum piglit_result
+run_test_file(const char *filename, bool es, char *testname)
+{
+	enum piglit_result result;
+	const char *hit;
+	char *ext;
+	int j;
+
+	memcpy(piglit_tolerance, default_piglit_tolerance,
+	       sizeof(piglit_tolerance));
+
+	/* Clear global variables to defaults. */
+	test_start = NULL;
+	free_test_commands();
+	assert(num_vertex_shaders == 0);
+	assert(num_tess_ctrl_shaders == 0);
+	assert(num_tess_eval_shaders == 0);
+	assert(num_geometry_shaders == 0);
+	assert(num_fragment_shaders == 0);
+	assert(num_compute_shaders == 0);
+	num_cached_shaders = 0;
+	assert(num_uniform_blocks == 0);
+	assert(uniform_block_bos == NULL);
+	geometry_layout_input_type = GL_TRIANGLES;
+	geometry_layout_output_type = GL_TRIANGLE_STRIP;
+	geometry_layout_vertices_out = 0;
+	memset(atomics_bos, 0, sizeof(atomics_bos));
+	memset(ssbo, 0, sizeof(ssbo));
+	for (j = 0; j < ARRAY_SIZE(subuniform_locations); j++)
+		assert(subuniform_locations[j] == NULL);
+	memset(num_subuniform_locations, 0, sizeof(num_subuniform_locations));
+	shader_string = NULL;
+	shader_string_size = 0;
+	vertex_data_start = NULL;
+	vertex_data_end = NULL;
+	vertex_data_binary_present = false;
+	prog = 0;
+	sso_vertex_prog = 0;
+	sso_tess_control_prog = 0;
+	sso_tess_eval_prog = 0;
+	sso_geometry_prog = 0;
+	sso_fragment_prog = 0;
+	sso_compute_prog = 0;
+	num_vbo_rows = 0;
+	vbo_present = false;
+	link_ok = false;
+	prog_in_use = false;
+	sso_in_use = false;
+	prog_err_info = NULL;
+	vao = 0;
+
+	/* Clear GL states to defaults. */
+	glClearColor(0, 0, 0, 0);
+# if PIGLIT_USE_OPENGL
+	glClearDepth(1);
+# else
+	glClearDepthf(1.0);
+# endif
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram(0);
+	glDisable(GL_DEPTH_TEST);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	for (int k = 0; k < gl_max_clip_planes; k++) {
+		glDisable(GL_CLIP_PLANE0 + k);
+	}
+
+	if (!(es) && (gl_version.num >= 20 ||
+	     piglit_is_extension_supported("GL_ARB_vertex_program")))
+		glDisable(GL_PROGRAM_POINT_SIZE);
+
+	for (int i = 0; i < 16; i++)
+		glDisableVertexAttribArray(i);
+
+	if (!piglit_is_core_profile && !es) {
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		glShadeModel(GL_SMOOTH);
+		glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
+	}
+
+	if (piglit_is_extension_supported("GL_ARB_vertex_program")) {
+		glDisable(GL_VERTEX_PROGRAM_ARB);
+		glBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
+	}
+	if (piglit_is_extension_supported("GL_ARB_fragment_program")) {
+		glDisable(GL_FRAGMENT_PROGRAM_ARB);
+		glBindProgramARB(GL_FRAGMENT_PROGRAM_ARB, 0);
+	}
+	if (piglit_is_extension_supported("GL_ARB_separate_shader_objects")) {
+		if (!pipeline)
+			glGenProgramPipelines(1, &pipeline);
+		glBindProgramPipeline(0);
+	}
+
+	if (piglit_is_extension_supported("GL_EXT_provoking_vertex"))
+		glProvokingVertexEXT(GL_LAST_VERTEX_CONVENTION_EXT);
+
+# if PIGLIT_USE_OPENGL
+	if (gl_version.num >= 40 ||
+	    piglit_is_extension_supported("GL_ARB_tessellation_shader")) {
+		static float ones[] = {1, 1, 1, 1};
+		glPatchParameteri(GL_PATCH_VERTICES, 3);
+		glPatchParameterfv(GL_PATCH_DEFAULT_OUTER_LEVEL, ones);
+		glPatchParameterfv(GL_PATCH_DEFAULT_INNER_LEVEL, ones);
+	}
+# else
+	/* Ideally one would use the following code:
+	 *
+	 * if (gl_version.num >= 32) {
+	 *         glPatchParameteri(GL_PATCH_VERTICES, 3);
+	 * }
+	 *
+	 * however, that doesn't work with mesa because those
+	 * symbols apparently need to be exported, but that
+	 * breaks non-gles builds.
+	 *
+	 * It seems rather unlikely that an implementation
+	 * would have GLES 3.2 support but not
+	 * OES_tessellation_shader.
+	 */
+	if (piglit_is_extension_supported("GL_OES_tessellation_shader")) {
+		glPatchParameteriOES(GL_PATCH_VERTICES_OES, 3);
+	}
+# endif
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	/* Strip the file path. */
+	hit = strrchr(filename, PIGLIT_PATH_SEP);
+	if (hit)
+		strcpy(testname, hit+1);
+	else
+		strcpy(testname, filename);
+
+	/* Strip the file extension. */
+	ext = strstr(testname, ".shader_test");
+	if (ext && !ext[12])
+		*ext = 0;
+
+	/* Print the name before we start the test, that way if
+	 * the test fails we can still resume and know which
+	 * test failed */
+	printf("PIGLIT TEST: %i - %s\n", test_num, testname);
+	fprintf(stderr, "PIGLIT TEST: %i - %s\n", test_num, testname);
+	test_num++;
+
+	/* Run the test. */
+	result = init_test(filename);
+
+	if (result == PIGLIT_PASS) {
+		result = piglit_display();
+	}
+
+	/* destroy GL objects? */
+	teardown_ubos();
+	teardown_atomics();
+	teardown_fbos();
+
+	return result;
+}
+
+/**
+ * Report the result of a test run by run_test_file().
+ *
+ * In worker mode every test script gets a regular result line and the
+ * phase timings of the script, followed by a "PIGLIT WORKER: done" marker
+ * on both stderr and stdout, so that the process feeding us test scripts
+ * knows where the output of one ends.
+ */
+static void
+report_test_file_result(enum piglit_result result, const char *testname)
+{
+	if (!worker_mode) {
+		piglit_report_subtest_result(result, "%s", testname);
+		return;
+	}
+
+	printf("PIGLIT: {\"result\": \"%s\" }\n",
+	       piglit_result_to_string(result));
+	piglit_phase_report();
+	fprintf(stderr, "PIGLIT WORKER: done\n");
+	fflush(stderr);
+	printf("PIGLIT WORKER: done\n");
+	fflush(stdout);
+}
+
 void
 piglit_init(int argc, char **argv)
 {
@@ -3770,9 +4761,9 @@ piglit_init(int argc, char **argv)
 	bool core = piglit_is_core_profile;
 	bool es;
 	enum piglit_result result;
-	float default_piglit_tolerance[4];
 
 	report_subtests = piglit_strip_arg(&argc, argv, "-report-subtests");
+	worker_mode = piglit_strip_arg(&argc, argv, "-worker");
 	if (argc < 2) {
 		printf("usage: shader_runner <test.shader_test>\n");
 		exit(1);
@@ -3781,6 +4772,10 @@ piglit_init(int argc, char **argv)
 	memcpy(default_piglit_tolerance, piglit_tolerance,
 	       sizeof(piglit_tolerance));
 
+	shader_cache_dir = getenv("PIGLIT_SHADER_CACHE_DIR");
+	if (shader_cache_dir != NULL && shader_cache_dir[0] == '\0')
+		shader_cache_dir = NULL;
+
 	piglit_require_GLSL();
 
 	version_init(&gl_version, VERSION_GL,
@@ -3832,179 +4827,40 @@ piglit_init(int argc, char **argv)
 	read_width = render_width = piglit_width;
 	read_height = render_height = piglit_height;
 
-	/* Automatic mode can run multiple tests per session. */
-	if (report_subtests) {
-		char testname[4096], *ext;
-		int i, j;
+	/* Automatic mode can run multiple tests per session.
+	 *
+	 * In worker mode, test scripts are additionally read from stdin,
+	 * one path per line, until stdin is closed.  If a script needs a
+	 * different GL config, the context is recreated and the worker
+	 * carries on with that script.
+	 */
+	if (report_subtests || worker_mode) {
+		char testname[4096];
+		char filename[4096];
+		int i;
 
 		for (i = 1; i < argc; i++) {
-			const char *hit, *filename = argv[i];
-
-			memcpy(piglit_tolerance, default_piglit_tolerance,
-			       sizeof(piglit_tolerance));
-
 			/* Re-initialize the GL context if a different GL config is required. */
-			if (!validate_current_gl_context(filename))
+			if (!validate_current_gl_context(argv[i]))
 				recreate_gl_context(argv[0], argc - i, argv + i);
 
-			/* Clear global variables to defaults. */
-			test_start = NULL;
-			assert(num_vertex_shaders == 0);
-			assert(num_tess_ctrl_shaders == 0);
-			assert(num_tess_eval_shaders == 0);
-			assert(num_geometry_shaders == 0);
-			assert(num_fragment_shaders == 0);
-			assert(num_compute_shaders == 0);
-			assert(num_uniform_blocks == 0);
-			assert(uniform_block_bos == NULL);
-			geometry_layout_input_type = GL_TRIANGLES;
-			geometry_layout_output_type = GL_TRIANGLE_STRIP;
-			geometry_layout_vertices_out = 0;
-			memset(atomics_bos, 0, sizeof(atomics_bos));
-			memset(ssbo, 0, sizeof(ssbo));
-			for (j = 0; j < ARRAY_SIZE(subuniform_locations); j++)
-				assert(subuniform_locations[j] == NULL);
-			memset(num_subuniform_locations, 0, sizeof(num_subuniform_locations));
-			shader_string = NULL;
-			shader_string_size = 0;
-			vertex_data_start = NULL;
-			vertex_data_end = NULL;
-			prog = 0;
-			sso_vertex_prog = 0;
-			sso_tess_control_prog = 0;
-			sso_tess_eval_prog = 0;
-			sso_geometry_prog = 0;
-			sso_fragment_prog = 0;
-			sso_compute_prog = 0;
-			num_vbo_rows = 0;
-			vbo_present = false;
-			link_ok = false;
-			prog_in_use = false;
-			sso_in_use = false;
-			prog_err_info = NULL;
-			vao = 0;
-
-			/* Clear GL states to defaults. */
-			glClearColor(0, 0, 0, 0);
-# if PIGLIT_USE_OPENGL
-			glClearDepth(1);
-# else
-			glClearDepthf(1.0);
-# endif
-			glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
-			glActiveTexture(GL_TEXTURE0);
-			glUseProgram(0);
-			glDisable(GL_DEPTH_TEST);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-			for (int k = 0; k < gl_max_clip_planes; k++) {
-				glDisable(GL_CLIP_PLANE0 + k);
-			}
-
-			if (!(es) && (gl_version.num >= 20 ||
-			     piglit_is_extension_supported("GL_ARB_vertex_program")))
-				glDisable(GL_PROGRAM_POINT_SIZE);
-
-			for (int i = 0; i < 16; i++)
-				glDisableVertexAttribArray(i);
-
-			if (!piglit_is_core_profile && !es) {
-				glMatrixMode(GL_PROJECTION);
-				glLoadIdentity();
-				glMatrixMode(GL_MODELVIEW);
-				glLoadIdentity();
-				glShadeModel(GL_SMOOTH);
-				glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
-			}
-
-			if (piglit_is_extension_supported("GL_ARB_vertex_program")) {
-				glDisable(GL_VERTEX_PROGRAM_ARB);
-				glBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
-			}
-			if (piglit_is_extension_supported("GL_ARB_fragment_program")) {
-				glDisable(GL_FRAGMENT_PROGRAM_ARB);
-				glBindProgramARB(GL_FRAGMENT_PROGRAM_ARB, 0);
-			}
-			if (piglit_is_extension_supported("GL_ARB_separate_shader_objects")) {
-				if (!pipeline)
-					glGenProgramPipelines(1, &pipeline);
-				glBindProgramPipeline(0);
-			}
-
-			if (piglit_is_extension_supported("GL_EXT_provoking_vertex"))
-				glProvokingVertexEXT(GL_LAST_VERTEX_CONVENTION_EXT);
-
-# if PIGLIT_USE_OPENGL
-			if (gl_version.num >= 40 ||
-			    piglit_is_extension_supported("GL_ARB_tessellation_shader")) {
-				static float ones[] = {1, 1, 1, 1};
-				glPatchParameteri(GL_PATCH_VERTICES, 3);
-				glPatchParameterfv(GL_PATCH_DEFAULT_OUTER_LEVEL, ones);
-				glPatchParameterfv(GL_PATCH_DEFAULT_INNER_LEVEL, ones);
-			}
-# else
-			/* Ideally one would use the following code:
-			 *
-			 * if (gl_version.num >= 32) {
-			 *         glPatchParameteri(GL_PATCH_VERTICES, 3);
-			 * }
-			 *
-			 * however, that doesn't work with mesa because those
-			 * symbols apparently need to be exported, but that
-			 * breaks non-gles builds.
-			 *
-			 * It seems rather unlikely that an implementation
-			 * would have GLES 3.2 support but not
-			 * OES_tessellation_shader.
-			 */
-			if (piglit_is_extension_supported("GL_OES_tessellation_shader")) {
-				glPatchParameteriOES(GL_PATCH_VERTICES_OES, 3);
-			}
-# endif
-
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			/* Strip the file path. */
-			hit = strrchr(filename, PIGLIT_PATH_SEP);
-			if (hit)
-				strcpy(testname, hit+1);
-			else
-				strcpy(testname, filename);
-
-			/* Strip the file extension. */
-			ext = strstr(testname, ".shader_test");
-			if (ext && !ext[12])
-				*ext = 0;
+			result = run_test_file(argv[i], es, testname);
+			report_test_file_result(result, testname);
+		}
 
-			/* Print the name before we start the test, that way if
-			 * the test fails we can still resume and know which
-			 * test failed */
-			printf("PIGLIT TEST: %i - %s\n", test_num, testname);
-			fprintf(stderr, "PIGLIT TEST: %i - %s\n", test_num, testname);
-			test_num++;
+		while (worker_mode &&
+		       fgets(filename, sizeof(filename), stdin) != NULL) {
+			char *file_arg = filename;
 
-			/* Run the test. */
-			result = init_test(filename);
+			filename[strcspn(filename, "\r\n")] = '\0';
+			if (filename[0] == '\0')
+				continue;
 
-			if (result == PIGLIT_PASS) {
-				result = piglit_display();
-			}
-			/* Use subtest when running with more than one test,
-			 * but use regular test result when running with just
-			 * one.  This allows the standard process-at-a-time
-			 * mode to keep working.
-			 */
-			if (report_subtests) {
-				piglit_report_subtest_result(
-					result, "%s", testname);
-			} else {
-				piglit_report_result(result);
-			}
+			if (!validate_current_gl_context(filename))
+				recreate_gl_context(argv[0], 1, &file_arg);
 
-			/* destroy GL objects? */
-			teardown_ubos();
-			teardown_atomics();
-			teardown_fbos();
+			result = run_test_file(filename, es, testname);
+			report_test_file_result(result, testname);
 		}
 		exit(0);
 	}
@@ -106,6 +106,16 @@
  *   buffers).  On some implementations (e.g. the nVidia proprietary
  *   driver for Linux) this is necessary for framebuffer completeness.
  *   On others (e.g. i965), this is an important corner case to test.
+ *
+ * Rendering the reference image is the expensive part of these tests,
+ * especially on software rasterizers, and it only depends on the
+ * pattern and its size, not on the sample count or the buffer under
+ * test.  If PIGLIT_MSAA_REFERENCE_CACHE_DIR names an existing directory,
+ * reference images are stored there, keyed by the pattern, its size, the
+ * supersample factor and the driver, and later tests show the stored
+ * image instead of rendering it.  If PIGLIT_MSAA_REFERENCE_CACHE_VERIFY
+ * is also set, the reference image is always rendered, the test fails if
+ * it differs from the stored one, and the stored one is replaced.
  */
 
 #include "common.h"
@@ -253,11 +263,13 @@ Stats::is_better_than(double rms_error_threshold)
 }
 
 Test::Test(TestPattern *pattern, ManifestProgram *manifest_program,
-	   bool test_resolve, GLbitfield blit_type, bool srgb)
+	   bool test_resolve, GLbitfield blit_type, bool srgb,
+	   const char *reference_name)
 	: pattern(pattern),
 	  manifest_program(manifest_program),
 	  test_resolve(test_resolve),
 	  blit_type(blit_type),
+	  reference_name(reference_name),
 	  num_samples(0),
 	  pattern_width(0),
 	  pattern_height(0),
@@ -452,10 +464,10 @@ Test::draw_to_default_framebuffer()
 }
 
 /**
- * Draw the entire test image, rendering it a piece at a time.
+ * Render the entire reference image, a piece at a time.
  */
 void
-Test::draw_reference_image()
+Test::render_reference_image()
 {
 	int downsampled_width =
 		supersample_fbo.config.width / supersample_factor;
@@ -483,6 +495,157 @@ Test::draw_reference_image()
 	}
 }
 
+/**
+ * The reference image cache directory, or NULL if the cache is disabled
+ * or cached images can't be shown because there are no floating point
+ * textures.
+ */
+const char *
+Test::reference_cache_dir()
+{
+	const char *dir = getenv("PIGLIT_MSAA_REFERENCE_CACHE_DIR");
+
+	if (dir == NULL || reference_name == NULL)
+		return NULL;
+	if (piglit_get_gl_version() < 30 &&
+	    !piglit_is_extension_supported("GL_ARB_texture_float"))
+		return NULL;
+	return dir;
+}
+
+/**
+ * Compute the reference image cache key of this test.
+ */
+uint64_t
+Test::reference_cache_key()
+{
+	static const GLenum strings[] = {
+		GL_VENDOR, GL_RENDERER, GL_VERSION
+	};
+	const int params[] = {
+		pattern_width, pattern_height, supersample_factor, srgb
+	};
+	uint64_t key = PIGLIT_HASH_INIT;
+
+	for (unsigned i = 0; i < ARRAY_SIZE(strings); i++)
+		key = piglit_hash_string(key,
+					 (const char *) glGetString(strings[i]));
+	key = piglit_hash_string(key, reference_name);
+	key = piglit_hash_update(key, params, sizeof(params));
+
+	return key;
+}
+
+/**
+ * Upload a cached reference image to cached_reference_fbo and show it
+ * where a rendered one would be.  Returns false if the fbo can't be set
+ * up.
+ */
+bool
+Test::show_cached_reference_image(const float *data)
+{
+	FboConfig config(0, pattern_width, pattern_height);
+	config.color_internalformat = GL_RGBA32F;
+	config.num_rb_attachments = 0;
+	config.num_tex_attachments = 1;
+	config.combine_depth_stencil = false;
+	config.depth_internalformat = GL_NONE;
+	config.stencil_internalformat = GL_NONE;
+	if (!cached_reference_fbo.try_setup(config))
+		return false;
+
+	glBindTexture(GL_TEXTURE_RECTANGLE, cached_reference_fbo.color_tex[0]);
+	glTexSubImage2D(GL_TEXTURE_RECTANGLE, 0, 0, 0,
+			pattern_width, pattern_height,
+			GL_RGBA, GL_FLOAT, data);
+	show(&cached_reference_fbo, pattern_width, 0);
+	return true;
+}
+
+/**
+ * Compare a rendered reference image to the cached one, and print how
+ * much they differ.  Returns true if they are identical.
+ */
+bool
+Test::compare_cached_reference_image(const float *cached,
+				     const float *rendered)
+{
+	int size = pattern_width * pattern_height * 4;
+	int num_different = 0;
+	float max_difference = 0.0;
+
+	for (int i = 0; i < size; ++i) {
+		float difference = fabs(cached[i] - rendered[i]);
+		if (difference != 0.0) {
+			++num_different;
+			max_difference = MAX2(max_difference, difference);
+		}
+	}
+
+	if (num_different != 0) {
+		printf("Reference image differs from the cached one in "
+		       "%d of %d components, by up to %f\n",
+		       num_different, size, max_difference);
+		return false;
+	}
+	printf("Reference image matches the cached one\n");
+	return true;
+}
+
+/**
+ * Draw the entire reference image, or show it from the reference image
+ * cache.  Returns false if the cache is being verified and the rendered
+ * image differs from the cached one.
+ */
+bool
+Test::draw_reference_image()
+{
+	const char *cache_dir = reference_cache_dir();
+	bool verify = getenv("PIGLIT_MSAA_REFERENCE_CACHE_VERIFY") != NULL;
+	size_t size = pattern_width * pattern_height * 4 * sizeof(float);
+	uint64_t cache_key = 0;
+	float *cached = NULL;
+	size_t cached_size = 0;
+	bool pass = true;
+
+	if (cache_dir != NULL) {
+		cache_key = reference_cache_key();
+		cached = (float *) piglit_cache_load(cache_dir, cache_key,
+						     &cached_size);
+		if (cached != NULL && cached_size != size) {
+			free(cached);
+			cached = NULL;
+		}
+		if (cached != NULL && !verify &&
+		    show_cached_reference_image(cached)) {
+			printf("Reference image cache hit\n");
+			free(cached);
+			return true;
+		}
+	}
+
+	render_reference_image();
+
+	if (cache_dir != NULL) {
+		float *rendered = (float *) malloc(size);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, piglit_winsys_fbo);
+		glReadPixels(pattern_width, 0, pattern_width, pattern_height,
+			     GL_RGBA, GL_FLOAT, rendered);
+
+		if (cached != NULL)
+			pass = compare_cached_reference_image(cached,
+							      rendered);
+		else if (verify)
+			printf("Reference image is not cached\n");
+		piglit_cache_store(cache_dir, cache_key, rendered, size);
+		free(rendered);
+	}
+
+	free(cached);
+	return pass;
+}
+
 /**
  * Measure the accuracy of MSAA downsampling.  Pixels that are fully
  * on or off in the reference image are required to be fully on or off
@@ -594,9 +757,11 @@ Test::measure_accuracy()
 bool
 Test::run()
 {
+	bool pass = true;
+
 	draw_test_image(&multisample_fbo);
-	draw_reference_image();
-	return measure_accuracy();
+	pass = draw_reference_image() && pass;
+	return measure_accuracy() && pass;
 }
 
 
@@ -608,32 +773,36 @@ create_test(test_type_enum test_type, int n_samples, bool small,
 	Test *test = NULL;
 	switch (test_type) {
 	case TEST_TYPE_COLOR:
-		test = new Test(new Triangles(), NULL, false, 0, false);
+		test = new Test(new Triangles(), NULL, false, 0, false,
+				"triangles");
 		break;
 	case TEST_TYPE_SRGB:
-		test = new Test(new Triangles(), NULL, false, 0, true);
+		test = new Test(new Triangles(), NULL, false, 0, true,
+				"triangles");
 		break;
 	case TEST_TYPE_STENCIL_DRAW:
 		test = new Test(new StencilSunburst(),
 				new ManifestStencil(),
-				false, 0, false);
+				false, 0, false, "stencil-sunburst");
 		break;
 	case TEST_TYPE_STENCIL_RESOLVE:
 		test = new Test(new StencilSunburst(),
 				new ManifestStencil(),
 				true,
-				GL_STENCIL_BUFFER_BIT, false);
+				GL_STENCIL_BUFFER_BIT, false,
+				"stencil-sunburst");
 		break;
 	case TEST_TYPE_DEPTH_DRAW:
 		test = new Test(new DepthSunburst(),
 				new ManifestDepth(),
-				false, 0, false);
+				false, 0, false, "depth-sunburst");
 		break;
 	case TEST_TYPE_DEPTH_RESOLVE:
 		test = new Test(new DepthSunburst(),
 				new ManifestDepth(),
 				true,
-				GL_DEPTH_BUFFER_BIT, false);
+				GL_DEPTH_BUFFER_BIT, false,
+				"depth-sunburst");
 		break;
 	default:
 		printf("Unrecognized test type\n");
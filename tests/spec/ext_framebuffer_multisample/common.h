@@ -98,14 +98,15 @@ class Test
 public:
 	Test(piglit_util_test_pattern::TestPattern *pattern,
 	     piglit_util_test_pattern::ManifestProgram *manifest_program,
-	     bool test_resolve, GLbitfield blit_type, bool srgb);
+	     bool test_resolve, GLbitfield blit_type, bool srgb,
+	     const char *reference_name);
 	void init(int num_samples, bool small, bool combine_depth_stencil,
 		  int pattern_width, int pattern_height,
 		  int supersample_factor, GLenum filter_mode);
 	bool run();
 	void draw_test_image(piglit_util_fbo::Fbo *fbo);
 	void draw_to_default_framebuffer();
-	void draw_reference_image();
+	bool draw_reference_image();
 	bool measure_accuracy();
 
 	/**
@@ -118,6 +119,12 @@ private:
 	void downsample_color(int downsampled_width, int downsampled_height);
 	void show(piglit_util_fbo::Fbo *src_fbo, int x_offset, int y_offset);
 	void draw_pattern(int x_offset, int y_offset, int width, int height);
+	void render_reference_image();
+	const char *reference_cache_dir();
+	uint64_t reference_cache_key();
+	bool show_cached_reference_image(const float *data);
+	bool compare_cached_reference_image(const float *cached,
+					    const float *rendered);
 
 	/** The test pattern to draw. */
 	piglit_util_test_pattern::TestPattern *pattern;
@@ -167,6 +174,19 @@ private:
 	 */
 	piglit_util_fbo::Fbo downsample_fbo;
 
+	/**
+	 * Floating point fbo that a reference image from the reference
+	 * image cache is uploaded to, to be shown like a rendered one.
+	 */
+	piglit_util_fbo::Fbo cached_reference_fbo;
+
+	/**
+	 * Name of the pattern and manifest program, which together
+	 * with the pattern size, supersample factor, sRGB and the
+	 * driver determine the reference image.
+	 */
+	const char *reference_name;
+
 	int num_samples;
 	int pattern_width;
 	int pattern_height;
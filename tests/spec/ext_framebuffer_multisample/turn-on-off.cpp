@@ -94,7 +94,7 @@ piglit_display(void)
 	test->draw_test_image(&test->test_fbo);
 
 	/* Draw a reference image for MSAA */
-	test->draw_reference_image();
+	pass = test->draw_reference_image() && pass;
 
 	/* Measure the accuracy of MSAA in multisample FBO by comparing the
 	 * test image to reference image. This varifies if MSAA is actually
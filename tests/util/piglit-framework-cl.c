@@ -23,6 +23,9 @@
 
 #include <stdlib.h>
 #include <regex.h>
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "piglit-framework-cl.h"
 
@@ -132,6 +135,121 @@ bool check_device_extensions(cl_device_id device_id, char* extensions)
 	return true;
 }
 
+/* Run tests per platform or device */
+
+/*
+ * A test run on one platform or device. With PIGLIT_CL_PARALLEL_DEVICES set
+ * each run is started on its own thread, with its own context and command
+ * queue, and the subtest results it reports are collected so they can be
+ * printed in the order of the runs once all of them have finished.
+ */
+struct test_run {
+	int argc;
+	const char** argv;
+	const struct piglit_cl_test_config_header* config;
+	int version;
+	cl_platform_id platform_id;
+	cl_device_id device_id;
+
+	enum piglit_result result;
+	FILE* subtests;
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_t thread;
+	bool started;
+#endif
+};
+
+static void
+run_test(struct test_run* run)
+{
+	piglit_set_subtest_report_stream(run->subtests);
+	piglit_phase_begin(PIGLIT_PHASE_DRAW);
+	run->result = run->config->_test_run(run->argc,
+	                                     run->argv,
+	                                     (void*)run->config,
+	                                     run->version,
+	                                     run->platform_id,
+	                                     run->device_id);
+	piglit_phase_end(PIGLIT_PHASE_DRAW);
+	piglit_set_subtest_report_stream(NULL);
+}
+
+#ifdef PIGLIT_HAS_PTHREADS
+static void*
+run_test_thread(void* data)
+{
+	run_test(data);
+	return NULL;
+}
+#endif
+
+/* Start a test run, or run it now if it can't or shouldn't be threaded */
+static struct test_run*
+start_test_run(int argc, const char** argv,
+               const struct piglit_cl_test_config_header* config,
+               int version, cl_platform_id platform_id, cl_device_id device_id,
+               bool parallel)
+{
+	struct test_run* run = calloc(1, sizeof(struct test_run));
+
+	run->argc = argc;
+	run->argv = argv;
+	run->config = config;
+	run->version = version;
+	run->platform_id = platform_id;
+	run->device_id = device_id;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	if(parallel) {
+		run->subtests = tmpfile();
+		if(run->subtests != NULL &&
+		   pthread_create(&run->thread, NULL, run_test_thread, run) == 0) {
+			run->started = true;
+			return run;
+		}
+
+		fprintf(stderr,
+		        "Could not start a thread for the test, running it now.\n");
+		if(run->subtests != NULL) {
+			fclose(run->subtests);
+			run->subtests = NULL;
+		}
+	}
+#endif
+
+	run_test(run);
+	return run;
+}
+
+/* Wait for a test run, print the subtests it reported and free it */
+static enum piglit_result
+finish_test_run(struct test_run* run)
+{
+	enum piglit_result result;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	if(run->started) {
+		pthread_join(run->thread, NULL);
+	}
+#endif
+
+	if(run->subtests != NULL) {
+		char buffer[4096];
+		size_t size;
+
+		rewind(run->subtests);
+		while((size = fread(buffer, 1, sizeof(buffer), run->subtests)) > 0) {
+			fwrite(buffer, 1, size, stdout);
+		}
+		fflush(stdout);
+		fclose(run->subtests);
+	}
+
+	result = run->result;
+	free(run);
+	return result;
+}
+
 /* Run the test(s) */
 int piglit_cl_framework_run(int argc, char** argv)
 {
@@ -141,6 +259,10 @@ int piglit_cl_framework_run(int argc, char** argv)
 	cl_platform_id platform_id = NULL;
 	cl_device_id device_id = NULL;
 
+	bool parallel = getenv("PIGLIT_CL_PARALLEL_DEVICES") != NULL;
+	struct test_run** runs = NULL;
+	unsigned int num_runs = 0;
+
 	/* Get test configuration */
 	struct piglit_cl_test_config_header *config =
 		piglit_cl_get_test_config(argc,
@@ -157,7 +279,9 @@ int piglit_cl_framework_run(int argc, char** argv)
 
 	/* Init */
 	if(config->init_func != NULL) {
+		piglit_phase_begin(PIGLIT_PHASE_INIT);
 		config->init_func(argc, (const char**)argv, config);
+		piglit_phase_end(PIGLIT_PHASE_INIT);
 	}
 
 	/* Print test name and file */
@@ -189,6 +313,7 @@ int piglit_cl_framework_run(int argc, char** argv)
 	} else {
 		/* Run tests per platform or device */
 		int i;
+		unsigned int r;
 		regex_t platform_regex;
 		regex_t device_regex;
 
@@ -267,13 +392,14 @@ int piglit_cl_framework_run(int argc, char** argv)
 
 				/* run test on platform */
 				print_test_info(config, final_version, platform_id, NULL);
-				piglit_merge_result(&result,
-				                    config->_test_run(argc,
-				                                      (const char**)argv,
-				                                      (void*)config,
-				                                      final_version,
-				                                      platform_id,
-				                                      NULL));
+				runs = realloc(runs, (num_runs + 1) * sizeof(struct test_run*));
+				runs[num_runs++] = start_test_run(argc,
+				                                  (const char**)argv,
+				                                  config,
+				                                  final_version,
+				                                  platform_id,
+				                                  NULL,
+				                                  parallel);
 			} else { //config->run_per_device
 				int j;
 
@@ -341,19 +467,26 @@ int piglit_cl_framework_run(int argc, char** argv)
 					}
 
 					print_test_info(config, version, platform_id, device_id);
-					piglit_merge_result(&result,
-					                    config->_test_run(argc,
-					                                      (const char**)argv,
-					                                      (void*)config,
-					                                      final_version,
-					                                      platform_id,
-					                                      device_id));
+					runs = realloc(runs, (num_runs + 1) * sizeof(struct test_run*));
+					runs[num_runs++] = start_test_run(argc,
+					                                  (const char**)argv,
+					                                  config,
+					                                  final_version,
+					                                  platform_id,
+					                                  device_id,
+					                                  parallel);
 				}
 
 				free(device_ids);
 			}
 		}
 
+		/* Merge the results in the order the runs were started */
+		for(r = 0; r < num_runs; r++) {
+			piglit_merge_result(&result, finish_test_run(runs[r]));
+		}
+		free(runs);
+
 		if(config->platform_regex != NULL) {
 			regfree(&platform_regex);
 		}
@@ -366,7 +499,9 @@ int piglit_cl_framework_run(int argc, char** argv)
 
 	/* Clean */
 	if(config->clean_func != NULL) {
+		piglit_phase_begin(PIGLIT_PHASE_TEARDOWN);
 		config->clean_func(argc, (const char**)argv, config);
+		piglit_phase_end(PIGLIT_PHASE_TEARDOWN);
 	}
 
 	/* Report merged result */
@@ -180,9 +180,36 @@ destroy(void)
 	if (!gl_fw)
 		return;
 
+	piglit_phase_begin(PIGLIT_PHASE_TEARDOWN);
 	if (gl_fw->destroy)
 		gl_fw->destroy(gl_fw);
 	gl_fw = NULL;
+	piglit_phase_end(PIGLIT_PHASE_TEARDOWN);
+}
+
+/* The test's config, with init and display wrapped to time them. */
+static struct piglit_gl_test_config timed_config;
+static void (*test_config_init)(int argc, char *argv[]);
+static enum piglit_result (*test_config_display)(void);
+
+static void
+timed_init(int argc, char *argv[])
+{
+	piglit_phase_begin(PIGLIT_PHASE_INIT);
+	test_config_init(argc, argv);
+	piglit_phase_end(PIGLIT_PHASE_INIT);
+}
+
+static enum piglit_result
+timed_display(void)
+{
+	enum piglit_result result;
+
+	piglit_phase_begin(PIGLIT_PHASE_DRAW);
+	result = test_config_display();
+	piglit_phase_end(PIGLIT_PHASE_DRAW);
+
+	return result;
 }
 
 void
@@ -192,7 +219,17 @@ piglit_gl_test_run(int argc, char *argv[],
 	piglit_width = config->window_width;
 	piglit_height = config->window_height;
 
-	gl_fw = piglit_gl_framework_factory(config);
+	timed_config = *config;
+	test_config_init = config->init;
+	test_config_display = config->display;
+	if (config->init)
+		timed_config.init = timed_init;
+	if (config->display)
+		timed_config.display = timed_display;
+
+	piglit_phase_begin(PIGLIT_PHASE_CONTEXT);
+	gl_fw = piglit_gl_framework_factory(&timed_config);
+	piglit_phase_end(PIGLIT_PHASE_CONTEXT);
 	if (gl_fw == NULL) {
 		printf("piglit: error: failed to create "
 		       "piglit_gl_framework\n");
@@ -22,6 +22,9 @@
  */
 
 #include <inttypes.h>
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "piglit-util-cl.h"
 
@@ -533,17 +536,94 @@ piglit_cl_get_event_profiling_info(cl_event event, cl_profiling_info param) {
 	return piglit_cl_get_info(clGetEventProfilingInfo, &event, param);
 }
 
-bool
-piglit_cl_is_platform_extension_supported(cl_platform_id platform,
-                                          const char *name)
+/**
+ * Extension sets of the platforms and devices queried so far.  Their
+ * extensions can't change during the life of the process, so each set is
+ * built on the first query and kept.  Devices may be tested on their own
+ * threads, so the cache is only touched with cl_extension_cache_lock held.
+ */
+static struct cl_extension_cache {
+	const void *object;
+	struct piglit_extension_set *set;
+	struct cl_extension_cache *next;
+} *cl_extension_cache = NULL;
+#ifdef PIGLIT_HAS_PTHREADS
+static pthread_mutex_t cl_extension_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static const struct piglit_extension_set *
+cl_cached_extension_set(const void *object)
+{
+	struct cl_extension_cache *entry;
+
+	for (entry = cl_extension_cache; entry; entry = entry->next) {
+		if (entry->object == object)
+			return entry->set;
+	}
+
+	return NULL;
+}
+
+static const struct piglit_extension_set *
+cl_cache_extension_set(const void *object, char *extensions)
 {
-	char* extensions = piglit_cl_get_platform_info(platform,
-	                                               CL_PLATFORM_EXTENSIONS);
-	bool supported = piglit_is_extension_in_string(extensions, name);
+	struct cl_extension_cache *entry = malloc(sizeof(*entry));
+
+	if (entry == NULL) {
+		fprintf(stderr, "Could not allocate extension cache entry\n");
+		free(extensions);
+		return NULL;
+	}
+
+	entry->object = object;
+	entry->set = piglit_extension_set_create_from_string(extensions);
+	entry->next = cl_extension_cache;
+	cl_extension_cache = entry;
 
 	free(extensions);
+	return entry->set;
+}
 
-	return supported;
+/**
+ * Look up the extension set of \p platform, or of \p device when it isn't
+ * NULL, querying it and adding it to the cache on the first call.
+ */
+static const struct piglit_extension_set *
+cl_get_extension_set(cl_platform_id platform, cl_device_id device)
+{
+	const void *object = device != NULL ? (const void *)device
+	                                    : (const void *)platform;
+	const struct piglit_extension_set *set;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&cl_extension_cache_lock);
+#endif
+	set = cl_cached_extension_set(object);
+	if (set == NULL && device != NULL) {
+		set = cl_cache_extension_set(device,
+			piglit_cl_get_device_info(device,
+			                          CL_DEVICE_EXTENSIONS));
+	} else if (set == NULL) {
+		set = cl_cache_extension_set(platform,
+			piglit_cl_get_platform_info(platform,
+			                            CL_PLATFORM_EXTENSIONS));
+	}
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_unlock(&cl_extension_cache_lock);
+#endif
+
+	if (set == NULL)
+		piglit_report_result(PIGLIT_FAIL);
+
+	return set;
+}
+
+bool
+piglit_cl_is_platform_extension_supported(cl_platform_id platform,
+                                          const char *name)
+{
+	return piglit_extension_set_contains(
+		cl_get_extension_set(platform, NULL), name);
 }
 
 void
@@ -568,12 +648,8 @@ piglit_cl_require_not_platform_extension(cl_platform_id platform,
 bool
 piglit_cl_is_device_extension_supported(cl_device_id device, const char *name)
 {
-	char* extensions = piglit_cl_get_device_info(device, CL_DEVICE_EXTENSIONS);
-	bool supported = piglit_is_extension_in_string(extensions, name);
-
-	free(extensions);
-
-	return supported;
+	return piglit_extension_set_contains(
+		cl_get_extension_set(NULL, device), name);
 }
 
 void
@@ -718,12 +794,14 @@ piglit_cl_create_context(cl_platform_id platform_id,
 	memcpy(context->device_ids, device_ids, num_devices * sizeof(cl_device_id));
 
 	/* create and assign context */
+	piglit_phase_begin(PIGLIT_PHASE_CONTEXT);
 	context->cl_ctx = clCreateContext(cl_ctx_properties,
 	                                  context->num_devices,
 	                                  context->device_ids,
 	                                  NULL,
 	                                  NULL,
 	                                  &errNo);
+	piglit_phase_end(PIGLIT_PHASE_CONTEXT);
 	if(errNo != CL_SUCCESS) {
 		free(context->device_ids);
 		free(context);
@@ -782,6 +860,181 @@ piglit_cl_release_context(piglit_cl_context context)
 	free(context);
 }
 
+/*
+ * Program binary cache, enabled by pointing PIGLIT_CL_PROGRAM_CACHE_DIR at an
+ * existing directory in tests that opted in with piglit_cl_use_program_cache().
+ * Programs built from source are stored with their CL_PROGRAM_BINARIES, keyed
+ * by the devices, their drivers, the build options and the source, and later
+ * builds of the same program are done from those binaries instead. Builds
+ * that are expected to fail never use the cache.
+ */
+static bool program_cache_enabled = false;
+static unsigned program_cache_hits = 0;
+static unsigned program_cache_misses = 0;
+#ifdef PIGLIT_HAS_PTHREADS
+static pthread_mutex_t program_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+cl_program
+piglit_cl_build_program_with_binary_extended(piglit_cl_context context,
+                                             size_t* lenghts,
+                                             unsigned char** binaries,
+                                             const char* options, bool fail);
+
+void
+piglit_cl_use_program_cache(bool enable)
+{
+	program_cache_enabled = enable;
+}
+
+static void
+program_cache_count(bool hit)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&program_cache_lock);
+#endif
+	if(hit) {
+		program_cache_hits++;
+	} else {
+		program_cache_misses++;
+	}
+	printf("Program cache %s (%u hits, %u misses)\n",
+	       hit ? "hit" : "miss", program_cache_hits, program_cache_misses);
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_unlock(&program_cache_lock);
+#endif
+}
+
+static uint64_t
+program_cache_key(piglit_cl_context context, cl_uint count, char** strings,
+                  const char* options)
+{
+	static const cl_device_info device_strings[] = {
+		CL_DEVICE_NAME, CL_DEVICE_VENDOR, CL_DEVICE_VERSION, CL_DRIVER_VERSION
+	};
+	uint64_t key = PIGLIT_HASH_INIT;
+	unsigned i, j;
+
+	for(i = 0; i < context->num_devices; i++) {
+		for(j = 0; j < ARRAY_SIZE(device_strings); j++) {
+			char* info = piglit_cl_get_device_info(context->device_ids[i],
+			                                       device_strings[j]);
+			key = piglit_hash_string(key, info);
+			free(info);
+		}
+	}
+
+	key = piglit_hash_string(key, options);
+	key = piglit_hash_update(key, &count, sizeof(count));
+	for(i = 0; i < count; i++) {
+		key = piglit_hash_string(key, strings[i]);
+	}
+
+	return key;
+}
+
+/*
+ * Entries start with the number of devices and the size of the binary of
+ * each device, followed by the binaries themselves.
+ */
+static cl_program
+program_cache_load(const char* dir, uint64_t key, piglit_cl_context context,
+                   const char* options)
+{
+	size_t size;
+	char* data = piglit_cache_load(dir, key, &size);
+	size_t header_size = sizeof(cl_uint) + context->num_devices * sizeof(size_t);
+	cl_program program = NULL;
+	cl_uint num_devices;
+	size_t* lengths;
+	unsigned char** binaries;
+	size_t offset;
+	unsigned i;
+
+	if(data == NULL) {
+		return NULL;
+	}
+
+	if(size < header_size) {
+		free(data);
+		return NULL;
+	}
+	memcpy(&num_devices, data, sizeof(cl_uint));
+	if(num_devices != context->num_devices) {
+		free(data);
+		return NULL;
+	}
+
+	lengths = malloc(num_devices * sizeof(size_t));
+	binaries = malloc(num_devices * sizeof(unsigned char*));
+	memcpy(lengths, data + sizeof(cl_uint), num_devices * sizeof(size_t));
+	offset = header_size;
+	for(i = 0; i < num_devices; i++) {
+		if(lengths[i] == 0 || lengths[i] > size - offset) {
+			break;
+		}
+		binaries[i] = (unsigned char*)data + offset;
+		offset += lengths[i];
+	}
+
+	if(i == num_devices) {
+		program = piglit_cl_build_program_with_binary_extended(context,
+		                                                       lengths,
+		                                                       binaries,
+		                                                       options,
+		                                                       false);
+	}
+
+	free(binaries);
+	free(lengths);
+	free(data);
+	return program;
+}
+
+static void
+program_cache_store(const char* dir, uint64_t key, piglit_cl_context context,
+                    cl_program program)
+{
+	cl_uint num_devices = context->num_devices;
+	size_t* lengths = malloc(num_devices * sizeof(size_t));
+	unsigned char** binaries = malloc(num_devices * sizeof(unsigned char*));
+	size_t header_size = sizeof(cl_uint) + num_devices * sizeof(size_t);
+	size_t size = header_size;
+	char* data = NULL;
+	unsigned i;
+
+	if(clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES,
+	                    num_devices * sizeof(size_t), lengths,
+	                    NULL) != CL_SUCCESS) {
+		goto out;
+	}
+	for(i = 0; i < num_devices; i++) {
+		if(lengths[i] == 0) {
+			goto out;
+		}
+		size += lengths[i];
+	}
+
+	data = malloc(size);
+	memcpy(data, &num_devices, sizeof(cl_uint));
+	memcpy(data + sizeof(cl_uint), lengths, num_devices * sizeof(size_t));
+	binaries[0] = (unsigned char*)data + header_size;
+	for(i = 1; i < num_devices; i++) {
+		binaries[i] = binaries[i-1] + lengths[i-1];
+	}
+
+	if(clGetProgramInfo(program, CL_PROGRAM_BINARIES,
+	                    num_devices * sizeof(unsigned char*), binaries,
+	                    NULL) == CL_SUCCESS) {
+		piglit_cache_store(dir, key, data, size);
+	}
+
+out:
+	free(data);
+	free(binaries);
+	free(lengths);
+}
+
 cl_program
 piglit_cl_build_program_with_source_extended(piglit_cl_context context,
                                              cl_uint count, char** strings,
@@ -789,6 +1042,18 @@ piglit_cl_build_program_with_source_extended(piglit_cl_context context,
 {
 	cl_int errNo;
 	cl_program program;
+	const char* cache_dir = program_cache_enabled && !fail
+	                        ? getenv("PIGLIT_CL_PROGRAM_CACHE_DIR") : NULL;
+	uint64_t cache_key = 0;
+
+	if(cache_dir != NULL) {
+		cache_key = program_cache_key(context, count, strings, options);
+		program = program_cache_load(cache_dir, cache_key, context, options);
+		program_cache_count(program != NULL);
+		if(program != NULL) {
+			return program;
+		}
+	}
 
 	program = clCreateProgramWithSource(context->cl_ctx,
 	                                    count,
@@ -802,12 +1067,14 @@ piglit_cl_build_program_with_source_extended(piglit_cl_context context,
 		return NULL;
 	}
 	
+	piglit_phase_begin(PIGLIT_PHASE_COMPILE);
 	errNo = clBuildProgram(program,
 	                       context->num_devices,
 	                       context->device_ids,
 	                       options,
 	                       NULL,
 	                       NULL);
+	piglit_phase_end(PIGLIT_PHASE_COMPILE);
 	if(   (!fail && errNo != CL_SUCCESS)
 	   || ( fail && errNo == CL_SUCCESS)) {
 		int i;
@@ -841,6 +1108,10 @@ piglit_cl_build_program_with_source_extended(piglit_cl_context context,
 		return NULL;
 	}
 
+	if(cache_dir != NULL) {
+		program_cache_store(cache_dir, cache_key, context, program);
+	}
+
 	return program;
 }
 
@@ -901,12 +1172,14 @@ piglit_cl_build_program_with_binary_extended(piglit_cl_context context,
 	}
 	free(binary_status);
 	
+	piglit_phase_begin(PIGLIT_PHASE_COMPILE);
 	errNo = clBuildProgram(program,
 	                       context->num_devices,
 	                       context->device_ids,
 	                       options,
 	                       NULL,
 	                       NULL);
+	piglit_phase_end(PIGLIT_PHASE_COMPILE);
 	if(   (!fail && errNo != CL_SUCCESS)
 	   || ( fail && errNo == CL_SUCCESS)) {
 		int i;
@@ -978,13 +1251,13 @@ piglit_cl_create_buffer(piglit_cl_context context, cl_mem_flags flags,
 	return buffer;
 }
 
-bool
-piglit_cl_write_buffer(cl_command_queue command_queue, cl_mem buffer,
-                       size_t offset, size_t cb, const void *ptr)
+static bool
+write_buffer(cl_command_queue command_queue, cl_mem buffer, cl_bool blocking,
+             size_t offset, size_t cb, const void *ptr)
 {
 	cl_int errNo;
 
-	errNo = clEnqueueWriteBuffer(command_queue, buffer, CL_TRUE, offset, cb,
+	errNo = clEnqueueWriteBuffer(command_queue, buffer, blocking, offset, cb,
 	                             ptr, 0, NULL, NULL);
 	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
 		fprintf(stderr,
@@ -996,6 +1269,20 @@ piglit_cl_write_buffer(cl_command_queue command_queue, cl_mem buffer,
 	return true;
 }
 
+bool
+piglit_cl_write_buffer(cl_command_queue command_queue, cl_mem buffer,
+                       size_t offset, size_t cb, const void *ptr)
+{
+	return write_buffer(command_queue, buffer, CL_TRUE, offset, cb, ptr);
+}
+
+bool
+piglit_cl_enqueue_write_buffer(cl_command_queue command_queue, cl_mem buffer,
+                               size_t offset, size_t cb, const void *ptr)
+{
+	return write_buffer(command_queue, buffer, CL_FALSE, offset, cb, ptr);
+}
+
 bool
 piglit_cl_write_whole_buffer(cl_command_queue command_queue, cl_mem buffer,
                              const void *ptr)
@@ -1011,14 +1298,14 @@ piglit_cl_write_whole_buffer(cl_command_queue command_queue, cl_mem buffer,
 	return success;
 }
 
-bool
-piglit_cl_read_buffer(cl_command_queue command_queue, cl_mem buffer,
-                      size_t offset, size_t cb, void *ptr)
+static bool
+read_buffer(cl_command_queue command_queue, cl_mem buffer, cl_bool blocking,
+            size_t offset, size_t cb, void *ptr)
 {
 	cl_int errNo;
 
-	errNo = clEnqueueReadBuffer(command_queue, buffer, CL_TRUE, offset, cb, ptr,
-	                            0, NULL, NULL);
+	errNo = clEnqueueReadBuffer(command_queue, buffer, blocking, offset, cb,
+	                            ptr, 0, NULL, NULL);
 	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
 		fprintf(stderr,
 		        "Could not enqueue buffer read: %s\n",
@@ -1029,6 +1316,20 @@ piglit_cl_read_buffer(cl_command_queue command_queue, cl_mem buffer,
 	return true;
 }
 
+bool
+piglit_cl_read_buffer(cl_command_queue command_queue, cl_mem buffer,
+                      size_t offset, size_t cb, void *ptr)
+{
+	return read_buffer(command_queue, buffer, CL_TRUE, offset, cb, ptr);
+}
+
+bool
+piglit_cl_enqueue_read_buffer(cl_command_queue command_queue, cl_mem buffer,
+                              size_t offset, size_t cb, void *ptr)
+{
+	return read_buffer(command_queue, buffer, CL_FALSE, offset, cb, ptr);
+}
+
 bool
 piglit_cl_read_whole_buffer(cl_command_queue command_queue, cl_mem buffer,
                             void *ptr)
@@ -1109,14 +1410,13 @@ piglit_cl_create_image(piglit_cl_context context, cl_mem_flags flags,
 	return image;
 }
 
-bool
-piglit_cl_write_image(cl_command_queue command_queue, cl_mem image,
-                      const size_t *origin, const size_t *region,
-                      const void *ptr)
+static bool
+write_image(cl_command_queue command_queue, cl_mem image, cl_bool blocking,
+            const size_t *origin, const size_t *region, const void *ptr)
 {
 	cl_int errNo;
 
-	errNo = clEnqueueWriteImage(command_queue, image, CL_TRUE, origin, region,
+	errNo = clEnqueueWriteImage(command_queue, image, blocking, origin, region,
 	                            0, 0, ptr, 0, NULL, NULL);
 	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
 		fprintf(stderr,
@@ -1128,6 +1428,14 @@ piglit_cl_write_image(cl_command_queue command_queue, cl_mem image,
 	return true;
 }
 
+bool
+piglit_cl_write_image(cl_command_queue command_queue, cl_mem image,
+                      const size_t *origin, const size_t *region,
+                      const void *ptr)
+{
+	return write_image(command_queue, image, CL_TRUE, origin, region, ptr);
+}
+
 static void
 piglit_get_image_region(cl_mem image, size_t *region)
 {
@@ -1196,13 +1504,23 @@ piglit_cl_write_whole_image(cl_command_queue command_queue, cl_mem image,
 }
 
 bool
-piglit_cl_read_image(cl_command_queue command_queue, cl_mem image,
-                     const size_t *origin, const size_t *region,
-                     void *ptr)
+piglit_cl_enqueue_write_whole_image(cl_command_queue command_queue,
+                                    cl_mem image, const void *ptr)
+{
+	size_t origin[3], region[3];
+
+	memset(origin, 0, sizeof(origin));
+	piglit_get_image_region(image, region);
+	return write_image(command_queue, image, CL_FALSE, origin, region, ptr);
+}
+
+static bool
+read_image(cl_command_queue command_queue, cl_mem image, cl_bool blocking,
+           const size_t *origin, const size_t *region, void *ptr)
 {
 	cl_int errNo;
 
-	errNo = clEnqueueReadImage(command_queue, image, CL_TRUE, origin, region,
+	errNo = clEnqueueReadImage(command_queue, image, blocking, origin, region,
 	                           0, 0, ptr, 0, NULL, NULL);
 	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
 		fprintf(stderr,
@@ -1214,6 +1532,14 @@ piglit_cl_read_image(cl_command_queue command_queue, cl_mem image,
 	return true;
 }
 
+bool
+piglit_cl_read_image(cl_command_queue command_queue, cl_mem image,
+                     const size_t *origin, const size_t *region,
+                     void *ptr)
+{
+	return read_image(command_queue, image, CL_TRUE, origin, region, ptr);
+}
+
 bool
 piglit_cl_read_whole_image(cl_command_queue command_queue, cl_mem image,
                            void *ptr)
@@ -1228,6 +1554,17 @@ piglit_cl_read_whole_image(cl_command_queue command_queue, cl_mem image,
 	return success;
 }
 
+bool
+piglit_cl_enqueue_read_whole_image(cl_command_queue command_queue,
+                                   cl_mem image, void *ptr)
+{
+	size_t origin[3], region[3];
+
+	memset(origin, 0, sizeof(origin));
+	piglit_get_image_region(image, region);
+	return read_image(command_queue, image, CL_FALSE, origin, region, ptr);
+}
+
 cl_kernel
 piglit_cl_create_kernel(cl_program program, const char* kernel_name)
 {
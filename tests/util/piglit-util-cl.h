@@ -402,11 +402,28 @@ piglit_cl_create_context(cl_platform_id platform_id,
 void
 piglit_cl_release_context(piglit_cl_context context);
 
+/**
+ * \brief Enable or disable the program binary cache.
+ *
+ * The cache is disabled by default. Programs built from cached binaries
+ * have no source and may lack information requested with build options
+ * such as \c -cl-kernel-arg-info, so only tests that just run the kernels
+ * of their programs should enable it.
+ *
+ * @param enable  Whether \c piglit_cl_build_program_with_source uses
+ *                PIGLIT_CL_PROGRAM_CACHE_DIR.
+ */
+void
+piglit_cl_use_program_cache(bool enable);
+
 /**
  * \brief Create and build a program with source.
  *
  * Create and build a program with source for all devices in
- * \c piglit_cl_context.
+ * \c piglit_cl_context. If the test enabled the program cache with
+ * \c piglit_cl_use_program_cache() and PIGLIT_CL_PROGRAM_CACHE_DIR names an
+ * existing directory, the program binaries are cached there and used instead
+ * of the source on later builds of the same program.
  *
  * @param context      Context on which to create and build program.
  * @param count        Number of strings in \c strings.
@@ -504,6 +521,25 @@ piglit_cl_write_buffer(cl_command_queue command_queue,
                        size_t cb,
                        const void *ptr);
 
+/**
+ * \brief Non-blocking write to a buffer.
+ *
+ * \warning \c ptr must stay valid until the command queue is finished.
+ *
+ * @param command_queue  Command queue to enqueue operation on.
+ * @param buffer         Memory buffer to write to.
+ * @param offset         Offset in buffer.
+ * @param cb             Size of data in bytes.
+ * @param ptr            Pointer to data to be written to buffer.
+ * @return               \c true on succes, \c false otherwise.
+ */
+bool
+piglit_cl_enqueue_write_buffer(cl_command_queue command_queue,
+                               cl_mem buffer,
+                               size_t offset,
+                               size_t cb,
+                               const void *ptr);
+
 /**
  * \brief Blocking write to a whole buffer.
  *
@@ -537,6 +573,25 @@ piglit_cl_read_buffer(cl_command_queue command_queue,
                       size_t cb,
                       void *ptr);
 
+/**
+ * \brief Non-blocking read from a buffer.
+ *
+ * The data is only available in \c ptr once the command queue is finished.
+ *
+ * @param command_queue  Command queue to enqueue operation on.
+ * @param buffer         Memory buffer to read from.
+ * @param offset         Offset in buffer.
+ * @param cb             Size of data in bytes.
+ * @param ptr            Pointer to data to be written from buffer.
+ * @return               \c true on succes, \c false otherwise.
+ */
+bool
+piglit_cl_enqueue_read_buffer(cl_command_queue command_queue,
+                              cl_mem buffer,
+                              size_t offset,
+                              size_t cb,
+                              void *ptr);
+
 /**
  * \brief Blocking read from a whole buffer.
  *
@@ -637,6 +692,23 @@ piglit_cl_write_whole_image(cl_command_queue command_queue,
                             cl_mem image,
                             const void *ptr);
 
+/**
+ * \brief Non-blocking write to the entire area of an image.
+ *
+ * \warning \c ptr must point to memory space which is equal or larger
+ * in size than \c image, and must stay valid until the command queue is
+ * finished.
+ *
+ * @param command_queue  Command queue to enqueue operation on.
+ * @param image          Image to write to.
+ * @param ptr            Pointer to data to be written to image.
+ * @return               \c true on succes, \c false otherwise.
+ */
+bool
+piglit_cl_enqueue_write_whole_image(cl_command_queue command_queue,
+                                    cl_mem image,
+                                    const void *ptr);
+
 /**
  * \brief Blocking read from an image.
  *
@@ -670,6 +742,24 @@ piglit_cl_read_whole_image(cl_command_queue command_queue,
                            cl_mem image,
                            void *ptr);
 
+/**
+ * \brief Non-blocking read of the full contents of an image.
+ *
+ * The data is only available in \c ptr once the command queue is finished.
+ *
+ * \warning \c ptr must point to memory space which is equal or larger
+ * in size than \c image.
+ *
+ * @param command_queue  Command queue to enqueue operation on.
+ * @param image          Image to read from.
+ * @param ptr            Pointer to data read from image.
+ * @return               \c true on succes, \c false otherwise.
+ */
+bool
+piglit_cl_enqueue_read_whole_image(cl_command_queue command_queue,
+                                   cl_mem image,
+                                   void *ptr);
+
 /**
  * \brief Create a sampler.
  *
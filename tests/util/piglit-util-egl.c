@@ -131,6 +131,47 @@ piglit_egl_get_default_display(EGLenum platform)
 	return peglGetPlatformDisplayEXT(platform, EGL_DEFAULT_DISPLAY, NULL);
 }
 
+/**
+ * Extension sets of the displays queried so far, along with the extension
+ * string each one was built from, so that a display that was terminated
+ * and reinitialized with different extensions gets a fresh set.
+ */
+static struct egl_extension_cache {
+	EGLDisplay dpy;
+	char *string;
+	struct piglit_extension_set *set;
+	struct egl_extension_cache *next;
+} *egl_extension_cache = NULL;
+
+static const struct piglit_extension_set *
+egl_extension_set(EGLDisplay egl_dpy, const char *egl_extension_list)
+{
+	struct egl_extension_cache *entry;
+
+	if (egl_extension_list == NULL)
+		egl_extension_list = "";
+
+	for (entry = egl_extension_cache; entry; entry = entry->next) {
+		if (entry->dpy == egl_dpy)
+			break;
+	}
+
+	if (entry == NULL) {
+		entry = calloc(1, sizeof(*entry));
+		entry->dpy = egl_dpy;
+		entry->next = egl_extension_cache;
+		egl_extension_cache = entry;
+	} else if (strcmp(entry->string, egl_extension_list) == 0) {
+		return entry->set;
+	}
+
+	free(entry->string);
+	piglit_extension_set_destroy(entry->set);
+	entry->string = strdup(egl_extension_list);
+	entry->set = piglit_extension_set_create_from_string(egl_extension_list);
+	return entry->set;
+}
+
 bool
 piglit_is_egl_extension_supported(EGLDisplay egl_dpy, const char *name)
 {
@@ -147,7 +188,8 @@ piglit_is_egl_extension_supported(EGLDisplay egl_dpy, const char *name)
 			piglit_check_egl_error(EGL_BAD_DISPLAY))
 		return false;
 
-	return piglit_is_extension_in_string(egl_extension_list, name);
+	return piglit_extension_set_contains(
+		egl_extension_set(egl_dpy, egl_extension_list), name);
 }
 
 void piglit_require_egl_extension(EGLDisplay dpy, const char *name)
@@ -24,16 +24,19 @@
 #include "piglit-util-gl.h"
 #include <ctype.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 /**
- * An array of pointers to extension strings.
- *
- * Each extension is pointed to by a separate entry in the array.
+ * The set of extensions supported by the current context.
  *
- * The end of the array is indicated by a NULL pointer.
+ * Built on the first piglit_is_extension_supported() call and dropped by
+ * piglit_gl_invalidate_extensions().
  */
-static const char **gl_extensions = NULL;
+static struct piglit_extension_set *gl_extensions = NULL;
 
 static const float color_wheel[4][4] = {
 	{1, 0, 0, 1}, /* red */
@@ -77,15 +80,16 @@ int piglit_get_gl_version(void)
 	return 10*major+minor;
 }
 
-static const char** gl_extension_array_from_getstring()
+static struct piglit_extension_set *gl_extension_set_from_getstring()
 {
 	const char *gl_extensions_string;
 	gl_extensions_string = (const char *) glGetString(GL_EXTENSIONS);
-	return piglit_split_string_to_array(gl_extensions_string, " ");
+	return piglit_extension_set_create_from_string(gl_extensions_string);
 }
 
-static const char** gl_extension_array_from_getstringi()
+static struct piglit_extension_set *gl_extension_set_from_getstringi()
 {
+	struct piglit_extension_set *set;
 	const char **strings;
 	int loop, num_extensions;
 
@@ -99,7 +103,9 @@ static const char** gl_extension_array_from_getstringi()
 
 	strings[loop] = NULL;
 
-	return (const char**) strings;
+	set = piglit_extension_set_create_from_array(strings);
+	free(strings);
+	return set;
 }
 
 static void initialize_piglit_extension_support(void)
@@ -109,24 +115,22 @@ static void initialize_piglit_extension_support(void)
 	}
 
 	if (piglit_get_gl_version() < 30) {
-		gl_extensions = gl_extension_array_from_getstring();
+		gl_extensions = gl_extension_set_from_getstring();
 	} else {
-		gl_extensions = gl_extension_array_from_getstringi();
+		gl_extensions = gl_extension_set_from_getstringi();
 	}
 }
 
 void piglit_gl_invalidate_extensions()
 {
-	if (gl_extensions != NULL) {
-		free(gl_extensions);
-		gl_extensions = NULL;
-	}
+	piglit_extension_set_destroy(gl_extensions);
+	gl_extensions = NULL;
 }
 
 bool piglit_is_extension_supported(const char *name)
 {
 	initialize_piglit_extension_support();
-	return piglit_is_extension_in_array(gl_extensions, name);
+	return piglit_extension_set_contains(gl_extensions, name);
 }
 
 void piglit_require_gl_version(int required_version_times_10)
@@ -1037,6 +1041,131 @@ piglit_get_luminance_intensity_bits(GLenum internalformat, int *bits)
 	return false;
 }
 
+/**
+ * Framebuffer readback cache used by the color probes, see
+ * piglit_probe_cache_enable().
+ *
+ * There is one RGBA image per readback type.  Each one covers the
+ * rectangle (0, 0, width, height) of the read framebuffer and is filled
+ * by the first probe that needs it after the cache was invalidated.
+ */
+struct probe_cache_image {
+	GLenum type;
+	void *pixels;
+	int width, height;
+	bool valid;
+};
+
+static struct {
+	bool enabled;
+	unsigned readbacks_saved;
+	int can_probe_ubyte;
+	struct probe_cache_image images[2];
+} probe_cache = {
+	.can_probe_ubyte = -1,
+	.images = { { GL_FLOAT }, { GL_UNSIGNED_BYTE } },
+};
+
+void
+piglit_probe_cache_enable(bool enable)
+{
+	unsigned i;
+
+	piglit_probe_cache_invalidate();
+	for (i = 0; i < ARRAY_SIZE(probe_cache.images); i++) {
+		free(probe_cache.images[i].pixels);
+		probe_cache.images[i].pixels = NULL;
+		probe_cache.images[i].width = 0;
+		probe_cache.images[i].height = 0;
+	}
+
+	probe_cache.enabled = enable;
+	probe_cache.readbacks_saved = 0;
+}
+
+void
+piglit_probe_cache_invalidate(void)
+{
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(probe_cache.images); i++)
+		probe_cache.images[i].valid = false;
+	probe_cache.can_probe_ubyte = -1;
+}
+
+unsigned
+piglit_probe_cache_readbacks_saved(void)
+{
+	return probe_cache.readbacks_saved;
+}
+
+/**
+ * Return the cached RGBA pixels of the given \p type for the rectangle
+ * (x, y, w, h), reading back the framebuffer first if the cached image is
+ * stale or too small.  The row stride of the returned image, in pixels, is
+ * returned in \p stride.
+ *
+ * Returns NULL if the cache is disabled, in which case the caller should
+ * read the pixels itself.
+ */
+static const void *
+probe_cache_read(int x, int y, int w, int h, GLenum type, int *stride)
+{
+	struct probe_cache_image *image = NULL;
+	unsigned bpp, i;
+	int width, height;
+
+	if (!probe_cache.enabled || x < 0 || y < 0 || w <= 0 || h <= 0)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(probe_cache.images); i++) {
+		if (probe_cache.images[i].type == type)
+			image = &probe_cache.images[i];
+	}
+	assert(image != NULL);
+
+	bpp = 4 * (type == GL_FLOAT ? sizeof(GLfloat) : sizeof(GLubyte));
+
+	if (image->valid && x + w <= image->width &&
+	    y + h <= image->height) {
+		probe_cache.readbacks_saved++;
+	} else {
+		width = MAX2(x + w, piglit_width);
+		height = MAX2(y + h, piglit_height);
+		if (image->valid) {
+			width = MAX2(width, image->width);
+			height = MAX2(height, image->height);
+		}
+
+		free(image->pixels);
+		image->pixels = malloc((size_t) width * height * bpp);
+		image->width = width;
+		image->height = height;
+		image->valid = true;
+
+		piglit_phase_begin(PIGLIT_PHASE_READBACK);
+		if (type == GL_FLOAT && piglit_is_gles()) {
+			GLubyte *pixels_b = malloc((size_t) width * height * 4);
+			GLfloat *pixels_f = image->pixels;
+			size_t n;
+
+			glReadPixels(0, 0, width, height, GL_RGBA,
+				     GL_UNSIGNED_BYTE, pixels_b);
+			for (n = 0; n < (size_t) width * height * 4; n++)
+				pixels_f[n] = pixels_b[n] / 255.0;
+			free(pixels_b);
+		} else {
+			glReadPixels(0, 0, width, height, GL_RGBA, type,
+				     image->pixels);
+		}
+		piglit_phase_end(PIGLIT_PHASE_READBACK);
+	}
+
+	*stride = image->width;
+	return (const char *) image->pixels +
+		((size_t) y * image->width + x) * bpp;
+}
+
 /* Wrapper around glReadPixels that always returns floats; reads and converts
  * GL_UNSIGNED_BYTE on GLES.  If pixels == NULL, malloc a float array of the
  * appropriate size, otherwise use the one provided. */
@@ -1045,22 +1174,45 @@ piglit_read_pixels_float(GLint x, GLint y, GLsizei width, GLsizei height,
                          GLenum format, GLfloat *pixels)
 {
 	GLubyte *pixels_b;
+	const GLfloat *cached;
 	unsigned i, ncomponents;
+	int stride;
 
 	ncomponents = width * height * piglit_num_components(format);
 	if (!pixels)
 		pixels = malloc(ncomponents * sizeof(GLfloat));
 
-	if (!piglit_is_gles()) {
-		glReadPixels(x, y, width, height, format, GL_FLOAT, pixels);
+	if ((format == GL_RGBA || format == GL_RGB) &&
+	    (cached = probe_cache_read(x, y, width, height, GL_FLOAT,
+				       &stride))) {
+		unsigned c = piglit_num_components(format);
+		GLfloat *dst = pixels;
+		int px, py;
+
+		for (py = 0; py < height; py++) {
+			const GLfloat *src = cached + (size_t) py * stride * 4;
+
+			for (px = 0; px < width; px++) {
+				memcpy(dst, src, c * sizeof(GLfloat));
+				dst += c;
+				src += 4;
+			}
+		}
 		return pixels;
 	}
 
-	pixels_b = malloc(ncomponents * sizeof(GLubyte));
-	glReadPixels(x, y, width, height, format, GL_UNSIGNED_BYTE, pixels_b);
-	for (i = 0; i < ncomponents; i++)
-		pixels[i] = pixels_b[i] / 255.0;
-	free(pixels_b);
+	piglit_phase_begin(PIGLIT_PHASE_READBACK);
+	if (!piglit_is_gles()) {
+		glReadPixels(x, y, width, height, format, GL_FLOAT, pixels);
+	} else {
+		pixels_b = malloc(ncomponents * sizeof(GLubyte));
+		glReadPixels(x, y, width, height, format, GL_UNSIGNED_BYTE,
+			     pixels_b);
+		for (i = 0; i < ncomponents; i++)
+			pixels[i] = pixels_b[i] / 255.0;
+		free(pixels_b);
+	}
+	piglit_phase_end(PIGLIT_PHASE_READBACK);
 	return pixels;
 }
 
@@ -1069,6 +1221,10 @@ piglit_can_probe_ubyte()
 {
 	int r,g,b,a,read;
 
+	if (probe_cache.enabled && probe_cache.can_probe_ubyte >= 0)
+		return probe_cache.can_probe_ubyte;
+	probe_cache.can_probe_ubyte = false;
+
 	if (!piglit_is_extension_supported("GL_ARB_framebuffer_object"))
 		return false;
 
@@ -1091,7 +1247,8 @@ piglit_can_probe_ubyte()
 	if (!r && !g && !b && !a)
 		return false;
 
-	return r <= 8 && g <= 8 && b <= 8 && a <= 8;
+	probe_cache.can_probe_ubyte = r <= 8 && g <= 8 && b <= 8 && a <= 8;
+	return probe_cache.can_probe_ubyte;
 }
 
 int
@@ -1192,6 +1349,265 @@ piglit_probe_pixel_rgba(int x, int y, const float* expected)
 	return 0;
 }
 
+/**
+ * Result of comparing a rectangle of pixels with compare_rect_float() or
+ * compare_rect_ubyte().
+ */
+struct compare_stats {
+	/** Position of the first mismatching pixel in the rectangle, in
+	 * row-major order, or -1 if all pixels matched. */
+	int first_x, first_y;
+	/** Number of pixels with at least one mismatching channel. */
+	unsigned mismatches;
+	/** Largest absolute difference seen in each compared channel,
+	 * in the units of the data (0-255 for ubyte comparisons). */
+	float max_error[4];
+};
+
+static void
+compare_stats_init(struct compare_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->first_x = -1;
+	stats->first_y = -1;
+}
+
+static void
+compare_stats_add_mismatch(struct compare_stats *stats, int x, int y)
+{
+	if (stats->mismatches++ == 0) {
+		stats->first_x = x;
+		stats->first_y = y;
+	}
+}
+
+/**
+ * Compare one row of \p w pixels of \p components floats each.  The first
+ * \p compared channels of each pixel are checked, and a channel mismatches
+ * when its absolute difference is >= its tolerance.  If \p expected_step
+ * is zero, every pixel is compared against the single pixel at
+ * \p expected.
+ */
+static void
+compare_row_float(const float *observed, const float *expected,
+		  int expected_step, int w, int components, int compared,
+		  const float *tolerance, int y, struct compare_stats *stats)
+{
+	int i, p;
+
+#ifdef __SSE2__
+	if (components == 4) {
+		const __m128 abs_mask =
+			_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const int lanes = (1 << compared) - 1;
+		__m128 max_error = _mm_setzero_ps();
+		float tol_in[4] = { 0 }, ref[4] = { 0 }, max_out[4];
+		__m128 tol, e = _mm_setzero_ps();
+
+		/* Callers probing RGB pass 3-channel expected values and
+		 * tolerances, so only read the compared channels and leave
+		 * the rest masked off by \c lanes.
+		 */
+		memcpy(tol_in, tolerance, compared * sizeof(float));
+		tol = _mm_loadu_ps(tol_in);
+		if (!expected_step) {
+			memcpy(ref, expected, compared * sizeof(float));
+			e = _mm_loadu_ps(ref);
+		}
+
+		for (i = 0; i < w; i++) {
+			__m128 d;
+
+			if (expected_step)
+				e = _mm_loadu_ps(expected + i * 4);
+			d = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(observed + i * 4),
+						  e), abs_mask);
+			/* NaN differences never count as mismatches, so keep
+			 * them out of the maximum as well.
+			 */
+			max_error = _mm_max_ps(d, max_error);
+			if (_mm_movemask_ps(_mm_cmpge_ps(d, tol)) & lanes)
+				compare_stats_add_mismatch(stats, i, y);
+		}
+
+		_mm_storeu_ps(max_out, max_error);
+		for (p = 0; p < compared; p++)
+			stats->max_error[p] = MAX2(stats->max_error[p],
+						   max_out[p]);
+		return;
+	}
+#endif
+
+	for (i = 0; i < w; i++) {
+		const float *probe = observed + i * components;
+		const float *ref = expected + i * expected_step;
+		bool mismatch = false;
+
+		for (p = 0; p < compared; p++) {
+			float d = fabsf(probe[p] - ref[p]);
+
+			mismatch |= d >= tolerance[p];
+			if (d > stats->max_error[p])
+				stats->max_error[p] = d;
+		}
+
+		if (mismatch)
+			compare_stats_add_mismatch(stats, i, y);
+	}
+}
+
+/**
+ * Compare a \p w x \p h rectangle of float pixels in a single pass.
+ *
+ * \p observed_stride and \p expected_stride are the row pitches of the
+ * images, in pixels.  An \p expected_stride of zero compares every pixel
+ * against the single pixel at \p expected.
+ */
+static void
+compare_rect_float(const float *observed, int observed_stride,
+		   const float *expected, int expected_stride,
+		   int w, int h, int components, int compared,
+		   const float *tolerance, struct compare_stats *stats)
+{
+	int j;
+
+	piglit_phase_begin(PIGLIT_PHASE_PROBE);
+	compare_stats_init(stats);
+	for (j = 0; j < h; j++) {
+		compare_row_float(observed + j * observed_stride * components,
+				  expected + j * expected_stride * components,
+				  expected_stride ? components : 0,
+				  w, components, compared, tolerance, j,
+				  stats);
+	}
+	piglit_phase_end(PIGLIT_PHASE_PROBE);
+}
+
+/**
+ * Same as compare_row_float(), for GLubyte channels.  Tolerances are
+ * integers; a tolerance <= 0 makes every value mismatch.
+ */
+static void
+compare_row_ubyte(const GLubyte *observed, const GLubyte *expected,
+		  int expected_step, int w, int components, int compared,
+		  const int *tolerance, int y, struct compare_stats *stats)
+{
+	int max_error[4] = { 0 };
+	int i = 0, p;
+
+#ifdef __SSE2__
+	if (components == 4) {
+		GLubyte tol_bytes[16], max_out[16];
+		int lanes = 0;
+		__m128i tol, e, max = _mm_setzero_si128();
+
+		/* Channels that can never mismatch are masked off. */
+		for (p = 0; p < 16; p++) {
+			int t = p % 4 < compared ? tolerance[p % 4] : 256;
+
+			tol_bytes[p] = CLAMP(t, 0, 255);
+			if (t <= 255)
+				lanes |= 1 << p;
+		}
+		tol = _mm_loadu_si128((const __m128i *) tol_bytes);
+
+		if (!expected_step) {
+			GLubyte ref[4] = { 0 };
+			uint32_t pixel;
+
+			/* Only the compared channels of expected exist. */
+			memcpy(ref, expected, compared);
+			memcpy(&pixel, ref, 4);
+			e = _mm_set1_epi32(pixel);
+		}
+
+		for (; i + 4 <= w; i += 4) {
+			__m128i o = _mm_loadu_si128((const __m128i *)
+						    (observed + i * 4));
+			__m128i d;
+			int m, k;
+
+			if (expected_step)
+				e = _mm_loadu_si128((const __m128i *)
+						    (expected + i * 4));
+			d = _mm_or_si128(_mm_subs_epu8(o, e),
+					 _mm_subs_epu8(e, o));
+			max = _mm_max_epu8(max, d);
+
+			/* d >= tol */
+			m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(d, tol),
+							     d)) & lanes;
+			for (k = 0; m && k < 4; k++) {
+				if (m & (0xf << (k * 4)))
+					compare_stats_add_mismatch(stats,
+								   i + k, y);
+			}
+		}
+
+		_mm_storeu_si128((__m128i *) max_out, max);
+		for (p = 0; p < 16; p++)
+			max_error[p % 4] = MAX2(max_error[p % 4], max_out[p]);
+	}
+#endif
+
+	for (; i < w; i++) {
+		const GLubyte *probe = observed + i * components;
+		const GLubyte *ref = expected + i * expected_step;
+		bool mismatch = false;
+
+		for (p = 0; p < compared; p++) {
+			int d = abs((int) probe[p] - (int) ref[p]);
+
+			mismatch |= d >= tolerance[p];
+			max_error[p] = MAX2(max_error[p], d);
+		}
+
+		if (mismatch)
+			compare_stats_add_mismatch(stats, i, y);
+	}
+
+	for (p = 0; p < compared; p++)
+		stats->max_error[p] = MAX2(stats->max_error[p], max_error[p]);
+}
+
+/** Same as compare_rect_float(), for GLubyte channels. */
+static void
+compare_rect_ubyte(const GLubyte *observed, int observed_stride,
+		   const GLubyte *expected, int expected_stride,
+		   int w, int h, int components, int compared,
+		   const int *tolerance, struct compare_stats *stats)
+{
+	int j;
+
+	piglit_phase_begin(PIGLIT_PHASE_PROBE);
+	compare_stats_init(stats);
+	for (j = 0; j < h; j++) {
+		compare_row_ubyte(observed + j * observed_stride * components,
+				  expected + j * expected_stride * components,
+				  expected_stride ? components : 0,
+				  w, components, compared, tolerance, j,
+				  stats);
+	}
+	piglit_phase_end(PIGLIT_PHASE_PROBE);
+}
+
+/**
+ * Print how many of the \p total pixels a comparison found to differ and
+ * the largest error per channel, after the first mismatch was reported.
+ */
+static void
+print_compare_stats(const struct compare_stats *stats, unsigned total,
+		    int compared)
+{
+	int p;
+
+	printf("  %u of %u pixels differ, max error:", stats->mismatches,
+	       total);
+	for (p = 0; p < compared; p++)
+		printf(" %f", stats->max_error[p]);
+	printf("\n");
+}
+
 static void
 piglit_array_float_to_ubyte(int n, const float *f, GLubyte *b)
 {
@@ -1214,79 +1630,75 @@ static bool
 piglit_probe_rect_ubyte(int x, int y, int w, int h, int num_components,
 			const float *fexpected, bool silent)
 {
-	int i, j, p;
-	GLubyte *probe;
-	GLubyte *pixels;
-	GLubyte tolerance[4];
+	int p, stride;
+	const GLubyte *probe;
+	const GLubyte *image;
+	GLubyte *pixels = NULL;
+	GLubyte tolerance_b[4];
+	int tolerance[4];
 	GLubyte expected[4];
+	struct compare_stats stats;
 
-	piglit_array_float_to_ubyte_roundup(num_components, piglit_tolerance, tolerance);
+	piglit_array_float_to_ubyte_roundup(num_components, piglit_tolerance, tolerance_b);
 	piglit_array_float_to_ubyte(num_components, fexpected, expected);
-
-	/* RGBA readbacks are likely to be faster */
-	pixels = malloc(w*h*4);
-	glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			probe = &pixels[(j*w+i)*4];
-
-			for (p = 0; p < num_components; ++p) {
-				if (abs((int)probe[p] - (int)expected[p]) >= tolerance[p]) {
-					if (!silent) {
-						printf("Probe color at (%i,%i)\n", x+i, y+j);
-						if (num_components == 4) {
-							printf("  Expected: %u %u %u %u\n",
-							       expected[0], expected[1],
-							       expected[2], expected[3]);
-							printf("  Observed: %u %u %u %u\n",
-							       probe[0], probe[1], probe[2], probe[3]);
-						} else {
-							printf("  Expected: %u %u %u\n",
-							       expected[0], expected[1],
-							       expected[2]);
-							printf("  Observed: %u %u %u\n",
-							       probe[0], probe[1], probe[2]);
-						}
-					}
-					free(pixels);
-					return false;
-				}
-			}
+	for (p = 0; p < num_components; ++p)
+		tolerance[p] = tolerance_b[p];
+
+	image = probe_cache_read(x, y, w, h, GL_UNSIGNED_BYTE, &stride);
+	if (!image) {
+		/* RGBA readbacks are likely to be faster */
+		pixels = malloc(w*h*4);
+		piglit_phase_begin(PIGLIT_PHASE_READBACK);
+		glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		piglit_phase_end(PIGLIT_PHASE_READBACK);
+		image = pixels;
+		stride = w;
+	}
+
+	compare_rect_ubyte(image, stride, expected, 0, w, h, 4,
+			   num_components, tolerance, &stats);
+
+	if (stats.mismatches && !silent) {
+		probe = &image[(stats.first_y*stride+stats.first_x)*4];
+
+		printf("Probe color at (%i,%i)\n",
+		       x+stats.first_x, y+stats.first_y);
+		if (num_components == 4) {
+			printf("  Expected: %u %u %u %u\n",
+			       expected[0], expected[1],
+			       expected[2], expected[3]);
+			printf("  Observed: %u %u %u %u\n",
+			       probe[0], probe[1], probe[2], probe[3]);
+		} else {
+			printf("  Expected: %u %u %u\n",
+			       expected[0], expected[1],
+			       expected[2]);
+			printf("  Observed: %u %u %u\n",
+			       probe[0], probe[1], probe[2]);
 		}
+		print_compare_stats(&stats, w*h, num_components);
 	}
 
 	free(pixels);
-	return true;
+	return stats.mismatches == 0;
 }
 
 int
 piglit_probe_rect_rgb_silent(int x, int y, int w, int h, const float *expected)
 {
-	int i, j, p;
-	GLfloat *probe;
 	GLfloat *pixels;
+	struct compare_stats stats;
 
 	if (piglit_can_probe_ubyte())
 		return piglit_probe_rect_ubyte(x, y, w, h, 3, expected, true);
 
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGB, NULL);
 
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			probe = &pixels[(j*w+i)*3];
-
-			for (p = 0; p < 3; ++p) {
-				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-					free(pixels);
-					return 0;
-				}
-			}
-		}
-	}
+	compare_rect_float(pixels, w, expected, 0, w, h, 3, 3,
+			   piglit_tolerance, &stats);
 
 	free(pixels);
-	return 1;
+	return stats.mismatches == 0;
 }
 
 /* More efficient variant if you don't know need floats and GBA channels. */
@@ -1324,36 +1736,32 @@ piglit_probe_rect_r_ubyte(int x, int y, int w, int h, GLubyte expected)
 int
 piglit_probe_rect_rgb(int x, int y, int w, int h, const float *expected)
 {
-	int i, j, p;
 	GLfloat *probe;
 	GLfloat *pixels;
+	struct compare_stats stats;
 
 	if (piglit_can_probe_ubyte())
 		return piglit_probe_rect_ubyte(x, y, w, h, 3, expected, false);
 
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
 
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			probe = &pixels[(j*w+i)*4];
+	compare_rect_float(pixels, w, expected, 0, w, h, 4, 3,
+			   piglit_tolerance, &stats);
 
-			for (p = 0; p < 3; ++p) {
-				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-					printf("Probe color at (%i,%i)\n", x+i, y+j);
-					printf("  Expected: %f %f %f\n",
-					       expected[0], expected[1], expected[2]);
-					printf("  Observed: %f %f %f\n",
-					       probe[0], probe[1], probe[2]);
+	if (stats.mismatches) {
+		probe = &pixels[(stats.first_y*w+stats.first_x)*4];
 
-					free(pixels);
-					return 0;
-				}
-			}
-		}
+		printf("Probe color at (%i,%i)\n",
+		       x+stats.first_x, y+stats.first_y);
+		printf("  Expected: %f %f %f\n",
+		       expected[0], expected[1], expected[2]);
+		printf("  Observed: %f %f %f\n",
+		       probe[0], probe[1], probe[2]);
+		print_compare_stats(&stats, w*h, 3);
 	}
 
 	free(pixels);
-	return 1;
+	return stats.mismatches == 0;
 }
 
 int
@@ -1394,36 +1802,32 @@ piglit_probe_rects_equal(int x1, int y1, int x2, int y2,
 int
 piglit_probe_rect_rgba(int x, int y, int w, int h, const float *expected)
 {
-	int i, j, p;
 	GLfloat *probe;
 	GLfloat *pixels;
+	struct compare_stats stats;
 
 	if (piglit_can_probe_ubyte())
 		return piglit_probe_rect_ubyte(x, y, w, h, 4, expected, false);
 
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
 
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			probe = &pixels[(j*w+i)*4];
+	compare_rect_float(pixels, w, expected, 0, w, h, 4, 4,
+			   piglit_tolerance, &stats);
 
-			for (p = 0; p < 4; ++p) {
-				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-					printf("Probe color at (%i,%i)\n", x+i, y+j);
-					printf("  Expected: %f %f %f %f\n",
-					       expected[0], expected[1], expected[2], expected[3]);
-					printf("  Observed: %f %f %f %f\n",
-					       probe[0], probe[1], probe[2], probe[3]);
+	if (stats.mismatches) {
+		probe = &pixels[(stats.first_y*w+stats.first_x)*4];
 
-					free(pixels);
-					return 0;
-				}
-			}
-		}
+		printf("Probe color at (%i,%i)\n",
+		       x+stats.first_x, y+stats.first_y);
+		printf("  Expected: %f %f %f %f\n",
+		       expected[0], expected[1], expected[2], expected[3]);
+		printf("  Observed: %f %f %f %f\n",
+		       probe[0], probe[1], probe[2], probe[3]);
+		print_compare_stats(&stats, w*h, 4);
 	}
 
 	free(pixels);
-	return 1;
+	return stats.mismatches == 0;
 }
 
 int
@@ -1586,31 +1990,26 @@ piglit_compare_images_color(int x, int y, int w, int h, int num_components,
 			    const float *expected_image,
 			    const float *observed_image)
 {
-	int i, j, p;
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			const float *expected =
-				&expected_image[(j*w+i)*num_components];
-			const float *probe =
-				&observed_image[(j*w+i)*num_components];
-
-			for (p = 0; p < num_components; ++p) {
-				if (fabs(probe[p] - expected[p])
-				    >= tolerance[p]) {
-					printf("Probe at (%i,%i)\n", x+i, y+j);
-					printf("  Expected:");
-					print_pixel_float(expected, num_components);
-					printf("\n  Observed:");
-					print_pixel_float(probe, num_components);
-					printf("\n");
+	struct compare_stats stats;
 
-					return 0;
-				}
-			}
-		}
+	compare_rect_float(observed_image, w, expected_image, w, w, h,
+			   num_components, num_components, tolerance, &stats);
+
+	if (stats.mismatches) {
+		const int offset =
+			(stats.first_y*w+stats.first_x)*num_components;
+
+		printf("Probe at (%i,%i)\n",
+		       x+stats.first_x, y+stats.first_y);
+		printf("  Expected:");
+		print_pixel_float(&expected_image[offset], num_components);
+		printf("\n  Observed:");
+		print_pixel_float(&observed_image[offset], num_components);
+		printf("\n");
+		print_compare_stats(&stats, w*h, num_components);
 	}
 
-	return 1;
+	return stats.mismatches == 0;
 }
 
 /**
@@ -1777,36 +2176,33 @@ piglit_probe_image_ubyte(int x, int y, int w, int h, GLenum format,
 {
 	const int c = piglit_num_components(format);
 	GLubyte *pixels = malloc(w * h * 4 * sizeof(GLubyte));
-	int i, j, p;
+	int tolerance[4];
+	struct compare_stats stats;
+	int p;
 
 	glReadPixels(x, y, w, h, format, GL_UNSIGNED_BYTE, pixels);
 
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
-			const GLubyte *expected = &image[(j * w + i) * c];
-			const GLubyte *probe = &pixels[(j * w + i) * c];
+	for (p = 0; p < c; ++p)
+		tolerance[p] = ceil(piglit_tolerance[p] * 255);
 
-			for (p = 0; p < c; ++p) {
+	compare_rect_ubyte(pixels, w, image, w, w, h, c, c, tolerance,
+			   &stats);
 
-				const int tolerance = ceil(piglit_tolerance[p] * 255);
-				if (abs((int)probe[p] - (int)expected[p]) < tolerance)
-					continue;
+	if (stats.mismatches) {
+		const int offset = (stats.first_y * w + stats.first_x) * c;
 
-				printf("Probe at (%i,%i)\n", x + i, y + j);
-				printf("  Expected:");
-				print_pixel_ubyte(expected, c);
-				printf("\n  Observed:");
-				print_pixel_ubyte(probe, c);
-				printf("\n");
-
-				free(pixels);
-				return 0;
-			}
-		}
+		printf("Probe at (%i,%i)\n",
+		       x + stats.first_x, y + stats.first_y);
+		printf("  Expected:");
+		print_pixel_ubyte(&image[offset], c);
+		printf("\n  Observed:");
+		print_pixel_ubyte(&pixels[offset], c);
+		printf("\n");
+		print_compare_stats(&stats, w * h, c);
 	}
 
 	free(pixels);
-	return 1;
+	return stats.mismatches == 0;
 }
 
 /**
@@ -1821,9 +2217,9 @@ int piglit_probe_texel_rect_rgb(int target, int level, int x, int y,
 {
 	GLfloat *buffer;
 	GLfloat *probe;
-	int i, j, p;
 	GLint width;
 	GLint height;
+	struct compare_stats stats;
 
 	glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
 	glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
@@ -1836,27 +2232,23 @@ int piglit_probe_texel_rect_rgb(int target, int level, int x, int y,
 	assert(x+w <= width);
 	assert(y+h <= height);
 
-	for (j = y; j < y+h; ++j) {
-		for (i = x; i < x+w; ++i) {
-			probe = &buffer[(j * width + i) * 3];
+	compare_rect_float(&buffer[(y * width + x) * 3], width, expected, 0,
+			   w, h, 3, 3, piglit_tolerance, &stats);
 
-			for (p = 0; p < 3; ++p) {
-				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-					printf("Probe color at (%i,%i)\n", i, j);
-					printf("  Expected: %f %f %f\n",
-					       expected[0], expected[1], expected[2]);
-					printf("  Observed: %f %f %f\n",
-					       probe[0], probe[1], probe[2]);
+	if (stats.mismatches) {
+		const int i = x + stats.first_x, j = y + stats.first_y;
 
-					free(buffer);
-					return 0;
-				}
-			}
-		}
+		probe = &buffer[(j * width + i) * 3];
+		printf("Probe color at (%i,%i)\n", i, j);
+		printf("  Expected: %f %f %f\n",
+		       expected[0], expected[1], expected[2]);
+		printf("  Observed: %f %f %f\n",
+		       probe[0], probe[1], probe[2]);
+		print_compare_stats(&stats, w * h, 3);
 	}
 
 	free(buffer);
-	return 1;
+	return stats.mismatches == 0;
 }
 
 /**
@@ -1884,9 +2276,9 @@ int piglit_probe_texel_rect_rgba(int target, int level, int x, int y,
 {
 	GLfloat *buffer;
 	GLfloat *probe;
-	int i, j, p;
 	GLint width;
 	GLint height;
+	struct compare_stats stats;
 
 	glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
 	glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
@@ -1899,27 +2291,23 @@ int piglit_probe_texel_rect_rgba(int target, int level, int x, int y,
 	assert(x+w <= width);
 	assert(y+h <= height);
 
-	for (j = y; j < y+h; ++j) {
-		for (i = x; i < x+w; ++i) {
-			probe = &buffer[(j * width + i) * 4];
+	compare_rect_float(&buffer[(y * width + x) * 4], width, expected, 0,
+			   w, h, 4, 4, piglit_tolerance, &stats);
 
-			for (p = 0; p < 4; ++p) {
-				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-					printf("Probe color at (%i,%i)\n", i, j);
-					printf("  Expected: %f %f %f %f\n",
-					       expected[0], expected[1], expected[2], expected[3]);
-					printf("  Observed: %f %f %f %f\n",
-					       probe[0], probe[1], probe[2], probe[3]);
+	if (stats.mismatches) {
+		const int i = x + stats.first_x, j = y + stats.first_y;
 
-					free(buffer);
-					return 0;
-				}
-			}
-		}
+		probe = &buffer[(j * width + i) * 4];
+		printf("Probe color at (%i,%i)\n", i, j);
+		printf("  Expected: %f %f %f %f\n",
+		       expected[0], expected[1], expected[2], expected[3]);
+		printf("  Observed: %f %f %f %f\n",
+		       probe[0], probe[1], probe[2], probe[3]);
+		print_compare_stats(&stats, w * h, 4);
 	}
 
 	free(buffer);
-	return 1;
+	return stats.mismatches == 0;
 }
 
 /**
@@ -1948,10 +2336,12 @@ int piglit_probe_texel_volume_rgba(int target, int level, int x, int y, int z,
 {
 	GLfloat *buffer;
 	GLfloat *probe;
-	int i, j, k, p;
+	int k;
 	GLint width;
 	GLint height;
 	GLint depth;
+	struct compare_stats stats, total;
+	int p;
 
 	glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
 	glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
@@ -1967,29 +2357,36 @@ int piglit_probe_texel_volume_rgba(int target, int level, int x, int y, int z,
 	assert(y+h <= height);
 	assert(z+d <= depth);
 
+	compare_stats_init(&total);
 	for (k = z; k < z+d; ++k) {
-		for (j = y; j < y+h; ++j) {
-			for (i = x; i < x+w; ++i) {
-				probe = &buffer[(k * width * height + j * width + i) * 4];
-
-				for (p = 0; p < 4; ++p) {
-					if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p]) {
-						printf("Probe color at (%i,%i,%i)\n", i, j, k);
-						printf("  Expected: %f %f %f %f\n",
-						       expected[0], expected[1], expected[2], expected[3]);
-						printf("  Observed: %f %f %f %f\n",
-						       probe[0], probe[1], probe[2], probe[3]);
-
-						free(buffer);
-						return 0;
-					}
-				}
-			}
+		const GLfloat *slice = &buffer[k * width * height * 4];
+
+		compare_rect_float(&slice[(y * width + x) * 4], width,
+				   expected, 0, w, h, 4, 4, piglit_tolerance,
+				   &stats);
+
+		if (stats.mismatches && !total.mismatches) {
+			const int i = x + stats.first_x;
+			const int j = y + stats.first_y;
+
+			probe = &buffer[(k * width * height + j * width + i) * 4];
+			printf("Probe color at (%i,%i,%i)\n", i, j, k);
+			printf("  Expected: %f %f %f %f\n",
+			       expected[0], expected[1], expected[2], expected[3]);
+			printf("  Observed: %f %f %f %f\n",
+			       probe[0], probe[1], probe[2], probe[3]);
 		}
+		total.mismatches += stats.mismatches;
+		for (p = 0; p < 4; ++p)
+			total.max_error[p] = MAX2(total.max_error[p],
+						  stats.max_error[p]);
 	}
 
+	if (total.mismatches)
+		print_compare_stats(&total, w * h * d, 4);
+
 	free(buffer);
-	return 1;
+	return total.mismatches == 0;
 }
 
 /**
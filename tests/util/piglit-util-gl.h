@@ -154,6 +154,27 @@ int piglit_probe_rect_rgba_int(int x, int y, int w, int h, const int* expected);
 int piglit_probe_rect_rgba_uint(int x, int y, int w, int h, const unsigned int* expected);
 void piglit_compute_probe_tolerance(GLenum format, float *tolerance);
 
+/**
+ * Enable or disable the framebuffer readback cache of the color probes.
+ *
+ * While the cache is enabled, the RGB and RGBA probes read the whole read
+ * framebuffer once and check later probes against that copy.  The caller
+ * must call piglit_probe_cache_invalidate() after anything that may change
+ * what glReadPixels() would return: drawing, clearing, blitting, or
+ * changing the read framebuffer, read buffer or pixel pack state.
+ *
+ * Enabling or disabling the cache also invalidates it and resets the
+ * counter returned by piglit_probe_cache_readbacks_saved().
+ */
+void piglit_probe_cache_enable(bool enable);
+void piglit_probe_cache_invalidate(void);
+
+/**
+ * Number of probes answered from the readback cache since it was last
+ * enabled.
+ */
+unsigned piglit_probe_cache_readbacks_saved(void);
+
 /**
  * Compare two pixels.
  * \param x the x coordinate of the pixel being probed
@@ -43,6 +43,10 @@
 #include <inttypes.h>
 #include <time.h>
 
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
 #if defined(PIGLIT_HAS_POSIX_CLOCK_MONOTONIC) && defined(PIGLIT_HAS_POSIX_TIMER_NOTIFY_THREAD)
 #include <pthread.h>
 #include <signal.h>
@@ -219,6 +223,144 @@ bool piglit_is_extension_in_string(const char *haystack, const char *needle)
 	return false;
 }
 
+/**
+ * An immutable set of extension names.
+ *
+ * The names are copied into one block and indexed by an open-addressing
+ * hash table at least twice as large as the number of names, so a lookup
+ * usually costs one hash and one strcmp().
+ */
+struct piglit_extension_set {
+	unsigned mask;
+	const char **slots;
+	char *names;
+};
+
+static uint64_t
+extension_set_hash(const char *name, size_t len)
+{
+	return piglit_hash_update(PIGLIT_HASH_INIT, name, len);
+}
+
+static struct piglit_extension_set *
+extension_set_create(const char *string, const char *separators)
+{
+	struct piglit_extension_set *set = calloc(1, sizeof(*set));
+	unsigned count = 0, size = 16;
+	char *name, *p;
+
+	assert(set != NULL);
+	set->names = strdup(string ? string : "");
+	assert(set->names != NULL);
+
+	/* Split the copy in place, counting the names.  This doesn't use
+	 * strtok(), since callers look extensions up while splitting lists
+	 * of their own with it.
+	 */
+	for (p = set->names; *p != '\0'; p++) {
+		if (strchr(separators, *p) != NULL)
+			*p = '\0';
+		else if (p == set->names || p[-1] == '\0')
+			count++;
+	}
+
+	while (size < 2 * count)
+		size *= 2;
+	set->mask = size - 1;
+	set->slots = calloc(size, sizeof(*set->slots));
+	assert(set->slots != NULL);
+
+	name = set->names;
+	while (count > 0) {
+		size_t len;
+		unsigned i;
+
+		/* Skip the separators before the next name. */
+		while (*name == '\0')
+			name++;
+		len = strlen(name);
+
+		i = extension_set_hash(name, len) & set->mask;
+		while (set->slots[i] != NULL && strcmp(set->slots[i], name))
+			i = (i + 1) & set->mask;
+		set->slots[i] = name;
+
+		name += len;
+		count--;
+	}
+
+	return set;
+}
+
+struct piglit_extension_set *
+piglit_extension_set_create_from_string(const char *string)
+{
+	return extension_set_create(string, " ");
+}
+
+struct piglit_extension_set *
+piglit_extension_set_create_from_array(const char **names)
+{
+	struct piglit_extension_set *set;
+	size_t length = 1;
+	char *string, *p;
+	unsigned i;
+
+	for (i = 0; names[i] != NULL; i++)
+		length += strlen(names[i]) + 1;
+
+	string = malloc(length);
+	assert(string != NULL);
+
+	p = string;
+	for (i = 0; names[i] != NULL; i++) {
+		size_t len = strlen(names[i]);
+
+		memcpy(p, names[i], len);
+		p += len;
+		*p++ = '\n';
+	}
+	*p = '\0';
+
+	/* GL extension names never contain whitespace, so a newline is a
+	 * safe separator.
+	 */
+	set = extension_set_create(string, "\n");
+	free(string);
+	return set;
+}
+
+bool
+piglit_extension_set_contains(const struct piglit_extension_set *set,
+			      const char *name)
+{
+	const size_t len = strlen(name);
+	unsigned i;
+
+	if (len == 0)
+		return false;
+
+	i = extension_set_hash(name, len) & set->mask;
+	while (set->slots[i] != NULL) {
+		if (strcmp(set->slots[i], name) == 0)
+			return true;
+		i = (i + 1) & set->mask;
+	}
+
+	return false;
+}
+
+void
+piglit_extension_set_destroy(struct piglit_extension_set *set)
+{
+	if (set == NULL)
+		return;
+
+	free(set->slots);
+	free(set->names);
+	free(set);
+}
+
 /** Returns the line in the program string given the character position. */
 int piglit_find_line(const char *program, int position)
 {
@@ -300,18 +442,58 @@ piglit_set_timeout(double seconds, enum piglit_result timeout_result)
 #endif
 }
 
+#ifdef PIGLIT_HAS_PTHREADS
+static pthread_key_t subtest_report_key;
+static pthread_once_t subtest_report_key_once = PTHREAD_ONCE_INIT;
+
+static void
+create_subtest_report_key(void)
+{
+	pthread_key_create(&subtest_report_key, NULL);
+}
+#else
+static FILE *subtest_report_stream;
+#endif
+
+void
+piglit_set_subtest_report_stream(FILE *stream)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_once(&subtest_report_key_once, create_subtest_report_key);
+	pthread_setspecific(subtest_report_key, stream);
+#else
+	subtest_report_stream = stream;
+#endif
+}
+
+static FILE *
+get_subtest_report_stream(void)
+{
+	FILE *stream;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_once(&subtest_report_key_once, create_subtest_report_key);
+	stream = pthread_getspecific(subtest_report_key);
+#else
+	stream = subtest_report_stream;
+#endif
+
+	return stream != NULL ? stream : stdout;
+}
+
 void
 piglit_report_subtest_result(enum piglit_result result, const char *format, ...)
 {
 	const char *result_str = piglit_result_to_string(result);
+	FILE *stream = get_subtest_report_stream();
 	va_list ap;
 
 	va_start(ap, format);
 
-	printf("PIGLIT: {\"subtest\": {\"");
-	vprintf(format, ap);
-	printf("\" : \"%s\"}}\n", result_str);
-	fflush(stdout);
+	fprintf(stream, "PIGLIT: {\"subtest\": {\"");
+	vfprintf(stream, format, ap);
+	fprintf(stream, "\" : \"%s\"}}\n", result_str);
+	fflush(stream);
 
 	va_end(ap);
 }
@@ -639,6 +821,192 @@ piglit_delay_ns(int64_t time_ns)
 	return end - start;
 }
 
+static const char *const phase_names[PIGLIT_NUM_PHASES] = {
+	[PIGLIT_PHASE_CONTEXT] = "context",
+	[PIGLIT_PHASE_INIT] = "init",
+	[PIGLIT_PHASE_COMPILE] = "compile",
+	[PIGLIT_PHASE_LINK] = "link",
+	[PIGLIT_PHASE_DRAW] = "draw",
+	[PIGLIT_PHASE_READBACK] = "readback",
+	[PIGLIT_PHASE_PROBE] = "probe",
+	[PIGLIT_PHASE_TEARDOWN] = "teardown",
+};
+
+#define PHASE_STACK_DEPTH 16
+
+/**
+ * The phases a thread is in, innermost last, and the time the innermost
+ * one was entered or got control back from a nested phase.  Phases begun
+ * when the stack is full are only counted in \c overflow, and the same
+ * number of piglit_phase_end() calls is ignored.
+ */
+struct phase_stack {
+	unsigned depth;
+	unsigned overflow;
+	enum piglit_phase phases[PHASE_STACK_DEPTH];
+	int64_t start;
+};
+
+/* Time spent in each phase by all threads since the last report. */
+static int64_t phase_totals[PIGLIT_NUM_PHASES];
+static bool phase_entered[PIGLIT_NUM_PHASES];
+static bool phase_report_at_exit;
+
+#ifdef PIGLIT_HAS_PTHREADS
+static pthread_mutex_t phase_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t phase_stack_key;
+static pthread_once_t phase_stack_key_once = PTHREAD_ONCE_INIT;
+
+static void
+create_phase_stack_key(void)
+{
+	pthread_key_create(&phase_stack_key, free);
+}
+#else
+static struct phase_stack main_phase_stack;
+#endif
+
+static struct phase_stack *
+get_phase_stack(void)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	struct phase_stack *stack;
+
+	pthread_once(&phase_stack_key_once, create_phase_stack_key);
+	stack = pthread_getspecific(phase_stack_key);
+	if (stack == NULL) {
+		stack = calloc(1, sizeof(*stack));
+		if (stack != NULL)
+			pthread_setspecific(phase_stack_key, stack);
+	}
+	return stack;
+#else
+	return &main_phase_stack;
+#endif
+}
+
+static void
+lock_phases(void)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&phase_lock);
+#endif
+}
+
+static void
+unlock_phases(void)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_unlock(&phase_lock);
+#endif
+}
+
+/**
+ * Charge the time since the innermost phase of \p stack got control to
+ * that phase.  Must be called with the phase lock held.
+ */
+static void
+charge_phase(struct phase_stack *stack, int64_t now)
+{
+	if (stack->depth > 0)
+		phase_totals[stack->phases[stack->depth - 1]] +=
+			now - stack->start;
+	stack->start = now;
+}
+
+void
+piglit_phase_begin(enum piglit_phase phase)
+{
+	struct phase_stack *stack = get_phase_stack();
+	int64_t now;
+
+	if (stack == NULL)
+		return;
+	if (stack->depth == PHASE_STACK_DEPTH) {
+		stack->overflow++;
+		return;
+	}
+
+	now = piglit_time_get_nano();
+
+	lock_phases();
+	charge_phase(stack, now);
+	phase_entered[phase] = true;
+	if (!phase_report_at_exit) {
+		phase_report_at_exit = true;
+		atexit(piglit_phase_report);
+	}
+	unlock_phases();
+
+	stack->phases[stack->depth++] = phase;
+}
+
+void
+piglit_phase_end(enum piglit_phase phase)
+{
+	struct phase_stack *stack = get_phase_stack();
+	unsigned i;
+
+	if (stack == NULL)
+		return;
+	if (stack->overflow > 0) {
+		stack->overflow--;
+		return;
+	}
+
+	for (i = stack->depth; i > 0; i--) {
+		if (stack->phases[i - 1] == phase)
+			break;
+	}
+	if (i == 0)
+		return;
+
+	lock_phases();
+	charge_phase(stack, piglit_time_get_nano());
+	unlock_phases();
+
+	stack->depth = i - 1;
+}
+
+void
+piglit_phase_report(void)
+{
+	struct phase_stack *stack = get_phase_stack();
+	const char *sep = "";
+	bool any = false;
+	unsigned i;
+
+	lock_phases();
+
+	/* The test may exit while it's still in a phase, like when
+	 * piglit_report_result() is called from piglit_display().
+	 */
+	if (stack != NULL)
+		charge_phase(stack, piglit_time_get_nano());
+
+	for (i = 0; i < PIGLIT_NUM_PHASES; i++)
+		any = any || phase_entered[i];
+
+	if (any) {
+		fflush(stdout);
+		fprintf(stderr, "PIGLIT-PHASES: {");
+		for (i = 0; i < PIGLIT_NUM_PHASES; i++) {
+			if (!phase_entered[i])
+				continue;
+			fprintf(stderr, "%s\"%s\": %.6f", sep, phase_names[i],
+				phase_totals[i] / 1e9);
+			sep = ", ";
+		}
+		fprintf(stderr, "}\n");
+		fflush(stderr);
+	}
+
+	memset(phase_totals, 0, sizeof(phase_totals));
+	memset(phase_entered, 0, sizeof(phase_entered));
+
+	unlock_phases();
+}
+
 /**
  * Search for an argument with the given name in the argument list.
  * If it is found, remove it and return true.
@@ -846,3 +1214,127 @@ piglit_free_aligned(void *p)
 	free(p);
 #endif
 }
+
+
+uint64_t
+piglit_hash_update(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *p = data;
+
+	/* 64-bit FNV-1a */
+	for (size_t i = 0; i < size; i++) {
+		hash ^= p[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
+
+	return hash;
+}
+
+
+uint64_t
+piglit_hash_string(uint64_t hash, const char *str)
+{
+	if (str == NULL)
+		str = "";
+
+	/* Include the terminator so that "ab" + "c" != "a" + "bc". */
+	return piglit_hash_update(hash, str, strlen(str) + 1);
+}
+
+
+struct piglit_cache_header {
+	char magic[8];
+	uint64_t key;
+	uint64_t size;
+	uint64_t checksum;
+};
+
+static const char piglit_cache_magic[8] = "PIGLITC1";
+
+
+static void
+piglit_cache_path(char *buf, size_t buf_size, const char *dir, uint64_t key)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "%016" PRIx64 ".bin", key);
+	piglit_join_paths(buf, buf_size, 2, dir, name);
+}
+
+
+void *
+piglit_cache_load(const char *dir, uint64_t key, size_t *size)
+{
+	struct piglit_cache_header header;
+	char path[4096];
+	void *data;
+	FILE *fp;
+
+	piglit_cache_path(path, sizeof(path), dir, key);
+
+	fp = fopen(path, "rb");
+	if (fp == NULL)
+		return NULL;
+
+	if (fread(&header, sizeof(header), 1, fp) != 1 ||
+	    memcmp(header.magic, piglit_cache_magic, sizeof(header.magic)) ||
+	    header.key != key || header.size > SIZE_MAX) {
+		fclose(fp);
+		return NULL;
+	}
+
+	data = malloc(header.size ? header.size : 1);
+	if (data == NULL ||
+	    fread(data, 1, header.size, fp) != header.size ||
+	    piglit_hash_update(PIGLIT_HASH_INIT, data, header.size) !=
+	    header.checksum) {
+		free(data);
+		fclose(fp);
+		return NULL;
+	}
+
+	fclose(fp);
+	*size = header.size;
+	return data;
+}
+
+
+bool
+piglit_cache_store(const char *dir, uint64_t key, const void *data,
+		   size_t size)
+{
+	struct piglit_cache_header header;
+	char path[4096];
+	char tmp_path[4096 + 64];
+	bool ok;
+	FILE *fp;
+
+	piglit_cache_path(path, sizeof(path), dir, key);
+
+	/* Write to a private file and rename it into place, so that
+	 * concurrent test processes never see a partially written entry.
+	 */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%" PRIu64 ".%" PRId64 ".tmp",
+		 path, piglit_gettid(), piglit_time_get_nano());
+
+	fp = fopen(tmp_path, "wb");
+	if (fp == NULL)
+		return false;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, piglit_cache_magic, sizeof(header.magic));
+	header.key = key;
+	header.size = size;
+	header.checksum = piglit_hash_update(PIGLIT_HASH_INIT, data, size);
+
+	ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+	     fwrite(data, 1, size, fp) == size;
+	ok = fclose(fp) == 0 && ok;
+
+	if (ok)
+		ok = rename(tmp_path, path) == 0;
+	if (!ok)
+		remove(tmp_path);
+
+	return ok;
+}
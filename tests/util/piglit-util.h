@@ -381,6 +381,29 @@ bool piglit_is_extension_in_string(const char *haystack, const char *needle);
  */
 bool piglit_is_extension_in_array(const char **haystack, const char *needle);
 
+/**
+ * A set of extension names with constant-time lookup.
+ *
+ * API-specific helpers build one of these when the extension list is first
+ * queried and use it for every later piglit_*_extension_supported() call.
+ */
+struct piglit_extension_set;
+
+/** Build a set from a space-separated extension string.  NULL is empty. */
+struct piglit_extension_set *
+piglit_extension_set_create_from_string(const char *string);
+
+/** Build a set from a NULL-terminated array of extension names. */
+struct piglit_extension_set *
+piglit_extension_set_create_from_array(const char **names);
+
+bool
+piglit_extension_set_contains(const struct piglit_extension_set *set,
+			      const char *name);
+
+void
+piglit_extension_set_destroy(struct piglit_extension_set *set);
+
 int piglit_find_line(const char *program, int position);
 void piglit_merge_result(enum piglit_result *all, enum piglit_result subtest);
 const char * piglit_result_to_string(enum piglit_result result);
@@ -389,6 +412,60 @@ void piglit_set_timeout(double seconds, enum piglit_result timeout_result);
 void piglit_report_subtest_result(enum piglit_result result,
 				  const char *format, ...) PRINTFLIKE(2, 3);
 
+/**
+ * Make piglit_report_subtest_result() write the subtest results of the
+ * calling thread to \p stream instead of stdout, or to stdout again if
+ * \p stream is NULL. This lets tests that run on several threads print the
+ * results of each thread in a deterministic order.
+ */
+void piglit_set_subtest_report_stream(FILE *stream);
+
+/**
+ * Phases of a test run that piglit_phase_begin() and piglit_phase_end()
+ * can time.  For OpenCL tests, running the test on a device is timed as
+ * PIGLIT_PHASE_DRAW.
+ */
+enum piglit_phase {
+	PIGLIT_PHASE_CONTEXT,
+	PIGLIT_PHASE_INIT,
+	PIGLIT_PHASE_COMPILE,
+	PIGLIT_PHASE_LINK,
+	PIGLIT_PHASE_DRAW,
+	PIGLIT_PHASE_READBACK,
+	PIGLIT_PHASE_PROBE,
+	PIGLIT_PHASE_TEARDOWN,
+	PIGLIT_NUM_PHASES
+};
+
+/**
+ * Start timing \p phase on the calling thread.
+ *
+ * Phases nest, and the time spent in a phase doesn't include the time
+ * spent in the phases nested in it, so wrapping a readback in a probe
+ * times the readback and the comparison separately.
+ */
+void piglit_phase_begin(enum piglit_phase phase);
+
+/**
+ * Stop timing \p phase on the calling thread.
+ *
+ * Phases nested in \p phase that weren't ended yet are ended too, and
+ * ending a phase that wasn't begun does nothing.
+ */
+void piglit_phase_end(enum piglit_phase phase);
+
+/**
+ * Print the time spent in each phase since the last report to stderr, as
+ * a line like
+ *
+ *     PIGLIT-PHASES: {"compile": 0.001234, "draw": 0.000567}
+ *
+ * with the times in seconds, and start counting from zero again.  Nothing
+ * is printed if no phase was begun.  This is called at exit once a phase
+ * was begun, so tests only need to call it to report more than once.
+ */
+void piglit_phase_report(void);
+
 void piglit_disable_error_message_boxes(void);
 
 extern void piglit_set_rlimit(unsigned long lim);
@@ -483,6 +560,48 @@ piglit_alloc_aligned(size_t alignment, size_t size);
 void
 piglit_free_aligned(void *p);
 
+/** Initial value for piglit_hash_update() and piglit_hash_string(). */
+#define PIGLIT_HASH_INIT UINT64_C(0xcbf29ce484222325)
+
+/**
+ * \brief Fold \a size bytes of \a data into a running 64-bit hash.
+ *
+ * This is a non-cryptographic hash (FNV-1a) meant for building cache
+ * keys, not for detecting malicious collisions.
+ */
+uint64_t
+piglit_hash_update(uint64_t hash, const void *data, size_t size);
+
+/**
+ * \brief Fold a null-terminated string into a running 64-bit hash.
+ *
+ * The terminator is hashed as well, so consecutive strings can't alias.
+ * NULL is treated as the empty string.
+ */
+uint64_t
+piglit_hash_string(uint64_t hash, const char *str);
+
+/**
+ * \brief Read the entry stored under \a key in cache directory \a dir.
+ *
+ * Returns a malloc'ed copy of the data and its size in \a size, or NULL
+ * if there is no such entry or it fails its checksum.
+ */
+void *
+piglit_cache_load(const char *dir, uint64_t key, size_t *size);
+
+/**
+ * \brief Store \a size bytes of \a data under \a key in cache directory
+ * \a dir.
+ *
+ * The entry is written to a temporary file and renamed into place, so
+ * concurrent readers never see a partial entry.  Returns false if the
+ * entry could not be written; the directory must already exist.
+ */
+bool
+piglit_cache_store(const char *dir, uint64_t key, const void *data,
+		   size_t size);
+
 
 #ifdef __cplusplus
 } /* end extern "C" */
@@ -75,6 +75,22 @@
  * If an error occurs, setup_vbo_from_text() will print out a
  * description of the error and exit with PIGLIT_FAIL.
  *
+ * Large amounts of vertex data can instead be kept in a binary file,
+ * which is loaded into the vertex buffer object as it is.  The text
+ * then only has the row of column headers followed by the name of the
+ * file, relative to the directory of the test script:
+ *
+ *   \verbatim
+ *   vertex/double/vec3	foo/uint/uint	bar[0]/int/int	bar[1]/int/int
+ *   vertex-data.bin
+ *   \endverbatim
+ *
+ * The file holds the rows one after the other, each with the data of
+ * the columns in order, tightly packed and little-endian, as in the
+ * vertex_data array below.  To process it, call
+ * setup_vbo_from_binary() with the text and the name of the test
+ * script.
+ *
  * For the first example above, the call to setup_vbo_from_text() is
  * roughly equivalent to the following GL operations:
  *
@@ -126,6 +142,7 @@
  * \endcode
  */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <errno.h>
@@ -616,13 +633,17 @@ vertex_attrib_description::setup(size_t *offset, size_t stride) const
 class vbo_data
 {
 public:
-	vbo_data(std::string const &text, GLuint prog);
+	vbo_data(const char *text_start, const char *text_end, GLuint prog);
+	vbo_data(const char *text_start, const char *text_end, GLuint prog,
+		 const char *script_name);
 	size_t setup() const;
 
 private:
-	void parse_header_line(const std::string &line, GLuint prog);
-	void parse_data_line(const std::string &line, unsigned int line_num);
-	void parse_line(std::string line, unsigned int line_num, GLuint prog);
+	void parse_header_line(const char *line, const char *line_end,
+			       GLuint prog);
+	void parse_data_line(const char *line, const char *line_end,
+			     unsigned int line_num);
+	void load_binary(const std::string &file_name);
 
 	/**
 	 * True if the header line has already been parsed.
@@ -652,11 +673,52 @@ private:
 
 
 
+/**
+ * Find the end of the line starting at \c line, leaving out any
+ * end-of-line comment, and set \c next to the start of the following
+ * line.
+ */
+static const char *
+find_line_end(const char *line, const char *text_end, const char **next)
+{
+	const char *newline =
+		(const char *) memchr(line, '\n', text_end - line);
+	if (newline == NULL) {
+		newline = text_end;
+		*next = text_end;
+	} else {
+		*next = newline + 1;
+	}
+
+	const char *comment = (const char *) memchr(line, '#', newline - line);
+	return comment ? comment : newline;
+}
+
+
+/**
+ * Count the lines from \c text to \c text_end.
+ */
+static size_t
+count_lines(const char *text, const char *text_end)
+{
+	size_t lines = 0;
+	while (text < text_end) {
+		const char *newline =
+			(const char *) memchr(text, '\n', text_end - text);
+		++lines;
+		if (newline == NULL)
+			break;
+		text = newline + 1;
+	}
+	return lines;
+}
+
+
 static bool
-is_blank_line(const std::string &line)
+is_blank_line(const char *line, const char *line_end)
 {
-	for (size_t i = 0; i < line.size(); ++i) {
-		if (!isspace(line[i]))
+	for (; line < line_end; ++line) {
+		if (!isspace(*line))
 			return false;
 	}
 	return true;
@@ -671,52 +733,61 @@ is_blank_line(const std::string &line)
  * then exit with PIGLIT_FAIL.
  */
 void
-vbo_data::parse_header_line(const std::string &line, GLuint prog)
+vbo_data::parse_header_line(const char *line, const char *line_end,
+			    GLuint prog)
 {
-	size_t pos = 0;
+	const char *pos = line;
 	this->stride = 0;
-	while (pos < line.size()) {
-		if (isspace(line[pos])) {
+	while (pos < line_end) {
+		if (isspace(*pos)) {
 			++pos;
 		} else {
-			size_t column_header_end = pos;
-			while (column_header_end < line.size() &&
-			       !isspace(line[column_header_end]))
+			const char *column_header_end = pos;
+			while (column_header_end < line_end &&
+			       !isspace(*column_header_end))
 				++column_header_end;
-			std::string column_header = line.substr(
-				pos, column_header_end - pos);
+			std::string column_header(pos, column_header_end);
 			vertex_attrib_description desc(
 				prog, column_header.c_str());
 			attribs.push_back(desc);
 			this->stride += desc.rows * desc.data_type_size;
-			pos = column_header_end + 1;
+			pos = column_header_end;
 		}
 	}
 }
 
 
 /**
- * Convert a data row into binary form and append it to this->raw_data.
+ * Convert a data row into binary form and store it in the next row of
+ * this->raw_data, which has to be large enough for it.
  *
  * If there is a parse failure, print a description of the problem and
  * then exit with PIGLIT_FAIL.
  */
 void
-vbo_data::parse_data_line(const std::string &line, unsigned int line_num)
+vbo_data::parse_data_line(const char *line, const char *line_end,
+			  unsigned int line_num)
 {
-	/* Allocate space in raw_data for this line */
-	size_t old_size = this->raw_data.size();
-	this->raw_data.resize(old_size + this->stride);
-	char *data_ptr = &this->raw_data[old_size];
+	assert((this->num_rows + 1) * this->stride <= this->raw_data.size());
+	char *data_ptr = &this->raw_data[this->num_rows * this->stride];
 
-	const char *line_ptr = line.c_str();
+	const char *line_ptr = line;
 	for (size_t i = 0; i < this->attribs.size(); ++i) {
 		for (size_t j = 0; j < this->attribs[i].rows; ++j) {
+			const char *datum = line_ptr;
 			if (!this->attribs[i].parse_datum(&line_ptr,
 							  data_ptr)) {
 				printf("At line %u of [vertex data] section\n",
 				       line_num);
-				printf("Offending text: %s\n", line_ptr);
+				printf("Offending text: %.*s\n",
+				       (int) (line_end - datum), datum);
+				piglit_report_result(PIGLIT_FAIL);
+			}
+			/* The number parsers skip newlines too */
+			if (line_ptr > line_end) {
+				printf("At line %u of [vertex data] section\n"
+				       "Not enough data in the row\n",
+				       line_num);
 				piglit_report_result(PIGLIT_FAIL);
 			}
 			data_ptr += this->attribs[i].data_type_size;
@@ -728,48 +799,162 @@ vbo_data::parse_data_line(const std::string &line, unsigned int line_num)
 
 
 /**
- * Parse a line of input text.
+ * Parse the input but don't execute any GL commands.
  *
  * If there is a parse failure, print a description of the problem and
  * then exit with PIGLIT_FAIL.
  */
-void
-vbo_data::parse_line(std::string line, unsigned int line_num, GLuint prog)
+vbo_data::vbo_data(const char *text_start, const char *text_end, GLuint prog)
+	: header_seen(false), stride(0), num_rows(0)
 {
-	/* Ignore end-of-line comments */
-	line = line.substr(0, line.find('#'));
+	unsigned int line_num = 1;
 
-	/* Ignore blank or comment-only lines */
-	if (is_blank_line(line))
-		return;
+	const char *line = text_start;
+	while (line < text_end) {
+		const char *next;
+		const char *line_end = find_line_end(line, text_end, &next);
 
-	if (!this->header_seen) {
-		this->header_seen = true;
-		parse_header_line(line, prog);
-	} else {
-		parse_data_line(line, line_num);
+		/* Ignore blank or comment-only lines */
+		if (!is_blank_line(line, line_end)) {
+			if (!this->header_seen) {
+				this->header_seen = true;
+				parse_header_line(line, line_end, prog);
+
+				/* Each of the remaining lines is a row
+				 * at most.
+				 */
+				this->raw_data.resize(
+					count_lines(next, text_end) *
+					this->stride);
+			} else {
+				parse_data_line(line, line_end, line_num);
+			}
+		}
+
+		line = next;
+		++line_num;
 	}
 }
 
 
 /**
- * Parse the input but don't execute any GL commands.
+ * Parse the column headers and the file name of binary vertex data,
+ * and load the file, but don't execute any GL commands.
  *
- * If there is a parse failure, print a description of the problem and
- * then exit with PIGLIT_FAIL.
+ * If there is a failure, print a description of the problem and then
+ * exit with PIGLIT_FAIL.
  */
-vbo_data::vbo_data(const std::string &text, GLuint prog)
+vbo_data::vbo_data(const char *text_start, const char *text_end, GLuint prog,
+		   const char *script_name)
 	: header_seen(false), stride(0), num_rows(0)
 {
-	unsigned int line_num = 1;
+	std::string file_name;
+
+	const char *line = text_start;
+	while (line < text_end) {
+		const char *next;
+		const char *line_end = find_line_end(line, text_end, &next);
+
+		if (!is_blank_line(line, line_end)) {
+			if (!this->header_seen) {
+				this->header_seen = true;
+				parse_header_line(line, line_end, prog);
+			} else if (file_name.empty()) {
+				while (isspace(*line))
+					++line;
+				while (isspace(line_end[-1]))
+					--line_end;
+				file_name.assign(line, line_end);
+			} else {
+				printf("[vertex data binary] section has more"
+				       " than the column headers and a file"
+				       " name\n");
+				piglit_report_result(PIGLIT_FAIL);
+			}
+		}
+
+		line = next;
+	}
+
+	if (file_name.empty()) {
+		printf("[vertex data binary] section is missing the"
+		       " column headers or the file name\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
 
-	size_t pos = 0;
-	while (pos < text.size()) {
-		size_t end_of_line = text.find('\n', pos);
-		if (end_of_line == std::string::npos)
-			end_of_line = text.size();
-		parse_line(text.substr(pos, end_of_line), line_num++, prog);
-		pos = end_of_line + 1;
+	/* The file name is relative to the directory of the script */
+	if (file_name[0] != '/' && file_name[0] != PIGLIT_PATH_SEP) {
+		const char *sep = strrchr(script_name, '/');
+		if (PIGLIT_PATH_SEP != '/' &&
+		    strrchr(script_name, PIGLIT_PATH_SEP) > sep)
+			sep = strrchr(script_name, PIGLIT_PATH_SEP);
+		if (sep != NULL)
+			file_name.insert(0, script_name, sep - script_name + 1);
+	}
+
+	load_binary(file_name);
+}
+
+
+/**
+ * Read the rows of binary vertex data straight into this->raw_data,
+ * converting them from little-endian if needed.
+ *
+ * If there is a failure, print a description of the problem and then
+ * exit with PIGLIT_FAIL.
+ */
+void
+vbo_data::load_binary(const std::string &file_name)
+{
+	FILE *f = fopen(file_name.c_str(), "rb");
+	if (f == NULL) {
+		printf("Could not open vertex data file %s\n",
+		       file_name.c_str());
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	long size = -1;
+	if (fseek(f, 0, SEEK_END) == 0) {
+		size = ftell(f);
+		rewind(f);
+	}
+	if (size < 0) {
+		printf("Could not get the size of vertex data file %s\n",
+		       file_name.c_str());
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	if (this->stride == 0 || size % this->stride != 0) {
+		printf("Size of vertex data file %s is not a multiple of"
+		       " the size of a row (%lu bytes)\n",
+		       file_name.c_str(), (unsigned long) this->stride);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	this->raw_data.resize(size);
+	if (size > 0 &&
+	    fread(&this->raw_data[0], 1, size, f) != (size_t) size) {
+		printf("Could not read vertex data file %s\n",
+		       file_name.c_str());
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	fclose(f);
+
+	this->num_rows = size / this->stride;
+
+	const uint16_t one = 1;
+	if (*(const uint8_t *) &one == 1)
+		return;
+
+	/* Big-endian host, swap the bytes of each datum */
+	char *data_ptr = this->raw_data.empty() ? NULL : &this->raw_data[0];
+	for (size_t row = 0; row < this->num_rows; ++row) {
+		for (size_t i = 0; i < this->attribs.size(); ++i) {
+			const size_t type_size = this->attribs[i].data_type_size;
+			for (size_t j = 0; j < this->attribs[i].rows; ++j) {
+				std::reverse(data_ptr, data_ptr + type_size);
+				data_ptr += type_size;
+			}
+		}
 	}
 }
 
@@ -785,7 +970,8 @@ vbo_data::setup() const
 	glGenBuffers(1, &buffer_handle);
 	glBindBuffer(GL_ARRAY_BUFFER, buffer_handle);
 	glBufferData(GL_ARRAY_BUFFER, this->stride * this->num_rows,
-		     &this->raw_data[0], GL_STATIC_DRAW);
+		     this->raw_data.empty() ? NULL : &this->raw_data[0],
+		     GL_STATIC_DRAW);
 
 	size_t offset = 0;
 	for (size_t i = 0; i < attribs.size(); ++i)
@@ -812,6 +998,27 @@ setup_vbo_from_text(GLuint prog, const char *text_start, const char *text_end)
 {
 	if (text_end == NULL)
 		text_end = text_start + strlen(text_start);
-	std::string text(text_start, text_end);
-	return vbo_data(text, prog).setup();
+	return vbo_data(text_start, text_end, prog).setup();
+}
+
+
+/**
+ * Set up a vertex buffer object for the program prog with binary
+ * vertex data.  The text from text_start to text_end has the column
+ * headers and the name of the data file, which is relative to the
+ * directory of script_name.  If text_end is NULL, the string is
+ * assumed to be null-terminated.
+ *
+ * Return value is the number of rows of vertex data found.
+ *
+ * For details about the format, see the comment at the top of this
+ * file.
+ */
+size_t
+setup_vbo_from_binary(GLuint prog, const char *text_start,
+		      const char *text_end, const char *script_name)
+{
+	if (text_end == NULL)
+		text_end = text_start + strlen(text_start);
+	return vbo_data(text_start, text_end, prog, script_name).setup();
 }
@@ -30,6 +30,10 @@ extern "C" {
 size_t
 setup_vbo_from_text(GLuint prog, const char *text_start, const char *text_end);
 
+size_t
+setup_vbo_from_binary(GLuint prog, const char *text_start,
+		      const char *text_end, const char *script_name);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
@@ -35,6 +35,7 @@ import pytest
 import six
 
 from framework import core
+from framework import exceptions
 from framework.backends import abstract
 from framework.backends import compression
 
@@ -167,6 +168,83 @@ def test_decompress(mode, tmpdir):
     assert actual == 'foo'
 
 
+@skip.PY2
+class TestBlocks(object):
+    """Tests for compressing in parallel blocks on python 3.x."""
+
+    @pytest.mark.parametrize("mode", ['bz2', 'gz', 'xz'])
+    def test_many_blocks(self, mode, tmpdir, config):
+        """A file of many blocks decompresses as one."""
+        config.set('core', 'compression threads', '4')
+        testfile = six.text_type(tmpdir.join('test'))
+        expected = ''.join('line {}\n'.format(i) for i in range(1000))
+
+        with mock.patch('framework.backends.compression.BLOCK_SIZE', 100):
+            with compression.COMPRESSORS[mode](testfile) as f:
+                for line in expected.splitlines(True):
+                    f.write(line)
+
+        with compression.DECOMPRESSORS[mode](testfile) as f:
+            assert f.read() == expected
+
+    @pytest.mark.parametrize("mode", ['bz2', 'gz', 'xz'])
+    def test_empty(self, mode, tmpdir, config):
+        """A file with nothing written is still valid."""
+        testfile = six.text_type(tmpdir.join('test'))
+
+        with compression.COMPRESSORS[mode](testfile):
+            pass
+
+        with compression.DECOMPRESSORS[mode](testfile) as f:
+            assert f.read() == ''
+
+    def test_level(self, tmpdir, config):
+        """The level from piglit.conf is used."""
+        config.set('core', 'compression level', '1')
+        testfile = six.text_type(tmpdir.join('test'))
+
+        with mock.patch('framework.backends.compression.bz2.compress',
+                        return_value=b'') as compress:
+            with compression.COMPRESSORS['bz2'](testfile) as f:
+                f.write('foo')
+
+        assert compress.call_args[1]['compresslevel'] == 1
+
+
+class TestGetLevel(object):
+    """Tests for the compression.get_level function."""
+
+    def test_default(self, config):
+        """Without a level the default of the mode is used."""
+        assert compression.get_level() is None
+
+    def test_piglit_conf(self, config):
+        """The level is read from piglit.conf."""
+        config.set('core', 'compression level', '3')
+        assert compression.get_level() == 3
+
+    def test_invalid(self, config):
+        """An invalid level is an error."""
+        config.set('core', 'compression level', 'fast')
+        with pytest.raises(exceptions.PiglitFatalError):
+            compression.get_level()
+
+
+class TestGetThreads(object):
+    """Tests for the compression.get_threads function."""
+
+    def test_default(self, config):
+        """Without a value there is a thread for each cpu."""
+        with mock.patch('framework.backends.compression.multiprocessing.'
+                        'cpu_count', return_value=7):
+            assert compression.get_threads() == 7
+
+    def test_piglit_conf(self, config):
+        """The number of threads is read from piglit.conf."""
+        config.set('core', 'compression threads', '2')
+        assert compression.get_threads() == 2
+
+
 @skip.posix
 @skip.PY3
 @requires_xz_bin
@@ -0,0 +1,147 @@
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the indexed backend."""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+try:
+    import mock
+except ImportError:
+    from unittest import mock
+
+import pytest
+import six
+
+from framework import backends
+from framework import exceptions
+from framework import grouptools
+from framework import results
+from framework import status
+
+from . import shared
+
+# pylint: disable=no-self-use,protected-access
+
+
+def _write_run(dest, tests, finalize=True):
+    backend = backends.indexed.IndexedBackend(dest)
+    backend.initialize(dict(shared.INITIAL_METADATA))
+    for name, result in tests:
+        with backend.write_test(name) as t:
+            t(result)
+    if finalize:
+        backend.finalize(
+            {'time_elapsed':
+                results.TimeAttribute(start=0.0, end=1.0).to_json()})
+
+
+def _result(result, out='', subtests=None, phases=None):
+    res = results.TestResult(result)
+    res.out = out
+    res.time = results.TimeAttribute(start=1.0, end=3.0)
+    if subtests:
+        res.subtests.update(subtests)
+    if phases:
+        res.phases = phases
+    return res
+
+
+class TestIndexedBackend(object):
+    """Tests for writing and loading indexed runs."""
+
+    @pytest.fixture
+    def run(self, tmpdir):
+        _write_run(six.text_type(tmpdir), [
+            (grouptools.join('a', 'pass'), _result('pass', out='output')),
+            (grouptools.join('a', 'fail'),
+             _result('fail', phases={'draw': 0.5})),
+            (grouptools.join('b', 'subtests'),
+             _result('pass', subtests={'x': 'pass', 'y': 'crash'})),
+        ])
+        return backends.load(six.text_type(tmpdir))
+
+    def test_intermediate_files_removed(self, tmpdir, run):
+        assert tmpdir.join('results.pidx').check()
+        assert not tmpdir.join('metadata.json').check()
+        assert not tmpdir.join('tests').check()
+
+    def test_metadata(self, run):
+        assert run.name == 'name'
+        assert run.time_elapsed.end == 1.0
+
+    def test_tests(self, run):
+        assert set(run.tests) == {grouptools.join('a', 'pass'),
+                                  grouptools.join('a', 'fail'),
+                                  grouptools.join('b', 'subtests')}
+
+    def test_get_result(self, run):
+        assert run.get_result(grouptools.join('a', 'fail')) == status.FAIL
+
+    def test_get_subtest_result(self, run):
+        assert run.get_result(
+            grouptools.join('b', 'subtests', 'y')) == status.CRASH
+
+    def test_totals(self, run):
+        assert run.totals['root']['pass'] == 2
+        assert run.totals['root']['crash'] == 1
+        assert run.totals['a']['fail'] == 1
+
+    def test_time(self, run):
+        assert run.tests[grouptools.join('a', 'pass')].time.total == 2.0
+
+    def test_phases(self, run):
+        assert run.tests[grouptools.join('a', 'fail')].phases == {'draw': 0.5}
+
+    def test_record_not_read_for_status(self, run):
+        with mock.patch.object(backends.indexed._Container, 'read') as read:
+            for test in six.itervalues(run.tests):
+                _ = test.result
+                _ = test.subtests
+                _ = test.phases
+        assert not read.called
+
+    def test_record_read_for_output(self, run):
+        assert run.tests[grouptools.join('a', 'pass')].out == 'output'
+
+    def test_record_read_once(self, run):
+        with mock.patch.object(backends.indexed._Container, 'read',
+                               autospec=True,
+                               side_effect=backends.indexed._Container.read) \
+                as read:
+            test = run.tests[grouptools.join('a', 'pass')]
+            _ = test.out
+            _ = test.err
+            _ = test.command
+        assert read.call_count == 1
+
+    def test_resume(self, tmpdir):
+        _write_run(six.text_type(tmpdir),
+                   [('test', _result('pass'))], finalize=False)
+        run = backends.load(six.text_type(tmpdir))
+        assert run.tests['test'].result == status.PASS
+
+    def test_truncated(self, tmpdir, run):
+        with open(six.text_type(tmpdir.join('results.pidx')), 'rb') as f:
+            data = f.read()
+        with open(six.text_type(tmpdir.join('results.pidx')), 'wb') as f:
+            f.write(data[:-4])
+
+        with pytest.raises(exceptions.PiglitFatalError):
+            backends.load(six.text_type(tmpdir.join('results.pidx')))
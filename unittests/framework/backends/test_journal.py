@@ -0,0 +1,109 @@
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the framework.backends.journal module."""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+
+import six
+
+from framework.backends import journal
+
+# pylint: disable=no-self-use
+
+
+class TestJournal(object):
+    """Tests for the Journal class."""
+
+    def test_read(self, tmpdir):
+        """journal.read: records come back in the order written."""
+        p = six.text_type(tmpdir.join('journal'))
+        j = journal.Journal(p)
+        j.append('a', b'1')
+        j.append('b', b'2')
+        j.append('a', b'3')
+        j.close()
+
+        assert list(journal.read(p)) == [('a', b'1'), ('b', b'2'), ('a', b'3')]
+
+    def test_index(self, tmpdir):
+        """journal.index: the last record of each key wins."""
+        p = six.text_type(tmpdir.join('journal'))
+        j = journal.Journal(p)
+        j.append('a', b'1')
+        j.append('b', b'2')
+        j.append('a', b'3')
+        j.close()
+
+        offsets = journal.index(p)
+        assert list(offsets) == ['a', 'b']
+        with open(p, 'rb') as f:
+            assert journal.read_at(f, offsets['a']) == b'3'
+
+    def test_torn_record(self, tmpdir):
+        """journal.read: a partially written record is ignored."""
+        p = six.text_type(tmpdir.join('journal'))
+        j = journal.Journal(p)
+        j.append('a', b'1')
+        j.append('b', b'22222')
+        j.close()
+        with open(p, 'rb+') as f:
+            f.truncate(len(f.read()) - 2)
+
+        assert list(journal.read(p)) == [('a', b'1')]
+
+    def test_corrupt_record(self, tmpdir):
+        """journal.read: a record that fails its crc is ignored."""
+        p = six.text_type(tmpdir.join('journal'))
+        j = journal.Journal(p)
+        j.append('a', b'1')
+        j.append('b', b'2')
+        j.close()
+        with open(p, 'rb+') as f:
+            f.seek(-1, 2)
+            f.write(b'x')
+
+        assert list(journal.read(p)) == [('a', b'1')]
+
+    def test_reopen_drops_torn_record(self, tmpdir):
+        """journal.Journal: appending after a crash drops the torn record."""
+        p = six.text_type(tmpdir.join('journal'))
+        j = journal.Journal(p)
+        j.append('a', b'1')
+        j.close()
+        with open(p, 'ab') as f:
+            f.write(b'\0\0')
+
+        j = journal.Journal(p)
+        j.append('b', b'2')
+        j.close()
+
+        assert list(journal.read(p)) == [('a', b'1'), ('b', b'2')]
+
+    def test_group_commit(self, tmpdir):
+        """journal.Journal: records are fsync'd in groups."""
+        p = six.text_type(tmpdir.join('journal'))
+        j = journal.Journal(p, sync=True, commit_records=4,
+                            commit_interval=60)
+        for i in range(10):
+            j.append('a', six.text_type(i).encode('utf-8'))
+        assert j.commits == 2
+        j.close()
+        assert j.commits == 3
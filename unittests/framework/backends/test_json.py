@@ -41,6 +41,7 @@ from framework import backends
 from framework import exceptions
 from framework import grouptools
 from framework import results
+from framework.backends import journal
 
 from . import shared
 
@@ -73,7 +74,7 @@ class TestJSONBackend(object):
         """Tests for the write_test method."""
 
         def test_write(self, tmpdir):
-            """The write method should create a file."""
+            """The write method should create a journal."""
             p = six.text_type(tmpdir)
             test = backends.json.JSONBackend(p)
             test.initialize(shared.INITIAL_METADATA)
@@ -81,7 +82,7 @@ class TestJSONBackend(object):
             with test.write_test('bar') as t:
                 t(results.TestResult())
 
-            assert tmpdir.join('tests/0.json').check()
+            assert tmpdir.join('tests/journal.json').check()
 
         def test_load(self, tmpdir):
             """Test that the written JSON can be loaded.
@@ -97,8 +98,9 @@ class TestJSONBackend(object):
             with test.write_test('bar') as t:
                 t(results.TestResult())
 
-            with tmpdir.join('tests/0.json').open('r') as f:
-                json.load(f)
+            for _, value in journal.read(
+                    six.text_type(tmpdir.join('tests/journal.json'))):
+                json.loads(value.decode('utf-8'))
 
     class TestFinalize(object):
         """Tests for the finalize method."""
@@ -232,6 +234,92 @@ class TestResume(object):
             {'group1/test1', 'group1/test2', 'group2/test3', 'group2/test4'}
 
 
+    def test_load_torn_journal(self, tmpdir):
+        """backends.json._resume: ignores a partially written record."""
+        f = six.text_type(tmpdir)
+        backend = backends.json.JSONBackend(f)
+        backend.initialize(shared.INITIAL_METADATA)
+        with backend.write_test("group1/test1") as t:
+            t(results.TestResult('fail'))
+        with backend.write_test("group1/test2") as t:
+            t(results.TestResult('pass'))
+        backend._close_journal()
+        with open(os.path.join(f, 'tests', 'journal.json'), 'rb+') as w:
+            w.truncate(len(w.read()) - 1)
+        test = backends.json._resume(f)
+
+        assert test.tests['group1/test1'].result == 'fail'
+        assert test.tests['group1/test2'].result == 'incomplete'
+
+
+class TestResumeLegacy(object):
+    """Tests for resuming a run started with a file per test."""
+
+    @pytest.fixture
+    def legacy(self, tmpdir):
+        """A run written by a piglit that wrote a file per test."""
+        f = six.text_type(tmpdir)
+        backends.json.JSONBackend(f).initialize(
+            dict(shared.INITIAL_METADATA))
+
+        tests = [('group1/test1', results.TestResult('pass')),
+                 ('group1/test2', results.TestResult('incomplete'))]
+        for i, (name, result) in enumerate(tests):
+            with open(os.path.join(f, 'tests', '{}.json'.format(i)),
+                      'w') as w:
+                json.dump({name: result}, w,
+                          default=backends.json.piglit_encoder)
+        with open(os.path.join(f, 'tests', '2.json'), 'w') as w:
+            w.write('{"group2/te')
+        return f
+
+    def test_resume_loads_legacy(self, legacy):
+        """backends.json._resume: loads the per-test files."""
+        test = backends.json._resume(legacy)
+
+        assert test.tests['group1/test1'].result == 'pass'
+        assert test.tests['group1/test2'].result == 'incomplete'
+
+    def test_finalize_keeps_legacy(self, legacy):
+        """backends.json.JSONBackend.finalize: keeps the results written
+        before the resume, and the resumed results supersede them."""
+        backend = backends.json.JSONBackend(legacy)
+        with backend.write_test('group1/test2') as t:
+            t(results.TestResult('fail'))
+        backend.finalize(
+            {'time_elapsed':
+             results.TimeAttribute(start=0, end=1).to_json()})
+
+        test = backends.load(legacy)
+        assert set(test.tests) == {'group1/test1', 'group1/test2'}
+        assert test.tests['group1/test1'].result == 'pass'
+        assert test.tests['group1/test2'].result == 'fail'
+
+    def test_finalize_without_new_tests(self, legacy):
+        """backends.json.JSONBackend.finalize: keeps the legacy results
+        when nothing was run after resuming."""
+        backend = backends.json.JSONBackend(legacy)
+        backend.finalize(
+            {'time_elapsed':
+             results.TimeAttribute(start=0, end=1).to_json()})
+
+        test = backends.load(legacy)
+        assert set(test.tests) == {'group1/test1', 'group1/test2'}
+
+    def test_legacy_files_moved(self, legacy):
+        """backends.json.JSONBackend: the per-test files are moved into the
+        journal."""
+        backend = backends.json.JSONBackend(legacy)
+        with backend.write_test('group1/test2') as t:
+            t(results.TestResult('fail'))
+        backend._close_journal()
+
+        assert os.listdir(os.path.join(legacy, 'tests')) == ['journal.json']
+        test = backends.json._resume(legacy)
+        assert test.tests['group1/test1'].result == 'pass'
+        assert test.tests['group1/test2'].result == 'fail'
+
+
 class TestLoadResults(object):
     """Tests for the load_results function."""
 
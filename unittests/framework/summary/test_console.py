@@ -141,3 +141,39 @@ class TestPrintResult(object):
         actual, _ = capsys.readouterr()
 
         assert expected == actual
+
+
+class TestPrintPhases(object):
+    """Tests for the _print_phases function."""
+
+    @pytest.fixture
+    def output(self, capsys):
+        res1 = results.TestrunResult()
+        res1.name = 'run1'
+        res1.tests['foo'] = results.TestResult('pass')
+        res1.tests['foo'].phases = {'draw': 1.0, 'compile': 0.5}
+        res1.tests['bar'] = results.TestResult('pass')
+        res1.tests['bar'].phases = {'draw': 0.25, 'custom': 2.0}
+        res1.tests['baz'] = results.TestResult('pass')
+
+        res2 = results.TestrunResult()
+        res2.name = 'run2'
+        res2.tests['foo'] = results.TestResult('pass')
+        res2.tests['foo'].phases = {'link': 3.0}
+
+        console_._print_phases(common.Results([res1, res2]))
+        return capsys.readouterr()[0].splitlines()
+
+    def test_order(self, output):
+        """summary.console_._print_phases: known phases come first, in the
+        order they happen."""
+        assert [l.split(':')[0].strip() for l in output[3:]] == \
+            ['compile', 'link', 'draw', 'custom', 'total']
+
+    def test_sums(self, output):
+        """summary.console_._print_phases: sums the phases of each run."""
+        assert output[5].split() == ['draw:', '1.250', '0.000']
+
+    def test_total(self, output):
+        """summary.console_._print_phases: totals all phases of each run."""
+        assert output[-1].split() == ['total:', '3.750', '3.000']
@@ -26,9 +26,16 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import os
+try:
+    import mock
+except ImportError:
+    from unittest import mock
 
+import pytest
 import six
 
+from framework import backends
+from framework import results
 from framework.summary import html_
 
 
@@ -38,3 +45,99 @@ def test_copy_static(tmpdir):
     html_._copy_static_files(six.text_type(tmpdir))
     assert os.path.exists('index.css'), 'index.css not created correctly'
     assert os.path.exists('result.css'), 'result.css not created correctly'
+
+
+def _run(name, tests):
+    """Make a TestrunResult with the given test statuses."""
+    run = results.TestrunResult()
+    run.name = name
+    run.time_elapsed = results.TimeAttribute(start=0.0, end=1.0)
+    for test, status in six.iteritems(tests):
+        run.tests[test] = results.TestResult(status)
+    run.calculate_group_totals()
+    return run
+
+
+class TestIncremental(object):
+    """Tests for writing a summary into the directory of an earlier one."""
+
+    @pytest.fixture(autouse=True)
+    def serial(self):
+        """Render in this process, so the tests can see the renders."""
+        with mock.patch.object(html_, '_BATCH_SIZE', 1):
+            with mock.patch.object(html_.multiprocessing, 'Pool') as pool:
+                pool.return_value.map.side_effect = \
+                    lambda f, pages: [f(p) for p in pages]
+                yield
+
+    @staticmethod
+    def _html(tmpdir, runs, exclude=None):
+        with mock.patch.object(html_.backends, 'load',
+                               side_effect=lambda r: r):
+            with mock.patch.object(html_, '_render_test_page',
+                                   side_effect=html_._render_test_page) as r:
+                html_.html(runs, six.text_type(tmpdir), exclude)
+        return sorted(c[0][0][1] for c in r.call_args_list)
+
+    def test_first(self, tmpdir):
+        """Every test page is rendered into an empty directory."""
+        rendered = self._html(tmpdir, [_run('a', {'x': 'pass', 'y': 'fail'})])
+        assert rendered == ['x', 'y']
+        assert tmpdir.join('a', 'x.html').check()
+        assert tmpdir.join('manifest.json').check()
+
+    def test_unchanged(self, tmpdir):
+        """No test page is rendered again for the same results."""
+        self._html(tmpdir, [_run('a', {'x': 'pass'})])
+        assert self._html(tmpdir, [_run('a', {'x': 'pass'})]) == []
+
+    def test_added_run(self, tmpdir):
+        """Only the pages of an added results file are rendered."""
+        self._html(tmpdir, [_run('a', {'x': 'pass'})])
+        rendered = self._html(tmpdir, [_run('a', {'x': 'pass'}),
+                                       _run('b', {'x': 'fail'})])
+        assert rendered == ['x']
+        assert tmpdir.join('b', 'x.html').check()
+
+    def test_changed(self, tmpdir):
+        """A test page whose result changed is rendered again."""
+        self._html(tmpdir, [_run('a', {'x': 'pass', 'y': 'pass'})])
+        rendered = self._html(tmpdir, [_run('a', {'x': 'pass', 'y': 'fail'})])
+        assert rendered == ['y']
+
+    def test_removed(self, tmpdir):
+        """A page that isn't written anymore is removed."""
+        self._html(tmpdir, [_run('a', {'x': 'pass', 'y': 'pass'})])
+        self._html(tmpdir, [_run('a', {'x': 'pass'})])
+        assert not tmpdir.join('a', 'y.html').check()
+
+    def test_missing(self, tmpdir):
+        """A page in the manifest that was deleted is rendered again."""
+        self._html(tmpdir, [_run('a', {'x': 'pass'})])
+        tmpdir.join('a', 'x.html').remove()
+        assert self._html(tmpdir, [_run('a', {'x': 'pass'})]) == ['x']
+
+    def test_report(self, tmpdir, capsys):
+        """The number of written and unchanged pages is printed."""
+        self._html(tmpdir, [_run('a', {'x': 'pass'})])
+        capsys.readouterr()
+        self._html(tmpdir, [_run('a', {'x': 'pass'})])
+        # The index and the seven comparison pages are unchanged too.
+        assert 'Wrote 0 pages, 10 were unchanged' in capsys.readouterr()[0]
+
+    def test_indexed_unchanged(self, tmpdir):
+        """The records of an indexed run aren't read for unchanged pages."""
+        dest = tmpdir.mkdir('results')
+        backend = backends.indexed.IndexedBackend(six.text_type(dest))
+        backend.initialize({'name': 'a', 'options': {}})
+        with backend.write_test('x') as t:
+            t(results.TestResult('pass'))
+        backend.finalize({'time_elapsed':
+                          results.TimeAttribute(start=0, end=1).to_json()})
+
+        out = tmpdir.mkdir('out')
+        self._html(out, [backends.load(six.text_type(dest))])
+        with mock.patch.object(backends.indexed._Container, 'read') as read:
+            rendered = self._html(out, [backends.load(six.text_type(dest))])
+        assert rendered == []
+        assert not read.called
@@ -283,6 +283,43 @@ class TestTest(object):
 
             assert test.result.result is status.FAIL
 
+    class TestInterpretPhases(object):
+        """Tests for Test._interpret_phases."""
+
+        def test_phases(self):
+            """The phase timings are read into result.phases."""
+            test = _Test(['foobar'])
+            test.result.err = 'PIGLIT-PHASES: {"compile": 0.5, "draw": 0.25}\n'
+            test._interpret_phases()
+
+            assert test.result.phases == {'compile': 0.5, 'draw': 0.25}
+
+        def test_stripped(self):
+            """The phase lines are removed from err."""
+            test = _Test(['foobar'])
+            test.result.err = 'before\nPIGLIT-PHASES: {"draw": 1.0}\nafter'
+            test._interpret_phases()
+
+            assert test.result.err == 'before\nafter'
+
+        def test_summed(self):
+            """Several phase lines are summed."""
+            test = _Test(['foobar'])
+            test.result.err = ('PIGLIT-PHASES: {"draw": 1.0}\n'
+                               'PIGLIT-PHASES: {"draw": 0.5, "link": 2.0}\n')
+            test._interpret_phases()
+
+            assert test.result.phases == {'draw': 1.5, 'link': 2.0}
+
+        def test_malformed(self):
+            """A line that isn't json is left in err."""
+            test = _Test(['foobar'])
+            test.result.err = 'PIGLIT-PHASES: {"draw": \n'
+            test._interpret_phases()
+
+            assert test.result.phases == {}
+            assert test.result.err == 'PIGLIT-PHASES: {"draw": \n'
+
 
 class TestWindowResizeMixin(object):
     """Tests for the WindowResizeMixin class."""
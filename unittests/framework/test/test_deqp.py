@@ -29,6 +29,7 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import textwrap
+import threading
 try:
     from unittest import mock
 except ImportError:
@@ -41,6 +42,7 @@ from framework import exceptions
 from framework import grouptools
 from framework import profile
 from framework import status
+from framework.test import base
 from framework.test import deqp
 
 # pylint:disable=invalid-name,no-self-use
@@ -51,6 +53,11 @@ class _DEQPTestTest(deqp.DEQPBaseTest):
     extra_args = ['extra']
 
 
+class _DEQPBatchTestTest(deqp.DEQPBatchTest):
+    deqp_bin = 'deqp.bin'
+    extra_args = ['extra']
+
+
 class TestGetOptions(object):
     """Tests for the get_option function."""
 
@@ -120,6 +127,242 @@ class TestMakeProfile(object):
         assert expected in self.profile.test_list
 
 
+class TestMakeProfileBatches(object):
+    """Test deqp.make_profile with a batch class."""
+
+    def test_no_process_isolation(self, mocker):
+        """deqp.make_profile: batches cases without process isolation"""
+        mocker.patch('framework.test.deqp.options.OPTIONS.process_isolation',
+                     False)
+        profile_ = deqp.make_profile(['a.b.c', 'a.b.d'], _DEQPTestTest,
+                                     _DEQPBatchTestTest)
+        tests = profile_.test_list
+        assert list(tests) == [grouptools.join('a', 'b', 'c'),
+                               grouptools.join('a', 'b', 'd')]
+        assert isinstance(tests[grouptools.join('a', 'b', 'c')],
+                          deqp.DEQPBatchCase)
+        assert tests[grouptools.join('a', 'b', 'c')].batch is \
+            tests[grouptools.join('a', 'b', 'd')].batch
+
+    def test_process_isolation(self, mocker):
+        """deqp.make_profile: doesn't batch cases with process isolation"""
+        mocker.patch('framework.test.deqp.options.OPTIONS.process_isolation',
+                     True)
+        profile_ = deqp.make_profile(['a.b.c'], _DEQPTestTest,
+                                     _DEQPBatchTestTest)
+        assert isinstance(profile_.test_list[grouptools.join('a', 'b', 'c')],
+                          _DEQPTestTest)
+
+    def test_setup_selects(self, mocker):
+        """deqp.DEQPProfile.setup: selects the cases that aren't filtered"""
+        mocker.patch('framework.test.deqp.options.OPTIONS.process_isolation',
+                     False)
+        profile_ = deqp.make_profile(['a.b.c', 'a.b.d'], _DEQPTestTest,
+                                     _DEQPBatchTestTest)
+        profile_.filters.append(lambda n, _: n.endswith('d'))
+        batch = profile_.test_list[grouptools.join('a', 'b', 'c')].batch
+        select = mocker.patch.object(batch, 'select')
+        profile_.setup()
+
+        select.assert_called_once_with(['a.b.d'])
+
+
+class TestGenBatches(object):
+    """Tests for the gen_batches function."""
+
+    def test_groups(self):
+        """deqp.gen_batches: cases of different groups are in different
+        batches
+        """
+        assert list(deqp.gen_batches(['a.b.c', 'a.b.d', 'a.e.f'], 10)) == [
+            ['a.b.c', 'a.b.d'],
+            ['a.e.f'],
+        ]
+
+    def test_size(self):
+        """deqp.gen_batches: batches have at most size cases"""
+        assert list(deqp.gen_batches(['a.b', 'a.c', 'a.d'], 2)) == [
+            ['a.b', 'a.c'],
+            ['a.d'],
+        ]
+
+
+class TestQPAParser(object):
+    """Tests for the QPAParser class."""
+
+    _log = textwrap.dedent("""\
+        #beginSession
+        #beginTestCaseResult dEQP-GLES3.a.pass
+        <?xml version="1.0" encoding="UTF-8"?>
+        <TestCaseResult Version="0.3.4" CasePath="dEQP-GLES3.a.pass">
+        <Text>Result StatusCode="Fail"</Text>
+        <Result StatusCode="Pass">Pass</Result>
+        </TestCaseResult>
+        #endTestCaseResult
+        #beginTestCaseResult dEQP-GLES3.a.skip
+        <Result StatusCode="NotSupported">Not supported</Result>
+        #endTestCaseResult
+        #beginTestCaseResult dEQP-GLES3.a.timeout
+        #terminateTestCaseResult Timeout
+        #beginTestCaseResult dEQP-GLES3.a.crash
+        <TestCaseResult Version="0.3.4" CasePath="dEQP-GLES3.a.crash">
+        """)
+
+    def test_parse(self):
+        """deqp.QPAParser.feed: gets the status of each case"""
+        parser = deqp.QPAParser()
+        assert parser.feed(self._log) == [
+            ('dEQP-GLES3.a.pass', 'pass', 'Pass (Pass)'),
+            ('dEQP-GLES3.a.skip', 'skip', 'NotSupported (Not supported)'),
+            ('dEQP-GLES3.a.timeout', 'timeout', 'Timeout'),
+        ]
+        assert parser.current == 'dEQP-GLES3.a.crash'
+
+    def test_pieces(self):
+        """deqp.QPAParser.feed: lines can be split between pieces"""
+        parser = deqp.QPAParser()
+        done = []
+        for i in range(0, len(self._log), 7):
+            done.extend(parser.feed(self._log[i:i + 7]))
+        assert done == deqp.QPAParser().feed(self._log)
+
+
+class TestDEQPBatchTest(object):
+    """Tests for the DEQPBatchTest and DEQPBatchCase classes."""
+
+    @pytest.fixture(autouse=True)
+    def no_poll(self, mocker):
+        mocker.patch.object(deqp.DEQPBatchTest, '_POLL', 0.01)
+
+    @staticmethod
+    def _fake_deqp(crash=(), processes=None, wait=None):
+        """Make a _run_command that writes a QPA log like dEQP would.
+
+        The cases of each process are added to processes. If wait is given,
+        it is called with the case that was just written and the log file.
+
+        """
+        def run(test, **kwargs):
+            command = kwargs['_command']
+            args = dict(a.split('=', 1) for a in command if '=' in a)
+            with open(args['--deqp-caselist-file']) as f:
+                cases = f.read().split()
+            if processes is not None:
+                processes.append(cases)
+            test.result.returncode = 0
+            test.result.out = 'out'
+            test.result.err = 'err'
+            with open(args['--deqp-log-filename'], 'w') as f:
+                for case in cases:
+                    f.write('#beginTestCaseResult {}\n'.format(case))
+                    if case in crash:
+                        test.result.returncode = -6
+                        return
+                    f.write('<Result StatusCode="Pass">Pass</Result>\n'
+                            '#endTestCaseResult\n')
+                    f.flush()
+                    if wait is not None:
+                        wait(case)
+        return run
+
+    @staticmethod
+    def _run(batch, case):
+        test = deqp.DEQPBatchCase(batch, case)
+        test.run()
+        return test.result
+
+    def test_command_adds_extra_args(self):
+        """deqp.DEQPBatchTest.command: adds the extra arguments"""
+        assert _DEQPBatchTestTest(['a.b']).command == ['deqp.bin', 'extra']
+
+    def test_case_command(self):
+        """deqp.DEQPBatchCase.command: runs the case on its own"""
+        batch = _DEQPBatchTestTest(['a.b'])
+        assert deqp.DEQPBatchCase(batch, 'a.b').command == \
+            ['deqp.bin', 'extra', '--deqp-case=a.b']
+
+    def test_one_process(self, mocker):
+        """deqp.DEQPBatchCase.run: the cases of a batch run in one process"""
+        processes = []
+        mocker.patch('framework.test.base.Test._run_command',
+                     self._fake_deqp(processes=processes))
+        batch = _DEQPBatchTestTest(['a.b', 'a.c'])
+
+        assert self._run(batch, 'a.b').result is status.PASS
+        assert self._run(batch, 'a.c').result is status.PASS
+        assert processes == [['a.b', 'a.c']]
+
+    def test_resume(self, mocker):
+        """deqp.DEQPBatchCase.run: charges a crash to the case in progress
+        and resumes after it
+        """
+        mocker.patch('framework.test.base.Test._run_command',
+                     self._fake_deqp(crash=['a.c']))
+        batch = _DEQPBatchTestTest(['a.b', 'a.c', 'a.d'])
+
+        assert self._run(batch, 'a.b').result is status.PASS
+        crashed = self._run(batch, 'a.c')
+        assert crashed.result is status.CRASH
+        assert crashed.returncode == -6
+        assert crashed.err == 'err'
+        assert self._run(batch, 'a.d').result is status.PASS
+
+    def test_selected(self, mocker):
+        """deqp.DEQPBatchCase.run: only the selected cases are run"""
+        processes = []
+        mocker.patch('framework.test.base.Test._run_command',
+                     self._fake_deqp(processes=processes))
+        batch = _DEQPBatchTestTest(['a.b', 'a.c', 'a.d'])
+        batch.select(['a.b', 'a.d'])
+
+        self._run(batch, 'a.d')
+        self._run(batch, 'a.b')
+        assert processes == [['a.d', 'a.b']]
+
+    def test_incremental(self, mocker):
+        """deqp.DEQPBatchCase.run: a case gets its result while dEQP is
+        still running the cases after it
+        """
+        first = threading.Event()
+
+        def wait(case):
+            if case == 'a.c':
+                assert first.wait(5), 'a.b had to wait for a.c'
+
+        mocker.patch('framework.test.base.Test._run_command',
+                     self._fake_deqp(wait=wait))
+        batch = _DEQPBatchTestTest(['a.b', 'a.c'])
+
+        assert self._run(batch, 'a.b').result is status.PASS
+        first.set()
+        assert self._run(batch, 'a.c').result is status.PASS
+
+    def test_missing_binary(self, mocker):
+        """deqp.DEQPBatchCase.run: cases are skipped without the binary"""
+        mocker.patch('framework.test.base.Test._run_command',
+                     side_effect=base.TestRunError('not found', 'skip'))
+        batch = _DEQPBatchTestTest(['a.b', 'a.c'])
+
+        assert self._run(batch, 'a.b').result is status.SKIP
+        assert self._run(batch, 'a.c').result is status.SKIP
+
+
+class TestBatchSize(object):
+    """Tests for the _BatchSize class."""
+
+    def test_no_crashes(self):
+        """deqp._BatchSize: runs all cases in one process without crashes"""
+        size = deqp._BatchSize()
+        size.update(1000, 0)
+        assert size.get(1000) == 1000
+
+    def test_crashes(self):
+        """deqp._BatchSize: runs fewer cases in one process after crashes"""
+        size = deqp._BatchSize()
+        size.update(100, 10)
+        assert size.get(1000) < 100
+
+
 class TestIterDeqpTestCases(object):
     """Tests for iter_deqp_test_cases."""
 
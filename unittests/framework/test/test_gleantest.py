@@ -107,3 +107,46 @@ def test_crash():
     test.interpret_result()
 
     assert test.result.result is status.CRASH
+
+
+def test_shard_command():
+    """test.gleantest.GleanTest: shard is passed with --shard."""
+    test = GleanTest('texCombine', shard='GL_ADD')
+    index = test.command.index('--shard')
+    assert test.command[index + 1] == 'GL_ADD'
+
+
+def test_no_shard_command():
+    """test.gleantest.GleanTest: --shard isn't passed without a shard."""
+    test = GleanTest('texCombine')
+    assert '--shard' not in test.command
+
+
+class TestInterpretResultShards(object):
+    """Tests for the subtests of shards in GleanTest.interpret_result."""
+
+    @pytest.fixture
+    def test(self):
+        test = GleanTest('texCombine')
+        test.result.returncode = 0
+        test.result.out = (
+            'PIGLIT: {"subtest": {"GL_ADD" : "pass"}}\n'
+            'PIGLIT: {"subtest": {"crossbar" : "skip"}}\n'
+            'texCombine:  PASS rgba8\n')
+        return test
+
+    def test_subtests(self, test):
+        test.interpret_result()
+        assert test.result.subtests['GL_ADD'] == 'pass'
+        assert test.result.subtests['crossbar'] == 'skip'
+
+    def test_out(self, test):
+        """The PIGLIT: lines are removed from the output."""
+        test.interpret_result()
+        assert test.result.out == 'texCombine:  PASS rgba8\n'
+
+    def test_fail(self, test):
+        test.result.out = ('PIGLIT: {"subtest": {"GL_ADD" : "fail"}}\n'
+                           'texCombine:  FAIL rgba8\n')
+        test.interpret_result()
+        assert test.result.result is status.FAIL
@@ -481,3 +481,68 @@ def test_add_compatibility_requirement_binary(version, extension, tmpdir,
     # The compat extension was added to the slow skipping (C level)
     # requirements
     assert extension in test.command
+
+
+class TestMultiGLSLParserTest(object):
+    """Tests for the MultiGLSLParserTest class."""
+
+    @staticmethod
+    def _write(tmpdir, name, version, check_link='false'):
+        p = tmpdir.join(name)
+        p.write(textwrap.dedent("""\
+            /* [config]
+             * expect_result: pass
+             * glsl_version: {}
+             * check_link: {}
+             * [end config]
+             */""".format(version, check_link)))
+        return six.text_type(p)
+
+    @pytest.fixture
+    def inst(self, tmpdir):
+        """A fixture that creates an instance to test."""
+        return glsl.MultiGLSLParserTest([
+            self._write(tmpdir, 'foo.vert', '1.30', 'true'),
+            self._write(tmpdir, 'bar.frag', '1.30'),
+        ])
+
+    def test_command(self, inst):
+        """MultiGLSLParserTest: the arguments of each file are separated by
+        '--'.
+        """
+        command = [os.path.basename(c) for c in inst.command]
+        assert command == [
+            'glslparsertest', '-report-subtests',
+            'foo.vert', 'pass', '1.30', '--check-link', '--',
+            'bar.frag', 'pass', '1.30']
+
+    def test_subtests(self, inst):
+        """MultiGLSLParserTest: each file is a subtest."""
+        assert set(inst.result.subtests) == {'foo.vert', 'bar.frag'}
+
+    def test_resume(self, inst):
+        """MultiGLSLParserTest: resuming starts at the given file."""
+        actual = [os.path.basename(c) for c in inst._resume(1)]  # pylint: disable=protected-access
+        assert actual == ['glslparsertest', '-report-subtests',
+                          'bar.frag', 'pass', '1.30']
+
+    def test_mixed_versions(self, tmpdir):
+        """MultiGLSLParserTest: files must request the same GLSL version."""
+        with pytest.raises(exceptions.PiglitInternalError):
+            glsl.MultiGLSLParserTest([
+                self._write(tmpdir, 'foo.vert', '1.30'),
+                self._write(tmpdir, 'bar.frag', '1.40'),
+            ])
+
+    def test_batch_skip(self, inst, mocker):
+        """MultiGLSLParserTest: a batch that skips before reporting any file
+        marks every file skip.
+        """
+        def run(self, *args, **kwargs):  # pylint: disable=unused-argument
+            self.result.returncode = 0
+            self.result.out = 'PIGLIT: {"result": "skip" }\n'
+
+        mocker.patch('framework.test.base.Test._run_command', run)
+        inst._run_command()  # pylint: disable=protected-access
+        assert dict(inst.result.subtests) == {'foo.vert': 'skip',
+                                              'bar.frag': 'skip'}
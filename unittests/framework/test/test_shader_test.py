@@ -24,6 +24,7 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import os
+import sys
 import textwrap
 try:
     import mock
@@ -265,3 +266,64 @@ class TestMultiShaderTest(object):
         assert os.path.basename(actual[1]) == 'bar.shader_test'
         assert os.path.basename(actual[2]) == '-auto'
 
+
+
+class TestShaderRunnerWorker(object):
+    """Tests for the ShaderRunnerWorker class."""
+
+    @pytest.yield_fixture
+    def worker(self, tmpdir):
+        """A worker running a script that speaks the -worker protocol."""
+        script = tmpdir.join('fake_runner')
+        script.write(textwrap.dedent("""\
+            #!{}
+            import os
+            import sys
+
+            def run(name):
+                sys.stdout.write('PIGLIT TEST: 1 - ' + name + '\\n')
+                sys.stdout.flush()
+                if name == 'crash':
+                    os.abort()
+                sys.stdout.write('PIGLIT: {{"result": "pass" }}\\n')
+                sys.stderr.write('stderr of ' + name + '\\n')
+                sys.stderr.write('PIGLIT WORKER: done\\n')
+                sys.stderr.flush()
+                sys.stdout.write('PIGLIT WORKER: done\\n')
+                sys.stdout.flush()
+
+            run(sys.argv[1])
+            for line in iter(sys.stdin.readline, ''):
+                run(line.strip())
+            """.format(sys.executable)))
+        script.chmod(0o755)
+
+        worker = shader_test.ShaderRunnerWorker([six.text_type(script)])
+        yield worker
+        worker.close()
+
+    def test_output(self, worker):
+        """Output is split at the done marker."""
+        out, err, returncode = worker.run('foo')
+        assert out == 'PIGLIT TEST: 1 - foo\nPIGLIT: {"result": "pass" }\n'
+        assert err == 'stderr of foo\n'
+        assert returncode == 0
+
+    def test_reused(self, worker):
+        """The same process runs consecutive test files."""
+        worker.run('foo')
+        pid = worker.last_pid
+        out, _, _ = worker.run('bar')
+        assert worker.last_pid == pid
+        assert 'PIGLIT TEST: 1 - bar' in out
+
+    def test_crash(self, worker):
+        """A crash is reported and the worker is restarted."""
+        worker.run('foo')
+        pid = worker.last_pid
+        _, _, returncode = worker.run('crash')
+        assert returncode < 0
+
+        _, _, returncode = worker.run('bar')
+        assert returncode == 0
+        assert worker.last_pid != pid
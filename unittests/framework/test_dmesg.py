@@ -29,7 +29,9 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 import collections
+import errno
 import re
+import threading
 try:
     import mock
 except ImportError:
@@ -311,6 +313,183 @@ class TestLinuxDmesg(object):
             assert repr(dmesg.LinuxDmesg()) == 'LinuxDmesg()'
 
 
+class _KmsgReaderTester(dmesg.KmsgReader):
+    """KmsgReader without /dev/kmsg or a thread, log() logs a message."""
+
+    def __init__(self):  # pylint: disable=super-init-not-called
+        self._lock = mock.MagicMock()
+        self._messages = collections.deque()
+        self._first = 0
+        self._marks = collections.Counter()
+        self._fd = None
+        self.records = collections.deque()
+
+    def log(self, line, level=3):
+        self.records.append('{},0,1500000,-;{}\n'.format(
+            level, line).encode('utf-8'))
+
+    def read(self, fd, size):  # pylint: disable=unused-argument
+        if not self.records:
+            raise OSError(errno.EAGAIN, 'EAGAIN')
+        return self.records.popleft()
+
+
+class TestKmsgReader(object):
+    """Tests for the KmsgReader class."""
+
+    @pytest.fixture
+    def reader(self, mocker):
+        reader = _KmsgReaderTester()
+        mocker.patch('framework.dmesg.os.read', reader.read)
+        return reader
+
+    def test_parse(self):
+        """dmesg.KmsgReader.parse: gets the level and a dmesg line"""
+        assert dmesg.KmsgReader.parse(
+            b'11,42,1500000,-;foo bar\n SUBSYSTEM=x\n') == \
+            (3, '[    1.500000] foo bar')
+
+    def test_messages(self, reader):
+        """dmesg.KmsgReader.messages: gets the messages between marks"""
+        reader.log('before')
+        start = reader.mark()
+        reader.log('foo')
+        reader.log('bar', level=6)
+        end = reader.mark()
+        reader.log('after')
+        reader.mark()
+
+        assert [(l, m[15:]) for _, l, m in reader.messages(start, end)] == \
+            [(3, 'foo'), (6, 'bar')]
+
+    def test_dropped(self, reader):
+        """dmesg.KmsgReader: messages before every mark are dropped"""
+        start = reader.mark()
+        reader.log('foo')
+        end = reader.mark()
+        reader.release(start)
+        reader.release(end)
+        reader.log('bar')
+        reader.mark()
+
+        assert len(reader._messages) == 0
+
+    def test_kept(self, reader):
+        """dmesg.KmsgReader: messages after a mark are kept"""
+        start = reader.mark()
+        reader.log('foo')
+        reader.release(reader.mark())
+
+        assert len(reader.messages(start, reader.position)) == 1
+
+
+class TestKmsgDmesg(object):
+    """Tests for the KmsgDmesg class."""
+
+    @pytest.fixture
+    def testers(self, mocker):
+        reader = _KmsgReaderTester()
+        mocker.patch('framework.dmesg.os.read', reader.read)
+        mocker.patch('framework.dmesg.get_kmsg_reader',
+                     mocker.Mock(return_value=reader))
+        return reader, dmesg.KmsgDmesg()
+
+    @staticmethod
+    def _in_thread(function):
+        """Run a function in a new thread and wait for it."""
+        thread = threading.Thread(target=function)
+        thread.start()
+        thread.join()
+
+    def test_update_result(self, testers):
+        """dmesg.KmsgDmesg.update_result: gets the messages of the test"""
+        reader, test = testers
+        reader.log('before')
+        test.update_dmesg()
+        reader.log('foo')
+        result = test.update_result(results.TestResult('pass'))
+
+        assert result.result is status.DMESG_WARN
+        assert result.dmesg == '[    1.500000] foo'
+
+    def test_level(self, testers):
+        """dmesg.KmsgDmesg.update_result: ignores info and debug messages"""
+        reader, test = testers
+        test.update_dmesg()
+        reader.log('foo', level=6)
+        result = test.update_result(results.TestResult('pass'))
+
+        assert result.result is status.PASS
+
+    def test_ambiguous(self, testers):
+        """dmesg.KmsgDmesg.update_result: marks messages logged while
+        another test ran as ambiguous
+        """
+        reader, test = testers
+        test.update_dmesg()
+        reader.log('foo')
+        self._in_thread(test.update_dmesg)
+        reader.log('bar')
+        result = test.update_result(results.TestResult('pass'))
+
+        assert result.dmesg == ('[    1.500000] foo\n'
+                                '(ambiguous) [    1.500000] bar')
+
+    def test_ambiguous_finished(self, testers):
+        """dmesg.KmsgDmesg.update_result: marks messages logged while a test
+        that already finished ran as ambiguous
+        """
+        reader, test = testers
+        test.update_dmesg()
+
+        def other():
+            test.update_dmesg()
+            reader.log('foo')
+            test.update_result(results.TestResult('pass'))
+        self._in_thread(other)
+
+        result = test.update_result(results.TestResult('pass'))
+
+        assert result.dmesg == '(ambiguous) [    1.500000] foo'
+
+    def test_serial(self, testers):
+        """dmesg.KmsgDmesg.update_result: messages of earlier tests aren't
+        ambiguous
+        """
+        reader, test = testers
+        test.update_dmesg()
+        reader.log('foo')
+        test.update_result(results.TestResult('pass'))
+        test.update_dmesg()
+        reader.log('bar')
+        result = test.update_result(results.TestResult('pass'))
+
+        assert result.dmesg == '[    1.500000] bar'
+
+    def test_drained_at_end(self, testers, mocker):
+        """dmesg.KmsgDmesg.update_result: gets the messages of the test when
+        the reader drops old messages while the test ends
+        """
+        reader, test = testers
+        release = reader.release
+
+        def release_and_drain(position):
+            # Like the background thread reading right after a release
+            release(position)
+            with reader._lock:
+                reader._drain()
+        mocker.patch.object(reader, 'release', release_and_drain)
+
+        test.update_dmesg()
+        reader.log('foo')
+        result = test.update_result(results.TestResult('pass'))
+
+        assert result.dmesg == '[    1.500000] foo'
+
+    def test_repr(self, testers):
+        assert repr(testers[1]) == 'KmsgDmesg()'
+
+
 class TestDummyDmesg(object):
     """Tests for the DummyDmesg class."""
     _Namespace = collections.namedtuple('_Namespace', ['dmesg', 'result'])
@@ -364,6 +543,8 @@ class TestGetDmesg(object):
         platforms with various configurations.
         """
         mocker.patch('framework.dmesg.sys.platform', platform)
+        mocker.patch('framework.dmesg.get_kmsg_reader',
+                     mocker.Mock(side_effect=OSError(errno.ENOENT, 'ENOENT')))
 
         with mock.patch('framework.dmesg.subprocess.check_output',
                         mock.Mock(return_value=b'[1.0]foo')):
@@ -372,3 +553,24 @@ class TestGetDmesg(object):
         # We don't want a subclass, we want the *exact* class. This is a
         # unittest after all
         assert type(actual) == expected  # pylint: disable=unidiomatic-typecheck
+
+    @skip.linux
+    def test_get_dmesg_kmsg(self, mocker):
+        """dmesg.get_dmesg: returns a KmsgDmesg if /dev/kmsg can be read."""
+        mocker.patch('framework.dmesg.sys.platform', 'linux')
+        mocker.patch('framework.dmesg.get_kmsg_reader')
+
+        assert type(dmesg.get_dmesg()) == dmesg.KmsgDmesg  # pylint: disable=unidiomatic-typecheck
+
+    @skip.linux
+    def test_get_dmesg_kmsg_restricted(self, mocker):
+        """dmesg.get_dmesg: returns a LinuxDmesg if /dev/kmsg can't be
+        opened, even though its permissions allow it.
+        """
+        mocker.patch('framework.dmesg.sys.platform', 'linux')
+        mocker.patch('framework.dmesg.os.open',
+                     mocker.Mock(side_effect=OSError(errno.EPERM, 'EPERM')))
+        mocker.patch('framework.dmesg.subprocess.check_output',
+                     mocker.Mock(return_value=b'[1.0]foo'))
+
+        assert type(dmesg.get_dmesg()) == dmesg.LinuxDmesg  # pylint: disable=unidiomatic-typecheck
@@ -27,6 +27,8 @@ from __future__ import (
     absolute_import, division, print_function, unicode_literals
 )
 
+import errno
+
 import pytest
 import six
 
@@ -146,6 +148,8 @@ class TestMonitoring(object):
     @skip.linux
     def test_dmesg_error(self, mocker):
         """monitoring.Monitoring: error found on the dmesg."""
+        mocker.patch('framework.monitoring.get_kmsg_reader',
+                     mocker.Mock(side_effect=OSError(errno.EPERM, 'EPERM')))
         mocker.patch('framework.dmesg.subprocess.check_output',
                      mocker.Mock(return_value=b'[1.0]This\n[2.0]is\n[3.0]dmesg'))
         self.monitoring.add_rule('no_error_file',
@@ -163,6 +167,8 @@ class TestMonitoring(object):
     @skip.linux
     def test_dmesg_no_error(self, mocker):
         """monitoring.Monitoring: no error found on the dmesg."""
+        mocker.patch('framework.monitoring.get_kmsg_reader',
+                     mocker.Mock(side_effect=OSError(errno.EPERM, 'EPERM')))
         mocker.patch('framework.dmesg.subprocess.check_output',
                      mocker.Mock(return_value=b'[1.0]This\n[2.0]is\n[3.0]dmesg'))
         self.monitoring.add_rule('no_error_file',
@@ -176,3 +182,43 @@ class TestMonitoring(object):
         self.monitoring.check_monitoring()
 
         assert self.monitoring.abort_needed is False
+
+    @skip.linux
+    def test_kmsg_error(self, mocker):
+        """monitoring.Monitoring: error found on /dev/kmsg."""
+        reader = mocker.Mock()
+        reader.mark.side_effect = [0, 1, 3]
+        reader.messages.side_effect = [[(0, 3, '[1.0] foo')],
+                                       [(1, 4, '[2.0] foo'),
+                                        (2, 3, '[3.0] *ERROR* bar')]]
+        mocker.patch('framework.monitoring.get_kmsg_reader',
+                     mocker.Mock(return_value=reader))
+        self.monitoring.add_rule('no_error_file',
+                                 'dmesg',
+                                 '--level emerg,alert,crit,err',
+                                 self.regex)
+        self.monitoring.update_monitoring()
+        self.monitoring.check_monitoring()
+
+        assert self.monitoring.abort_needed is True
+        reader.messages.assert_called_with(1, 3)
+        reader.release.assert_called_with(1)
+
+    @skip.linux
+    def test_kmsg_level(self, mocker):
+        """monitoring.Monitoring: ignores /dev/kmsg messages of other
+        levels.
+        """
+        reader = mocker.Mock()
+        reader.mark.side_effect = [0, 1, 2]
+        reader.messages.side_effect = [[], [(1, 4, '[2.0] *ERROR* bar')]]
+        mocker.patch('framework.monitoring.get_kmsg_reader',
+                     mocker.Mock(return_value=reader))
+        self.monitoring.add_rule('no_error_file',
+                                 'dmesg',
+                                 '--level emerg,alert,crit,err',
+                                 self.regex)
+        self.monitoring.update_monitoring()
+        self.monitoring.check_monitoring()
+
+        assert self.monitoring.abort_needed is False
@@ -305,3 +305,44 @@ class TestRegexFilter(object):
             """Returns False when the test matches any regex."""
             test = profile.RegexFilter([r'fob', r'bar'], inverse=True)
             assert test('foobob', None)
+
+
+class TestSchedule(object):
+    """Tests for the Schedule class."""
+
+    def test_fallback_median(self):
+        """Unknown tests are assumed to take the median of the known times."""
+        test = profile.Schedule({'a': 1.0, 'b': 2.0, 'c': 10.0})
+        assert test.estimate('d') == 2.0
+
+    def test_fallback_default(self):
+        """Without any known times the default estimate is used."""
+        test = profile.Schedule({})
+        assert test.estimate('a') == profile.Schedule.DEFAULT_ESTIMATE
+
+    def test_order(self):
+        """The longest tests come first, unknown ones at the median."""
+        test = profile.Schedule({'a': 1.0, 'b': 5.0, 'c': 3.0})
+        names = [n for n, _ in test.order(
+            [('a', None), ('b', None), ('c', None), ('d', None)])]
+        assert names == ['b', 'c', 'd', 'a']
+
+    def test_makespan(self):
+        """Tests go to whichever worker frees up first."""
+        test = profile.Schedule({'a': 4.0, 'b': 3.0, 'c': 2.0, 'd': 2.0})
+        assert test.makespan([(2, ['a', 'b', 'c', 'd'])]) == 6.0
+
+    def test_makespan_lanes(self):
+        """Lanes run side by side, the longest one decides."""
+        test = profile.Schedule({'a': 4.0, 'b': 3.0, 'c': 6.0})
+        assert test.makespan([(2, ['a', 'b']), (1, ['c'])]) == 6.0
+
+    def test_from_results(self):
+        """Only tests with a recorded time are used."""
+        from framework import results
+        run = results.TestrunResult()
+        run.tests['a'] = results.TestResult('pass')
+        run.tests['a'].time = results.TimeAttribute(1.0, 3.5)
+        run.tests['b'] = results.TestResult('notrun')
+        test = profile.Schedule.from_results(run)
+        assert test.timings == {'a': 2.5}
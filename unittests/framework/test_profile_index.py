@@ -0,0 +1,152 @@
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the framework.profile_index module."""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import os
+import textwrap
+
+import pytest
+import six
+
+from framework import profile_index
+from framework.test import glsl_parser_test
+
+# pylint: disable=invalid-name,no-self-use,protected-access
+
+_SHADER_TEST = textwrap.dedent("""\
+    [require]
+    GL ES >= 3.0
+    GLSL ES >= 3.00
+    GL_OES_texture_3D
+
+    [test]
+    draw rect -1 -1 2 2
+    """)
+
+_GLSL_TEST = textwrap.dedent("""\
+    // [config]
+    // expect_result: pass
+    // glsl_version: 1.30
+    // require_extensions: GL_ARB_foo
+    // [end config]
+    """)
+
+
+@pytest.fixture
+def files(tmpdir):
+    shader = tmpdir.join('test.shader_test')
+    shader.write(_SHADER_TEST)
+    glsl = tmpdir.join('test.frag')
+    glsl.write(_GLSL_TEST)
+    legacy = tmpdir.join('legacy.frag')
+    legacy.write('void main() {}\n')
+    return (six.text_type(tmpdir.join('index.json')), six.text_type(shader),
+            six.text_type(glsl), six.text_type(legacy))
+
+
+class TestProfileIndex(object):
+    """Tests for the ProfileIndex class."""
+
+    def test_shader_test(self, files):
+        """ProfileIndex.shader_test: a cached parser matches a fresh one."""
+        path, shader, _, _ = files
+        index = profile_index.ProfileIndex(None)
+        fresh = index.shader_test(shader)
+        index = profile_index.ProfileIndex(path)
+        index.shader_test(shader)
+        index.write()
+
+        cached = profile_index.ProfileIndex(path).shader_test(shader)
+        assert cached.prog == fresh.prog == 'shader_runner_gles3'
+        assert cached.gl_required == fresh.gl_required
+        assert cached.gles_version == fresh.gles_version
+        assert cached.glsl_es_version == fresh.glsl_es_version
+
+    def test_hit(self, files):
+        """ProfileIndex: unchanged files are not parsed again."""
+        path, shader, glsl, _ = files
+        index = profile_index.ProfileIndex(path)
+        index.shader_test(shader)
+        index.glsl_parser_test(glsl)
+        index.write()
+
+        index = profile_index.ProfileIndex(path)
+        parser = index.glsl_parser_test(glsl)
+        index.shader_test(shader)
+        assert (index.hits, index.misses) == (2, 0)
+        assert parser.gl_required == {'GL_ARB_foo'}
+        assert parser.glsl_version == 1.3
+
+    def test_modified(self, files):
+        """ProfileIndex: files whose size changed are parsed again."""
+        path, shader, _, _ = files
+        index = profile_index.ProfileIndex(path)
+        index.shader_test(shader)
+        index.write()
+
+        with open(shader, 'a') as f:
+            f.write('probe all rgba 0 0 0 0\n')
+
+        index = profile_index.ProfileIndex(path)
+        index.shader_test(shader)
+        assert (index.hits, index.misses) == (0, 1)
+
+    def test_no_config(self, files):
+        """ProfileIndex.glsl_parser_test: files without a config block keep
+        raising GLSLParserNoConfigError when cached.
+        """
+        path, _, _, legacy = files
+        index = profile_index.ProfileIndex(path)
+        with pytest.raises(glsl_parser_test.GLSLParserNoConfigError):
+            index.glsl_parser_test(legacy)
+        index.write()
+
+        index = profile_index.ProfileIndex(path)
+        with pytest.raises(glsl_parser_test.GLSLParserNoConfigError):
+            index.glsl_parser_test(legacy)
+        assert index.hits == 1
+
+    def test_stale(self, files):
+        """ProfileIndex.write: entries that were not looked up are dropped."""
+        path, shader, glsl, _ = files
+        index = profile_index.ProfileIndex(path)
+        index.shader_test(shader)
+        index.glsl_parser_test(glsl)
+        index.write()
+
+        os.unlink(glsl)
+        index = profile_index.ProfileIndex(path)
+        index.shader_test(shader)
+        index.write()
+
+        index = profile_index.ProfileIndex(path)
+        assert list(index._ProfileIndex__entries) == [shader]
+
+    def test_bad_file(self, files):
+        """ProfileIndex: a corrupt index is ignored."""
+        path, shader, _, _ = files
+        with open(path, 'w') as f:
+            f.write('{not json')
+
+        index = profile_index.ProfileIndex(path)
+        index.shader_test(shader)
+        assert index.misses == 1
@@ -116,6 +116,7 @@ class TestTestResult(object):
                     'exception': 'an exception',
                     'dmesg': 'this is dmesg',
                     'pid': [1934],
+                    'phases': {'compile': 0.5, 'draw': 0.25},
                 }
 
                 cls.test = results.TestResult.from_dict(cls.dict)
@@ -172,6 +173,14 @@ class TestTestResult(object):
                 """sets pid properly."""
                 assert self.test.pid == self.dict['pid']
 
+            def test_phases(self):
+                """sets phases properly."""
+                assert self.test.phases == self.dict['phases']
+
+            def test_no_phases(self):
+                """phases default to empty for older results."""
+                assert results.TestResult.from_dict({}).phases == {}
+
         class TestResult(object):
             """Tests for TestResult.result getter and setter methods."""
 
@@ -233,6 +242,7 @@ class TestTestResult(object):
             test.dmesg = 'this is dmesg'
             test.pid = 1934
             test.traceback = 'a traceback'
+            test.phases = {'link': 1.5}
 
             cls.test = test
             cls.json = test.to_json()
@@ -285,6 +295,10 @@ class TestTestResult(object):
             """results.TestResult.to_json: Adds the traceback attribute"""
             assert self.test.traceback == self.json['traceback']
 
+        def test_phases(self):
+            """results.TestResult.to_json: Adds the phases attribute"""
+            assert self.test.phases == self.json['phases']
+
     class TestUpdate(object):
         """Tests for TestResult.update."""
 
@@ -588,6 +602,50 @@ class TestTestrunResult(object):
                 self.inst.get_result('fooobar')
 
 
+class TestResultTree(object):
+    """Tests for the ResultTree class."""
+
+    @classmethod
+    def setup_class(cls):
+        """setup state for all tests."""
+        sub = results.TestResult('pass')
+        sub.subtests['foo'] = status.PASS
+        sub.subtests['bar'] = status.FAIL
+
+        cls.tree = results.ResultTree({
+            grouptools.join('group', 'sub'): sub,
+            grouptools.join('group', 'sub', 'bar'): results.TestResult('skip'),
+            'test': results.TestResult('crash'),
+        })
+
+    def test_names(self):
+        """names has tests and subtests, but not tests with subtests."""
+        assert sorted(self.tree.names) == sorted([
+            grouptools.join('group', 'sub', 'foo'),
+            grouptools.join('group', 'sub', 'bar'),
+            'test',
+        ])
+
+    def test_subtest_status(self):
+        """statuses has the statuses of subtests."""
+        assert self.tree.statuses[grouptools.join('group', 'sub', 'foo')] == \
+            status.PASS
+
+    def test_test_before_subtest(self):
+        """A test takes precedence over a subtest with the same name."""
+        assert self.tree.statuses[grouptools.join('group', 'sub', 'bar')] == \
+            status.SKIP
+
+    def test_totals(self):
+        """A test with subtests is a group that also has a test in it."""
+        totals = self.tree.totals()
+        assert totals[grouptools.join('group', 'sub')]['skip'] == 1
+        assert totals[grouptools.join('group', 'sub')]['fail'] == 1
+        assert totals['group']['skip'] == 1
+        assert totals['root']['crash'] == 1
+        assert sum(six.itervalues(totals['root'])) == 4
+
+
 class TestTimeAttribute(object):
     """Tests for the TimeAttribute class."""
 
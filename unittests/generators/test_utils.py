@@ -0,0 +1,86 @@
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for generated_tests/modules/utils.py"""
+
+from __future__ import (
+    absolute_import, division, print_function, unicode_literals
+)
+import os
+
+# pylint can't figure out the sys.path manipulation.
+from modules import utils  # pylint: disable=import-error,wrong-import-order
+
+
+class TestWriteIfChanged(object):
+    """Tests for modules.utils.write_if_changed."""
+
+    def test_new_file(self, tmpdir):
+        """modules.utils.write_if_changed: creates the file and its dir"""
+        f = tmpdir.join('a', 'b.txt')
+        assert utils.write_if_changed(str(f), 'foo') is True
+        assert f.read() == 'foo'
+
+    def test_unchanged(self, tmpdir):
+        """modules.utils.write_if_changed: leaves the same content alone"""
+        f = tmpdir.join('b.txt')
+        f.write('foo')
+        os.utime(str(f), (0, 0))
+        assert utils.write_if_changed(str(f), 'foo') is False
+        assert os.stat(str(f)).st_mtime == 0
+
+    def test_changed(self, tmpdir):
+        """modules.utils.write_if_changed: rewrites different content"""
+        f = tmpdir.join('b.txt')
+        f.write('foo')
+        assert utils.write_if_changed(str(f), 'bar') is True
+        assert f.read() == 'bar'
+
+
+class TestOpenIfChanged(object):
+    """Tests for modules.utils.open_if_changed."""
+
+    def test_written_on_close(self, tmpdir):
+        """modules.utils.open_if_changed: writes the pieces when closed"""
+        f = tmpdir.join('b.txt')
+        with utils.open_if_changed(str(f)) as out:
+            out.write('foo')
+            out.write('bar')
+            assert not f.check()
+        assert f.read() == 'foobar'
+
+    def test_unchanged(self, tmpdir):
+        """modules.utils.open_if_changed: leaves the same content alone"""
+        f = tmpdir.join('b.txt')
+        f.write('foo')
+        os.utime(str(f), (0, 0))
+        out = utils.open_if_changed(str(f))
+        out.write('foo')
+        assert out.close() is False
+        assert os.stat(str(f)).st_mtime == 0
+
+    def test_exception(self, tmpdir):
+        """modules.utils.open_if_changed: isn't written on an exception"""
+        f = tmpdir.join('b.txt')
+        try:
+            with utils.open_if_changed(str(f)) as out:
+                out.write('foo')
+                raise RuntimeError
+        except RuntimeError:
+            pass
+        assert not f.check()